@@ -0,0 +1,113 @@
+/*
+* Purpose: Compare finding the closest route point a square at a time with getClosestPoint() and a
+*          straight run at a time with getClosestPointOnSegments(), on long routes through generated
+*          cities with short and long blocks, and check both give the same point for every query.
+*
+* Build from this folder with a larger map and longer routes, e.g.
+*   gcc -O2 -DMAP_ROWS=120 -DMAP_COLS=120 -DMAX_ROUTE=1000 -I../SourceCode bench_closest.c
+*       ../SourceCode/mapping.c ../SourceCode/MS3Functions.c ../SourceCode/pathing.c ../SourceCode/hpa.c
+*       ../SourceCode/roadgraph.c ../SourceCode/fleetscore.c ../SourceCode/citygen.c
+*       ../SourceCode/segments.c -lm -o bench_closest
+* or add the same files to a console project with MAP_ROWS, MAP_COLS and MAX_ROUTE defined.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <time.h>
+#include "MS3FunctionSpecs.h"
+#include "citygen.h"
+#include "segments.h"
+
+#define BENCH_TRUCKS 16
+#define NUM_QUERIES 20000
+
+static struct City city;
+static struct Truck fleet[BENCH_TRUCKS];
+static struct Truck scanned[BENCH_TRUCKS];
+static struct RouteSegment segments[BENCH_TRUCKS][MAX_ROUTE];
+static int numSegments[BENCH_TRUCKS];
+static struct Point queries[NUM_QUERIES];
+
+static double milliseconds(clock_t begin) {
+    return 1000.0 * (clock() - begin) / CLOCKS_PER_SEC;
+}
+
+static void runCity(const char* name, int blockSize) {
+    struct CityConfig cityConfig = { MAP_ROWS, MAP_COLS, blockSize, 2, 2, 55, 2025 };
+    struct CityRandom random;
+    long points = 0, runs = 0, checksum[2] = { 0, 0 }, differ = 0, kept = 0;
+    double scanTime, runTime, scanDistance, runDistance, sum[2] = { 0, 0 };
+    clock_t begin;
+    int i, t;
+
+    generateCity(&city, &cityConfig);
+    generateFleet(fleet, BENCH_TRUCKS, &city, MAX_ROUTE, 77);
+    for (t = 0; t < BENCH_TRUCKS; t++) {
+        numSegments[t] = compressRoute(&fleet[t].route, segments[t], MAX_ROUTE);
+        points += fleet[t].route.numPoints;
+        runs += numSegments[t];
+        kept += fleet[t].numSegments > 0;
+
+        // The same truck with its runs hidden, so calculateRouteDistance() falls back to the scan
+        scanned[t] = fleet[t];
+        scanned[t].numSegments = 0;
+    }
+    seedCityRandom(&random, 99);
+    for (i = 0; i < NUM_QUERIES; i++) {
+        queries[i].row = (char)cityRandomBelow(&random, MAP_ROWS);
+        queries[i].col = (char)cityRandomBelow(&random, MAP_COLS);
+    }
+
+    begin = clock();
+    for (t = 0; t < BENCH_TRUCKS; t++) {
+        for (i = 0; i < NUM_QUERIES; i++) {
+            checksum[0] += getClosestPoint(&fleet[t].route, queries[i]);
+        }
+    }
+    scanTime = milliseconds(begin);
+
+    begin = clock();
+    for (t = 0; t < BENCH_TRUCKS; t++) {
+        for (i = 0; i < NUM_QUERIES; i++) {
+            checksum[1] += getClosestPointOnSegments(segments[t], numSegments[t], queries[i]);
+        }
+    }
+    runTime = milliseconds(begin);
+
+    // Untimed, every answer compared
+    for (t = 0; t < BENCH_TRUCKS; t++) {
+        for (i = 0; i < NUM_QUERIES; i++) {
+            differ += getClosestPoint(&fleet[t].route, queries[i]) != getClosestPointOnSegments(segments[t], numSegments[t], queries[i]);
+        }
+    }
+
+    begin = clock();
+    for (t = 0; t < BENCH_TRUCKS; t++) {
+        for (i = 0; i < NUM_QUERIES; i++) {
+            sum[0] += calculateRouteDistance(&scanned[t], queries[i], &city.map);
+        }
+    }
+    scanDistance = milliseconds(begin);
+
+    begin = clock();
+    for (t = 0; t < BENCH_TRUCKS; t++) {
+        for (i = 0; i < NUM_QUERIES; i++) {
+            sum[1] += calculateRouteDistance(&fleet[t], queries[i], &city.map);
+        }
+    }
+    runDistance = milliseconds(begin);
+
+    printf("%s: %d trucks averaging %ld squares in %ld runs, %ld of them with the runs kept by indexRoute()\n",
+        name, BENCH_TRUCKS, points / BENCH_TRUCKS, runs / BENCH_TRUCKS, kept);
+    printf("  closest point    scan %8.2f ms   runs %8.2f ms   %5.1fx   %ld of %ld differ\n",
+        scanTime, runTime, scanTime / runTime, differ + (checksum[0] != checksum[1]), (long)BENCH_TRUCKS * NUM_QUERIES);
+    printf("  route distance   scan %8.2f ms   runs %8.2f ms   %5.1fx   %s\n",
+        scanDistance, runDistance, scanDistance / runDistance, sum[0] == sum[1] ? "same totals" : "TOTALS DIFFER");
+}
+
+int main(void) {
+    printf("%dx%d map, routes of up to %d squares, %d queries per truck\n", MAP_ROWS, MAP_COLS, MAX_ROUTE, NUM_QUERIES);
+    runCity("short blocks", 5);
+    runCity("long blocks", 20);
+    return 0;
+}
@@ -0,0 +1,260 @@
+/*
+* Purpose: Load generator for the intake server. Many clients each keep a few requests in flight on
+*          the Unix domain socket, and the time from sending a request to reading its answer is
+*          measured, once with every request placed on its own and once in batches.
+*
+* Linux only. Build from this folder, e.g.
+*   gcc -O2 -I../SourceCode bench_intake_server.c ../SourceCode/mapping.c ../SourceCode/MS3Functions.c
+*       ../SourceCode/pathing.c ../SourceCode/hpa.c ../SourceCode/roadgraph.c ../SourceCode/fleetscore.c
+*       ../SourceCode/segments.c ../SourceCode/platform.c ../SourceCode/snapshot.c ../SourceCode/backlog.c
+*       ../SourceCode/outputsink.c ../SourceCode/pipeline.c ../SourceCode/intakeserver.c
+*       -lm -pthread -o bench_intake_server
+* Run with no arguments to start a server in the same process, or give the socket of a running
+* DeliveryApp --serve to load that instead:  ./bench_intake_server [socket [clients [in flight]]]
+*/
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "MS3FunctionSpecs.h"
+#include "intakeserver.h"
+#include "pipeline.h"
+#include "platform.h"
+#include "snapshot.h"
+
+#define MAX_CLIENTS 512
+#define MAX_IN_FLIGHT 16
+#define REQUESTS 200000
+
+static const char socketPath[] = "bench_intake_server.sock";
+static const char snapshotPath[] = "bench_intake_server.snap";
+
+/**
+ * One client connection and the requests it has sent but not had answered
+ */
+struct Client {
+    int descriptor;
+    int sent;
+    int answered;
+    char last;                          // last byte read, to find an empty line split across reads
+    double sentAt[MAX_IN_FLIGHT];       // by request number modulo MAX_IN_FLIGHT
+};
+
+/**
+ * A server run on its own thread
+ */
+struct ServerRun {
+    int maxBatch;
+    struct Truck trucks[NUM_TRUCKS];
+    struct Map map;
+    int placed;
+};
+
+static struct Client clients[MAX_CLIENTS];
+static struct pollfd polls[MAX_CLIENTS];
+static double latencies[REQUESTS];
+static char requests[REQUESTS][24];
+static struct Snapshot snapshot;
+static struct CapacityIndex capacity;
+static struct FleetIndex fleet;
+static struct DestinationTable destinations;
+
+static double seconds(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void serve(void* argument) {
+    struct ServerRun* run = (struct ServerRun*)argument;
+    run->placed = runIntakeServer(socketPath, run->maxBatch, run->trucks, NUM_TRUCKS, &run->map);
+}
+
+// The course map and trucks, empty, saving to a fresh snapshot as the console does
+static void startServerRun(struct ServerRun* run, int maxBatch) {
+    run->maxBatch = maxBatch;
+    run->map = populateMap();
+    loadBlueRoute(&run->trucks[0].route);
+    loadGreenRoute(&run->trucks[1].route);
+    loadYellowRoute(&run->trucks[2].route);
+    for (int i = 0; i < NUM_TRUCKS; i++) {
+        run->trucks[i].truckNumber = i;
+        run->trucks[i].numShipments = 0;
+        run->trucks[i].currentWeight = 0.0;
+        run->trucks[i].currentVolume = 0.0;
+        indexRoute(&run->trucks[i]);
+    }
+    buildFleetIndex(&fleet, run->trucks, NUM_TRUCKS);
+    useFleetIndex(&fleet, run->trucks);
+    buildCapacityIndex(&capacity, run->trucks, NUM_TRUCKS);
+    useCapacityIndex(&capacity);
+    buildDestinationTable(&destinations, &run->map, run->trucks, NUM_TRUCKS);
+    useDestinationTable(&destinations, run->trucks, &run->map);
+    if (snapshotCreate(snapshotPath, &run->map, run->trucks, NUM_TRUCKS) && snapshotOpen(&snapshot, snapshotPath, &run->map, run->trucks, NUM_TRUCKS)) {
+        useIntakeSnapshot(&snapshot);
+    }
+}
+
+static void endServerRun(void) {
+    useIntakeSnapshot(NULL);
+    snapshotClose(&snapshot);
+    remove(snapshotPath);
+}
+
+static int connectTo(const char* path) {
+    struct sockaddr_un address;
+    int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    if (descriptor >= 0 && connect(descriptor, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(descriptor);
+        descriptor = -1;
+    }
+    return descriptor;
+}
+
+// Drive every client until all the requests are answered; returns the seconds it took
+static double generateLoad(const char* path, int numClients, int inFlight, int total) {
+    double begin;
+    int answered = 0, next = 0;
+
+    for (int c = 0; c < numClients; c++) {
+        // The server may still be starting
+        for (int round = 0; (clients[c].descriptor = connectTo(path)) < 0; round++) {
+            if (round == 5000) {
+                printf("could not connect to %s\n", path);
+                exit(1);
+            }
+            backOff(round);
+        }
+        clients[c].sent = 0;
+        clients[c].answered = 0;
+        clients[c].last = '\n';
+        polls[c].fd = clients[c].descriptor;
+    }
+
+    begin = seconds();
+    while (answered < total) {
+        // Top every client up to its window, taking requests in turn from the shared list
+        for (int c = 0; c < numClients; c++) {
+            struct Client* client = &clients[c];
+
+            while (client->sent - client->answered < inFlight && next < total) {
+                const char* line = requests[next++];
+
+                client->sentAt[client->sent % MAX_IN_FLIGHT] = seconds();
+                client->sent++;
+                if (write(client->descriptor, line, strlen(line)) < 0) {
+                    printf("write failed: %s\n", strerror(errno));
+                    exit(1);
+                }
+            }
+            polls[c].events = client->sent > client->answered ? POLLIN : 0;
+        }
+
+        if (poll(polls, (nfds_t)numClients, -1) < 0 && errno != EINTR) {
+            break;
+        }
+        for (int c = 0; c < numClients; c++) {
+            struct Client* client = &clients[c];
+            char buffer[8192];
+            ssize_t n;
+
+            if (!(polls[c].revents & (POLLIN | POLLHUP))) {
+                continue;
+            }
+            n = read(client->descriptor, buffer, sizeof(buffer));
+            if (n <= 0) {
+                printf("server closed the connection\n");
+                exit(1);
+            }
+            // Each answer ends with an empty line
+            for (ssize_t i = 0; i < n; i++) {
+                if (buffer[i] == '\n' && client->last == '\n') {
+                    latencies[answered++] = seconds() - client->sentAt[client->answered % MAX_IN_FLIGHT];
+                    client->answered++;
+                }
+                client->last = buffer[i];
+            }
+        }
+    }
+    begin = seconds() - begin;
+
+    for (int c = 0; c < numClients; c++) {
+        close(clients[c].descriptor);
+    }
+    return begin;
+}
+
+static void report(const char* label, double elapsed, int total) {
+    qsort(latencies, (size_t)total, sizeof(double), compareDoubles);
+    printf("  %-18s %9.0f requests/s   latency p50 %7.1f us   p99 %7.1f us   max %8.1f us\n", label,
+        total / elapsed, 1e6 * latencies[total / 2], 1e6 * latencies[total * 99 / 100], 1e6 * latencies[total - 1]);
+}
+
+int main(int argc, char* argv[]) {
+    static struct ServerRun run;
+    const char* external = argc > 1 ? argv[1] : NULL;
+    int numClients = argc > 2 ? atoi(argv[2]) : 64;
+    int inFlight = argc > 3 ? atoi(argv[3]) : 4;
+    int batches[2] = { 1, SERVER_BATCH };
+    struct Thread server;
+    double elapsed;
+
+    if (numClients < 1 || numClients > MAX_CLIENTS || inFlight < 1 || inFlight > MAX_IN_FLIGHT) {
+        printf("clients must be 1-%d and in flight 1-%d\n", MAX_CLIENTS, MAX_IN_FLIGHT);
+        return 1;
+    }
+
+    // Light boxes anywhere on the map, with the odd bad line among them
+    srand(7);
+    for (int i = 0; i < REQUESTS; i++) {
+        if (i % 50 == 49) {
+            strcpy(requests[i], "what 2 3C\n");
+        }
+        else {
+            sprintf(requests[i], "%d %s %d%c\n", 1 + rand() % 40, rand() % 4 ? "0.5" : "2",
+                1 + rand() % MAP_ROWS, 'A' + rand() % 25);
+        }
+    }
+
+    printf("%d clients with up to %d requests each in flight, %d requests\n", numClients, inFlight, REQUESTS);
+    if (external != NULL) {
+        elapsed = generateLoad(external, numClients, inFlight, REQUESTS);
+        report(external, elapsed, REQUESTS);
+        return 0;
+    }
+
+    for (int b = 0; b < 2; b++) {
+        char label[32];
+
+        startServerRun(&run, batches[b]);
+        if (!threadStart(&server, serve, &run)) {
+            printf("could not start the server\n");
+            return 1;
+        }
+        elapsed = generateLoad(socketPath, numClients, inFlight, REQUESTS);
+        stopIntakeServer();
+        threadJoin(&server);
+        endServerRun();
+
+        sprintf(label, "batches of %d", batches[b]);
+        report(label, elapsed, REQUESTS);
+        printf("  %18s %d placed\n", "", run.placed);
+    }
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*
+* Purpose: Compare the path engines on large open and building-dense maps.
+*
+* Build from this folder with a larger map, e.g.
+*   gcc -O2 -DMAP_ROWS=120 -DMAP_COLS=120 -DMAX_ROUTE=2000 -I../SourceCode bench_pathing.c
+*       ../SourceCode/mapping.c ../SourceCode/pathing.c ../SourceCode/hpa.c ../SourceCode/roadgraph.c -lm -o bench_pathing
+* or add the same files to a console project with MAP_ROWS, MAP_COLS and MAX_ROUTE defined.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <time.h>
+#include "mapping.h"
+#include "pathing.h"
+#include "hpa.h"
+#include "roadgraph.h"
+
+#define NUM_QUERIES 2000
+
+static unsigned int seed = 12345;
+static struct MoveTable moveTable;
+
+static int nextRandom(const int limit)
+{
+	seed = seed * 1103515245u + 12345u;
+	return (int)((seed >> 16) % (unsigned int)limit);
+}
+
+/*
+* Scatter rectangular buildings over an empty map until roughly percentBuilt of it is covered.
+*/
+static void buildMap(struct Map* map, const int percentBuilt, const int maxBlock)
+{
+	int target = MAP_ROWS * MAP_COLS * percentBuilt / 100, built = 0;
+	int r, c, row, col, height, width;
+
+	for (r = 0; r < MAP_ROWS; r++)
+	{
+		for (c = 0; c < MAP_COLS; c++)
+		{
+			map->squares[r][c] = 0;
+		}
+	}
+	map->numRows = MAP_ROWS;
+	map->numCols = MAP_COLS;
+
+	while (built < target)
+	{
+		row = nextRandom(MAP_ROWS);
+		col = nextRandom(MAP_COLS);
+		height = 1 + nextRandom(maxBlock);
+		width = 1 + nextRandom(maxBlock);
+		for (r = row; r < row + height && r < MAP_ROWS; r++)
+		{
+			for (c = col; c < col + width && c < MAP_COLS; c++)
+			{
+				if (map->squares[r][c] == 0)
+				{
+					map->squares[r][c] = 1;
+					built++;
+				}
+			}
+		}
+	}
+}
+
+static struct Point randomOpenPoint(const struct Map* map)
+{
+	struct Point pt;
+
+	do
+	{
+		pt.row = (char)nextRandom(MAP_ROWS);
+		pt.col = (char)nextRandom(MAP_COLS);
+	} while (!isOpenSquare(map, pt.row, pt.col));
+	return pt;
+}
+
+static int moveDistance(const struct Point a, const struct Point b)
+{
+	int deltaRow = a.row > b.row ? a.row - b.row : b.row - a.row;
+	int deltaCol = a.col > b.col ? a.col - b.col : b.col - a.col;
+
+	return deltaRow > deltaCol ? deltaRow : deltaCol;
+}
+
+/*
+* Time every engine on the same random queries whose end points are at least minDistance moves
+* apart, checking each path length against the single direction breadth first search. The
+* hierarchical engine is allowed to be slightly longer, so its extra length is reported instead.
+*/
+static void runEngines(const char* title, const struct Map* map, const int minDistance)
+{
+	static struct Point starts[NUM_QUERIES], dests[NUM_QUERIES];
+	static int baseline[NUM_QUERIES];
+	const char* names[] = { "BFS", "A*", "JPS", "BiBFS", "HPA*", "CH" };
+	enum PathEngine engines[] = { PATH_BFS, PATH_ASTAR, PATH_JPS, PATH_BIDIRECTIONAL, PATH_HIERARCHICAL, PATH_CONTRACTED };
+	long expanded, baseLength, length;
+	int e, i, mismatches;
+	clock_t begin;
+	struct Route route;
+
+	for (i = 0; i < NUM_QUERIES; i++)
+	{
+		do
+		{
+			starts[i] = randomOpenPoint(map);
+			dests[i] = randomOpenPoint(map);
+		} while (moveDistance(starts[i], dests[i]) < minDistance);
+	}
+
+	printf("%s (%dx%d)\n", title, MAP_ROWS, MAP_COLS);
+	for (e = 0; e < 6; e++)
+	{
+		expanded = 0;
+		mismatches = 0;
+		baseLength = 0;
+		length = 0;
+		begin = clock();
+		for (i = 0; i < NUM_QUERIES; i++)
+		{
+			findPathInto(map, starts[i], dests[i], engines[e], &route);
+			expanded += getLastPathStats().expanded;
+			if (e == 0) baseline[i] = route.numPoints;
+			else if (route.numPoints != baseline[i]) mismatches++;
+			baseLength += baseline[i];
+			length += route.numPoints;
+		}
+		printf("  %-6s %8.2f ms  %10ld expanded  %4d length mismatches  %+.2f%% length\n", names[e],
+			1000.0 * (clock() - begin) / CLOCKS_PER_SEC, expanded, mismatches,
+			baseLength > 0 ? 100.0 * (length - baseLength) / baseLength : 0.0);
+	}
+
+	// the plain searches again, reading each square's open moves from the precomputed table
+	useMoveTable(&moveTable, map);
+	for (e = 0; e < 4; e++)
+	{
+		if (engines[e] == PATH_JPS) continue;
+		mismatches = 0;
+		begin = clock();
+		for (i = 0; i < NUM_QUERIES; i++)
+		{
+			findPathInto(map, starts[i], dests[i], engines[e], &route);
+			if (route.numPoints != baseline[i]) mismatches++;
+		}
+		printf("  %-6s %8.2f ms  with move table      %4d length mismatches\n", names[e],
+			1000.0 * (clock() - begin) / CLOCKS_PER_SEC, mismatches);
+	}
+	useMoveTable(NULL, NULL);
+
+	// the original walk with its result returned by value and written in place
+	for (e = 0; e < 2; e++)
+	{
+		length = 0;
+		begin = clock();
+		for (i = 0; i < NUM_QUERIES; i++)
+		{
+			if (e == 0) route = findPath(map, starts[i], dests[i], PATH_GREEDY);
+			else findPathInto(map, starts[i], dests[i], PATH_GREEDY, &route);
+			length += route.numPoints;
+		}
+		printf("  %-6s %8.2f ms  %s  %ld points\n", "Greedy", 1000.0 * (clock() - begin) / CLOCKS_PER_SEC,
+			e == 0 ? "by value   " : "into buffer", length);
+	}
+
+	// diversion distances only need the length, which skips filling in the steps inside clusters
+	expanded = 0;
+	length = 0;
+	begin = clock();
+	for (i = 0; i < NUM_QUERIES; i++)
+	{
+		e = hpaPathLength(getHpaIndex(), map, starts[i], dests[i]);
+		expanded += hpaGetLastStats().expanded;
+		length += e > 0 ? e : 0;
+	}
+	printf("  %-6s %8.2f ms  %10ld expanded  (length only)        %+.2f%% length\n", "HPA*",
+		1000.0 * (clock() - begin) / CLOCKS_PER_SEC, expanded,
+		baseLength > 0 ? 100.0 * (length - baseLength) / baseLength : 0.0);
+
+	expanded = 0;
+	mismatches = 0;
+	begin = clock();
+	for (i = 0; i < NUM_QUERIES; i++)
+	{
+		e = roadDistance(getRoadIndex(), starts[i], dests[i]);
+		expanded += roadGetLastStats().expanded;
+		if (e != (baseline[i] > 0 ? baseline[i] : -1)) mismatches++;
+	}
+	printf("  %-6s %8.2f ms  %10ld expanded  %4d length mismatches  (length only)\n", "CH",
+		1000.0 * (clock() - begin) / CLOCKS_PER_SEC, expanded, mismatches);
+}
+
+/*
+* Build both indexes for the current map and report what the road graph looks like.
+*/
+static void buildIndexes(const struct Map* map, struct HpaIndex* hpa, struct RoadIndex* roads)
+{
+	clock_t begin;
+
+	hpaBuild(hpa, map);
+	buildMoveTable(&moveTable, map);
+	begin = clock();
+	roadBuild(roads, map);
+	printf("Road graph: %d nodes, %d corridors, %d arcs after contraction, built in %.1f ms%s\n",
+		roads->numNodes, roads->numChains, roads->numArcs, 1000.0 * (clock() - begin) / CLOCKS_PER_SEC,
+		roads->complete ? "" : " (too many arcs, CH falls back to A*)");
+}
+
+int main(void)
+{
+	static struct Map map;
+	static struct HpaIndex index;
+	static struct RoadIndex roads;
+
+	useHpaIndex(&index);
+	useRoadIndex(&roads);
+	buildMap(&map, 10, 4);
+	buildIndexes(&map, &index, &roads);
+	runEngines("Open map, 10% buildings", &map, 0);
+	runEngines("Open map, long diversions", &map, MAP_ROWS / 2);
+	buildMap(&map, 40, 6);
+	buildIndexes(&map, &index, &roads);
+	runEngines("Building-dense map, 40% buildings", &map, 0);
+	runEngines("Building-dense map, long diversions", &map, MAP_ROWS / 2);
+	return 0;
+}
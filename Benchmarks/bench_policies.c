@@ -0,0 +1,143 @@
+/*
+* Purpose: Compare the assignment policies on throughput and how many shipments they manage to place.
+*
+* Build from this folder with
+*   gcc -O2 -I../SourceCode bench_policies.c ../SourceCode/mapping.c ../SourceCode/MS3Functions.c
+*       ../SourceCode/pathing.c ../SourceCode/hpa.c ../SourceCode/roadgraph.c ../SourceCode/mapupdate.c
+*       ../SourceCode/assignpolicy.c ../SourceCode/fleetscore.c ../SourceCode/segments.c -lm -o bench_policies
+* or add the same files to a console project.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "assignpolicy.h"
+#include "fleetscore.h"
+
+#define NUM_DAYS 200
+#define SHIPMENTS_PER_DAY 600
+#define BENCH_TRUCKS 12
+
+static unsigned int seed = 12345;
+
+static int nextRandom(const int limit) {
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 16) % (unsigned int)limit);
+}
+
+static struct Shipment shipments[NUM_DAYS][SHIPMENTS_PER_DAY];
+static struct Truck fleet[BENCH_TRUCKS];
+static struct CapacityIndex capacity;
+static int indexFleet = 0;
+
+/*
+* Make the same shipments for every policy: mostly small parcels with the odd heavy one,
+* a third of them going straight to a square on one of the routes.
+*/
+static void makeShipments(const struct Map* map) {
+    const double volumes[3] = { 0.5, 2.0, 5.0 };
+    struct Route routes[3] = { getBlueRoute(), getGreenRoute(), getYellowRoute() };
+    int d, i;
+
+    for (d = 0; d < NUM_DAYS; d++) {
+        for (i = 0; i < SHIPMENTS_PER_DAY; i++) {
+            struct Shipment* s = &shipments[d][i];
+            s->weight = (nextRandom(10) == 0) ? 500 + nextRandom(1500) : 1 + nextRandom(300);
+            s->volume = volumes[nextRandom(3)];
+            if (nextRandom(3) == 0) {
+                const struct Route* r = &routes[nextRandom(3)];
+                s->destination = r->points[nextRandom(r->numPoints)];
+            }
+            else {
+                do {
+                    s->destination.row = (char)nextRandom(MAP_ROWS);
+                    s->destination.col = (char)nextRandom(MAP_COLS);
+                } while (map->squares[(int)s->destination.row][(int)s->destination.col] == 1);
+            }
+        }
+    }
+}
+
+static void resetFleet(void) {
+    struct Route routes[3] = { getBlueRoute(), getGreenRoute(), getYellowRoute() };
+    int i;
+
+    memset(fleet, 0, sizeof(fleet));
+    for (i = 0; i < BENCH_TRUCKS; i++) {
+        fleet[i].route = routes[i % 3];
+        fleet[i].truckNumber = i;
+        indexRoute(&fleet[i]);
+    }
+    if (indexFleet) {
+        buildCapacityIndex(&capacity, fleet, BENCH_TRUCKS);
+    }
+}
+
+/*
+* Run every day through one policy, emptying the fleet at the start of each day.
+* reference, if given, is checked against every result.
+*/
+static void runPolicy(const char* name, AssignFunction assign, const struct Map* map, AssignFunction reference) {
+    static struct Truck check[BENCH_TRUCKS];
+    long placed = 0, diverted = 0, mismatches = 0;
+    double diversion = 0.0, elapsed = 0.0;
+    clock_t begin;
+    int d, i;
+
+    for (d = 0; d < NUM_DAYS; d++) {
+        resetFleet();
+        memcpy(check, fleet, sizeof(fleet));
+        begin = clock();
+        for (i = 0; i < SHIPMENTS_PER_DAY; i++) {
+            struct DeliveryResult result = assign(fleet, BENCH_TRUCKS, &shipments[d][i], map);
+            if (result.success) {
+                placed++;
+                diverted += result.needsDiversion;
+                diversion += result.distanceToGo;
+            }
+            if (reference != NULL) {
+                struct DeliveryResult expected;
+                clock_t paused = clock();
+                expected = reference(check, BENCH_TRUCKS, &shipments[d][i], map);
+                if (expected.success != result.success || expected.truckIndex != result.truckIndex
+                    || expected.distanceToGo != result.distanceToGo) {
+                    mismatches++;
+                }
+                begin += clock() - paused;
+            }
+        }
+        elapsed += (double)(clock() - begin) / CLOCKS_PER_SEC;
+    }
+
+    printf("  %-14s %8.2f ms  %9.0f shipments/s  %6.2f%% placed  %6.2f%% diverted  %5.2f mean diversion",
+        name, 1000.0 * elapsed, NUM_DAYS * SHIPMENTS_PER_DAY / (elapsed > 0 ? elapsed : 1e-9),
+        100.0 * placed / (NUM_DAYS * SHIPMENTS_PER_DAY), placed ? 100.0 * diverted / placed : 0.0,
+        placed ? diversion / placed : 0.0);
+    if (reference != NULL) {
+        printf("  %ld mismatches", mismatches);
+    }
+    printf("\n");
+}
+
+int main(void) {
+    struct Map map = populateMap();
+    int p;
+
+    makeShipments(&map);
+    printf("%d days of %d shipments, %d trucks\n", NUM_DAYS, SHIPMENTS_PER_DAY, BENCH_TRUCKS);
+    runPolicy("assignShipment", assignShipment, &map, NULL);
+
+    // The same rules scored from the capacity index's arrays, checked against the plain loop
+    indexFleet = 1;
+    useCapacityIndex(&capacity);
+    printf("  (capacity index, %s scoring)\n", fleetScoreKernel());
+    runPolicy("assignShipment", assignShipment, &map, assignShipment);
+    useCapacityIndex(NULL);
+    indexFleet = 0;
+
+    for (p = 0; p < NUM_ASSIGN_POLICIES; p++) {
+        runPolicy(assignPolicies[p].name, assignPolicies[p].assign, &map, p == 0 ? assignShipment : NULL);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+* Purpose: Time assignment and diversion routing on a generated city many times the size of the
+*          course map, for each of the destination models.
+*
+* Build from this folder with a larger map, e.g.
+*   gcc -O2 -DMAP_ROWS=120 -DMAP_COLS=120 -DMAX_ROUTE=1000 -I../SourceCode bench_scale.c
+*       ../SourceCode/mapping.c ../SourceCode/MS3Functions.c ../SourceCode/pathing.c ../SourceCode/hpa.c
+*       ../SourceCode/roadgraph.c ../SourceCode/fleetscore.c ../SourceCode/citygen.c
+*       ../SourceCode/segments.c -lm -o bench_scale
+* or add the same files to a console project with MAP_ROWS, MAP_COLS and MAX_ROUTE defined.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <time.h>
+#include "MS3FunctionSpecs.h"
+#include "citygen.h"
+#include "hpa.h"
+
+#define NUM_DAYS 20
+#define SHIPMENTS_PER_DAY 2000
+#define BENCH_TRUCKS MAX_FLEET
+
+static struct City city;
+static struct Truck routes[BENCH_TRUCKS];
+static struct Truck fleet[BENCH_TRUCKS];
+static struct CapacityIndex capacity;
+static struct HpaIndex hpa;
+static struct Workload workload;
+
+static double milliseconds(clock_t begin) {
+    return 1000.0 * (clock() - begin) / CLOCKS_PER_SEC;
+}
+
+/*
+* Run every day of one destination model, emptying the fleet at the start of each day, then
+* find the diversion of every shipment placed off its truck's route.
+*/
+static void runModel(const char* name, const struct WorkloadConfig* config) {
+    static struct Shipment placed[SHIPMENTS_PER_DAY];
+    static int placedOn[SHIPMENTS_PER_DAY];
+    double assignTime = 0, routeTime = 0;
+    long numPlaced = 0, numDiverted = 0, points = 0;
+    struct Route diversion;
+    clock_t begin;
+    int d, i, n, t;
+
+    startWorkload(&workload, config, &city.map);
+    for (d = 0; d < NUM_DAYS; d++) {
+        for (t = 0; t < BENCH_TRUCKS; t++) {
+            fleet[t] = routes[t];
+        }
+        buildCapacityIndex(&capacity, fleet, BENCH_TRUCKS);
+        useCapacityIndex(&capacity);
+
+        n = 0;
+        begin = clock();
+        for (i = 0; i < SHIPMENTS_PER_DAY; i++) {
+            struct Shipment s;
+            struct DeliveryResult result;
+
+            nextShipment(&workload, &city.map, &s);
+            result = assignShipment(fleet, BENCH_TRUCKS, &s, &city.map);
+            if (result.success) {
+                placed[n] = s;
+                placedOn[n++] = result.truckIndex;
+            }
+        }
+        assignTime += milliseconds(begin);
+        useCapacityIndex(NULL);
+        numPlaced += n;
+
+        begin = clock();
+        for (i = 0; i < n; i++) {
+            if (!isOnRoute(&fleet[placedOn[i]], placed[i].destination)) {
+                points += findDiversionInto(&city.map, &fleet[placedOn[i]].route, placed[i].destination, &diversion);
+                numDiverted++;
+            }
+        }
+        routeTime += milliseconds(begin);
+    }
+    printf("  %-9s assign %8.2f ms  %6ld placed of %d   diversions %8.2f ms  %6ld routed  %7ld squares\n",
+        name, assignTime, numPlaced, NUM_DAYS * SHIPMENTS_PER_DAY, routeTime, numDiverted, points);
+}
+
+int main(void) {
+    struct CityConfig cityConfig = { MAP_ROWS, MAP_COLS, 5, 2, 2, 55, 2025 };
+    struct WorkloadConfig uniform = { DESTINATIONS_UNIFORM, 0, 0, 0, 0.0, 1500, 1 };
+    struct WorkloadConfig hotspots = { DESTINATIONS_HOTSPOTS, 6, 4, 80, 0.0, 1500, 2 };
+    struct WorkloadConfig zipf = { DESTINATIONS_ZIPF, 0, 0, 0, 1.0, 1500, 3 };
+    clock_t begin;
+    long length = 0;
+    int t;
+
+    begin = clock();
+    generateCity(&city, &cityConfig);
+    generateFleet(routes, BENCH_TRUCKS, &city, MAX_ROUTE, 77);
+    for (t = 0; t < BENCH_TRUCKS; t++) {
+        length += routes[t].route.numPoints;
+    }
+    printf("%dx%d city (%.0fx the course map), %d trucks averaging %ld squares of route, made in %.1f ms\n",
+        MAP_ROWS, MAP_COLS, MAP_ROWS * MAP_COLS / 625.0, BENCH_TRUCKS, length / BENCH_TRUCKS, milliseconds(begin));
+
+    hpaBuild(&hpa, &city.map);
+    useHpaIndex(&hpa);
+    runModel("uniform", &uniform);
+    runModel("hotspots", &hotspots);
+    runModel("zipf", &zipf);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+* Purpose: Compare serial and shard-parallel assignment on a large fleet for several thread counts.
+*
+* Build from this folder with
+*   gcc -O2 -I../SourceCode bench_shards.c ../SourceCode/mapping.c ../SourceCode/MS3Functions.c
+*       ../SourceCode/pathing.c ../SourceCode/hpa.c ../SourceCode/roadgraph.c ../SourceCode/mapupdate.c
+*       ../SourceCode/assignpolicy.c ../SourceCode/fleetscore.c ../SourceCode/workpool.c
+*       ../SourceCode/shardassign.c ../SourceCode/segments.c -lm -pthread -o bench_shards
+* or add the same files to a console project.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "MS3FunctionSpecs.h"
+#include "roadgraph.h"
+#include "shardassign.h"
+
+#define BENCH_TRUCKS 1024
+#define NUM_SHIPMENTS 500
+#define NUM_SHARDS 16
+
+static unsigned int seed = 12345;
+
+static int nextRandom(const int limit) {
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 16) % (unsigned int)limit);
+}
+
+static struct Truck serial[BENCH_TRUCKS];
+static struct Truck sharded[BENCH_TRUCKS];
+static struct Shipment shipments[NUM_SHIPMENTS];
+static struct DeliveryResult expected[NUM_SHIPMENTS];
+static struct FleetShards shards;
+static struct RoadIndex roads;
+
+// Wall-clock time, since clock() counts the time of every thread on some systems
+static double seconds(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void makeFleet(struct Truck trucks[]) {
+    struct Route routes[3] = { getBlueRoute(), getGreenRoute(), getYellowRoute() };
+    int i;
+
+    memset(trucks, 0, sizeof(struct Truck) * BENCH_TRUCKS);
+    for (i = 0; i < BENCH_TRUCKS; i++) {
+        trucks[i].route = routes[i % 3];
+        trucks[i].truckNumber = i;
+    }
+}
+
+int main(void) {
+    const int threadCounts[] = { 0, 1, 2, 4, 8 };
+    struct Map map = populateMap();
+    double begin, elapsed;
+    int i, t;
+
+    roadBuild(&roads, &map);
+    useRoadIndex(&roads);
+
+    for (i = 0; i < NUM_SHIPMENTS; i++) {
+        shipments[i].weight = 1 + nextRandom(1000);
+        shipments[i].volume = (nextRandom(2) == 0) ? 0.5 : 2.0;
+        do {
+            shipments[i].destination.row = (char)nextRandom(MAP_ROWS);
+            shipments[i].destination.col = (char)nextRandom(MAP_COLS);
+        } while (map.squares[(int)shipments[i].destination.row][(int)shipments[i].destination.col] == 1);
+    }
+
+    makeFleet(serial);
+    begin = seconds();
+    for (i = 0; i < NUM_SHIPMENTS; i++) {
+        expected[i] = assignShipment(serial, BENCH_TRUCKS, &shipments[i], &map);
+    }
+    elapsed = seconds() - begin;
+    printf("%d shipments, %d trucks, %d shards\n", NUM_SHIPMENTS, BENCH_TRUCKS, NUM_SHARDS);
+    printf("  serial        %8.2f ms\n", 1000.0 * elapsed);
+
+    for (t = 0; t < (int)(sizeof(threadCounts) / sizeof(threadCounts[0])); t++) {
+        struct WorkPool pool;
+        long mismatches = 0;
+
+        if (!poolStart(&pool, threadCounts[t])) {
+            printf("  could not start %d threads\n", threadCounts[t]);
+            continue;
+        }
+        makeFleet(sharded);
+        buildFleetShards(&shards, sharded, BENCH_TRUCKS, NUM_SHARDS);
+        begin = seconds();
+        for (i = 0; i < NUM_SHIPMENTS; i++) {
+            struct DeliveryResult result = assignShipmentSharded(&pool, &shards, sharded, BENCH_TRUCKS, &shipments[i], &map);
+            if (result.success != expected[i].success || result.truckIndex != expected[i].truckIndex
+                || result.distanceToGo != expected[i].distanceToGo) {
+                mismatches++;
+            }
+        }
+        elapsed = seconds() - begin;
+        poolStop(&pool);
+        printf("  %d+1 threads   %8.2f ms  %ld mismatches\n", threadCounts[t], 1000.0 * elapsed, mismatches);
+    }
+    return 0;
+}
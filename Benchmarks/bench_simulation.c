@@ -0,0 +1,74 @@
+/*
+* Purpose: Time a whole day of a large fleet driving its routes through a generated city while
+*          shipments come in and are given to trucks still to pass near them.
+*
+* Build from this folder with a larger map, e.g.
+*   gcc -O2 -DMAP_ROWS=120 -DMAP_COLS=120 -DMAX_ROUTE=1000 -I../SourceCode bench_simulation.c
+*       ../SourceCode/mapping.c ../SourceCode/MS3Functions.c ../SourceCode/pathing.c ../SourceCode/hpa.c
+*       ../SourceCode/roadgraph.c ../SourceCode/fleetscore.c ../SourceCode/citygen.c
+*       ../SourceCode/segments.c ../SourceCode/simulation.c -lm -o bench_simulation
+* or add the same files to a console project with MAP_ROWS, MAP_COLS and MAX_ROUTE defined.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <time.h>
+#include "MS3FunctionSpecs.h"
+#include "citygen.h"
+#include "simulation.h"
+
+#define BENCH_TRUCKS 256
+#define ORDERS_PER_DAY 20000
+#define DAY_START (8 * 3600)
+#define DAY_END (20 * 3600)
+
+static struct City city;
+static struct Truck fleet[BENCH_TRUCKS];
+static struct Workload workload;
+static struct Simulation sim;
+
+static double milliseconds(clock_t begin) {
+    return 1000.0 * (clock() - begin) / CLOCKS_PER_SEC;
+}
+
+int main(void) {
+    struct CityConfig cityConfig = { MAP_ROWS, MAP_COLS, 5, 2, 2, 55, 2025 };
+    struct WorkloadConfig uniform = { DESTINATIONS_UNIFORM, 0, 0, 0, 0.0, 1500, 1 };
+    struct SimulationConfig config = { DAY_START, 60, 60, 85 };
+    struct CityRandom random;
+    struct Shipment s;
+    double setup, run;
+    clock_t begin;
+    long length = 0;
+    int i, t;
+
+    generateCity(&city, &cityConfig);
+    generateFleet(fleet, BENCH_TRUCKS, &city, MAX_ROUTE, 77);
+    for (t = 0; t < BENCH_TRUCKS; t++) {
+        length += fleet[t].route.numPoints;
+    }
+    startWorkload(&workload, &uniform, &city.map);
+    seedCityRandom(&random, 5);
+
+    // Orders spread evenly at random over the working day
+    begin = clock();
+    startSimulation(&sim, fleet, BENCH_TRUCKS, &config);
+    for (i = 0; i < ORDERS_PER_DAY; i++) {
+        nextShipment(&workload, &city.map, &s);
+        scheduleOrder(&sim, DAY_START + cityRandomBelow(&random, DAY_END - DAY_START), &s);
+    }
+    setup = milliseconds(begin);
+
+    begin = clock();
+    runSimulation(&sim, 24 * 3600);
+    run = milliseconds(begin);
+
+    printf("%dx%d city, %d trucks averaging %ld squares of route, %d orders\n",
+        MAP_ROWS, MAP_COLS, BENCH_TRUCKS, length / BENCH_TRUCKS, ORDERS_PER_DAY);
+    printf("  schedule %8.2f ms   run %8.2f ms   %ld events\n", setup, run, sim.stats.events);
+    printf("  %d assigned, %d refused, %d delivered, average wait %.1f minutes, last arrival %02d:%02d\n",
+        sim.stats.assigned, sim.stats.refused, sim.stats.delivered,
+        sim.stats.delivered > 0 ? sim.stats.waitSeconds / 60.0 / sim.stats.delivered : 0.0,
+        sim.stats.lastArrival / 3600, sim.stats.lastArrival / 60 % 60);
+    return 0;
+}
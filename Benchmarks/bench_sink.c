@@ -0,0 +1,105 @@
+/*
+* Purpose: Compare printing deliveries directly with handing them to the text and binary output
+*          sinks, timing how long the posting thread is held up and how long the whole run takes.
+*
+* Build from this folder with
+*   gcc -O2 -I../SourceCode bench_sink.c ../SourceCode/mapping.c ../SourceCode/MS3Functions.c
+*       ../SourceCode/pathing.c ../SourceCode/hpa.c ../SourceCode/roadgraph.c ../SourceCode/mapupdate.c
+*       ../SourceCode/fleetscore.c ../SourceCode/platform.c ../SourceCode/outputsink.c
+*       ../SourceCode/segments.c -lm -pthread -o bench_sink
+* or add the same files to a console project.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <time.h>
+#include "MS3FunctionSpecs.h"
+#include "outputsink.h"
+
+#define NUM_DELIVERIES 20000
+
+static unsigned int seed = 12345;
+
+static int nextRandom(const int limit) {
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 16) % (unsigned int)limit);
+}
+
+static struct Truck trucks[3];
+static struct DeliveryResult results[NUM_DELIVERIES];
+static struct Point destinations[NUM_DELIVERIES];
+static struct OutputSink sink;
+
+// Wall-clock time, since clock() counts the time of every thread on some systems
+static double seconds(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void runSink(const char* name, enum SinkFormat format, const struct Map* map) {
+    FILE* output = tmpfile();
+    double begin, posted, finished;
+    long size;
+    int i;
+
+    if (output == NULL || !sinkOpen(&sink, output, format, map)) {
+        printf("  %-16s could not start\n", name);
+        return;
+    }
+    begin = seconds();
+    for (i = 0; i < NUM_DELIVERIES; i++) {
+        sinkDelivery(&sink, &trucks[results[i].truckIndex], &results[i], &destinations[i]);
+    }
+    posted = seconds();
+    sinkClose(&sink);
+    finished = seconds();
+    size = ftell(output);
+    fclose(output);
+    printf("  %-16s posting %8.2f ms  total %8.2f ms  %8ld bytes  %5ld writes\n",
+        name, 1000.0 * (posted - begin), 1000.0 * (finished - begin), size, sink.writes);
+}
+
+int main(void) {
+    struct Map map = populateMap();
+    struct Route routes[3] = { getBlueRoute(), getGreenRoute(), getYellowRoute() };
+    char text[DELIVERY_INFO_SIZE];
+    FILE* output;
+    double begin, elapsed;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        trucks[i].route = routes[i];
+        trucks[i].truckNumber = i;
+    }
+    for (i = 0; i < NUM_DELIVERIES; i++) {
+        results[i].success = 1;
+        results[i].truckIndex = nextRandom(3);
+        results[i].needsDiversion = 1;
+        do {
+            destinations[i].row = (char)nextRandom(MAP_ROWS);
+            destinations[i].col = (char)nextRandom(MAP_COLS);
+        } while (map.squares[(int)destinations[i].row][(int)destinations[i].col] == 1);
+    }
+
+    printf("%d deliveries\n", NUM_DELIVERIES);
+
+    // What the console loop used to do: format and write each one before taking the next
+    output = tmpfile();
+    if (output != NULL) {
+        begin = seconds();
+        for (i = 0; i < NUM_DELIVERIES; i++) {
+            formatDeliveryInfo(text, DELIVERY_INFO_SIZE, &trucks[results[i].truckIndex], &results[i], &map, &destinations[i]);
+            fputs(text, output);
+            fflush(output);
+        }
+        elapsed = seconds() - begin;
+        printf("  %-16s posting %8.2f ms  total %8.2f ms  %8ld bytes  %5d writes\n",
+            "direct", 1000.0 * elapsed, 1000.0 * elapsed, ftell(output), NUM_DELIVERIES);
+        fclose(output);
+    }
+
+    runSink("sink text", SINK_FORMAT_TEXT, &map);
+    runSink("sink binary", SINK_FORMAT_BINARY, &map);
+    return 0;
+}
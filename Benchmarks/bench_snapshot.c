@@ -0,0 +1,84 @@
+/*
+* Purpose: Compare setting up the map, indexes and fleet from scratch with mapping them from a snapshot,
+*          and time saving the fleet's load after each shipment.
+*
+* Build from this folder, best with a larger map, e.g.
+*   gcc -O2 -DMAP_ROWS=120 -DMAP_COLS=120 -DMAX_ROUTE=1000 -I../SourceCode bench_snapshot.c
+*       ../SourceCode/mapping.c ../SourceCode/MS3Functions.c ../SourceCode/pathing.c ../SourceCode/hpa.c
+*       ../SourceCode/roadgraph.c ../SourceCode/fleetscore.c ../SourceCode/citygen.c
+*       ../SourceCode/platform.c ../SourceCode/snapshot.c ../SourceCode/segments.c -lm -pthread -o bench_snapshot
+* or add the same files to a console project with MAP_ROWS, MAP_COLS and MAX_ROUTE defined.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <time.h>
+#include "MS3FunctionSpecs.h"
+#include "citygen.h"
+#include "snapshot.h"
+
+#define BENCH_TRUCKS MAX_FLEET
+#define NUM_SAVES 200
+
+static const char path[] = "bench_snapshot.snap";
+
+static struct City city;
+static struct Truck fleet[BENCH_TRUCKS];
+static struct MoveTable moves;
+static struct FleetIndex fleetIndex;
+static struct Snapshot snapshot;
+
+// Wall-clock time, since clock() does not count time spent waiting on the disk
+static double seconds(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(void) {
+    struct CityConfig cityConfig = { MAP_ROWS, MAP_COLS, 5, 2, 2, 55, 2025 };
+    struct Shipment s = { 1, 0.5, { 0, 0 } };
+    double begin, build, create, open, save;
+    int i;
+
+    generateCity(&city, &cityConfig);
+    generateFleet(fleet, BENCH_TRUCKS, &city, MAX_ROUTE, 77);
+    printf("%dx%d map, %d trucks, snapshot of %.1f MB\n", MAP_ROWS, MAP_COLS, BENCH_TRUCKS,
+        sizeof(struct SnapshotImage) / 1048576.0);
+
+    // What a cold start has to work out before taking the first shipment
+    begin = seconds();
+    buildMoveTable(&moves, &city.map);
+    buildFleetIndex(&fleetIndex, fleet, BENCH_TRUCKS);
+    build = seconds() - begin;
+
+    begin = seconds();
+    if (!snapshotCreate(path, &city.map, fleet, BENCH_TRUCKS)) {
+        printf("could not write %s\n", path);
+        return 1;
+    }
+    create = seconds() - begin;
+
+    begin = seconds();
+    if (!snapshotOpen(&snapshot, path, &city.map, fleet, BENCH_TRUCKS) || snapshotLoadFleet(&snapshot, fleet, BENCH_TRUCKS) != BENCH_TRUCKS) {
+        printf("could not open %s\n", path);
+        return 1;
+    }
+    open = seconds() - begin;
+
+    begin = seconds();
+    for (i = 0; i < NUM_SAVES; i++) {
+        s.destination = fleet[i % BENCH_TRUCKS].route.points[0];
+        addShipmentToTruck(&fleet[i % BENCH_TRUCKS], &s);
+        snapshotSaveFleet(&snapshot, fleet, BENCH_TRUCKS);
+    }
+    save = seconds() - begin;
+    snapshotClose(&snapshot);
+    remove(path);
+
+    printf("  build indexes       %9.2f ms\n", 1000.0 * build);
+    printf("  build and write     %9.2f ms\n", 1000.0 * create);
+    printf("  open and check      %9.2f ms\n", 1000.0 * open);
+    printf("  save fleet load     %9.3f ms each\n", 1000.0 * save / NUM_SAVES);
+    return 0;
+}
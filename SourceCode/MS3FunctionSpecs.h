@@ -24,6 +24,53 @@ int remainingCapacityKg(const struct Truck* t);
 */
 double remainingVolumeM3(const struct Truck* t);
 
+/*
+* Name: weightToGrams
+* Description: Converts kilograms to whole grams, rounding to the nearest gram
+* Parameters:
+*   - kg: weight in kilograms
+* Returns: The weight in grams, limited to the range of an int
+*/
+int weightToGrams(double kg);
+
+/*
+* Name: kilogramsNeeded
+* Description: Finds the whole number of kilograms of room a weight needs, so it can be
+*              compared with remainingCapacityKg() without doubles
+* Parameters:
+*   - kg: weight in kilograms
+* Returns: The weight rounded up to whole kilograms, after rounding to the nearest gram
+*/
+int kilogramsNeeded(double kg);
+
+/*
+* Name: volumeToUnits
+* Description: Converts cubic metres to half cubic metre units, rounding to the nearest unit
+* Parameters:
+*   - m3: volume in cubic metres
+* Returns: The volume in units of VOLUME_UNITS_PER_M3 per cubic metre, limited to the range of an int
+*/
+int volumeToUnits(double m3);
+
+/*
+* Name: remainingVolumeUnits
+* Description: Returns the remaining volume capacity of the truck in half cubic metre units
+* Parameters:
+*   - t: pointer to the truck structure
+* Returns: Units left, 0 if truck is NULL or at capacity
+*/
+int remainingVolumeUnits(const struct Truck* t);
+
+/*
+* Name: capacityLeftShare
+* Description: Returns the share of capacity the truck has left, by weight or volume whichever
+*              is less, as an exact integer so equal shares compare equal
+* Parameters:
+*   - t: pointer to the truck structure
+* Returns: Parts of CAPACITY_SCALE left, negative if the truck is overloaded, 0 if t is NULL
+*/
+int capacityLeftShare(const struct Truck* t);
+
 /*
 * Name: canFitShipment
 * Author: Mustafa Siddiqui
@@ -69,6 +116,9 @@ int findClosestTruck(const struct Truck trucks[], int numTrucks, const struct Po
 * Author: Mustafa Siddiqui
 * Description: Calculates the shortest distance from a truck's route to a destination point.
 *              Uses the A* algorithm to find the shortest path avoiding buildings.
+*              When a road index is installed with useRoadIndex() the distance is the number
+*              of moves along the roads, otherwise the straight-line distance to the closest
+*              route point.
 * Parameters:
 *   - truck: pointer to the truck structure
 *   - destination: the destination point
@@ -87,8 +137,237 @@ double calculateRouteDistance(const struct Truck* truck, const struct Point dest
 *   - shipment: pointer to the shipment to be added
 * Returns: 1 if shipment was successfully added, 0 otherwise
 */
+int addShipmentToTruck(struct Truck* truck, const struct Shipment* shipment);
+
+/*
+* Name: indexRoute
+* Description: Builds the truck's route bitmap so isOnRoute() is a single bit test, and splits
+*              the route into straight runs for getClosestRoutePoint().
+*              Must be called again whenever the truck's route changes.
+* Parameters:
+*   - truck: pointer to the truck structure
+* Returns: Nothing
+*/
+void indexRoute(struct Truck* truck);
+
+/*
+* Name: isOnRoute
+* Description: Checks whether a point is on the truck's route. Uses the route bitmap
+*              when indexRoute() has been called, otherwise scans the route.
+* Parameters:
+*   - truck: pointer to the truck structure
+*   - point: the point to look for
+* Returns: 1 if the route passes through the point, 0 otherwise
+*/
+int isOnRoute(const struct Truck* truck, const struct Point point);
+
+/*
+* Name: getClosestRoutePoint
+* Description: Finds the point on the truck's route closest to a point in a straight line.
+*              Projects the point onto each straight run of the route when indexRoute() has
+*              split it into runs, otherwise scans every point with getClosestPoint().
+* Parameters:
+*   - truck: pointer to the truck structure
+*   - point: the point to measure from
+* Returns: The index of the closest route point, the same one getClosestPoint() gives, or -1
+*          if the route is empty
+*/
+int getClosestRoutePoint(const struct Truck* truck, const struct Point point);
+
+/*
+* Name: buildFleetIndex
+* Description: Records which trucks pass through each square of the map, using bit i
+*              for trucks[i]. Must be built again whenever a route changes.
+* Parameters:
+*   - fleet: the index to fill in
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks in the array, at most MAX_FLEET are indexed
+* Returns: Nothing
+*/
+void buildFleetIndex(struct FleetIndex* fleet, const struct Truck trucks[], int numTrucks);
+
+/*
+* Name: trucksAtPoint
+* Description: Finds every truck whose route passes through a point with one lookup
+* Parameters:
+*   - fleet: the index built by buildFleetIndex()
+*   - point: the point to look up
+* Returns: Bit mask with bit i set if trucks[i] passes through the point, 0 if none do
+*/
+unsigned int trucksAtPoint(const struct FleetIndex* fleet, const struct Point point);
+
+/*
+* Name: useFleetIndex
+* Description: Lets assignShipment(), the assignment policies and assignShipmentSharded() find
+*              the trucks already passing the destination with one lookup. The index is only
+*              used when they are given the same truck array, which must hold the trucks the
+*              index was built from; any other array is scanned.
+* Parameters:
+*   - fleet: the index to use, or NULL to stop using one
+*   - trucks: the truck array the index describes
+* Returns: Nothing
+*/
+void useFleetIndex(const struct FleetIndex* fleet, const struct Truck trucks[]);
+
+/*
+* Name: buildCapacityIndex
+* Description: Builds a tournament tree over the trucks' remaining weight, volume and
+*              share of capacity left. addShipmentToTruck() keeps it up to date in
+*              O(log n) while it is in use.
+* Parameters:
+*   - index: the index to fill in
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks in the array, at most MAX_FLEET are indexed
+* Returns: Nothing
+*/
+void buildCapacityIndex(struct CapacityIndex* index, struct Truck trucks[], int numTrucks);
+
+/*
+* Name: updateCapacityIndex
+* Description: Refreshes one truck's leaf and the nodes above it after its cargo changes
+* Parameters:
+*   - index: the index built by buildCapacityIndex()
+*   - truckIndex: position of the truck in the array the index was built from
+* Returns: Nothing
+*/
+void updateCapacityIndex(struct CapacityIndex* index, int truckIndex);
+
+/*
+* Name: nextFittingTruck
+* Description: Finds the next truck the shipment fits in, skipping whole groups of trucks
+*              that are too full without looking at them one by one
+* Parameters:
+*   - index: the index built by buildCapacityIndex()
+*   - s: pointer to the shipment
+*   - from: the first truck position to consider
+* Returns: Position of the first truck at or after from that the shipment fits in, or -1
+*/
+int nextFittingTruck(const struct CapacityIndex* index, const struct Shipment* s, int from);
+
+/*
+* Name: bestFittingTruck
+* Description: Finds the truck with the most capacity left that the shipment fits in,
+*              breaking ties on the lowest truck number, among the trucks in a bit mask
+* Parameters:
+*   - index: the index built by buildCapacityIndex()
+*   - s: pointer to the shipment
+*   - mask: bit i set if trucks[i] may be chosen
+* Returns: Position of the chosen truck, or -1 if the shipment fits in none of them
+*/
+int bestFittingTruck(const struct CapacityIndex* index, const struct Shipment* s, unsigned int mask);
+
+/*
+* Name: useCapacityIndex
+* Description: Lets assignShipment() skip trucks that are too full and lets
+*              addShipmentToTruck() keep the index up to date
+* Parameters:
+*   - index: the index to use, or NULL to stop using one
+* Returns: Nothing
+*/
+void useCapacityIndex(struct CapacityIndex* index);
+
+/*
+* Name: buildDestinationTable
+* Description: Marks, for every square, the trucks that can deliver to it: the square is not a
+*              building and is joined to a square of the truck's route by moves between open
+*              squares, the moves a diversion can make
+* Parameters:
+*   - table: the table to fill in
+*   - map: pointer to the map
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks in the array
+* Returns: The number of squares that can be delivered to
+*/
+int buildDestinationTable(struct DestinationTable* table, const struct Map* map, const struct Truck trucks[], int numTrucks);
+
+/*
+* Name: isDeliverable
+* Description: Looks a destination up in a table built by buildDestinationTable()
+* Parameters:
+*   - table: the table
+*   - point: the destination
+* Returns: 1 if the point is on the map and some truck can deliver to it, 0 otherwise
+*/
+int isDeliverable(const struct DestinationTable* table, const struct Point point);
+
+/*
+* Name: trucksReaching
+* Description: Finds every truck that can deliver to a point with one lookup in a table built by
+*              buildDestinationTable()
+* Parameters:
+*   - table: the table
+*   - point: the destination
+* Returns: Bit mask with bit i set if trucks[i] can reach the point, 0 if none can
+*/
+unsigned int trucksReaching(const struct DestinationTable* table, const struct Point point);
+
+/*
+* Name: useDestinationTable
+* Description: Makes isValidDestination() check a destination with one lookup in the table, so
+*              the console, the intake server and the backlog all accept the same squares. When
+*              assignShipment(), the assignment policies or assignShipmentSharded() are given the
+*              same truck array they also pass over trucks whose route cannot reach the
+*              destination. The table is only used for the map it was built from, the same struct
+*              Map in memory; any other map is checked square by square.
+* Parameters:
+*   - table: the table to use, or NULL to only check the square is on the map and not a building
+*   - trucks: the truck array the table describes
+*   - map: the map the table was built from
+* Returns: Nothing
+*/
+void useDestinationTable(const struct DestinationTable* table, const struct Truck trucks[], const struct Map* map);
+
+/*
+* Name: findReachMasks
+* Description: Looks up which trucks already pass the destination in the fleet index in use, and
+*              which can reach it at all in the destination table in use. Each is only used when it
+*              was set for this truck array, and the table only for this map; without one, no truck
+*              is on route or every truck may reach, and calculateRouteDistance() decides.
+* Parameters:
+*   - masks: where to put the two masks
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks in the array
+*   - destination: where the shipment is going
+*   - map: pointer to the map
+* Returns: Nothing
+*/
+void findReachMasks(struct ReachMasks* masks, const struct Truck trucks[], int numTrucks, const struct Point destination, const struct Map* map);
+
+/*
+* Name: reachDistance
+* Description: The diversion calculateRouteDistance() gives for trucks[i], without measuring when the
+*              masks already tell: 0 for a truck passing the destination, -1 for one that cannot reach it
+* Parameters:
+*   - masks: what findReachMasks() found for this destination and truck array
+*   - trucks: array of truck structures
+*   - i: position of the truck in the array
+*   - destination: where the shipment is going
+*   - map: pointer to the map
+* Returns: The diversion distance, or -1 if the truck cannot take the shipment there
+*/
+double reachDistance(const struct ReachMasks* masks, const struct Truck trucks[], int i, const struct Point destination, const struct Map* map);
+
+// Room for everything formatDeliveryInfo() writes: two lines plus one "rrC, " per diversion square
+#define DELIVERY_INFO_SIZE (128 + 8 * MAX_ROUTE)
+
+/*
+* Name: formatDeliveryInfo
+* Description: Writes the same lines printDeliveryInfo() prints into a buffer instead, so the text
+*              can be built on one thread and written out on another
+* Parameters:
+*   - buffer: where to write the text, nul terminated
+*   - size: size of buffer, at least 1; DELIVERY_INFO_SIZE is always enough and smaller
+*           buffers get the text cut short
+*   - truck: the truck the shipment went on
+*   - result: what assignShipment() returned for it
+*   - map: pointer to the map
+*   - shipmentDestination: where the shipment is going
+* Returns: Number of characters written, not counting the nul, so at most size - 1
+*/
+int formatDeliveryInfo(char* buffer, int size, const struct Truck* truck, const struct DeliveryResult* result, const struct Map* map, const struct Point* shipmentDestination);
 
 int colLetterToIndex(char letter);
+int parseDestination(const char* destStr, struct Point* point);
 int isValidDestination(const struct Point* dest, const struct Map* map);
 void printDeliveryInfo(const struct Truck* truck, const struct DeliveryResult* result, const struct Map* map, const struct Point* shipmentDestination);
 
@@ -5,10 +5,17 @@
 
 #include "MS3FunctionSpecs.h"
 #include <stdio.h>
+#include <stdarg.h>
 #include <float.h>
+#include <math.h>
+#include <limits.h>
+#include <stdint.h>
 #include "MS3FunctionSpecs.h"
 #include "delivery.h"
 #include "mapping.h"
+#include "pathing.h"
+#include "roadgraph.h"
+#include "fleetscore.h"
 
 /*
 * Name: remainingCapacityKg
@@ -23,12 +30,13 @@ int remainingCapacityKg(const struct Truck* t) {
     }
 
     // Check if truck is already at or over capacity
-    if (t->currentWeight >= MAX_WEIGHT) {
+    int grams = weightToGrams(t->currentWeight);
+    if (grams >= MAX_WEIGHT_G) {
         return 0;
     }
 
-    // Calculate and return remaining capacity
-    return MAX_WEIGHT - t->currentWeight;
+    // Calculate and return remaining capacity in whole kilograms
+    return (MAX_WEIGHT_G - grams) / GRAMS_PER_KG;
 }
 
 /*
@@ -43,13 +51,79 @@ double remainingVolumeM3(const struct Truck* t) {
         return 0.0;
     }
 
-    // Check if truck is already at or over volume capacity
-    if (t->currentVolume >= MAX_VOLUME) {
-        return 0.0;
+    // Calculate and return remaining volume
+    return (double)remainingVolumeUnits(t) / VOLUME_UNITS_PER_M3;
+}
+
+/*
+* Name: weightToGrams
+* Description: Converts kilograms to whole grams
+*/
+int weightToGrams(double kg) {
+    double grams = floor(kg * GRAMS_PER_KG + 0.5);
+    if (grams >= INT_MAX) {
+        return INT_MAX;
     }
+    if (grams <= INT_MIN) {
+        return INT_MIN;
+    }
+    return (int)grams;
+}
 
-    // Calculate and return remaining volume
-    return MAX_VOLUME - t->currentVolume;
+/*
+* Name: kilogramsNeeded
+* Description: Rounds a weight up to whole kilograms
+*/
+int kilogramsNeeded(double kg) {
+    int grams = weightToGrams(kg);
+    if (grams <= 0) {
+        return -(-(long long)grams / GRAMS_PER_KG);
+    }
+    return grams / GRAMS_PER_KG + (grams % GRAMS_PER_KG != 0);
+}
+
+/*
+* Name: volumeToUnits
+* Description: Converts cubic metres to half cubic metre units
+*/
+int volumeToUnits(double m3) {
+    double units = floor(m3 * VOLUME_UNITS_PER_M3 + 0.5);
+    if (units >= INT_MAX) {
+        return INT_MAX;
+    }
+    if (units <= INT_MIN) {
+        return INT_MIN;
+    }
+    return (int)units;
+}
+
+/*
+* Name: remainingVolumeUnits
+* Description: Returns the remaining volume capacity in half cubic metre units
+*/
+int remainingVolumeUnits(const struct Truck* t) {
+    if (t == NULL) {
+        return 0;
+    }
+
+    int units = volumeToUnits(t->currentVolume);
+    return (units >= MAX_VOLUME_UNITS) ? 0 : MAX_VOLUME_UNITS - units;
+}
+
+/*
+* Name: capacityLeftShare
+* Description: Returns the share of capacity left as parts of CAPACITY_SCALE
+*/
+int capacityLeftShare(const struct Truck* t) {
+    if (t == NULL) {
+        return 0;
+    }
+
+    // Both shares over the same denominator, so the smaller one is found without dividing
+    long long weightShare = (long long)MAX_WEIGHT_G - weightToGrams(t->currentWeight);
+    long long volumeShare = ((long long)MAX_VOLUME_UNITS - volumeToUnits(t->currentVolume)) * (CAPACITY_SCALE / MAX_VOLUME_UNITS);
+    long long share = (weightShare < volumeShare) ? weightShare : volumeShare;
+    return (share < INT_MIN) ? INT_MIN : (int)share;
 }
 
 /*
@@ -66,13 +140,13 @@ int canFitShipment(const struct Truck* t, const struct Shipment* s) {
 
     // Check if shipment weight exceeds remaining weight capacity
     int remainingWeight = remainingCapacityKg(t);
-    if (s->weight > remainingWeight) {
+    if (kilogramsNeeded(s->weight) > remainingWeight) {
         return 0;  // Too heavy
     }
 
     // Check if shipment volume exceeds remaining volume capacity
-    double remainingVolume = remainingVolumeM3(t);
-    if (s->volume > remainingVolume) {
+    int remainingVolume = remainingVolumeUnits(t);
+    if (volumeToUnits(s->volume) > remainingVolume) {
         return 0;  // Too large
     }
 
@@ -121,35 +195,282 @@ double calculateRouteDistance(const struct Truck* truck,
 
     if (!truck || !map) return -1.0;
 
+    if (isOnRoute(truck, destination)) {
+        return 0.0;
+    }
+
+    // With a road index the distance is the number of moves to drive there instead of a straight line
+    if (getRoadIndex() != NULL && getRoadIndex()->complete) {
+        int moves = roadDistanceFromRoute(getRoadIndex(), &truck->route, destination);
+        return (moves < 0 || moves > 10) ? -1.0 : (double)moves;
+    }
+
+    int closest = getClosestRoutePoint(truck, destination);
+    if (closest < 0) {
+        return -1.0;
+    }
+
+    double shortestDistance = distance(&truck->route.points[closest], &destination);
+
+    if (shortestDistance > 10.0) {
+        return -1.0;
+    }
+
+    return shortestDistance;
+}
+
+
+
+
+/*
+* Name: indexRoute
+* Description: Builds the truck's route bitmap so isOnRoute() is a single bit test
+*/
+void indexRoute(struct Truck* truck) {
+    if (truck == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < ROUTE_MAP_WORDS; i++) {
+        truck->routeCells[i] = 0;
+    }
+
     for (int i = 0; i < truck->route.numPoints; i++) {
-        if (truck->route.points[i].row == destination.row &&
-            truck->route.points[i].col == destination.col) {
-            return 0.0;
-        }
+        int cell = truck->route.points[i].row * MAP_COLS + truck->route.points[i].col;
+        truck->routeCells[cell / 32] |= 1u << (cell % 32);
     }
 
-    double shortestDistance = DBL_MAX;
+    // Kept as runs as well when it is short enough, for getClosestRoutePoint()
+    truck->numSegments = compressRoute(&truck->route, truck->segments, MAX_ROUTE_SEGMENTS);
+    if (truck->numSegments < 0) {
+        truck->numSegments = 0;
+    }
+
+    truck->routeIndexed = 1;
+}
+
+/*
+* Name: isOnRoute
+* Description: Checks whether a point is on the truck's route
+*/
+int isOnRoute(const struct Truck* truck, const struct Point point) {
+    if (truck == NULL || point.row < 0 || point.row >= MAP_ROWS || point.col < 0 || point.col >= MAP_COLS) {
+        return 0;
+    }
+
+    // Bitmap built by indexRoute(), one bit test
+    if (truck->routeIndexed) {
+        int cell = point.row * MAP_COLS + point.col;
+        return (truck->routeCells[cell / 32] >> (cell % 32)) & 1u;
+    }
 
+    // Route was never indexed, scan it
     for (int i = 0; i < truck->route.numPoints; i++) {
-        struct Point routePoint = truck->route.points[i];
+        if (truck->route.points[i].row == point.row &&
+            truck->route.points[i].col == point.col) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+* Name: getClosestRoutePoint
+* Description: Finds the route point closest to a point, a run at a time when the route is indexed
+*/
+int getClosestRoutePoint(const struct Truck* truck, const struct Point point) {
+    if (truck == NULL) {
+        return -1;
+    }
+
+    // One projection per straight run rather than a distance per square
+    if (truck->routeIndexed && truck->numSegments > 0) {
+        return getClosestPointOnSegments(truck->segments, truck->numSegments, point);
+    }
 
-        // Removed debug print here
+    return getClosestPoint(&truck->route, point);
+}
 
-        double euclid = distance(&routePoint, &destination);
-        if (euclid < shortestDistance) {
-            shortestDistance = euclid;
+/*
+* Name: buildFleetIndex
+* Description: Records which trucks pass through each square of the map
+*/
+void buildFleetIndex(struct FleetIndex* fleet, const struct Truck trucks[], int numTrucks) {
+    if (fleet == NULL) {
+        return;
+    }
+
+    for (int row = 0; row < MAP_ROWS; row++) {
+        for (int col = 0; col < MAP_COLS; col++) {
+            fleet->trucksAt[row][col] = 0;
         }
     }
 
-    if (shortestDistance > 10.0) {
-        return -1.0;
+    fleet->numTrucks = 0;
+    if (trucks == NULL || numTrucks <= 0) {
+        return;
     }
 
-    return shortestDistance;
+    fleet->numTrucks = numTrucks < MAX_FLEET ? numTrucks : MAX_FLEET;
+    for (int i = 0; i < fleet->numTrucks; i++) {
+        for (int j = 0; j < trucks[i].route.numPoints; j++) {
+            int row = trucks[i].route.points[j].row, col = trucks[i].route.points[j].col;
+            fleet->trucksAt[row][col] |= 1u << i;
+        }
+    }
+}
+
+/*
+* Name: trucksAtPoint
+* Description: Finds every truck whose route passes through a point with one lookup
+*/
+unsigned int trucksAtPoint(const struct FleetIndex* fleet, const struct Point point) {
+    if (fleet == NULL || point.row < 0 || point.row >= MAP_ROWS || point.col < 0 || point.col >= MAP_COLS) {
+        return 0;
+    }
+    return fleet->trucksAt[(int)point.row][(int)point.col];
+}
+
+static const struct FleetIndex* activeFleet = NULL;
+static const struct Truck* activeFleetTrucks = NULL;     // the array activeFleet describes
+
+/*
+* Name: useFleetIndex
+* Description: Lets assignShipment() find the trucks already passing the destination with one lookup
+*/
+void useFleetIndex(const struct FleetIndex* fleet, const struct Truck trucks[]) {
+    activeFleet = fleet;
+    activeFleetTrucks = fleet != NULL ? trucks : NULL;
 }
 
+static struct CapacityIndex* activeCapacity = NULL;
+static const struct DestinationTable* activeDestinations = NULL;
+static const struct Truck* activeDestinationTrucks = NULL;     // the array activeDestinations describes
+static const struct Map* activeDestinationMap = NULL;          // the map it was built from
+
+/*
+* Name: buildCapacityIndex
+* Description: Builds a tournament tree over the trucks' remaining capacity
+*/
+void buildCapacityIndex(struct CapacityIndex* index, struct Truck trucks[], int numTrucks) {
+    if (index == NULL) {
+        return;
+    }
+
+    index->trucks = trucks;
+    index->numTrucks = (trucks == NULL || numTrucks <= 0) ? 0 : (numTrucks < MAX_FLEET ? numTrucks : MAX_FLEET);
 
+    // Empty leaves can never win
+    for (int node = 1; node < 2 * MAX_FLEET; node++) {
+        index->weightLeft[node] = INT_MIN;
+        index->volumeLeft[node] = INT_MIN;
+        index->capacityLeft[node] = INT_MIN;
+    }
 
+    for (int i = 0; i < index->numTrucks; i++) {
+        updateCapacityIndex(index, i);
+    }
+}
+
+/*
+* Name: updateCapacityIndex
+* Description: Refreshes one truck's leaf and the nodes above it after its cargo changes
+*/
+void updateCapacityIndex(struct CapacityIndex* index, int truckIndex) {
+    if (index == NULL || truckIndex < 0 || truckIndex >= index->numTrucks) {
+        return;
+    }
+
+    int node = MAX_FLEET + truckIndex;
+    index->weightLeft[node] = remainingCapacityKg(&index->trucks[truckIndex]);
+    index->volumeLeft[node] = remainingVolumeUnits(&index->trucks[truckIndex]);
+    index->capacityLeft[node] = capacityLeftShare(&index->trucks[truckIndex]);
+
+    // Replay the matches on the way up to the root
+    for (node /= 2; node >= 1; node /= 2) {
+        int left = 2 * node, right = 2 * node + 1;
+        index->weightLeft[node] = index->weightLeft[left] > index->weightLeft[right] ? index->weightLeft[left] : index->weightLeft[right];
+        index->volumeLeft[node] = index->volumeLeft[left] > index->volumeLeft[right] ? index->volumeLeft[left] : index->volumeLeft[right];
+        index->capacityLeft[node] = index->capacityLeft[left] > index->capacityLeft[right] ? index->capacityLeft[left] : index->capacityLeft[right];
+    }
+}
+
+// Nothing below the node fits the shipment, using the same comparisons as canFitShipment()
+static int subtreeTooFull(const struct CapacityIndex* index, int node, const struct Shipment* s) {
+    return kilogramsNeeded(s->weight) > index->weightLeft[node] || volumeToUnits(s->volume) > index->volumeLeft[node];
+}
+
+static int findFitting(const struct CapacityIndex* index, const struct Shipment* s, int node, int first, int last, int from) {
+    if (last < from || first >= index->numTrucks || subtreeTooFull(index, node, s)) {
+        return -1;
+    }
+    if (first == last) {
+        return first;
+    }
+
+    int mid = (first + last) / 2;
+    int found = findFitting(index, s, 2 * node, first, mid, from);
+    return found >= 0 ? found : findFitting(index, s, 2 * node + 1, mid + 1, last, from);
+}
+
+/*
+* Name: nextFittingTruck
+* Description: Finds the next truck the shipment fits in, skipping groups of full trucks
+*/
+int nextFittingTruck(const struct CapacityIndex* index, const struct Shipment* s, int from) {
+    if (index == NULL || s == NULL) {
+        return -1;
+    }
+    return findFitting(index, s, 1, 0, MAX_FLEET - 1, from < 0 ? 0 : from);
+}
+
+static void findBest(const struct CapacityIndex* index, const struct Shipment* s, unsigned int mask,
+    int node, int first, int last, int* best) {
+    int count = last - first + 1;
+    unsigned int rangeMask = (count >= 32 ? ~0u : ((1u << count) - 1u)) << first;
+
+    if (first >= index->numTrucks || (mask & rangeMask) == 0 || subtreeTooFull(index, node, s)) {
+        return;
+    }
+    // Nothing below can beat the best so far, equal capacity may still win on truck number
+    if (*best >= 0 && index->capacityLeft[node] < index->capacityLeft[MAX_FLEET + *best]) {
+        return;
+    }
+
+    if (first == last) {
+        int bestCapacity = *best >= 0 ? index->capacityLeft[MAX_FLEET + *best] : INT_MIN;
+        if (*best < 0 || index->capacityLeft[node] > bestCapacity ||
+            (index->capacityLeft[node] == bestCapacity && index->trucks[first].truckNumber < index->trucks[*best].truckNumber)) {
+            *best = first;
+        }
+        return;
+    }
+
+    int mid = (first + last) / 2;
+    findBest(index, s, mask, 2 * node, first, mid, best);
+    findBest(index, s, mask, 2 * node + 1, mid + 1, last, best);
+}
+
+/*
+* Name: bestFittingTruck
+* Description: Finds the truck with the most capacity left that the shipment fits in
+*/
+int bestFittingTruck(const struct CapacityIndex* index, const struct Shipment* s, unsigned int mask) {
+    int best = -1;
+
+    if (index != NULL && s != NULL) {
+        findBest(index, s, mask, 1, 0, MAX_FLEET - 1, &best);
+    }
+    return best;
+}
+
+/*
+* Name: useCapacityIndex
+* Description: Lets assignShipment() skip full trucks and addShipmentToTruck() update the index
+*/
+void useCapacityIndex(struct CapacityIndex* index) {
+    activeCapacity = index;
+}
 
 /*
 * Name: addShipmentToTruck
@@ -176,13 +497,56 @@ int addShipmentToTruck(struct Truck* truck, const struct Shipment* shipment) {
     truck->cargo[truck->numShipments] = *shipment;
     truck->numShipments++;
 
-    // Update truck's current weight and volume
-    truck->currentWeight += shipment->weight;
-    truck->currentVolume += shipment->volume;
+    // Update truck's current weight and volume, summed in whole grams and units so nothing drifts
+    truck->currentWeight = (double)((long long)weightToGrams(truck->currentWeight) + weightToGrams(shipment->weight)) / GRAMS_PER_KG;
+    truck->currentVolume = (double)((long long)volumeToUnits(truck->currentVolume) + volumeToUnits(shipment->volume)) / VOLUME_UNITS_PER_M3;
+
+    // Keep the capacity index in use up to date if the truck is one of its trucks
+    if (activeCapacity != NULL && activeCapacity->numTrucks > 0) {
+        uintptr_t first = (uintptr_t)activeCapacity->trucks;
+        uintptr_t here = (uintptr_t)truck;
+        if (here >= first && here < first + activeCapacity->numTrucks * sizeof(struct Truck)) {
+            updateCapacityIndex(activeCapacity, (int)((here - first) / sizeof(struct Truck)));
+        }
+    }
 
     return 1;
 }
 
+/*
+* Name: findReachMasks
+* Description: Looks up the trucks on route and those that can reach a destination
+*/
+void findReachMasks(struct ReachMasks* masks, const struct Truck trucks[], int numTrucks, const struct Point destination, const struct Map* map) {
+    masks->onRoute = 0;
+    masks->reaching = ~0u;
+    if (activeFleet != NULL && activeFleetTrucks == trucks && activeFleet->numTrucks == numTrucks) {
+        masks->onRoute = trucksAtPoint(activeFleet, destination);
+    }
+    if (activeDestinations != NULL && activeDestinationTrucks == trucks && activeDestinationMap == map
+        && activeDestinations->numTrucks == numTrucks) {
+        masks->reaching = trucksReaching(activeDestinations, destination);
+        masks->onRoute &= masks->reaching;
+    }
+}
+
+/*
+* Name: reachDistance
+* Description: A truck's diversion, taken from the masks when they already tell
+*/
+double reachDistance(const struct ReachMasks* masks, const struct Truck trucks[], int i, const struct Point destination, const struct Map* map) {
+    // The masks only have bits for the first MAX_FLEET trucks
+    if (i < MAX_FLEET) {
+        if (!((masks->reaching >> i) & 1u)) {
+            return -1.0;
+        }
+        if ((masks->onRoute >> i) & 1u) {
+            return 0.0;
+        }
+    }
+    return calculateRouteDistance(&trucks[i], destination, map);
+}
+
 /*
 * Name: assignShipment
 * Author: Judd niemi
@@ -197,11 +561,50 @@ struct DeliveryResult assignShipment(struct Truck trucks[], int numTrucks, const
     }
 
     double bestDiversionDist = 999999.0;
-    double bestCapacityPercent = -1.0;
+    int bestCapacity = INT_MIN;
 
-    for (int i = 0; i < numTrucks; i++) {
+    // Trucks already passing the destination, and those whose route cannot reach it to pass over
+    struct ReachMasks masks;
+    findReachMasks(&masks, trucks, numTrucks, s->destination, map);
+
+    // With a capacity index for this fleet, trucks too full for the shipment are skipped in bulk
+    const struct CapacityIndex* capacity = NULL;
+    if (activeCapacity != NULL && activeCapacity->trucks == trucks && activeCapacity->numTrucks == numTrucks) {
+        capacity = activeCapacity;
+    }
+
+    // A truck already passing the destination needs no diversion, so the best of those that fits wins
+    int onRouteBest = (capacity != NULL && masks.onRoute != 0) ? bestFittingTruck(capacity, s, masks.onRoute) : -1;
+    if (onRouteBest >= 0) {
+        result.truckIndex = onRouteBest;
+        result.distanceToGo = 0.0;
+        result.needsDiversion = 0;
+    }
+    else if (capacity != NULL) {
+        // Score the whole fleet from the index's arrays; only trucks with room need a distance
+        unsigned int candidates = fittingTrucks(capacity, s) & masks.reaching;
+        double diversion[MAX_FLEET] = { 0 };
+        for (int t = 0; t < numTrucks; t++) {
+            if ((candidates >> t) & 1u) {
+                diversion[t] = reachDistance(&masks, trucks, t, s->destination, map);
+                if (diversion[t] < 0) {
+                    candidates &= ~(1u << t);
+                }
+            }
+        }
+
+        int best = bestScoredTruck(capacity, diversion, candidates);
+        if (best >= 0) {
+            result.truckIndex = best;
+            result.distanceToGo = diversion[best];
+            result.needsDiversion = (diversion[best] > 0.01) ? 1 : 0;  // small epsilon for floating point
+        }
+    }
+
+    // Without a capacity index every truck is checked in turn
+    for (int i = 0; capacity == NULL && i < numTrucks; i++) {
         // Can truck reach destination? Calculate diversion distance
-        double diversionDist = calculateRouteDistance(&trucks[i], s->destination, map);
+        double diversionDist = reachDistance(&masks, trucks, i, s->destination, map);
 
         if (diversionDist < 0) {
             // Can't reach destination, skip this truck
@@ -214,9 +617,7 @@ struct DeliveryResult assignShipment(struct Truck trucks[], int numTrucks, const
         }
 
         // Calculate % capacity left (by weight or volume, whichever is less)
-        double weightLeftPercent = (MAX_WEIGHT - trucks[i].currentWeight) / MAX_WEIGHT;
-        double volumeLeftPercent = (MAX_VOLUME - trucks[i].currentVolume) / MAX_VOLUME;
-        double capacityLeftPercent = (weightLeftPercent < volumeLeftPercent) ? weightLeftPercent : volumeLeftPercent;
+        int capacityLeft = capacityLeftShare(&trucks[i]);
 
         // Check if this truck is better by MS4 rules
         int isBetterTruck = 0;
@@ -225,10 +626,10 @@ struct DeliveryResult assignShipment(struct Truck trucks[], int numTrucks, const
             isBetterTruck = 1;
         }
         else if (diversionDist == bestDiversionDist) {
-            if (capacityLeftPercent > bestCapacityPercent) {
+            if (capacityLeft > bestCapacity) {
                 isBetterTruck = 1;
             }
-            else if (capacityLeftPercent == bestCapacityPercent) {
+            else if (capacityLeft == bestCapacity) {
                 if (trucks[i].truckNumber < (result.truckIndex >= 0 ? trucks[result.truckIndex].truckNumber : 3)) {
                     isBetterTruck = 1;
                 }
@@ -237,7 +638,7 @@ struct DeliveryResult assignShipment(struct Truck trucks[], int numTrucks, const
 
         if (isBetterTruck) {
             bestDiversionDist = diversionDist;
-            bestCapacityPercent = capacityLeftPercent;
+            bestCapacity = capacityLeft;
             result.truckIndex = i;
             result.distanceToGo = diversionDist;
             result.needsDiversion = (diversionDist > 0.01) ? 1 : 0;  // small epsilon for floating point
@@ -294,41 +695,175 @@ int parseDestination(const char* destStr, struct Point* point) {
     return 1;
 }
 
-void printDeliveryInfo(const struct Truck* truck, const struct DeliveryResult* result, const struct Map* map, const struct Point* shipmentDestination) {
+// Appends to the length characters already in buffer, keeping the total under size when it has to cut the text short
+static int appendText(char* buffer, int size, int length, const char* format, ...) {
+    va_list args;
+    int written = 0;
+
+    if (length < size - 1) {
+        va_start(args, format);
+        written = vsnprintf(buffer + length, size - length, format, args);
+        va_end(args);
+    }
+    if (written > 0) {
+        length += written;
+    }
+    return length < size - 1 ? length : size - 1;
+}
+
+/*
+* Name: formatDeliveryInfo
+* Description: Writes the lines printDeliveryInfo prints into a buffer
+*/
+int formatDeliveryInfo(char* buffer, int size, const struct Truck* truck, const struct DeliveryResult* result, const struct Map* map, const struct Point* shipmentDestination) {
     const char* colors[] = { "BLUE", "GREEN", "YELLOW" };
     const char* color = "UNKNOWN";
+    int length = 0;
 
     if (truck->truckNumber >= 0 && truck->truckNumber < 3) {
         color = colors[truck->truckNumber];
     }
 
-    printf("truckNumber=%d, needsDiversion=%d, color=%s\n", truck->truckNumber, result->needsDiversion, color);
+    buffer[0] = '\0';
+    length = appendText(buffer, size, length, "truckNumber=%d, needsDiversion=%d, color=%s\n", truck->truckNumber, result->needsDiversion, color);
 
-    if (!result->needsDiversion) {
-        printf("Ship on %s LINE, no diversion\n", color);
+    if (!result->needsDiversion || isOnRoute(truck, *shipmentDestination)) {
+        length = appendText(buffer, size, length, "Ship on %s LINE, no diversion\n", color);
     }
     else {
-        printf("Ship on %s LINE, divert: ", color);
-        // rest of your diversion printing code...
+        length = appendText(buffer, size, length, "Ship on %s LINE, divert: ", color);
+
+        // The route point the truck leaves from followed by every square of the diversion
+        struct Route diversion;
+        findDiversionInto(map, &truck->route, *shipmentDestination, &diversion);
+        int leaveFrom = getClosestRoutePoint(truck, *shipmentDestination);
+        if (leaveFrom >= 0) {
+            length = appendText(buffer, size, length, "%d%c", truck->route.points[leaveFrom].row, 'A' + truck->route.points[leaveFrom].col);
+        }
+        for (int i = 0; i < diversion.numPoints; i++) {
+            length = appendText(buffer, size, length, ", %d%c", diversion.points[i].row, 'A' + diversion.points[i].col);
+        }
+        length = appendText(buffer, size, length, "\n");
     }
+    return length;
+}
+
+void printDeliveryInfo(const struct Truck* truck, const struct DeliveryResult* result, const struct Map* map, const struct Point* shipmentDestination) {
+    char text[DELIVERY_INFO_SIZE];
+
+    formatDeliveryInfo(text, DELIVERY_INFO_SIZE, truck, result, map, shipmentDestination);
+    fputs(text, stdout);
 }
 
 
 
-int isValidDestination(const struct Point* dest, const struct Map* map) {
-    if (!dest || !map) return 0;
+/*
+* Name: buildDestinationTable
+* Description: Floods out from every route square over open squares to mark those that can be delivered to
+*/
+int buildDestinationTable(struct DestinationTable* table, const struct Map* map, const struct Truck trucks[], int numTrucks) {
+    static int area[MAP_ROWS * MAP_COLS];               // which open area each square is in, -1 if none
+    static unsigned int areaTrucks[MAP_ROWS * MAP_COLS];
+    static int queue[MAP_ROWS * MAP_COLS];
+    int numAreas = 0, tail = 0;
 
-    if (dest->row < 0 || dest->row >= map->numRows || dest->col < 0 || dest->col >= map->numCols) {
+    if (table == NULL) {
+        return 0;
+    }
+    table->numTrucks = 0;
+    for (int cell = 0; cell < MAP_ROWS * MAP_COLS; cell++) {
+        table->reachedBy[cell] = 0;
+        area[cell] = -1;
+    }
+    if (map == NULL || trucks == NULL || numTrucks <= 0) {
         return 0;
     }
+    table->numTrucks = numTrucks < MAX_FLEET ? numTrucks : MAX_FLEET;
+
+    // A route reaches every square of each open area it passes through, so each area is flooded
+    // once from the first open route square found in it, moving straight or diagonally
+    for (int t = 0; t < table->numTrucks; t++) {
+        for (int i = 0; i < trucks[t].route.numPoints; i++) {
+            struct Point p = trucks[t].route.points[i];
+            int cell = p.row * MAP_COLS + p.col;
+            int head = tail;
+
+            if (!isOpenSquare(map, p.row, p.col)) {
+                continue;
+            }
+            if (area[cell] < 0) {
+                area[cell] = numAreas;
+                areaTrucks[numAreas++] = 0;
+                queue[tail++] = cell;
+                while (head < tail) {
+                    int row = queue[head] / MAP_COLS, col = queue[head] % MAP_COLS;
+
+                    head++;
+                    for (int dr = -1; dr <= 1; dr++) {
+                        for (int dc = -1; dc <= 1; dc++) {
+                            int next = (row + dr) * MAP_COLS + col + dc;
+
+                            if (isOpenSquare(map, row + dr, col + dc) && area[next] < 0) {
+                                area[next] = area[cell];
+                                queue[tail++] = next;
+                            }
+                        }
+                    }
+                }
+            }
+            areaTrucks[area[cell]] |= 1u << t;
+        }
+    }
 
-    int cellValue = map->squares[dest->row][dest->col];
+    // Every flooded square, the queue holds each exactly once
+    for (int i = 0; i < tail; i++) {
+        table->reachedBy[queue[i]] = areaTrucks[area[queue[i]]];
+    }
+    return tail;
+}
 
-    if (cellValue == 'B') {  // or whatever value indicates blocked
+/*
+* Name: isDeliverable
+* Description: Looks a destination up in the table
+*/
+int isDeliverable(const struct DestinationTable* table, const struct Point point) {
+    // One unsigned comparison each catches negative rows and columns as well
+    if (table == NULL || (unsigned)point.row >= MAP_ROWS || (unsigned)point.col >= MAP_COLS) {
         return 0;
     }
+    return table->reachedBy[point.row * MAP_COLS + point.col] != 0;
+}
 
-    return 1;
+/*
+* Name: trucksReaching
+* Description: Looks up which trucks can deliver to a destination
+*/
+unsigned int trucksReaching(const struct DestinationTable* table, const struct Point point) {
+    if (table == NULL || (unsigned)point.row >= MAP_ROWS || (unsigned)point.col >= MAP_COLS) {
+        return 0;
+    }
+    return table->reachedBy[point.row * MAP_COLS + point.col];
+}
+
+/*
+* Name: useDestinationTable
+* Description: Sets the table isValidDestination() looks destinations up in
+*/
+void useDestinationTable(const struct DestinationTable* table, const struct Truck trucks[], const struct Map* map) {
+    activeDestinations = table;
+    activeDestinationTrucks = table != NULL ? trucks : NULL;
+    activeDestinationMap = table != NULL ? map : NULL;
+}
+
+int isValidDestination(const struct Point* dest, const struct Map* map) {
+    if (!dest || !map) return 0;
+
+    if (activeDestinations != NULL && activeDestinationMap == map) {
+        return isDeliverable(activeDestinations, *dest);
+    }
+
+    // Without a table, anywhere on the map that is not a building (1)
+    return isOpenSquare(map, dest->row, dest->col);
 }
 
 
@@ -0,0 +1,54 @@
+/*
+* Purpose: Shipment assignment policies generated from DEFINE_ASSIGN_POLICY
+*/
+
+#include <stdio.h>
+#include "assignpolicy.h"
+
+/*
+* Name: fillCandidate
+* Description: Fills in everything but the diversion for a truck that can take the shipment
+*/
+void fillCandidate(struct AssignCandidate* candidate, const struct Truck* truck, int index, const struct Shipment* s) {
+    candidate->index = index;
+    candidate->truckNumber = truck->truckNumber;
+    candidate->capacityLeft = capacityLeftShare(truck);
+    candidate->weightLeft = MAX_WEIGHT_G - weightToGrams(truck->currentWeight) - weightToGrams(s->weight);
+    candidate->volumeLeft = MAX_VOLUME_UNITS - volumeToUnits(truck->currentVolume) - volumeToUnits(s->volume);
+    candidate->numShipments = truck->numShipments;
+}
+
+/*
+* Name: commitAssignment
+* Description: Loads the shipment on the chosen truck and reports the result
+*/
+struct DeliveryResult commitAssignment(struct Truck trucks[], const struct AssignCandidate* best, const struct Shipment* s) {
+    struct DeliveryResult result = { 0, -1, 0, 0.0 };
+
+    if (trucks == NULL || best == NULL || best->index < 0) {
+        return result;
+    }
+
+    result.truckIndex = best->index;
+    result.distanceToGo = best->diversion;
+    result.needsDiversion = (best->diversion > 0.01) ? 1 : 0;  // small epsilon for floating point
+
+    if (addShipmentToTruck(&trucks[best->index], s)) {
+        result.success = 1;
+    }
+    return result;
+}
+
+DEFINE_ASSIGN_POLICY(assignMinDiversion, BETTER_MIN_DIVERSION)
+DEFINE_ASSIGN_POLICY(assignWeightFirst, BETTER_WEIGHT_FIRST)
+DEFINE_ASSIGN_POLICY(assignVolumeFirst, BETTER_VOLUME_FIRST)
+DEFINE_ASSIGN_POLICY(assignBalanced, BETTER_BALANCED)
+DEFINE_ASSIGN_POLICY(assignCostWeighted, BETTER_COST_WEIGHTED)
+
+const struct AssignPolicy assignPolicies[NUM_ASSIGN_POLICIES] = {
+    { "min-diversion", assignMinDiversion },
+    { "weight-first", assignWeightFirst },
+    { "volume-first", assignVolumeFirst },
+    { "balanced", assignBalanced },
+    { "cost-weighted", assignCostWeighted }
+};
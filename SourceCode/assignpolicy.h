@@ -0,0 +1,144 @@
+#ifndef ASSIGNPOLICY_H
+#define ASSIGNPOLICY_H
+
+#include "delivery.h"
+#include "mapping.h"
+#include "MS3FunctionSpecs.h"
+
+// Weights of the cost-weighted policy: cost = diversion * POLICY_DIVERSION_COST + share of capacity used * POLICY_CAPACITY_COST
+#ifndef POLICY_DIVERSION_COST
+#define POLICY_DIVERSION_COST 1.0
+#endif
+#ifndef POLICY_CAPACITY_COST
+#define POLICY_CAPACITY_COST 5.0
+#endif
+
+/**
+ * Everything a policy may compare about a truck that can take the shipment
+ */
+struct AssignCandidate {
+    int index;              // Position in the truck array, -1 if there is no candidate
+    int truckNumber;        // The truck's number, used to break ties
+    double diversion;       // Distance from the route, as calculateRouteDistance()
+    int capacityLeft;       // Share of capacity left, as capacityLeftShare()
+    int weightLeft;         // Grams left after the shipment is loaded
+    int volumeLeft;         // Half cubic metre units left after the shipment is loaded
+    int numShipments;       // Shipments already on the truck
+};
+
+/**
+ * An assignment function with the same contract as assignShipment()
+ */
+typedef struct DeliveryResult (*AssignFunction)(struct Truck trucks[], int numTrucks, const struct Shipment* s, const struct Map* map);
+
+/**
+ * A named policy so callers can pick one at run time
+ */
+struct AssignPolicy {
+    const char* name;
+    AssignFunction assign;
+};
+
+/*
+* Comparisons used by the built-in policies. Each is true when candidate c should replace best b.
+*/
+
+// The MS4 rules: shortest diversion, then most capacity left, then lowest truck number
+#define BETTER_MIN_DIVERSION(c, b) \
+    ((c).diversion < (b).diversion || ((c).diversion == (b).diversion && \
+    ((c).capacityLeft > (b).capacityLeft || ((c).capacityLeft == (b).capacityLeft && (c).truckNumber < (b).truckNumber))))
+
+// Tightest fit by weight, keeping the emptiest trucks for heavy shipments, then shortest diversion
+#define BETTER_WEIGHT_FIRST(c, b) \
+    ((c).weightLeft < (b).weightLeft || ((c).weightLeft == (b).weightLeft && \
+    ((c).diversion < (b).diversion || ((c).diversion == (b).diversion && (c).truckNumber < (b).truckNumber))))
+
+// Tightest fit by volume, then shortest diversion
+#define BETTER_VOLUME_FIRST(c, b) \
+    ((c).volumeLeft < (b).volumeLeft || ((c).volumeLeft == (b).volumeLeft && \
+    ((c).diversion < (b).diversion || ((c).diversion == (b).diversion && (c).truckNumber < (b).truckNumber))))
+
+// Spread the load: most capacity left, then fewest shipments, then shortest diversion
+#define BETTER_BALANCED(c, b) \
+    ((c).capacityLeft > (b).capacityLeft || ((c).capacityLeft == (b).capacityLeft && \
+    ((c).numShipments < (b).numShipments || ((c).numShipments == (b).numShipments && \
+    ((c).diversion < (b).diversion || ((c).diversion == (b).diversion && (c).truckNumber < (b).truckNumber))))))
+
+#define POLICY_COST(c) ((c).diversion * POLICY_DIVERSION_COST + \
+    (double)(CAPACITY_SCALE - (c).capacityLeft) / CAPACITY_SCALE * POLICY_CAPACITY_COST)
+
+// Lowest combined cost of the diversion and the capacity used, then lowest truck number
+#define BETTER_COST_WEIGHTED(c, b) \
+    (POLICY_COST(c) < POLICY_COST(b) || (POLICY_COST(c) == POLICY_COST(b) && (c).truckNumber < (b).truckNumber))
+
+/*
+* Name: DEFINE_ASSIGN_POLICY
+* Description: Defines an assignment function whose scoring loop has the comparison written
+*              straight into it, so nothing is called through a pointer per truck. The
+*              capacity check comes first because it is much cheaper than the distance, and the
+*              fleet index and destination table are used as assignShipment() uses them.
+* Parameters:
+*   - name: name of the function to define
+*   - IS_BETTER: macro taking (candidate, best) that is true when candidate should win
+*/
+#define DEFINE_ASSIGN_POLICY(name, IS_BETTER) \
+struct DeliveryResult name(struct Truck trucks[], int numTrucks, const struct Shipment* s, const struct Map* map) { \
+    struct AssignCandidate best = { -1, 0, 0.0, 0, 0, 0, 0 }; \
+    struct AssignCandidate candidate; \
+    struct ReachMasks masks; \
+    if (trucks == NULL || numTrucks <= 0 || s == NULL || map == NULL) { \
+        return commitAssignment(trucks, &best, s); \
+    } \
+    findReachMasks(&masks, trucks, numTrucks, s->destination, map); \
+    for (int i = 0; i < numTrucks; i++) { \
+        if (!canFitShipment(&trucks[i], s)) { \
+            continue; \
+        } \
+        candidate.diversion = reachDistance(&masks, trucks, i, s->destination, map); \
+        if (candidate.diversion < 0) { \
+            continue; \
+        } \
+        fillCandidate(&candidate, &trucks[i], i, s); \
+        if (best.index < 0 || (IS_BETTER(candidate, best))) { \
+            best = candidate; \
+        } \
+    } \
+    return commitAssignment(trucks, &best, s); \
+}
+
+/*
+* Name: fillCandidate
+* Description: Fills in everything but the diversion for a truck that can take the shipment
+* Parameters:
+*   - candidate: the candidate to fill in
+*   - truck: pointer to the truck
+*   - index: position of the truck in the array
+*   - s: pointer to the shipment
+* Returns: Nothing
+*/
+void fillCandidate(struct AssignCandidate* candidate, const struct Truck* truck, int index, const struct Shipment* s);
+
+/*
+* Name: commitAssignment
+* Description: Loads the shipment on the chosen truck and reports the result the same way
+*              assignShipment() does
+* Parameters:
+*   - trucks: array of truck structures
+*   - best: the chosen candidate, index -1 if there is none
+*   - s: pointer to the shipment
+* Returns: The delivery result, success 0 if there was no candidate
+*/
+struct DeliveryResult commitAssignment(struct Truck trucks[], const struct AssignCandidate* best, const struct Shipment* s);
+
+struct DeliveryResult assignMinDiversion(struct Truck trucks[], int numTrucks, const struct Shipment* s, const struct Map* map);
+struct DeliveryResult assignWeightFirst(struct Truck trucks[], int numTrucks, const struct Shipment* s, const struct Map* map);
+struct DeliveryResult assignVolumeFirst(struct Truck trucks[], int numTrucks, const struct Shipment* s, const struct Map* map);
+struct DeliveryResult assignBalanced(struct Truck trucks[], int numTrucks, const struct Shipment* s, const struct Map* map);
+struct DeliveryResult assignCostWeighted(struct Truck trucks[], int numTrucks, const struct Shipment* s, const struct Map* map);
+
+#define NUM_ASSIGN_POLICIES 5
+
+// The built-in policies, the MS4 rules first
+extern const struct AssignPolicy assignPolicies[NUM_ASSIGN_POLICIES];
+
+#endif
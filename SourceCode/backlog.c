@@ -0,0 +1,228 @@
+/*
+* Purpose: Shipments that ship tomorrow, kept from one day's run to the next
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include "backlog.h"
+#include "MS3FunctionSpecs.h"
+#include "platform.h"
+
+#define BACKLOG_PATH_SIZE 1024
+#define MAX_AGE 255                 // ages are kept in one byte, older shipments are saved as this old
+
+// The file is little endian whatever the machine, a byte at a time
+static void putWord(unsigned char* out, unsigned int value) {
+    out[0] = (unsigned char)(value & 0xff);
+    out[1] = (unsigned char)((value >> 8) & 0xff);
+    out[2] = (unsigned char)((value >> 16) & 0xff);
+    out[3] = (unsigned char)((value >> 24) & 0xff);
+}
+
+static unsigned int getWord(const unsigned char* in) {
+    return (unsigned int)in[0] | ((unsigned int)in[1] << 8) | ((unsigned int)in[2] << 16) | ((unsigned int)in[3] << 24);
+}
+
+// 32 bit FNV-1a of the packed records
+static unsigned int checksum(const unsigned char* bytes, size_t size) {
+    unsigned int hash = 2166136261u;
+
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void packEntry(unsigned char* out, const struct BacklogEntry* entry, int today) {
+    int age = today - entry->day;
+
+    putWord(out, (unsigned int)weightToGrams(entry->shipment.weight));
+    out[4] = (unsigned char)volumeToUnits(entry->shipment.volume);
+    out[5] = (unsigned char)entry->shipment.destination.row;
+    out[6] = (unsigned char)entry->shipment.destination.col;
+    out[7] = (unsigned char)(age < 0 ? 0 : (age > MAX_AGE ? MAX_AGE : age));
+}
+
+/*
+* Name: backlogInit
+* Description: Empties a backlog
+*/
+void backlogInit(struct Backlog* backlog, int today) {
+    if (backlog == NULL) {
+        return;
+    }
+    backlog->today = today;
+    backlog->count = 0;
+    backlog->kept = 0;
+    backlog->next = 0;
+    backlog->placed = 0;
+    backlog->dropped = 0;
+}
+
+/*
+* Name: backlogAdd
+* Description: Puts a shipment at the back of the backlog
+*/
+int backlogAdd(struct Backlog* backlog, const struct Shipment* s) {
+    if (backlog == NULL || s == NULL || backlog->count == BACKLOG_MAX) {
+        return 0;
+    }
+    backlog->entries[backlog->count].shipment = *s;
+    backlog->entries[backlog->count].day = backlog->today;
+    backlog->count++;
+    return 1;
+}
+
+/*
+* Name: backlogLoad
+* Description: Reads and unpacks a saved backlog
+*/
+int backlogLoad(struct Backlog* backlog, const char* path) {
+    unsigned char header[BACKLOG_HEADER_SIZE];
+    unsigned char* records;
+    unsigned int count, day;
+    FILE* input;
+    int whole;
+
+    if (backlog == NULL) {
+        return 0;
+    }
+    backlogInit(backlog, 1);
+    input = path == NULL ? NULL : fopen(path, "rb");
+    if (input == NULL) {
+        return 0;
+    }
+
+    // Written by this version and no more shipments than fit
+    if (fread(header, sizeof(header), 1, input) != 1 || getWord(header) != BACKLOG_MAGIC
+        || getWord(header + 4) != BACKLOG_VERSION || (count = getWord(header + 12)) > BACKLOG_MAX) {
+        fclose(input);
+        return 0;
+    }
+    day = getWord(header + 8);
+
+    // Every record in one read, then checked before any of it is used
+    records = (unsigned char*)malloc((size_t)count * BACKLOG_RECORD_SIZE + 1);
+    whole = records != NULL && fread(records, BACKLOG_RECORD_SIZE, count, input) == count
+        && fgetc(input) == EOF && checksum(records, (size_t)count * BACKLOG_RECORD_SIZE) == getWord(header + 16);
+    fclose(input);
+    if (!whole) {
+        free(records);
+        return 0;
+    }
+
+    backlog->today = (int)day + 1;
+    for (unsigned int i = 0; i < count; i++) {
+        const unsigned char* record = records + (size_t)i * BACKLOG_RECORD_SIZE;
+        struct BacklogEntry* entry = &backlog->entries[i];
+
+        entry->shipment.weight = (double)getWord(record) / GRAMS_PER_KG;
+        entry->shipment.volume = (double)record[4] / VOLUME_UNITS_PER_M3;
+        entry->shipment.destination.row = (char)record[5];
+        entry->shipment.destination.col = (char)record[6];
+        entry->day = (int)day - record[7];
+    }
+    backlog->count = (int)count;
+    free(records);
+    return 1;
+}
+
+/*
+* Name: backlogSave
+* Description: Packs the waiting shipments and writes them to a new file
+*/
+int backlogSave(const struct Backlog* backlog, const char* path) {
+    unsigned char header[BACKLOG_HEADER_SIZE];
+    char temporary[BACKLOG_PATH_SIZE];
+    unsigned char* records;
+    FILE* output;
+    int count, n = 0, written;
+
+    if (backlog == NULL || path == NULL) {
+        return 0;
+    }
+    if (snprintf(temporary, sizeof(temporary), "%s.tmp", path) >= (int)sizeof(temporary)) {
+        return 0;
+    }
+
+    // Those tried and kept on this pass, then those still to try
+    count = backlog->kept + (backlog->count - backlog->next);
+    records = (unsigned char*)malloc((size_t)count * BACKLOG_RECORD_SIZE + 1);
+    if (records == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < backlog->kept; i++) {
+        packEntry(records + (size_t)n++ * BACKLOG_RECORD_SIZE, &backlog->entries[i], backlog->today);
+    }
+    for (int i = backlog->next; i < backlog->count; i++) {
+        packEntry(records + (size_t)n++ * BACKLOG_RECORD_SIZE, &backlog->entries[i], backlog->today);
+    }
+
+    putWord(header, BACKLOG_MAGIC);
+    putWord(header + 4, BACKLOG_VERSION);
+    putWord(header + 8, (unsigned int)backlog->today);
+    putWord(header + 12, (unsigned int)count);
+    putWord(header + 16, checksum(records, (size_t)count * BACKLOG_RECORD_SIZE));
+
+    output = fopen(temporary, "wb");
+    written = output != NULL && fwrite(header, sizeof(header), 1, output) == 1
+        && (count == 0 || fwrite(records, (size_t)count * BACKLOG_RECORD_SIZE, 1, output) == 1)
+        && syncFile(output);
+    if (output != NULL && fclose(output) != 0) {
+        written = 0;
+    }
+    free(records);
+
+    if (!written || !replaceFile(temporary, path)) {
+        remove(temporary);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+* Name: assignBacklog
+* Description: Tries the next batch of carried shipments, oldest first
+*/
+int assignBacklog(struct Backlog* backlog, struct Truck trucks[], int numTrucks, const struct Map* map, int maxShipments) {
+    struct Shipment smallest = { 1, 0.5, { 0, 0 } };
+    int tried = 0, room = 0;
+
+    if (backlog == NULL || trucks == NULL || map == NULL || backlog->next >= backlog->count) {
+        return 0;
+    }
+
+    // With every truck too full for the smallest box, nothing else can be placed today either
+    for (int t = 0; t < numTrucks && !room; t++) {
+        room = canFitShipment(&trucks[t], &smallest);
+    }
+
+    while (room && tried < maxShipments && backlog->next < backlog->count) {
+        struct BacklogEntry entry = backlog->entries[backlog->next++];
+        struct DeliveryResult result;
+
+        tried++;
+        if (!isValidDestination(&entry.shipment.destination, map)) {
+            backlog->dropped++;
+            continue;
+        }
+        result = assignShipment(trucks, numTrucks, &entry.shipment, map);
+        if (result.success) {
+            backlog->placed++;
+        }
+        else {
+            backlog->entries[backlog->kept++] = entry;
+        }
+    }
+
+    // At the end of the pass the ones kept close up to those not tried
+    if (!room || backlog->next == backlog->count) {
+        while (backlog->next < backlog->count) {
+            backlog->entries[backlog->kept++] = backlog->entries[backlog->next++];
+        }
+        backlog->count = backlog->kept;
+        backlog->next = backlog->count;
+    }
+    return tried;
+}
@@ -0,0 +1,102 @@
+#ifndef BACKLOG_H
+#define BACKLOG_H
+
+#include "delivery.h"
+#include "mapping.h"
+
+#ifndef BACKLOG_MAX
+#define BACKLOG_MAX 16384
+#endif
+#define BACKLOG_BATCH 256           // carried shipments assignBacklog() places per call
+#define BACKLOG_MAGIC 0x474c4b42u   // "BKLG" when read from the start of the file
+#define BACKLOG_VERSION 1
+#define BACKLOG_HEADER_SIZE 20      // bytes: magic, version, day, count and checksum, 4 each
+#define BACKLOG_RECORD_SIZE 8       // bytes: grams 4, volume units 1, row 1, column 1, age in days 1
+
+/**
+ * A shipment that could not be placed on the day it came in
+ */
+struct BacklogEntry {
+    struct Shipment shipment;
+    int day;                        // the day it first came in
+};
+
+/**
+ * Shipments waiting for a later day, oldest first. Shipments that are carried over keep their
+ * place ahead of those added since, so the array stays in order of age without sorting.
+ * Entries before kept have been tried on this pass and stay; entries from next on are still to try.
+ */
+struct Backlog {
+    int today;                      // the day being run
+    int count;
+    int kept;
+    int next;
+    int placed;                     // carried shipments placed so far today
+    int dropped;                    // carried shipments dropped today as their destination is not valid
+    struct BacklogEntry entries[BACKLOG_MAX];
+};
+
+/*
+* Name: backlogInit
+* Description: Empties a backlog
+* Parameters:
+*   - backlog: the backlog
+*   - today: the day being run
+* Returns: Nothing
+*/
+void backlogInit(struct Backlog* backlog, int today);
+
+/*
+* Name: backlogAdd
+* Description: Puts a shipment at the back of the backlog as having come in today
+* Parameters:
+*   - backlog: the backlog
+*   - s: pointer to the shipment
+* Returns: 1 if it was added, 0 if the backlog is full
+*/
+int backlogAdd(struct Backlog* backlog, const struct Shipment* s);
+
+/*
+* Name: backlogLoad
+* Description: Reads a backlog saved by backlogSave() in one read and unpacks it. The day being
+*              run becomes the day after the one it was saved on.
+* Parameters:
+*   - backlog: filled in with the saved shipments
+*   - path: the backlog file
+* Returns: 1 if the file was read, 0 if it is missing or damaged, in which case the backlog is
+*          left empty on day 1
+*/
+int backlogLoad(struct Backlog* backlog, const char* path);
+
+/*
+* Name: backlogSave
+* Description: Packs the shipments still waiting into 8 bytes each behind a short header with a
+*              checksum, and writes them beside path and syncs them to the disk before renaming over
+*              it, so the old file stays whole until the new one is complete. Shipments already tried on an unfinished pass
+*              are saved ahead of those not yet tried, as they are older.
+* Parameters:
+*   - backlog: the backlog
+*   - path: the backlog file
+* Returns: 1 if the file was written, 0 otherwise
+*/
+int backlogSave(const struct Backlog* backlog, const char* path);
+
+/*
+* Name: assignBacklog
+* Description: Tries the next batch of carried shipments, oldest first, with assignShipment().
+*              Those placed leave the backlog and the rest keep their order. Those whose
+*              destination isValidDestination() turns down, e.g. a square no route reaches any
+*              more, are dropped without being tried. Once no truck can take even the smallest
+*              box the rest of the pass is skipped without trying them. Call it until it returns
+*              0 to finish a pass; the morning's intake can be let in between batches.
+* Parameters:
+*   - backlog: the backlog
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks in the array
+*   - map: pointer to the map
+*   - maxShipments: the most shipments to try in this call, e.g. BACKLOG_BATCH
+* Returns: The number of shipments tried, 0 once the pass is finished
+*/
+int assignBacklog(struct Backlog* backlog, struct Truck trucks[], int numTrucks, const struct Map* map, int maxShipments);
+
+#endif
@@ -0,0 +1,276 @@
+#include <math.h>
+#include "citygen.h"
+#include "pathing.h"
+#include "MS3FunctionSpecs.h"
+
+#define CELL(row, col) ((row) * MAP_COLS + (col))
+#define CELL_ROW(cell) ((cell) / MAP_COLS)
+#define CELL_COL(cell) ((cell) % MAP_COLS)
+
+// down, right, up and left, with how much more likely a route is to take each at a crossing
+static const int stepRow[4] = { 1, 0, -1, 0 };
+static const int stepCol[4] = { 0, 1, 0, -1 };
+static const int stepPreference[4] = { 3, 3, 1, 1 };
+
+void seedCityRandom(struct CityRandom* random, const unsigned int seed)
+{
+	random->state = 0x9E3779B97F4A7C15ULL ^ seed;
+}
+
+/*
+* Step a 64 bit linear congruential generator and return the better mixed high bits.
+*/
+static unsigned int nextBits(struct CityRandom* random)
+{
+	random->state = random->state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (unsigned int)(random->state >> 33);
+}
+
+int cityRandomBelow(struct CityRandom* random, const int limit)
+{
+	return limit > 1 ? (int)(nextBits(random) % (unsigned int)limit) : 0;
+}
+
+double cityRandomUnit(struct CityRandom* random)
+{
+	return nextBits(random) / 2147483648.0;
+}
+
+/*
+* Mark every street in one direction: the first at 0 and the next one a block further on each time.
+*/
+static void layStreets(char street[], const int length, const struct CityConfig* config, struct CityRandom* random)
+{
+	int at, block;
+
+	for (at = 0; at < length; at++)
+	{
+		street[at] = 0;
+	}
+	for (at = 0; at < length; at += block + 1)
+	{
+		street[at] = 1;
+		block = config->blockSize + cityRandomBelow(random, 2 * config->blockJitter + 1) - config->blockJitter;
+		if (block < 1) block = 1;
+	}
+}
+
+void generateCity(struct City* city, const struct CityConfig* config)
+{
+	struct CityRandom random;
+	int rows = config->rows < 1 ? 1 : config->rows > MAP_ROWS ? MAP_ROWS : config->rows;
+	int cols = config->cols < 1 ? 1 : config->cols > MAP_COLS ? MAP_COLS : config->cols;
+	int lot = config->lotSize < 1 ? 1 : config->lotSize;
+	int r, c, lotRow, lotCol, built;
+
+	seedCityRandom(&random, config->seed);
+	for (r = 0; r < MAP_ROWS; r++)
+	{
+		for (c = 0; c < MAP_COLS; c++)
+		{
+			city->map.squares[r][c] = 0;
+		}
+	}
+	city->map.numRows = rows;
+	city->map.numCols = cols;
+	layStreets(city->streetRow, rows, config, &random);
+	layStreets(city->streetCol, cols, config, &random);
+	for (r = rows; r < MAP_ROWS; r++) city->streetRow[r] = 0;
+	for (c = cols; c < MAP_COLS; c++) city->streetCol[c] = 0;
+
+	for (lotRow = 0; lotRow < rows; lotRow += lot)
+	{
+		for (lotCol = 0; lotCol < cols; lotCol += lot)
+		{
+			built = cityRandomBelow(&random, 100) < config->percentBuilt;
+			for (r = lotRow; r < lotRow + lot && r < rows; r++)
+			{
+				for (c = lotCol; c < lotCol + lot && c < cols; c++)
+				{
+					if (!city->streetRow[r] && !city->streetCol[c]) city->map.squares[r][c] = built;
+				}
+			}
+		}
+	}
+}
+
+/*
+* Count the squares from a square along a street to the next crossing, or to the edge of the city.
+* Returns 0 if there is no street that way or it runs into a square the route already passes.
+*/
+static int segmentLength(const struct City* city, int row, int col, const int step, const char visited[])
+{
+	int length = 0;
+
+	if (stepRow[step] != 0 ? !city->streetCol[col] : !city->streetRow[row]) return 0;
+	while (1)
+	{
+		row += stepRow[step];
+		col += stepCol[step];
+		if (row < 0 || row >= city->map.numRows || col < 0 || col >= city->map.numCols) return length;
+		if (visited[CELL(row, col)]) return 0;
+		length++;
+		if (city->streetRow[row] && city->streetCol[col]) return length;
+	}
+}
+
+int generateRoute(struct Route* route, const struct City* city, const int maxLength, const char symbol, struct CityRandom* random)
+{
+	static char visited[MAP_CELLS];	// like the search scratch in pathing.c, one route is made at a time
+	int limit = maxLength > MAX_ROUTE ? MAX_ROUTE : maxLength;
+	int weight[4], length[4];
+	int row = 0, col = 0, total, pick, step, i;
+
+	route->numPoints = 0;
+	route->routeSymbol = symbol;
+	if (limit <= 0) return 0;
+
+	for (i = 0; i < MAP_CELLS; i++)
+	{
+		visited[i] = 0;
+	}
+	addPointToRoute(route, row, col);
+	visited[CELL(row, col)] = 1;
+
+	while (route->numPoints < limit)
+	{
+		total = 0;
+		for (step = 0; step < 4; step++)
+		{
+			length[step] = segmentLength(city, row, col, step, visited);
+			weight[step] = length[step] > 0 ? stepPreference[step] : 0;
+			total += weight[step];
+		}
+		if (total == 0) break;
+
+		pick = cityRandomBelow(random, total);
+		for (step = 0; pick >= weight[step]; step++)
+		{
+			pick -= weight[step];
+		}
+		for (i = 0; i < length[step] && route->numPoints < limit; i++)
+		{
+			row += stepRow[step];
+			col += stepCol[step];
+			addPointToRoute(route, row, col);
+			visited[CELL(row, col)] = 1;
+		}
+	}
+	return route->numPoints;
+}
+
+void generateFleet(struct Truck trucks[], const int numTrucks, const struct City* city, const int routeLength, const unsigned int seed)
+{
+	static const char symbols[3] = { BLUE, GREEN, YELLOW };
+	struct CityRandom random;
+	struct Truck empty = { 0 };
+	int i;
+
+	seedCityRandom(&random, seed);
+	for (i = 0; i < numTrucks; i++)
+	{
+		trucks[i] = empty;
+		generateRoute(&trucks[i].route, city, routeLength, symbols[i % 3], &random);
+		trucks[i].truckNumber = i;
+		indexRoute(&trucks[i]);
+	}
+}
+
+int startWorkload(struct Workload* workload, const struct WorkloadConfig* config, const struct Map* map)
+{
+	int r, c, i, j, swap;
+
+	workload->config = *config;
+	seedCityRandom(&workload->random, config->seed);
+	workload->numCells = 0;
+	for (r = 0; r < map->numRows; r++)
+	{
+		for (c = 0; c < map->numCols; c++)
+		{
+			if (isOpenSquare(map, r, c)) workload->cells[workload->numCells++] = CELL(r, c);
+		}
+	}
+	if (workload->numCells == 0) return 0;
+
+	if (config->model == DESTINATIONS_ZIPF)
+	{
+		// a random ranking, so the most popular squares are not all in the top left corner
+		for (i = workload->numCells - 1; i > 0; i--)
+		{
+			j = cityRandomBelow(&workload->random, i + 1);
+			swap = workload->cells[i];
+			workload->cells[i] = workload->cells[j];
+			workload->cells[j] = swap;
+		}
+		for (i = 0; i < workload->numCells; i++)
+		{
+			workload->cumulative[i] = (i > 0 ? workload->cumulative[i - 1] : 0.0) + 1.0 / pow(i + 1.0, config->zipfExponent);
+		}
+	}
+	else if (config->model == DESTINATIONS_HOTSPOTS)
+	{
+		if (workload->config.numHotspots < 1) workload->config.numHotspots = 1;
+		if (workload->config.numHotspots > MAX_HOTSPOTS) workload->config.numHotspots = MAX_HOTSPOTS;
+		for (i = 0; i < workload->config.numHotspots; i++)
+		{
+			workload->hotspots[i] = workload->cells[cityRandomBelow(&workload->random, workload->numCells)];
+		}
+	}
+	return workload->numCells;
+}
+
+/*
+* Draw a square near a hotspot, closer ones more likely. Falls back to the hotspot itself if a few
+* tries only land on buildings or off the map.
+*/
+static int nearHotspot(struct Workload* workload, const struct Map* map, const int hotspot)
+{
+	int radius = workload->config.hotspotRadius < 0 ? 0 : workload->config.hotspotRadius;
+	int tries, row, col;
+
+	for (tries = 0; tries < 16; tries++)
+	{
+		row = CELL_ROW(hotspot) + (cityRandomBelow(&workload->random, 2 * radius + 1) + cityRandomBelow(&workload->random, 2 * radius + 1)) / 2 - radius;
+		col = CELL_COL(hotspot) + (cityRandomBelow(&workload->random, 2 * radius + 1) + cityRandomBelow(&workload->random, 2 * radius + 1)) / 2 - radius;
+		if (isOpenSquare(map, row, col)) return CELL(row, col);
+	}
+	return hotspot;
+}
+
+void nextShipment(struct Workload* workload, const struct Map* map, struct Shipment* shipment)
+{
+	int maxWeight = workload->config.maxWeight < 1 ? 1 : workload->config.maxWeight;
+	int kind = cityRandomBelow(&workload->random, 10);
+	int cell, low, high, middle;
+	double target;
+
+	shipment->weight = floor(exp(cityRandomUnit(&workload->random) * log(maxWeight + 1.0)));
+	if (shipment->weight < 1) shipment->weight = 1;
+	if (shipment->weight > maxWeight) shipment->weight = maxWeight;
+	shipment->volume = kind < 6 ? 0.5 : kind < 9 ? 2.0 : 5.0;
+
+	if (workload->config.model == DESTINATIONS_ZIPF)
+	{
+		// the first rank whose running total passes a point drawn along the whole total
+		target = cityRandomUnit(&workload->random) * workload->cumulative[workload->numCells - 1];
+		low = 0;
+		high = workload->numCells - 1;
+		while (low < high)
+		{
+			middle = (low + high) / 2;
+			if (workload->cumulative[middle] > target) high = middle;
+			else low = middle + 1;
+		}
+		cell = workload->cells[low];
+	}
+	else if (workload->config.model == DESTINATIONS_HOTSPOTS && cityRandomBelow(&workload->random, 100) < workload->config.hotspotShare)
+	{
+		cell = nearHotspot(workload, map, workload->hotspots[cityRandomBelow(&workload->random, workload->config.numHotspots)]);
+	}
+	else
+	{
+		cell = workload->cells[cityRandomBelow(&workload->random, workload->numCells)];
+	}
+	shipment->destination.row = (char)CELL_ROW(cell);
+	shipment->destination.col = (char)CELL_COL(cell);
+}
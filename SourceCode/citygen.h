@@ -0,0 +1,156 @@
+#ifndef CITYGEN_H
+#define CITYGEN_H
+
+#include "mapping.h"
+#include "pathing.h"
+#include "delivery.h"
+
+// the most hotspots a workload can draw destinations around
+#ifndef MAX_HOTSPOTS
+#define MAX_HOTSPOTS 32
+#endif
+
+/**
+* A small seedable random number generator, so a generated city and workload can be made again exactly
+* from the same seed on any compiler.
+*/
+struct CityRandom
+{
+	unsigned long long state;
+};
+
+/**
+* How to lay out a generated city. The city is a grid of streets running the full width and height of
+* the map, with row 0 and column 0 always streets. The blocks between them are cut into square lots,
+* each of which is built on or left open.
+*/
+struct CityConfig
+{
+	int rows;			// at most MAP_ROWS
+	int cols;			// at most MAP_COLS
+	int blockSize;		// usual number of squares between two streets
+	int blockJitter;	// blocks are up to this many squares larger or smaller than blockSize
+	int lotSize;		// lots are this many squares on a side
+	int percentBuilt;	// chance out of 100 that a lot is built on
+	unsigned int seed;
+};
+
+/**
+* A generated city: the map and which of its rows and columns are streets.
+*/
+struct City
+{
+	struct Map map;
+	char streetRow[MAP_ROWS];	// true if the whole row is a street
+	char streetCol[MAP_COLS];	// true if the whole column is a street
+};
+
+/**
+* Where the destinations of a generated workload are drawn from.
+*/
+enum DestinationModel
+{
+	DESTINATIONS_UNIFORM,	// every open square equally likely
+	DESTINATIONS_HOTSPOTS,	// most shipments go near a few busy squares, the rest anywhere
+	DESTINATIONS_ZIPF		// open squares ranked in a random order, the square of rank k drawn in proportion to 1 / k^s
+};
+
+/**
+* How to generate a stream of shipments.
+*/
+struct WorkloadConfig
+{
+	enum DestinationModel model;
+	int numHotspots;		// DESTINATIONS_HOTSPOTS: number of busy squares, at most MAX_HOTSPOTS
+	int hotspotRadius;		// DESTINATIONS_HOTSPOTS: how far from a busy square its shipments land
+	int hotspotShare;		// DESTINATIONS_HOTSPOTS: percent of shipments that go near a busy square
+	double zipfExponent;	// DESTINATIONS_ZIPF: s, 1.0 is the classic Zipf distribution
+	int maxWeight;			// weights are spread evenly on a log scale from 1 to this many kilograms
+	unsigned int seed;
+};
+
+/**
+* The state of a shipment stream. It holds every open square of the map, so keep it static or allocated.
+*/
+struct Workload
+{
+	struct WorkloadConfig config;
+	struct CityRandom random;
+	int numCells;						// open squares a shipment can go to
+	int cells[MAP_CELLS];				// those squares as row * MAP_COLS + col, in rank order for DESTINATIONS_ZIPF
+	double cumulative[MAP_CELLS];		// DESTINATIONS_ZIPF: total weight of the squares up to each rank
+	int hotspots[MAX_HOTSPOTS];			// DESTINATIONS_HOTSPOTS: the busy squares
+};
+
+/**
+* Start a random number generator.
+* @param random - the generator
+* @param seed - the seed; the same seed always gives the same numbers
+*/
+void seedCityRandom(struct CityRandom* random, const unsigned int seed);
+
+/**
+* Draw a random number.
+* @param random - the generator
+* @param limit - one more than the largest number wanted, greater than 0
+* @returns - a number from 0 to limit - 1.
+*/
+int cityRandomBelow(struct CityRandom* random, const int limit);
+
+/**
+* Draw a random fraction.
+* @param random - the generator
+* @returns - a number from 0 up to but not including 1.
+*/
+double cityRandomUnit(struct CityRandom* random);
+
+/**
+* Lay out a city of streets and built-on lots.
+* @param city - the city to fill in
+* @param config - the size, density and seed of the city
+*/
+void generateCity(struct City* city, const struct CityConfig* config);
+
+/**
+* Make a route that follows the streets from the top left corner, choosing a new direction at each
+* crossing and never passing the same square twice. Turns down and to the right are favoured so routes
+* spread out across the city rather than doubling back.
+* @param route - where to write the route
+* @param city - the city to drive through
+* @param maxLength - the most points the route may have, at most MAX_ROUTE
+* @param symbol - the route symbol to give it
+* @param random - the generator to draw the turns from
+* @returns - the number of points in the route.
+*/
+int generateRoute(struct Route* route, const struct City* city, const int maxLength, const char symbol, struct CityRandom* random);
+
+/**
+* Make an empty fleet with a generated route for each truck. Route symbols take turns between BLUE,
+* GREEN and YELLOW and trucks are numbered from 0.
+* @param trucks - the trucks to fill in
+* @param numTrucks - the number of trucks
+* @param city - the city to drive through
+* @param routeLength - the most points each route may have, at most MAX_ROUTE
+* @param seed - the seed for the routes
+*/
+void generateFleet(struct Truck trucks[], const int numTrucks, const struct City* city, const int routeLength, const unsigned int seed);
+
+/**
+* Start a stream of shipments to the open squares of a map.
+* @param workload - the stream to start
+* @param config - the destination model, weights and seed
+* @param map - the map the shipments are delivered on
+* @returns - the number of open squares shipments can go to; no shipments can be made if it is 0.
+*/
+int startWorkload(struct Workload* workload, const struct WorkloadConfig* config, const struct Map* map);
+
+/**
+* Make the next shipment in a stream. Weights are between 1 and the configured maximum, mostly small;
+* volumes are 0.5, 2 or 5 cubic metres with the small boxes most common.
+* @param workload - a stream started with startWorkload()
+* @param map - the same map the stream was started with
+* @param shipment - where to write the shipment
+*/
+void nextShipment(struct Workload* workload, const struct Map* map, struct Shipment* shipment);
+
+#endif
@@ -0,0 +1,191 @@
+/*
+* Generated by Tools/gentables.c from the course map and routes in mapping.c. Do not edit;
+* run the generator again instead.
+*/
+
+#include "coursetables.h"
+
+#if MAP_ROWS != 25 || MAP_COLS != 25 || MAX_ROUTE != 100
+#error "coursetables.c was generated for a 25x25 map with routes of up to 100 points"
+#endif
+
+const struct Truck courseTrucks[NUM_TRUCKS] = {
+    {
+        .route = {
+            {
+                { 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 }, { 4, 1 }, { 4, 2 }, { 4, 3 }, { 4, 4 }, { 4, 5 },
+                { 4, 6 }, { 4, 7 }, { 4, 8 }, { 4, 9 }, { 5, 9 }, { 6, 9 }, { 7, 9 }, { 8, 9 }, { 9, 9 }, { 10, 9 },
+                { 10, 10 }, { 11, 10 }, { 12, 10 }, { 13, 10 }, { 14, 10 }, { 15, 10 }, { 16, 10 }, { 17, 10 }, { 17, 11 }, { 17, 12 },
+                { 17, 13 }, { 17, 14 }, { 17, 15 }, { 17, 16 }, { 17, 17 }, { 17, 18 }, { 17, 19 }, { 17, 20 }, { 17, 21 }, { 17, 22 },
+                { 17, 23 }, { 17, 24 }
+            },
+            42, 2
+        },
+        .truckNumber = 0,
+        .routeCells = {
+            0x02000001u, 0x00040000u, 0x00000800u, 0x00003ff0u, 0x80000040u, 0x01000000u,
+            0x00020000u, 0x00000400u, 0x20000018u, 0x00400000u, 0x00008000u, 0x00000100u,
+            0x04000002u, 0xfff80000u, 0x00000003u, 0x00000000u, 0x00000000u, 0x00000000u,
+            0x00000000u, 0x00000000u
+        },
+        .routeIndexed = 1,
+        .segments = {
+            { { 0, 0 }, 1, 0, 5 },
+            { { 4, 1 }, 0, 1, 9 },
+            { { 5, 9 }, 1, 0, 6 },
+            { { 10, 10 }, 1, 0, 8 },
+            { { 17, 11 }, 0, 1, 14 }
+        },
+        .numSegments = 5
+    },
+    {
+        .route = {
+            {
+                { 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 }, { 4, 1 }, { 4, 2 }, { 4, 3 }, { 4, 4 }, { 4, 5 },
+                { 4, 6 }, { 4, 7 }, { 4, 8 }, { 4, 9 }, { 4, 10 }, { 4, 11 }, { 3, 11 }, { 2, 11 }, { 1, 11 }, { 0, 11 },
+                { 0, 12 }, { 0, 13 }, { 0, 14 }, { 0, 15 }, { 0, 16 }, { 0, 17 }, { 0, 18 }, { 0, 19 }, { 1, 19 }, { 2, 19 },
+                { 3, 19 }, { 4, 19 }, { 5, 19 }, { 6, 19 }, { 7, 19 }, { 8, 19 }, { 9, 19 }, { 9, 20 }, { 9, 21 }, { 9, 22 },
+                { 9, 23 }, { 9, 24 }
+            },
+            42, 4
+        },
+        .truckNumber = 1,
+        .routeCells = {
+            0x020ff801u, 0x20041010u, 0x40400820u, 0x0080fff0u, 0x00010000u, 0x00000200u,
+            0x08000004u, 0x03f00000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u,
+            0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u,
+            0x00000000u, 0x00000000u
+        },
+        .routeIndexed = 1,
+        .segments = {
+            { { 0, 0 }, 1, 0, 5 },
+            { { 4, 1 }, 0, 1, 11 },
+            { { 3, 11 }, -1, 0, 4 },
+            { { 0, 12 }, 0, 1, 8 },
+            { { 1, 19 }, 1, 0, 9 },
+            { { 9, 20 }, 0, 1, 5 }
+        },
+        .numSegments = 6
+    },
+    {
+        .route = {
+            {
+                { 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 }, { 4, 1 }, { 4, 2 }, { 4, 3 }, { 5, 3 }, { 6, 3 },
+                { 7, 3 }, { 8, 3 }, { 9, 3 }, { 9, 2 }, { 9, 1 }, { 10, 1 }, { 11, 1 }, { 12, 1 }, { 13, 1 }, { 14, 1 },
+                { 15, 1 }, { 16, 1 }, { 17, 1 }, { 18, 1 }, { 19, 1 }, { 19, 2 }, { 19, 3 }, { 19, 4 }, { 19, 5 }, { 19, 6 },
+                { 19, 7 }, { 19, 8 }, { 19, 9 }, { 19, 10 }, { 19, 11 }, { 19, 12 }, { 19, 13 }, { 19, 14 }, { 19, 15 }, { 19, 16 },
+                { 19, 17 }, { 19, 18 }, { 19, 19 }, { 19, 20 }, { 19, 21 }, { 19, 22 }, { 19, 23 }, { 19, 24 }
+            },
+            48, 8
+        },
+        .truckNumber = 2,
+        .routeCells = {
+            0x02000001u, 0x00040000u, 0x00000800u, 0x000000f0u, 0x02000001u, 0x00040000u,
+            0x00000800u, 0x0800001cu, 0x00100000u, 0x00002000u, 0x80000040u, 0x01000000u,
+            0x00020000u, 0x00000400u, 0xf0000008u, 0x000fffffu, 0x00000000u, 0x00000000u,
+            0x00000000u, 0x00000000u
+        },
+        .routeIndexed = 1,
+        .segments = {
+            { { 0, 0 }, 1, 0, 5 },
+            { { 4, 1 }, 0, 1, 3 },
+            { { 5, 3 }, 1, 0, 5 },
+            { { 9, 2 }, 0, -1, 2 },
+            { { 10, 1 }, 1, 0, 10 },
+            { { 19, 2 }, 0, 1, 23 }
+        },
+        .numSegments = 6
+    }
+};
+
+const struct MoveTable courseMoves = {
+    {
+         48, 88,152, 40, 72,144, 48, 88,152,184,248,248,248,248,248,120, 88,152,184,120, 88,152,184,248,104,   // 0
+         37, 79,151, 35, 74,148, 37, 79,151, 55,223, 63, 95,159,191,111, 79,151,183,111, 79,151,183,255,107,   // 1
+        161,234,244,225,234,244,225,234,244,229,255,231,239,247,247,235,234,244,245,235,234,244,245,255,107,   // 2
+        177,250,252,249,250,252,249,250,252,249,254,249,250,252,253,251,250,252,253,251,250,252,253,255,107,   // 3
+        181,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,107,   // 4
+         21,159,191,127, 95,159, 63, 95,159,191,255,255,255,255,127,223, 63, 95,159,191,255,255,255,255,107,   // 5
+          5,151,183,111, 79,151, 39,207,183,119, 95, 31,159,191,111,223,167,111,215,183,255,127, 95, 31, 11,   // 6
+        160,244,245,235,234,244, 97,218,180,109, 79,  7,151,183,107,222,177,106,220,181,255,111, 79,  7,  3,   // 7
+        176,252,253,251,250,252,233,254,245,235,234,224,244,245,235,254,245,235,254,245,255,235,234,224, 96,   // 8
+        181,255,255,255,255,255,251,254,253,251,250,248,252,253,251,254,253,251,254,253,255,251,250,248,104,   // 9
+        149, 63, 95, 31,159,191,255,255,255,255,127, 95, 31, 31, 31, 31,159, 63, 95, 31,159, 63, 95, 31, 11,   // 10
+        149,167,239,231,247,119, 95, 31, 31,159, 47, 79,  7,  7,  7,  7,151, 39, 79,  7,151, 39, 79,  7,  3,   // 11
+        148, 49, 90, 24,156, 45, 79,  7,  7,151, 35, 74,  0,  0,  0,  0,148, 33, 74,  0,148, 33, 74,  0,  0,   // 12
+        148, 37, 79,  7,151,163,234,224,224,244, 97, 74,  0,  0,  0,  0,148, 33, 74,  0,148, 33, 74,  0,  0,   // 13
+        148,161,234,224,244,113, 90, 24,152,188,105, 74,  0,  0,  0,  0,148, 33, 74,  0,148, 33, 74,  0,  0,   // 14
+        180,241,250,248,252,109, 79,  7,151,183,235,234,224,224,224,224,244,225,234,224,244,225,234,224, 96,   // 15
+        180,253,255,255,255,107, 74,  0,148,181,251,250,248,248,248,248,252,249,250,248,252,249,250,248,104,   // 16
+        181,255,255,255,255,107, 74,  0,148,181,255,255,127, 95, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 11,   // 17
+        181,255,255,255,255,235,234,224,244,245,255,255,239,239,231,231,231,231,231,231,231,231,231,231, 99,   // 18
+        181,255,255,255,255,251,250,248,252,253,255,255,251,250,248,248,248,248,248,248,248,248,248,248,104,   // 19
+         53, 95, 31, 31, 31, 31, 31,159,191,127, 95,159, 63, 95,159, 63, 95, 31, 31,159,191,255,255,255,107,   // 20
+         37, 79,  7,  7,  7,  7,  7,151,183,111, 79,151, 39, 79,151, 39, 79,  7,  7,151, 55, 95, 31, 31, 11,   // 21
+         33, 74,  0,  0,  0,  0,  0,148,181,107, 74,148, 33, 74,148,161,234,224,224,244,101, 79,  7,  7,  3,   // 22
+         33, 74,  0,  0,  0,  0,  0,148,181,107, 74,148, 33, 74,148,177,250,248,248,252,233,234,224,224, 96,   // 23
+          1, 10,  0,  0,  0,  0,  0, 20, 21, 11, 10, 20,  1, 10, 20, 21, 31, 31, 31, 31, 27, 26, 24, 24,  8   // 24
+    }
+};
+
+const struct FleetIndex courseFleet = {
+    3,
+    {
+        { 7,0,0,0,0,0,0,0,0,0,0,2,2,2,2,2,2,2,2,2,0,0,0,0,0 },   // 0
+        { 7,0,0,0,0,0,0,0,0,0,0,2,0,0,0,0,0,0,0,2,0,0,0,0,0 },   // 1
+        { 7,0,0,0,0,0,0,0,0,0,0,2,0,0,0,0,0,0,0,2,0,0,0,0,0 },   // 2
+        { 7,0,0,0,0,0,0,0,0,0,0,2,0,0,0,0,0,0,0,2,0,0,0,0,0 },   // 3
+        { 7,7,7,7,3,3,3,3,3,3,2,2,0,0,0,0,0,0,0,2,0,0,0,0,0 },   // 4
+        { 0,0,0,4,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,2,0,0,0,0,0 },   // 5
+        { 0,0,0,4,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,2,0,0,0,0,0 },   // 6
+        { 0,0,0,4,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,2,0,0,0,0,0 },   // 7
+        { 0,0,0,4,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,2,0,0,0,0,0 },   // 8
+        { 0,4,4,4,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,2,2,2,2,2,2 },   // 9
+        { 0,4,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 10
+        { 0,4,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 11
+        { 0,4,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 12
+        { 0,4,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 13
+        { 0,4,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 14
+        { 0,4,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 15
+        { 0,4,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 16
+        { 0,4,0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 },   // 17
+        { 0,4,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 18
+        { 0,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4 },   // 19
+        { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 20
+        { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 21
+        { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 22
+        { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },   // 23
+        { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 }   // 24
+    }
+};
+
+const struct DestinationTable courseDestinations = {
+    3,
+    {
+        7,7,7,7,0,0,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 0
+        7,0,0,7,0,0,7,0,0,7,7,7,7,7,7,7,0,0,7,7,0,0,7,7,7,   // 1
+        7,0,0,7,0,0,7,0,0,7,0,7,0,0,7,7,0,0,7,7,0,0,7,7,7,   // 2
+        7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 3
+        7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 4
+        7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 5
+        0,0,7,7,0,0,7,0,0,7,7,7,7,7,7,0,7,0,0,7,7,7,7,7,7,   // 6
+        0,0,7,7,0,0,7,0,7,7,0,0,0,7,7,0,7,7,0,7,7,7,0,0,0,   // 7
+        7,7,7,7,7,7,7,0,7,7,0,0,0,7,7,0,7,7,0,7,7,7,0,0,0,   // 8
+        7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 9
+        7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 10
+        0,7,0,0,0,7,7,7,7,7,7,0,0,0,0,0,0,7,0,0,0,7,0,0,0,   // 11
+        0,7,7,7,7,7,0,0,0,0,7,0,0,0,0,0,0,7,0,0,0,7,0,0,0,   // 12
+        0,7,0,0,0,7,0,0,0,0,7,0,0,0,0,0,0,7,0,0,0,7,0,0,0,   // 13
+        0,7,0,0,0,7,7,7,7,7,7,0,0,0,0,0,0,7,0,0,0,7,0,0,0,   // 14
+        0,7,7,7,7,7,0,0,0,7,7,0,0,0,0,0,0,7,0,0,0,7,0,0,0,   // 15
+        7,7,7,7,7,7,0,0,0,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 16
+        7,7,7,7,7,7,0,0,0,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 17
+        7,7,7,7,7,7,0,0,0,7,7,7,7,0,0,0,0,0,0,0,0,0,0,0,0,   // 18
+        7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 19
+        7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,   // 20
+        7,0,0,0,0,0,0,0,7,7,0,0,7,0,0,7,0,0,0,0,7,7,7,7,7,   // 21
+        7,0,0,0,0,0,0,0,7,7,0,0,7,0,0,7,0,0,0,0,7,0,0,0,0,   // 22
+        7,0,0,0,0,0,0,0,7,7,0,0,7,0,0,7,7,7,7,7,7,0,0,0,0,   // 23
+        7,0,0,0,0,0,0,0,7,7,0,0,7,0,0,7,7,7,7,7,7,7,7,7,7   // 24
+    }
+};
@@ -0,0 +1,28 @@
+#ifndef COURSETABLES_H
+#define COURSETABLES_H
+
+#include "delivery.h"
+#include "mapping.h"
+#include "pathing.h"
+
+/*
+* The tables a fresh start needs for the course map and the three trucks, worked out ahead of time
+* by Tools/gentables.c and compiled into read-only data in coursetables.c, so starting up sets
+* nothing up and the pages are shared through the page cache by every copy of the app. Run the
+* generator again after changing the map, a route or one of these structures. They only match a
+* build with the default MAP_ROWS, MAP_COLS and MAX_ROUTE.
+*/
+
+// The blue, green and yellow trucks with their routes indexed by indexRoute() and nothing loaded
+extern const struct Truck courseTrucks[NUM_TRUCKS];
+
+// buildMoveTable() of getCourseMap()
+extern const struct MoveTable courseMoves;
+
+// buildFleetIndex() of courseTrucks
+extern const struct FleetIndex courseFleet;
+
+// buildDestinationTable() of getCourseMap() and courseTrucks
+extern const struct DestinationTable courseDestinations;
+
+#endif
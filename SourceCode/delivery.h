@@ -2,12 +2,23 @@
 #define DELIVERY_H
 
 #include "mapping.h"
+#include "segments.h"
 
 // Simple constants for the delivery system
 #define MAX_SHIPMENTS 50
 #define MAX_WEIGHT 5000      // kilograms
 #define MAX_VOLUME 200       // cubic meters
 #define NUM_TRUCKS 3
+#define MAX_FLEET 32         // one bit per truck in an unsigned int
+#define ROUTE_MAP_WORDS ((MAP_ROWS * MAP_COLS + 31) / 32)
+#define MAX_ROUTE_SEGMENTS (MAX_ROUTE / 4 + 1) // straight runs kept per truck; the course routes need 5 or 6
+
+// Fixed-point units so capacity sums and comparisons are exact
+#define GRAMS_PER_KG 1000
+#define MAX_WEIGHT_G (MAX_WEIGHT * GRAMS_PER_KG)
+#define VOLUME_UNITS_PER_M3 2       // boxes are 0.5, 2 or 5 cubic metres, so half cubic metres
+#define MAX_VOLUME_UNITS (MAX_VOLUME * VOLUME_UNITS_PER_M3)
+#define CAPACITY_SCALE MAX_WEIGHT_G // a share of capacity is counted in parts of this, one part per gram
 
 /**
  * Represents a package/shipment that needs to be delivered
@@ -30,6 +41,49 @@ struct Truck {
     double currentWeight;                   // Total weight currently loaded
     double currentVolume;                   // Total volume currently loaded
     int truckNumber;                        // 0=Blue, 1=Green, 2=Yellow
+    unsigned int routeCells[ROUTE_MAP_WORDS]; // One bit per map square the route passes through
+    int routeIndexed;                       // 1 once indexRoute() has filled in routeCells
+    struct RouteSegment segments[MAX_ROUTE_SEGMENTS]; // The route as straight runs, filled in by indexRoute()
+    int numSegments;                        // Runs in segments, 0 if the route needs more than MAX_ROUTE_SEGMENTS
+};
+
+/**
+ * Which trucks pass through each square of the map
+ */
+struct FleetIndex {
+    int numTrucks;                              // Trucks in the index, at most MAX_FLEET
+    unsigned int trucksAt[MAP_ROWS][MAP_COLS];  // Bit i is set if truck i passes through the square
+};
+
+/**
+ * Tournament tree over the fleet's remaining capacity. Node n covers nodes 2n and 2n+1 and
+ * truck i is the leaf MAX_FLEET + i, so each node holds the most left in any truck below it.
+ */
+struct CapacityIndex {
+    struct Truck* trucks;                   // The truck array the index was built from
+    int numTrucks;                          // Trucks in the index, at most MAX_FLEET
+    int weightLeft[2 * MAX_FLEET];          // Most kilograms left, as remainingCapacityKg()
+    int volumeLeft[2 * MAX_FLEET];          // Most half cubic metre units left
+    int capacityLeft[2 * MAX_FLEET];        // Largest share of capacity left, as capacityLeftShare()
+};
+
+/**
+ * Which trucks can deliver to each square: on the map, not a building, and joined by open squares
+ * to the truck's route. One mask per square at row * MAP_COLS + col, so checking a destination is
+ * one lookup. Must be built again whenever the map or a route changes; destinationMapObserver()
+ * does that for squares changed with setSquareBlocked().
+ */
+struct DestinationTable {
+    int numTrucks;                                  // Trucks in the table, at most MAX_FLEET
+    unsigned int reachedBy[MAP_ROWS * MAP_COLS];    // Bit i is set if truck i's route reaches the square
+};
+
+/**
+ * What the fleet index and destination table in use say about the trucks for one destination
+ */
+struct ReachMasks {
+    unsigned int onRoute;       // Bit i is set if truck i passes through the destination
+    unsigned int reaching;      // Bit i is set unless truck i's route is known not to reach it
 };
 
 /**
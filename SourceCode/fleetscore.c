@@ -0,0 +1,180 @@
+/*
+* Purpose: Scores every truck in the fleet at once from the capacity index's arrays
+*/
+
+#include <stddef.h>
+#include <float.h>
+#include "fleetscore.h"
+#include "MS3FunctionSpecs.h"
+
+#if !defined(FLEET_SCORE_SCALAR) && defined(__AVX2__)
+#define FLEET_SCORE_AVX2
+#include <immintrin.h>
+#elif !defined(FLEET_SCORE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define FLEET_SCORE_SSE2
+#include <emmintrin.h>
+#endif
+
+/*
+* Each backend works on LANES trucks at a time. The capacity fields are whole numbers, which
+* convert to double exactly, so every backend makes the same comparisons and picks the same truck.
+*/
+#if defined(FLEET_SCORE_AVX2)
+
+#define LANES 4
+typedef __m256d Lanes;
+
+static Lanes loadLanes(const double* p) { return _mm256_loadu_pd(p); }
+static Lanes loadIntLanes(const int* p) { return _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)p)); }
+static Lanes setLanes(double x) { return _mm256_set1_pd(x); }
+static Lanes minLanes(Lanes a, Lanes b) { return _mm256_min_pd(a, b); }
+static Lanes maxLanes(Lanes a, Lanes b) { return _mm256_max_pd(a, b); }
+static unsigned int equalBits(Lanes a, Lanes b) { return (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)); }
+static unsigned int notGreaterBits(Lanes a, Lanes b) { return (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_NGT_UQ)); }
+
+// Lanes whose bit is set come from a, the rest from other
+static Lanes selectLanes(unsigned int bits, Lanes a, Lanes other) {
+    const __m256i select = _mm256_set_epi64x(8, 4, 2, 1);
+    __m256i lanes = _mm256_and_si256(_mm256_set1_epi64x((long long)(bits & 0xF)), select);
+    return _mm256_blendv_pd(other, a, _mm256_castsi256_pd(_mm256_cmpeq_epi64(lanes, select)));
+}
+
+static double lowestLane(Lanes a) {
+    __m128d half = _mm_min_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    return _mm_cvtsd_f64(_mm_min_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+static double highestLane(Lanes a) {
+    __m128d half = _mm_max_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+#elif defined(FLEET_SCORE_SSE2)
+
+#define LANES 2
+typedef __m128d Lanes;
+
+static Lanes loadLanes(const double* p) { return _mm_loadu_pd(p); }
+static Lanes loadIntLanes(const int* p) { return _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)p)); }
+static Lanes setLanes(double x) { return _mm_set1_pd(x); }
+static Lanes minLanes(Lanes a, Lanes b) { return _mm_min_pd(a, b); }
+static Lanes maxLanes(Lanes a, Lanes b) { return _mm_max_pd(a, b); }
+static unsigned int equalBits(Lanes a, Lanes b) { return (unsigned int)_mm_movemask_pd(_mm_cmpeq_pd(a, b)); }
+static unsigned int notGreaterBits(Lanes a, Lanes b) { return (unsigned int)_mm_movemask_pd(_mm_cmpngt_pd(a, b)); }
+
+static Lanes selectLanes(unsigned int bits, Lanes a, Lanes other) {
+    int low = -(int)(bits & 1u), high = -(int)((bits >> 1) & 1u);
+    __m128d mask = _mm_castsi128_pd(_mm_set_epi32(high, high, low, low));
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, other));
+}
+
+static double lowestLane(Lanes a) { return _mm_cvtsd_f64(_mm_min_sd(a, _mm_unpackhi_pd(a, a))); }
+static double highestLane(Lanes a) { return _mm_cvtsd_f64(_mm_max_sd(a, _mm_unpackhi_pd(a, a))); }
+
+#else
+
+#define LANES 1
+typedef double Lanes;
+
+static Lanes loadLanes(const double* p) { return *p; }
+static Lanes loadIntLanes(const int* p) { return (double)*p; }
+static Lanes setLanes(double x) { return x; }
+static Lanes minLanes(Lanes a, Lanes b) { return (b < a) ? b : a; }
+static Lanes maxLanes(Lanes a, Lanes b) { return (b > a) ? b : a; }
+static unsigned int equalBits(Lanes a, Lanes b) { return a == b; }
+static unsigned int notGreaterBits(Lanes a, Lanes b) { return !(a > b); }
+static Lanes selectLanes(unsigned int bits, Lanes a, Lanes other) { return (bits & 1u) ? a : other; }
+static double lowestLane(Lanes a) { return a; }
+static double highestLane(Lanes a) { return a; }
+
+#endif
+
+// The fleet is scored in whole groups of lanes
+#if MAX_FLEET % 4 != 0
+#error MAX_FLEET must be a multiple of 4
+#endif
+
+/*
+* Name: fittingTrucks
+* Description: Finds every truck the shipment fits in
+*/
+unsigned int fittingTrucks(const struct CapacityIndex* index, const struct Shipment* s) {
+    if (index == NULL || s == NULL || index->numTrucks <= 0) {
+        return 0;
+    }
+
+    Lanes weight = setLanes((double)kilogramsNeeded(s->weight));
+    Lanes volume = setLanes((double)volumeToUnits(s->volume));
+    unsigned int fits = 0;
+
+    // canFitShipment() turns a truck down if the shipment is heavier or larger than the room left
+    for (int i = 0; i < MAX_FLEET; i += LANES) {
+        unsigned int light = notGreaterBits(weight, loadIntLanes(&index->weightLeft[MAX_FLEET + i]));
+        unsigned int small = notGreaterBits(volume, loadIntLanes(&index->volumeLeft[MAX_FLEET + i]));
+        fits |= (light & small) << i;
+    }
+
+    // Leaves past the last truck never fit, but do not rely on it
+    return (index->numTrucks >= MAX_FLEET) ? fits : fits & ((1u << index->numTrucks) - 1u);
+}
+
+/*
+* Name: bestScoredTruck
+* Description: Picks the best candidate by the MS4 rules
+*/
+int bestScoredTruck(const struct CapacityIndex* index, const double diversion[MAX_FLEET], unsigned int candidates) {
+    if (index == NULL || diversion == NULL || candidates == 0) {
+        return -1;
+    }
+
+    // Shortest diversion across the candidates
+    Lanes shortest = setLanes(DBL_MAX);
+    for (int i = 0; i < MAX_FLEET; i += LANES) {
+        shortest = minLanes(shortest, selectLanes(candidates >> i, loadLanes(&diversion[i]), setLanes(DBL_MAX)));
+    }
+    Lanes shortestAll = setLanes(lowestLane(shortest));
+
+    unsigned int tied = 0;
+    for (int i = 0; i < MAX_FLEET; i += LANES) {
+        tied |= equalBits(loadLanes(&diversion[i]), shortestAll) << i;
+    }
+    tied &= candidates;
+
+    // Most capacity left among those
+    if ((tied & (tied - 1u)) != 0) {
+        Lanes most = setLanes(-DBL_MAX);
+        for (int i = 0; i < MAX_FLEET; i += LANES) {
+            most = maxLanes(most, selectLanes(tied >> i, loadIntLanes(&index->capacityLeft[MAX_FLEET + i]), setLanes(-DBL_MAX)));
+        }
+        Lanes mostAll = setLanes(highestLane(most));
+
+        unsigned int roomiest = 0;
+        for (int i = 0; i < MAX_FLEET; i += LANES) {
+            roomiest |= equalBits(loadIntLanes(&index->capacityLeft[MAX_FLEET + i]), mostAll) << i;
+        }
+        tied &= roomiest;
+    }
+
+    // Lowest truck number, then lowest index; exact ties are rare so this stays scalar
+    int best = -1;
+    for (int i = 0; i < MAX_FLEET; i++) {
+        if (((tied >> i) & 1u) && (best < 0 || index->trucks[i].truckNumber < index->trucks[best].truckNumber)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/*
+* Name: fleetScoreKernel
+* Description: Names the instruction set the scoring functions were compiled for
+*/
+const char* fleetScoreKernel(void) {
+#if defined(FLEET_SCORE_AVX2)
+    return "avx2";
+#elif defined(FLEET_SCORE_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,43 @@
+#ifndef FLEETSCORE_H
+#define FLEETSCORE_H
+
+#include "delivery.h"
+
+/*
+* The capacity index keeps each truck's remaining weight, volume and capacity share in the
+* leaves weightLeft[MAX_FLEET + i], volumeLeft[MAX_FLEET + i] and capacityLeft[MAX_FLEET + i],
+* which is one array per field. These functions score the whole fleet from those arrays with
+* AVX2 or SSE2 when the compiler targets them and a plain loop otherwise. Define
+* FLEET_SCORE_SCALAR to force the plain loop. Every version gives exactly the same answer.
+*/
+
+/*
+* Name: fittingTrucks
+* Description: Finds every truck the shipment fits in, using the same comparisons as canFitShipment()
+* Parameters:
+*   - index: capacity index of the fleet
+*   - s: pointer to the shipment
+* Returns: Bit i is set if truck i has room for the shipment, 0 if either pointer is NULL
+*/
+unsigned int fittingTrucks(const struct CapacityIndex* index, const struct Shipment* s);
+
+/*
+* Name: bestScoredTruck
+* Description: Picks the truck assignShipment() would pick from a set of candidates: shortest
+*              diversion, then most capacity left, then lowest truck number, then lowest index
+* Parameters:
+*   - index: capacity index of the fleet
+*   - diversion: diversion distance of each truck, only read for candidates
+*   - candidates: bit i is set if truck i fits the shipment and can reach it
+* Returns: The index of the best truck, or -1 if there are no candidates
+*/
+int bestScoredTruck(const struct CapacityIndex* index, const double diversion[MAX_FLEET], unsigned int candidates);
+
+/*
+* Name: fleetScoreKernel
+* Description: Names the instruction set the scoring functions were compiled for
+* Returns: "avx2", "sse2" or "scalar"
+*/
+const char* fleetScoreKernel(void);
+
+#endif
@@ -0,0 +1,628 @@
+#include <stdio.h>
+#include "hpa.h"
+#include "pathing.h"
+
+#define CELL(row, col) ((row) * MAP_COLS + (col))
+#define CELL_ROW(cell) ((cell) / MAP_COLS)
+#define CELL_COL(cell) ((cell) % MAP_COLS)
+
+#define HPA_NO_PATH 0xFFFF
+#define HPA_ABSTRACT_NODES (HPA_MAX_CLUSTERS * HPA_MAX_CLUSTER_NODES + 2)
+#define HPA_START_ID (HPA_ABSTRACT_NODES - 2)
+#define HPA_GOAL_ID (HPA_ABSTRACT_NODES - 1)
+
+// entrances at least this long get a crossing at each end instead of one in the middle
+#define HPA_LONG_ENTRANCE 6
+
+static const struct HpaIndex* activeIndex;
+static struct PathStats lastStats;
+
+static const int moveRow[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+static const int moveCol[8] = { 0, -1, 1, -1, 1, 0, -1, 1 };
+
+// breadth first search inside one cluster
+static unsigned int localId;
+static unsigned int localSeen[MAP_CELLS];
+static int localDist[MAP_CELLS];
+static int localParent[MAP_CELLS];
+static int localQueue[MAP_CELLS];
+
+// A* over the abstract graph, using an indexed heap so each node is on it at most once
+static unsigned int abstractId;
+static unsigned int abstractSeen[HPA_ABSTRACT_NODES];
+static unsigned int abstractClosed[HPA_ABSTRACT_NODES];
+static int abstractCost[HPA_ABSTRACT_NODES];
+static int abstractParent[HPA_ABSTRACT_NODES];
+static int heapPos[HPA_ABSTRACT_NODES];
+static int heapKey[HPA_ABSTRACT_NODES];
+static int heap[HPA_ABSTRACT_NODES];
+static int heapSize;
+
+static int minInt(const int a, const int b)
+{
+	return a < b ? a : b;
+}
+
+static int moveDistance(const int fromCell, const int toCell)
+{
+	int deltaRow = CELL_ROW(toCell) - CELL_ROW(fromCell);
+	int deltaCol = CELL_COL(toCell) - CELL_COL(fromCell);
+
+	if (deltaRow < 0) deltaRow = -deltaRow;
+	if (deltaCol < 0) deltaCol = -deltaCol;
+	return deltaRow > deltaCol ? deltaRow : deltaCol;
+}
+
+static int clusterOf(const int cell)
+{
+	return (CELL_ROW(cell) / HPA_CLUSTER_SIZE) * HPA_CLUSTER_COLS + CELL_COL(cell) / HPA_CLUSTER_SIZE;
+}
+
+static void clusterBounds(const struct HpaIndex* index, const int cluster, int* r0, int* c0, int* r1, int* c1)
+{
+	*r0 = (cluster / HPA_CLUSTER_COLS) * HPA_CLUSTER_SIZE;
+	*c0 = (cluster % HPA_CLUSTER_COLS) * HPA_CLUSTER_SIZE;
+	*r1 = minInt(*r0 + HPA_CLUSTER_SIZE, index->numRows) - 1;
+	*c1 = minInt(*c0 + HPA_CLUSTER_SIZE, index->numCols) - 1;
+}
+
+/*
+* Breadth first search from one square that never leaves the cluster it is in. Stops early once
+* stopCell is reached; pass -1 to reach every square of the cluster.
+*/
+static void localSearch(const struct HpaIndex* index, const struct Map* map, const int fromCell, const int stopCell)
+{
+	int r0, c0, r1, c1, head = 0, tail = 0, cell, row, col, next, i;
+
+	clusterBounds(index, clusterOf(fromCell), &r0, &c0, &r1, &c1);
+	if (++localId == 0)
+	{
+		for (i = 0; i < MAP_CELLS; i++) localSeen[i] = 0;
+		localId = 1;
+	}
+
+	localSeen[fromCell] = localId;
+	localDist[fromCell] = 0;
+	localParent[fromCell] = fromCell;
+	localQueue[tail++] = fromCell;
+	while (head < tail)
+	{
+		cell = localQueue[head++];
+		lastStats.expanded++;
+		if (cell == stopCell) return;
+
+		row = CELL_ROW(cell);
+		col = CELL_COL(cell);
+		for (i = 0; i < 8; i++)
+		{
+			if (row + moveRow[i] < r0 || row + moveRow[i] > r1 || col + moveCol[i] < c0 || col + moveCol[i] > c1) continue;
+			if (!isOpenSquare(map, row + moveRow[i], col + moveCol[i])) continue;
+			next = CELL(row + moveRow[i], col + moveCol[i]);
+			if (localSeen[next] == localId) continue;
+
+			localSeen[next] = localId;
+			localDist[next] = localDist[cell] + 1;
+			localParent[next] = cell;
+			localQueue[tail++] = next;
+		}
+	}
+}
+
+static int localCost(const int cell)
+{
+	return localSeen[cell] == localId ? localDist[cell] : HPA_NO_PATH;
+}
+
+static void addCrossing(struct HpaBorder* border, const int cellA, const int cellB)
+{
+	if (border->numCrossings < HPA_MAX_CROSSINGS)
+	{
+		border->cellA[border->numCrossings] = (short)cellA;
+		border->cellB[border->numCrossings] = (short)cellB;
+		border->numCrossings++;
+	}
+}
+
+/*
+* Find the crossings along the straight border between two clusters. lineA and lineB are the row (or
+* column when vertical is true) of the last line of the first cluster and the first line of the
+* second, and the border runs from first to last along the other axis.
+*
+* Each run of squares open on both sides gets one crossing in its middle, or one at each end when it
+* is long. A diagonal step across the border gets its own crossing only when neither square it
+* touches has an open square straight across, since otherwise the same crossing can be reached
+* through a neighbouring run.
+*/
+static void findStraightCrossings(struct HpaBorder* border, const struct Map* map, const int vertical,
+	const int lineA, const int lineB, const int first, const int last)
+{
+	int k, runStart = -1, pairK, pairNext;
+
+#define SQUARE(line, k) (vertical ? CELL((k), (line)) : CELL((line), (k)))
+#define OPEN(line, k) (vertical ? isOpenSquare(map, (k), (line)) : isOpenSquare(map, (line), (k)))
+
+	border->numCrossings = 0;
+	for (k = first; k <= last + 1; k++)
+	{
+		pairK = k <= last && OPEN(lineA, k) && OPEN(lineB, k);
+		if (pairK && runStart < 0)
+		{
+			runStart = k;
+		}
+		else if (!pairK && runStart >= 0)
+		{
+			if (k - runStart < HPA_LONG_ENTRANCE)
+			{
+				addCrossing(border, SQUARE(lineA, (runStart + k - 1) / 2), SQUARE(lineB, (runStart + k - 1) / 2));
+			}
+			else
+			{
+				addCrossing(border, SQUARE(lineA, runStart), SQUARE(lineB, runStart));
+				addCrossing(border, SQUARE(lineA, k - 1), SQUARE(lineB, k - 1));
+			}
+			runStart = -1;
+		}
+	}
+
+	for (k = first; k < last; k++)
+	{
+		pairK = OPEN(lineA, k) && OPEN(lineB, k);
+		pairNext = OPEN(lineA, k + 1) && OPEN(lineB, k + 1);
+		if (pairK || pairNext) continue;
+
+		if (OPEN(lineA, k) && OPEN(lineB, k + 1)) addCrossing(border, SQUARE(lineA, k), SQUARE(lineB, k + 1));
+		if (OPEN(lineA, k + 1) && OPEN(lineB, k)) addCrossing(border, SQUARE(lineA, k + 1), SQUARE(lineB, k));
+	}
+
+#undef SQUARE
+#undef OPEN
+}
+
+/*
+* Recalculate whichever of the borders starting at cluster (clusterRow, clusterCol) exist.
+*/
+static void findBorders(struct HpaIndex* index, const struct Map* map, const int clusterRow, const int clusterCol)
+{
+	int r0, c0, r1, c1;
+	int hasRight = clusterCol + 1 < index->clusterCols;
+	int hasBelow = clusterRow + 1 < index->clusterRows;
+
+	if (clusterRow < 0 || clusterCol < 0 || clusterRow >= index->clusterRows || clusterCol >= index->clusterCols) return;
+
+	clusterBounds(index, clusterRow * HPA_CLUSTER_COLS + clusterCol, &r0, &c0, &r1, &c1);
+	if (hasRight)
+	{
+		findStraightCrossings(&index->vertical[clusterRow][clusterCol], map, 1, c1, c1 + 1, r0, r1);
+	}
+	if (hasBelow)
+	{
+		findStraightCrossings(&index->horizontal[clusterRow][clusterCol], map, 0, r1, r1 + 1, c0, c1);
+	}
+	if (hasRight && hasBelow)
+	{
+		index->cornerMain[clusterRow][clusterCol].numCrossings = 0;
+		if (isOpenSquare(map, r1, c1) && isOpenSquare(map, r1 + 1, c1 + 1))
+		{
+			addCrossing(&index->cornerMain[clusterRow][clusterCol], CELL(r1, c1), CELL(r1 + 1, c1 + 1));
+		}
+		index->cornerAnti[clusterRow][clusterCol].numCrossings = 0;
+		if (isOpenSquare(map, r1, c1 + 1) && isOpenSquare(map, r1 + 1, c1))
+		{
+			addCrossing(&index->cornerAnti[clusterRow][clusterCol], CELL(r1, c1 + 1), CELL(r1 + 1, c1));
+		}
+	}
+}
+
+/*
+* Add the crossings of one border to a cluster's nodes. useA says whether the cluster is the border's
+* first cluster.
+*/
+static void addBorderNodes(struct HpaIndex* index, struct HpaCluster* cluster, const struct HpaBorder* border, const int useA)
+{
+	int i, mine, other, slot;
+
+	for (i = 0; i < border->numCrossings; i++)
+	{
+		mine = useA ? border->cellA[i] : border->cellB[i];
+		other = useA ? border->cellB[i] : border->cellA[i];
+		slot = index->nodeSlot[mine];
+		if (slot < 0)
+		{
+			if (cluster->numNodes == HPA_MAX_CLUSTER_NODES) continue;
+			slot = cluster->numNodes++;
+			cluster->nodeCell[slot] = (short)mine;
+			cluster->numPartners[slot] = 0;
+			index->nodeSlot[mine] = (short)slot;
+		}
+		if (cluster->numPartners[slot] < HPA_MAX_PARTNERS)
+		{
+			cluster->partnerCell[slot][cluster->numPartners[slot]++] = (short)other;
+		}
+	}
+}
+
+/*
+* Rebuild a cluster's nodes from the borders around it and the cost of travelling between them.
+*/
+static void buildCluster(struct HpaIndex* index, const struct Map* map, const int clusterRow, const int clusterCol)
+{
+	struct HpaCluster* cluster;
+	int i, j;
+
+	if (clusterRow < 0 || clusterCol < 0 || clusterRow >= index->clusterRows || clusterCol >= index->clusterCols) return;
+
+	cluster = &index->clusters[clusterRow * HPA_CLUSTER_COLS + clusterCol];
+	for (i = 0; i < cluster->numNodes; i++)
+	{
+		index->nodeSlot[cluster->nodeCell[i]] = -1;
+	}
+	cluster->numNodes = 0;
+
+	if (clusterCol + 1 < index->clusterCols) addBorderNodes(index, cluster, &index->vertical[clusterRow][clusterCol], 1);
+	if (clusterCol > 0) addBorderNodes(index, cluster, &index->vertical[clusterRow][clusterCol - 1], 0);
+	if (clusterRow + 1 < index->clusterRows) addBorderNodes(index, cluster, &index->horizontal[clusterRow][clusterCol], 1);
+	if (clusterRow > 0) addBorderNodes(index, cluster, &index->horizontal[clusterRow - 1][clusterCol], 0);
+	if (clusterRow + 1 < index->clusterRows && clusterCol + 1 < index->clusterCols)
+	{
+		addBorderNodes(index, cluster, &index->cornerMain[clusterRow][clusterCol], 1);
+	}
+	if (clusterRow > 0 && clusterCol > 0)
+	{
+		addBorderNodes(index, cluster, &index->cornerMain[clusterRow - 1][clusterCol - 1], 0);
+	}
+	if (clusterRow + 1 < index->clusterRows && clusterCol > 0)
+	{
+		addBorderNodes(index, cluster, &index->cornerAnti[clusterRow][clusterCol - 1], 1);
+	}
+	if (clusterRow > 0 && clusterCol + 1 < index->clusterCols)
+	{
+		addBorderNodes(index, cluster, &index->cornerAnti[clusterRow - 1][clusterCol], 0);
+	}
+
+	for (i = 0; i < cluster->numNodes; i++)
+	{
+		localSearch(index, map, cluster->nodeCell[i], -1);
+		for (j = 0; j < cluster->numNodes; j++)
+		{
+			cluster->cost[i][j] = (unsigned short)localCost(cluster->nodeCell[j]);
+		}
+	}
+}
+
+void hpaBuild(struct HpaIndex* index, const struct Map* map)
+{
+	int i, r, c;
+
+	index->numRows = map->numRows;
+	index->numCols = map->numCols;
+	index->clusterRows = (map->numRows + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+	index->clusterCols = (map->numCols + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+	for (i = 0; i < MAP_CELLS; i++)
+	{
+		index->nodeSlot[i] = -1;
+	}
+	for (i = 0; i < HPA_MAX_CLUSTERS; i++)
+	{
+		index->clusters[i].numNodes = 0;
+	}
+
+	for (r = 0; r < index->clusterRows; r++)
+	{
+		for (c = 0; c < index->clusterCols; c++)
+		{
+			findBorders(index, map, r, c);
+		}
+	}
+	for (r = 0; r < index->clusterRows; r++)
+	{
+		for (c = 0; c < index->clusterCols; c++)
+		{
+			buildCluster(index, map, r, c);
+		}
+	}
+}
+
+void hpaUpdateCell(struct HpaIndex* index, const struct Map* map, const int row, const int col)
+{
+	int clusterRow = row / HPA_CLUSTER_SIZE, clusterCol = col / HPA_CLUSTER_SIZE;
+	int r, c;
+
+	// every border the square can lie on starts at this cluster or the one above, left or above-left
+	for (r = clusterRow - 1; r <= clusterRow; r++)
+	{
+		for (c = clusterCol - 1; c <= clusterCol; c++)
+		{
+			findBorders(index, map, r, c);
+		}
+	}
+	for (r = clusterRow - 1; r <= clusterRow + 1; r++)
+	{
+		for (c = clusterCol - 1; c <= clusterCol + 1; c++)
+		{
+			buildCluster(index, map, r, c);
+		}
+	}
+}
+
+static int heapLess(const int a, const int b)
+{
+	if (heapKey[a] != heapKey[b]) return heapKey[a] < heapKey[b];
+	return abstractCost[a] > abstractCost[b];
+}
+
+static void heapMoveUp(int i)
+{
+	int id = heap[i];
+
+	while (i > 0 && heapLess(id, heap[(i - 1) / 2]))
+	{
+		heap[i] = heap[(i - 1) / 2];
+		heapPos[heap[i]] = i;
+		i = (i - 1) / 2;
+	}
+	heap[i] = id;
+	heapPos[id] = i;
+}
+
+static int heapPop(void)
+{
+	int top = heap[0], id, i = 0, child;
+
+	id = heap[--heapSize];
+	while ((child = 2 * i + 1) < heapSize)
+	{
+		if (child + 1 < heapSize && heapLess(heap[child + 1], heap[child])) child++;
+		if (!heapLess(heap[child], id)) break;
+		heap[i] = heap[child];
+		heapPos[heap[i]] = i;
+		i = child;
+	}
+	if (heapSize > 0)
+	{
+		heap[i] = id;
+		heapPos[id] = i;
+	}
+	return top;
+}
+
+static void relaxAbstract(const int id, const int g, const int from, const int h)
+{
+	if (abstractClosed[id] == abstractId) return;
+	if (abstractSeen[id] != abstractId)
+	{
+		abstractSeen[id] = abstractId;
+		abstractCost[id] = g;
+		abstractParent[id] = from;
+		heapKey[id] = g + h;
+		heap[heapSize] = id;
+		heapMoveUp(heapSize++);
+		lastStats.generated++;
+	}
+	else if (g < abstractCost[id])
+	{
+		abstractCost[id] = g;
+		abstractParent[id] = from;
+		heapKey[id] = g + h;
+		heapMoveUp(heapPos[id]);
+	}
+}
+
+/*
+* Search the abstract graph. Returns 1 if the goal was reached; the path is in abstractParent.
+*/
+static int searchAbstract(const struct HpaIndex* index, const int startCell, const int destCell,
+	const int startCluster, const int destCluster, const int startCost[], const int destCost[])
+{
+	const struct HpaCluster* cluster;
+	int id, clusterId, slot, i, other, otherId;
+
+	if (++abstractId == 0)
+	{
+		for (i = 0; i < HPA_ABSTRACT_NODES; i++)
+		{
+			abstractSeen[i] = 0;
+			abstractClosed[i] = 0;
+		}
+		abstractId = 1;
+	}
+	heapSize = 0;
+	relaxAbstract(HPA_START_ID, 0, HPA_START_ID, moveDistance(startCell, destCell));
+
+	while (heapSize > 0)
+	{
+		id = heapPop();
+		abstractClosed[id] = abstractId;
+		lastStats.expanded++;
+		if (id == HPA_GOAL_ID) return 1;
+
+		if (id == HPA_START_ID)
+		{
+			cluster = &index->clusters[startCluster];
+			for (i = 0; i < cluster->numNodes; i++)
+			{
+				if (startCost[i] == HPA_NO_PATH) continue;
+				relaxAbstract(startCluster * HPA_MAX_CLUSTER_NODES + i, startCost[i], id,
+					moveDistance(cluster->nodeCell[i], destCell));
+			}
+			continue;
+		}
+
+		clusterId = id / HPA_MAX_CLUSTER_NODES;
+		slot = id % HPA_MAX_CLUSTER_NODES;
+		cluster = &index->clusters[clusterId];
+		for (i = 0; i < cluster->numNodes; i++)
+		{
+			if (i == slot || cluster->cost[slot][i] == HPA_NO_PATH) continue;
+			relaxAbstract(clusterId * HPA_MAX_CLUSTER_NODES + i, abstractCost[id] + cluster->cost[slot][i], id,
+				moveDistance(cluster->nodeCell[i], destCell));
+		}
+		for (i = 0; i < cluster->numPartners[slot]; i++)
+		{
+			other = cluster->partnerCell[slot][i];
+			if (index->nodeSlot[other] < 0) continue;
+			otherId = clusterOf(other) * HPA_MAX_CLUSTER_NODES + index->nodeSlot[other];
+			relaxAbstract(otherId, abstractCost[id] + 1, id, moveDistance(other, destCell));
+		}
+		if (clusterId == destCluster && destCost[slot] != HPA_NO_PATH)
+		{
+			relaxAbstract(HPA_GOAL_ID, abstractCost[id] + destCost[slot], id, 0);
+		}
+	}
+	return 0;
+}
+
+/*
+* Add the squares of the last local search from its start to toCell onto a route.
+*/
+static int appendLocalPath(struct Route* route, const int toCell)
+{
+	static int chain[MAP_CELLS];
+	int n = 0, cell;
+
+	for (cell = toCell; localParent[cell] != cell; cell = localParent[cell])
+	{
+		chain[n++] = cell;
+	}
+	if (route->numPoints + n > MAX_ROUTE) return 0;
+	while (n > 0)
+	{
+		cell = chain[--n];
+		addPointToRoute(route, CELL_ROW(cell), CELL_COL(cell));
+	}
+	return 1;
+}
+
+/*
+* Answer a query as far as the abstract path. Returns the length of the path or -1 if there is none.
+* *local is set when start and dest are joined inside one cluster, in which case the path is left in
+* the local search; otherwise it is left in abstractParent.
+*/
+static int hpaSearch(const struct HpaIndex* index, const struct Map* map, const int startCell, const int destCell, int* local)
+{
+	int startCost[HPA_MAX_CLUSTER_NODES], destCost[HPA_MAX_CLUSTER_NODES];
+	const struct HpaCluster* cluster;
+	int startCluster = clusterOf(startCell), destCluster = clusterOf(destCell), i;
+
+	*local = 0;
+	if (startCluster == destCluster)
+	{
+		localSearch(index, map, startCell, destCell);
+		if (localCost(destCell) != HPA_NO_PATH)
+		{
+			*local = 1;
+			return localCost(destCell);
+		}
+	}
+
+	cluster = &index->clusters[startCluster];
+	localSearch(index, map, startCell, -1);
+	for (i = 0; i < cluster->numNodes; i++)
+	{
+		startCost[i] = localCost(cluster->nodeCell[i]);
+	}
+	cluster = &index->clusters[destCluster];
+	localSearch(index, map, destCell, -1);
+	for (i = 0; i < cluster->numNodes; i++)
+	{
+		destCost[i] = localCost(cluster->nodeCell[i]);
+	}
+
+	if (!searchAbstract(index, startCell, destCell, startCluster, destCluster, startCost, destCost)) return -1;
+	return abstractCost[HPA_GOAL_ID];
+}
+
+static int validQuery(const struct Map* map, const struct Point start, const struct Point dest)
+{
+	lastStats.expanded = 0;
+	lastStats.generated = 0;
+	if (eqPt(start, dest) || !isOpenSquare(map, dest.row, dest.col)) return 0;
+	return start.row >= 0 && start.row < map->numRows && start.col >= 0 && start.col < map->numCols;
+}
+
+int hpaFindPathInto(const struct HpaIndex* index, const struct Map* map, const struct Point start, const struct Point dest, struct Route* path)
+{
+	static int chain[HPA_ABSTRACT_NODES];
+	int startCell = CELL(start.row, start.col), destCell = CELL(dest.row, dest.col);
+	int n = 0, id, cell, current, local;
+
+	path->numPoints = 0;
+	path->routeSymbol = DIVERSION;
+	if (!validQuery(map, start, dest)) return 0;
+
+	n = hpaSearch(index, map, startCell, destCell, &local);
+	if (n < 0 || n > MAX_ROUTE) return 0;
+	if (local)
+	{
+		if (!appendLocalPath(path, destCell)) path->numPoints = 0;
+		return path->numPoints;
+	}
+
+	n = 0;
+	for (id = HPA_GOAL_ID; id != HPA_START_ID; id = abstractParent[id])
+	{
+		chain[n++] = id;
+	}
+
+	// refine: a step between clusters is a single move, anything else is a search inside one cluster
+	current = startCell;
+	while (n > 0)
+	{
+		id = chain[--n];
+		cell = id == HPA_GOAL_ID ? destCell :
+			index->clusters[id / HPA_MAX_CLUSTER_NODES].nodeCell[id % HPA_MAX_CLUSTER_NODES];
+		if (cell == current) continue;
+
+		if (clusterOf(cell) != clusterOf(current))
+		{
+			if (path->numPoints == MAX_ROUTE)
+			{
+				path->numPoints = 0;
+				return 0;
+			}
+			addPointToRoute(path, CELL_ROW(cell), CELL_COL(cell));
+		}
+		else
+		{
+			localSearch(index, map, current, cell);
+			if (!appendLocalPath(path, cell))
+			{
+				path->numPoints = 0;
+				return 0;
+			}
+		}
+		current = cell;
+	}
+	return path->numPoints;
+}
+
+struct Route hpaFindPath(const struct HpaIndex* index, const struct Map* map, const struct Point start, const struct Point dest)
+{
+	struct Route result;
+
+	hpaFindPathInto(index, map, start, dest, &result);
+	return result;
+}
+
+int hpaPathLength(const struct HpaIndex* index, const struct Map* map, const struct Point start, const struct Point dest)
+{
+	int local;
+
+	if (eqPt(start, dest)) return 0;
+	if (!validQuery(map, start, dest)) return -1;
+	return hpaSearch(index, map, CELL(start.row, start.col), CELL(dest.row, dest.col), &local);
+}
+
+void useHpaIndex(const struct HpaIndex* index)
+{
+	activeIndex = index;
+}
+
+const struct HpaIndex* getHpaIndex(void)
+{
+	return activeIndex;
+}
+
+struct PathStats hpaGetLastStats(void)
+{
+	return lastStats;
+}
@@ -0,0 +1,131 @@
+#ifndef HPA_H
+#define HPA_H
+
+#include "mapping.h"
+#include "pathing.h"
+
+// The map is cut into square clusters of HPA_CLUSTER_SIZE squares on a side.
+#ifndef HPA_CLUSTER_SIZE
+#define HPA_CLUSTER_SIZE 10
+#endif
+#define HPA_CLUSTER_ROWS ((MAP_ROWS + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE)
+#define HPA_CLUSTER_COLS ((MAP_COLS + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE)
+#define HPA_MAX_CLUSTERS (HPA_CLUSTER_ROWS * HPA_CLUSTER_COLS)
+#define HPA_MAX_CLUSTER_NODES (4 * HPA_CLUSTER_SIZE)
+#define HPA_MAX_CROSSINGS (2 * HPA_CLUSTER_SIZE)
+#define HPA_MAX_PARTNERS 6
+
+/**
+* The places where a path can cross from one cluster into a neighbouring one. cellA is in the first
+* cluster and cellB in the second; both are stored as row * MAP_COLS + col.
+*/
+struct HpaBorder
+{
+	int numCrossings;
+	short cellA[HPA_MAX_CROSSINGS];
+	short cellB[HPA_MAX_CROSSINGS];
+};
+
+/**
+* The abstract graph of one cluster: the squares where paths enter or leave it, the cost of travelling
+* between each pair of them without leaving the cluster, and the squares across the border each one
+* leads to.
+*/
+struct HpaCluster
+{
+	int numNodes;
+	short nodeCell[HPA_MAX_CLUSTER_NODES];
+	unsigned short cost[HPA_MAX_CLUSTER_NODES][HPA_MAX_CLUSTER_NODES];
+	int numPartners[HPA_MAX_CLUSTER_NODES];
+	short partnerCell[HPA_MAX_CLUSTER_NODES][HPA_MAX_PARTNERS];
+};
+
+/**
+* A hierarchical index of a map for fast, near-shortest path queries on large maps. It contains no
+* pointers so it can be copied or saved as it is.
+*/
+struct HpaIndex
+{
+	int numRows;
+	int numCols;
+	int clusterRows;
+	int clusterCols;
+	struct HpaBorder vertical[HPA_CLUSTER_ROWS][HPA_CLUSTER_COLS];		// cluster (r,c) to (r,c+1)
+	struct HpaBorder horizontal[HPA_CLUSTER_ROWS][HPA_CLUSTER_COLS];	// cluster (r,c) to (r+1,c)
+	struct HpaBorder cornerMain[HPA_CLUSTER_ROWS][HPA_CLUSTER_COLS];	// cluster (r,c) to (r+1,c+1)
+	struct HpaBorder cornerAnti[HPA_CLUSTER_ROWS][HPA_CLUSTER_COLS];	// cluster (r,c+1) to (r+1,c)
+	struct HpaCluster clusters[HPA_MAX_CLUSTERS];
+	short nodeSlot[MAP_CELLS];	// index of a square in its cluster's nodes or -1
+};
+
+/**
+* Build the hierarchical index for a map. The index is large, so it should be static or allocated
+* rather than a local variable.
+* @param index - the index to fill in
+* @param map - the map showing the location of buildings.
+*/
+void hpaBuild(struct HpaIndex* index, const struct Map* map);
+
+/**
+* Bring the index up to date after one square of the map has changed. Only the cluster containing the
+* square and its neighbours are recalculated.
+* @param index - the index built from the map before the change
+* @param map - the map after the change
+* @param row - the row of the square that changed
+* @param col - the column of the square that changed
+*/
+void hpaUpdateCell(struct HpaIndex* index, const struct Map* map, const int row, const int col);
+
+/**
+* Find a path by searching the graph of cluster entrances and then filling in the steps inside each
+* cluster. The path is never through buildings but may be slightly longer than the shortest path.
+* @param index - the index built for the map
+* @param map - the map showing the location of buildings.
+* @param start - the point to start from
+* @param dest - the point to go to
+* @returns - the path from start to dest, not including start, or a Route of zero length if there is no
+* path, it does not fit in a Route, or start and dest are the same point.
+*/
+struct Route hpaFindPath(const struct HpaIndex* index, const struct Map* map, const struct Point start, const struct Point dest);
+
+/**
+* Find a path as hpaFindPath() does, writing it into caller-provided storage instead of returning a copy.
+* @param index - the index built for the map
+* @param map - the map showing the location of buildings.
+* @param start - the point to start from
+* @param dest - the point to go to
+* @param path - where to write the path; it has zero length if there is none
+* @returns - the number of points in the path.
+*/
+int hpaFindPathInto(const struct HpaIndex* index, const struct Map* map, const struct Point start, const struct Point dest, struct Route* path);
+
+/**
+* Find the length of the path hpaFindPath() would return without filling in the steps inside each
+* cluster. The work done depends on the cluster size rather than the map size.
+* @param index - the index built for the map
+* @param map - the map showing the location of buildings.
+* @param start - the point to start from
+* @param dest - the point to go to
+* @returns - the number of moves from start to dest or -1 if there is no path.
+*/
+int hpaPathLength(const struct HpaIndex* index, const struct Map* map, const struct Point start, const struct Point dest);
+
+/**
+* Get the counters for the most recent call to hpaFindPath() or hpaPathLength().
+* @returns - the abstract nodes and cluster squares searched by the last query.
+*/
+struct PathStats hpaGetLastStats(void);
+
+/**
+* Make findPath() with PATH_HIERARCHICAL and findDiversion() use an index.
+* @param index - the index to use, or NULL to stop using one
+*/
+void useHpaIndex(const struct HpaIndex* index);
+
+/**
+* Get the index installed with useHpaIndex().
+* @returns - the index in use or NULL if there is none.
+*/
+const struct HpaIndex* getHpaIndex(void);
+
+#endif
@@ -0,0 +1,453 @@
+/*
+* Purpose: Shipment intake as a local service: many clients on a Unix domain socket, one thread
+*          waiting on all of them with epoll, and their requests placed in batches
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "intakeserver.h"
+#include "pipeline.h"
+#include "MS3FunctionSpecs.h"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define ANSWER_SIZE (DELIVERY_INFO_SIZE + 1)        // the longest answer, with the empty line after it
+#define SERVER_OUTPUT_SIZE (4 * ANSWER_SIZE)
+#define SERVER_EVENTS 256
+#define TAG_LISTENER SERVER_MAX_CLIENTS             // epoll tag of the listening socket
+#define TAG_WAKE (SERVER_MAX_CLIENTS + 1)           // epoll tag of the stop event
+
+static const char goodbye[] = "Thanks for shipping with Seneca Polytechnic!";
+static volatile sig_atomic_t stopping = 0;
+static volatile int wakeDescriptor = -1;
+
+/**
+ * One client's socket and what is waiting to be read from it or written to it
+ */
+struct Connection {
+    int descriptor;                 // -1 while the slot is free
+    unsigned int watching;          // epoll events asked for
+    int ended;                      // the client closed its end or said goodbye, nothing more is read
+    int broken;                     // a write failed or a line was too long, close without answering
+    int ready;                      // on the server's ready list
+    int reserved;                   // output held for answers to requests in the current batch
+    int inLength;
+    int outLength;
+    char input[SERVER_INPUT_SIZE];
+    char output[SERVER_OUTPUT_SIZE];
+};
+
+/**
+ * Everything the server loop works with
+ */
+struct Server {
+    int poller;
+    int listener;
+    int accepting;                  // the listener is watched; not while every slot is taken
+    int maxBatch;
+    struct Truck* trucks;
+    int numTrucks;
+    const struct Map* map;
+    int numFree;
+    int freeSlots[SERVER_MAX_CLIENTS];
+    int numReady;
+    int readyList[SERVER_MAX_CLIENTS];      // connections with a whole request read and room to answer it
+    int batchCount;
+    int batchOwner[SERVER_BATCH];
+    struct IntakeRecord batch[SERVER_BATCH];
+    struct Connection connections[SERVER_MAX_CLIENTS];
+};
+
+static int hasRequest(const struct Connection* c) {
+    return memchr(c->input, '\n', (size_t)c->inLength) != NULL;
+}
+
+static int canAnswer(const struct Connection* c) {
+    return SERVER_OUTPUT_SIZE - c->outLength - c->reserved >= ANSWER_SIZE;
+}
+
+static void setWatch(struct Server* server, int descriptor, unsigned int events, int tag, int operation) {
+    struct epoll_event event;
+
+    event.events = events;
+    event.data.u64 = (uint64_t)tag;
+    epoll_ctl(server->poller, operation, descriptor, &event);
+}
+
+static void closeConnection(struct Server* server, int index) {
+    struct Connection* c = &server->connections[index];
+
+    if (c->ready) {
+        for (int i = 0; i < server->numReady; i++) {
+            if (server->readyList[i] == index) {
+                server->readyList[i] = server->readyList[--server->numReady];
+                break;
+            }
+        }
+        c->ready = 0;
+    }
+    epoll_ctl(server->poller, EPOLL_CTL_DEL, c->descriptor, NULL);
+    close(c->descriptor);
+    c->descriptor = -1;
+    server->freeSlots[server->numFree++] = index;
+
+    if (!server->accepting) {
+        setWatch(server, server->listener, EPOLLIN, TAG_LISTENER, EPOLL_CTL_ADD);
+        server->accepting = 1;
+    }
+}
+
+// Close a finished connection, or watch for what it waits on next and queue any requests it can take
+static void settle(struct Server* server, int index) {
+    struct Connection* c = &server->connections[index];
+    unsigned int events;
+
+    if (c->broken || (c->ended && c->outLength == 0 && c->reserved == 0 && !hasRequest(c))) {
+        closeConnection(server, index);
+        return;
+    }
+    events = (c->outLength > 0 ? EPOLLOUT : 0) | (!c->ended && c->inLength < SERVER_INPUT_SIZE ? EPOLLIN : 0);
+    if (events != c->watching) {
+        setWatch(server, c->descriptor, events, index, EPOLL_CTL_MOD);
+        c->watching = events;
+    }
+    if (!c->ready && hasRequest(c) && canAnswer(c)) {
+        server->readyList[server->numReady++] = index;
+        c->ready = 1;
+    }
+}
+
+static void acceptClients(struct Server* server) {
+    while (server->numFree > 0) {
+        int descriptor = accept4(server->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        int index;
+        struct Connection* c;
+
+        if (descriptor < 0) {
+            return;
+        }
+        index = server->freeSlots[--server->numFree];
+        c = &server->connections[index];
+        c->descriptor = descriptor;
+        c->watching = EPOLLIN;
+        c->ended = 0;
+        c->broken = 0;
+        c->ready = 0;
+        c->reserved = 0;
+        c->inLength = 0;
+        c->outLength = 0;
+        setWatch(server, descriptor, EPOLLIN, index, EPOLL_CTL_ADD);
+    }
+
+    // The rest wait in the listen queue until a connection closes
+    setWatch(server, server->listener, 0, TAG_LISTENER, EPOLL_CTL_DEL);
+    server->accepting = 0;
+}
+
+static void readRequests(struct Connection* c) {
+    while (!c->ended && c->inLength < SERVER_INPUT_SIZE) {
+        ssize_t n = recv(c->descriptor, c->input + c->inLength, (size_t)(SERVER_INPUT_SIZE - c->inLength), 0);
+
+        if (n > 0) {
+            c->inLength += (int)n;
+        }
+        else if (n == 0) {
+            // A last request without a newline still counts
+            c->ended = 1;
+            if (c->inLength > 0 && c->input[c->inLength - 1] != '\n') {
+                c->input[c->inLength++] = '\n';
+            }
+        }
+        else if (errno != EINTR) {
+            c->broken = errno != EAGAIN && errno != EWOULDBLOCK;
+            break;
+        }
+    }
+
+    // A full buffer without a whole line in it is not a request
+    if (c->inLength == SERVER_INPUT_SIZE && !hasRequest(c)) {
+        c->broken = 1;
+    }
+}
+
+static void writeAnswers(struct Connection* c) {
+    while (c->outLength > 0) {
+        ssize_t n = send(c->descriptor, c->output, (size_t)c->outLength, MSG_NOSIGNAL);
+
+        if (n > 0) {
+            c->outLength -= (int)n;
+            memmove(c->output, c->output + n, (size_t)c->outLength);
+        }
+        else if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            c->broken = n < 0 && errno != EAGAIN && errno != EWOULDBLOCK;
+            break;
+        }
+    }
+}
+
+// Take the next line off a connection's input and parse it the way the console does
+static int takeRequest(struct Connection* c, struct IntakeRecord* record, const struct Map* map) {
+    char line[SERVER_INPUT_SIZE];
+    char* end;
+    int length, inputs;
+
+    while ((end = (char*)memchr(c->input, '\n', (size_t)c->inLength)) != NULL) {
+        length = (int)(end - c->input);
+        memcpy(line, c->input, (size_t)length);
+        line[length] = '\0';
+        c->inLength -= length + 1;
+        memmove(c->input, end + 1, (size_t)c->inLength);
+
+        memset(record, 0, sizeof(*record));
+        inputs = sscanf(line, "%lf %lf %3s", &record->weight, &record->volume, record->destination);
+        if (inputs == EOF) {
+            continue;       // an empty line asks for nothing
+        }
+        if (inputs != 3) {
+            record->kind = INTAKE_REJECTED;
+            record->message = "Invalid input";
+        }
+        else if (record->weight == 0 && record->volume == 0 && (record->destination[0] == 'x' || record->destination[0] == 'X')) {
+            record->kind = INTAKE_STOP;
+            record->message = goodbye;
+        }
+        else {
+            record->kind = INTAKE_SHIPMENT;
+            checkIntake(record, map);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+// Fill the batch from the ready connections, holding room for each answer as its request is taken
+static void gatherBatch(struct Server* server) {
+    int kept = 0;
+
+    server->batchCount = 0;
+    for (int i = 0; i < server->numReady; i++) {
+        int index = server->readyList[i];
+        struct Connection* c = &server->connections[index];
+        struct IntakeRecord* record;
+
+        while (server->batchCount < server->maxBatch && canAnswer(c)
+            && takeRequest(c, record = &server->batch[server->batchCount], server->map)) {
+            server->batchOwner[server->batchCount++] = index;
+            c->reserved += ANSWER_SIZE;
+            if (record->kind == INTAKE_STOP) {
+                c->ended = 1;
+                c->inLength = 0;
+            }
+        }
+
+        if (hasRequest(c) && canAnswer(c)) {
+            server->readyList[kept++] = index;
+        }
+        else {
+            c->ready = 0;
+        }
+    }
+    server->numReady = kept;
+}
+
+static void answerBatch(struct Server* server) {
+    for (int i = 0; i < server->batchCount; i++) {
+        struct IntakeRecord* record = &server->batch[i];
+        struct Connection* c = &server->connections[server->batchOwner[i]];
+        char* out = c->output + c->outLength;
+        int room = SERVER_OUTPUT_SIZE - c->outLength, n;
+
+        if (record->kind == INTAKE_SHIPMENT && record->result.success) {
+            n = formatDeliveryInfo(out, room, &server->trucks[record->result.truckIndex], &record->result, server->map, &record->shipment.destination);
+        }
+        else {
+            n = snprintf(out, (size_t)room, "%s\n", record->kind == INTAKE_SHIPMENT ? "Ships tomorrow" : record->message);
+        }
+        out[n++] = '\n';
+        c->outLength += n;
+        c->reserved -= ANSWER_SIZE;
+    }
+
+    // Owners are settled after every answer is in, as settling may close a connection
+    for (int i = 0; i < server->batchCount; i++) {
+        int index = server->batchOwner[i];
+
+        if (server->connections[index].descriptor >= 0 && (i == 0 || server->batchOwner[i - 1] != index)) {
+            writeAnswers(&server->connections[index]);
+            settle(server, index);
+        }
+    }
+}
+
+static int openListener(const char* path) {
+    struct sockaddr_un address;
+    int listener;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        return -1;
+    }
+    unlink(path);
+    if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+/*
+* Name: runIntakeServer
+* Description: Serves shipment requests on a Unix domain socket until stopped
+*/
+int runIntakeServer(const char* path, int maxBatch, struct Truck trucks[], int numTrucks, const struct Map* map) {
+    struct epoll_event events[SERVER_EVENTS];
+    struct Server* server;
+    int wake, placed = 0;
+
+    if (path == NULL || trucks == NULL || map == NULL || maxBatch < 1 || maxBatch > SERVER_BATCH) {
+        return -1;
+    }
+
+    // Too large for the stack
+    server = (struct Server*)malloc(sizeof(struct Server));
+    if (server == NULL) {
+        return -1;
+    }
+    server->listener = openListener(path);
+    server->poller = epoll_create1(EPOLL_CLOEXEC);
+    wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server->listener < 0 || server->poller < 0 || wake < 0) {
+        if (server->listener >= 0) {
+            close(server->listener);
+            unlink(path);
+        }
+        if (server->poller >= 0) {
+            close(server->poller);
+        }
+        if (wake >= 0) {
+            close(wake);
+        }
+        free(server);
+        return -1;
+    }
+
+    server->maxBatch = maxBatch;
+    server->trucks = trucks;
+    server->numTrucks = numTrucks;
+    server->map = map;
+    server->numReady = 0;
+    server->numFree = SERVER_MAX_CLIENTS;
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        server->connections[i].descriptor = -1;
+        server->freeSlots[i] = SERVER_MAX_CLIENTS - 1 - i;
+    }
+    setWatch(server, server->listener, EPOLLIN, TAG_LISTENER, EPOLL_CTL_ADD);
+    setWatch(server, wake, EPOLLIN, TAG_WAKE, EPOLL_CTL_ADD);
+    server->accepting = 1;
+    wakeDescriptor = wake;
+
+    while (!stopping) {
+        // Don't sleep while requests already read are waiting for a batch
+        int n = epoll_wait(server->poller, events, SERVER_EVENTS, server->numReady > 0 ? 0 : -1);
+
+        if (n < 0 && errno != EINTR) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            int tag = (int)events[i].data.u64;
+            struct Connection* c;
+
+            if (tag == TAG_LISTENER) {
+                acceptClients(server);
+                continue;
+            }
+            if (tag == TAG_WAKE) {
+                continue;
+            }
+            c = &server->connections[tag];
+            if (c->descriptor < 0) {
+                continue;       // closed earlier in this round
+            }
+            if (events[i].events & EPOLLOUT) {
+                writeAnswers(c);
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                readRequests(c);
+            }
+            settle(server, tag);
+        }
+
+        gatherBatch(server);
+        if (server->batchCount > 0) {
+            placed += assignIntakeBatch(server->batch, server->batchCount, trucks, numTrucks, map);
+            answerBatch(server);
+        }
+    }
+
+    wakeDescriptor = -1;
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        if (server->connections[i].descriptor >= 0) {
+            close(server->connections[i].descriptor);
+        }
+    }
+    close(server->listener);
+    unlink(path);
+    close(server->poller);
+    close(wake);
+    free(server);
+    stopping = 0;
+    return placed;
+}
+
+/*
+* Name: stopIntakeServer
+* Description: Tells a running server to return
+*/
+void stopIntakeServer(void) {
+    uint64_t one = 1;
+    int wake = wakeDescriptor;
+
+    stopping = 1;
+    if (wake >= 0 && write(wake, &one, sizeof(one)) < 0) {
+        // the server is already awake
+    }
+}
+
+#else
+
+// Other systems have no epoll; the console and pipeline intake still work there
+
+int runIntakeServer(const char* path, int maxBatch, struct Truck trucks[], int numTrucks, const struct Map* map) {
+    (void)path;
+    (void)maxBatch;
+    (void)trucks;
+    (void)numTrucks;
+    (void)map;
+    return -1;
+}
+
+void stopIntakeServer(void) {
+}
+
+#endif
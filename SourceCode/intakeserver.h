@@ -0,0 +1,41 @@
+#ifndef INTAKESERVER_H
+#define INTAKESERVER_H
+
+#include "delivery.h"
+#include "mapping.h"
+
+#define SERVER_MAX_CLIENTS 1024     // connections open at once, more wait to be accepted
+#define SERVER_BATCH 256            // most shipments placed together in one assignIntakeBatch() call
+#define SERVER_INPUT_SIZE 256       // bytes of requests a connection may have waiting to be read
+
+/*
+* Name: runIntakeServer
+* Description: Serves shipment requests on a Unix domain socket until stopIntakeServer() is called.
+*              Each request is one line in the console's format, "weight size destination", and
+*              gets back the lines the console would print for it followed by an empty line.
+*              "0 0 x" or closing the connection ends a client's session. One thread waits on every
+*              connection with epoll; the requests that have come in since it last woke are checked
+*              and placed together as a batch, in the order they were read, and the answers are
+*              written back as each socket has room. The snapshot and backlog set with
+*              useIntakeSnapshot() and useIntakeBacklog() are used as the console uses them.
+*              Only built on Linux; elsewhere it returns -1 at once.
+* Parameters:
+*   - path: where to create the socket; an old socket file there is removed first
+*   - maxBatch: most requests to place together, 1 to SERVER_BATCH
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks in the array
+*   - map: pointer to the map
+* Returns: The number of shipments placed on a truck, or -1 if the socket could not be set up
+*/
+int runIntakeServer(const char* path, int maxBatch, struct Truck trucks[], int numTrucks, const struct Map* map);
+
+/*
+* Name: stopIntakeServer
+* Description: Tells a running runIntakeServer() to close its connections and return. Safe to call
+*              from a signal handler or another thread.
+* Parameters: None
+* Returns: Nothing
+*/
+void stopIntakeServer(void);
+
+#endif
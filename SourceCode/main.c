@@ -1,78 +1,164 @@
 
 #define _CRT_SECURE_NO_WARNINGS
+#include <signal.h>
 #include <stdio.h>
+#include <string.h>
 #include "mapping.h"
 #include "delivery.h"
 #include "MS3FunctionSpecs.h"
+#include "pipeline.h"
+#include "snapshot.h"
+#include "backlog.h"
+#include "intakeserver.h"
+#include "coursetables.h"
+
+// The three trucks with their routes, indexed and empty, copied from the tables built in at compile time
+static void startFresh(struct Truck trucks[]) {
+    for (int i = 0; i < NUM_TRUCKS; i++) {
+        trucks[i] = courseTrucks[i];
+    }
+}
 
-int main() {
-    struct Map baseMap = populateMap();
+static void stopServing(int signalNumber) {
+    (void)signalNumber;
+    stopIntakeServer();
+}
+
+// Usage: DeliveryApp [--serve socket | --end-day] [snapshot file [backlog file]]. With a snapshot file the map, indexes and loads are
+// kept in it, so the next start maps it instead of setting everything up again and carries on after a crash.
+// The loads are only emptied for a new day when the day is ended, by "0 0 x" on the console or by --end-day.
+// With a backlog file the shipments that ship tomorrow are kept in it and placed first on the next run.
+// With --serve shipments come from clients of a Unix domain socket instead of the console until interrupted;
+// stopping the server keeps the day's loads, so a restart carries on with them.
+int main(int argc, char* argv[]) {
+    static struct Snapshot snapshot;
+    static struct CapacityIndex capacity;
+    static struct Backlog backlog;
+    static struct DestinationTable destinations;
     struct Truck trucks[NUM_TRUCKS] = { 0 };
+    const struct Map* map = getCourseMap();
+    const char* socketPath = NULL;
+    const char* snapshotPath;
+    const char* backlogPath;
+    int fromSnapshot = 0;
+    int endDay = 0;
+    int dayEnded = 0;
+
+    if (argc > 2 && strcmp(argv[1], "--serve") == 0) {
+        socketPath = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+    else if (argc > 1 && strcmp(argv[1], "--end-day") == 0) {
+        endDay = 1;
+        argv++;
+        argc--;
+    }
+    snapshotPath = argc > 1 ? argv[1] : NULL;
+    backlogPath = (argc > 2 && !endDay) ? argv[2] : NULL;
+
+    if (snapshotPath != NULL) {
+        fromSnapshot = snapshotOpen(&snapshot, snapshotPath, map, courseTrucks, NUM_TRUCKS);
+        if (!fromSnapshot) {
+            // Missing, from another build, map or routes, or damaged, so make a new one
+            startFresh(trucks);
+            fromSnapshot = snapshotCreate(snapshotPath, map, trucks, NUM_TRUCKS)
+                && snapshotOpen(&snapshot, snapshotPath, map, courseTrucks, NUM_TRUCKS);
+        }
+        if (fromSnapshot && snapshotLoadFleet(&snapshot, trucks, NUM_TRUCKS) != NUM_TRUCKS) {
+            snapshotClose(&snapshot);
+            fromSnapshot = 0;
+        }
+        if (!fromSnapshot) {
+            printf("Could not use snapshot file %s, the day will not be saved\n", snapshotPath);
+        }
+    }
 
-    trucks[0].route = getBlueRoute();
-    trucks[0].truckNumber = 0;
-    trucks[1].route = getGreenRoute();
-    trucks[1].truckNumber = 1;
-    trucks[2].route = getYellowRoute();
-    trucks[2].truckNumber = 2;
+    if (fromSnapshot) {
+        // Used where they lie in the mapped file
+        map = &snapshot.image->map;
+        useFleetIndex(&snapshot.image->fleet, trucks);
+        useMoveTable(&snapshot.image->moves, map);
+        useIntakeSnapshot(&snapshot);
+    }
+    else {
+        // Nothing to work out, the tables are already in read-only data
+        startFresh(trucks);
+        useFleetIndex(&courseFleet, trucks);
+        useMoveTable(&courseMoves, map);
+    }
 
-    for (int i = 0; i < NUM_TRUCKS; i++) {
-        trucks[i].numShipments = 0;
-        trucks[i].currentWeight = 0.0;
-        trucks[i].currentVolume = 0.0;
+    buildCapacityIndex(&capacity, trucks, NUM_TRUCKS);
+    useCapacityIndex(&capacity);
+    if (fromSnapshot) {
+        buildDestinationTable(&destinations, map, trucks, NUM_TRUCKS);
+        useDestinationTable(&destinations, trucks, map);
+    }
+    else {
+        useDestinationTable(&courseDestinations, trucks, map);
     }
 
     printf("=================\nSeneca Polytechnic Deliveries:\n=================\n");
 
-    while (1) {
-        double weight;
-        double volume;
-        char destinationStr[4];  
-        printf("Enter shipment weight, box size and destination (0 0 x to stop): ");
-        int inputs = scanf("%lf %lf %3s", &weight, &volume, destinationStr);
-
-        if (inputs != 3) {
-            while (getchar() != '\n'); 
-            printf("Invalid input\n");
-            continue;
+    if (backlogPath != NULL) {
+        // Earlier days' shipments go first, oldest first, a batch at a time. A missing or damaged
+        // file starts an empty backlog.
+        backlogLoad(&backlog, backlogPath);
+        while (assignBacklog(&backlog, trucks, NUM_TRUCKS, map, BACKLOG_BATCH) > 0) {
         }
-
-        if (weight == 0 && volume == 0 && (destinationStr[0] == 'x' || destinationStr[0] == 'X')) {
-            printf("Thanks for shipping with Seneca Polytechnic!\n");
-            break;
+        if (backlog.placed > 0 || backlog.count > 0) {
+            printf("Carried over: %d placed, %d still waiting\n", backlog.placed, backlog.count);
         }
-
-        if (weight < 1 || weight > 5000) {
-            printf("Invalid weight (must be 1-5000 Kg.)\n");
-            continue;
+        if (backlog.dropped > 0) {
+            printf("Dropped %d carried shipments that can no longer be delivered\n", backlog.dropped);
         }
 
-        if (volume != 0.5 && volume != 2.0 && volume != 5.0) {
-            printf("Invalid size\n");
-            continue;
-        }
-
-        struct Point destination;
-        if (!parseDestination(destinationStr, &destination)) {
-            printf("Invalid destination\n");
-            continue;
+        // The load first, so a crash in between can only place a carried shipment twice, never lose it
+        if (fromSnapshot) {
+            snapshotSaveFleet(&snapshot, trucks, NUM_TRUCKS);
         }
+        backlogSave(&backlog, backlogPath);
+        useIntakeBacklog(&backlog, backlogPath);
+    }
 
-        if (!isValidDestination(&destination, &baseMap)) {
-            printf("Invalid destination\n");
-            continue;
+    if (endDay) {
+        // Nothing to place, only the day to end
+        dayEnded = 1;
+    }
+    else if (socketPath != NULL) {
+        // Every client's requests on one thread, placed a batch at a time
+        signal(SIGINT, stopServing);
+        signal(SIGTERM, stopServing);
+        printf("Serving on %s\n", socketPath);
+        fflush(stdout);
+        if (runIntakeServer(socketPath, SERVER_BATCH, trucks, NUM_TRUCKS, map) < 0) {
+            printf("Could not serve on %s\n", socketPath);
         }
+    }
+    else {
+        // Parsing, checking, assigning and printing each run on their own thread, one shipment after another
+        runIntakePipeline(stdin, trucks, NUM_TRUCKS, map, &dayEnded);
+    }
 
-        struct Shipment shipment = { weight, volume, destination };
-
-        struct DeliveryResult result = assignShipment(trucks, NUM_TRUCKS, &shipment, &baseMap);
+    if (backlogPath != NULL) {
+        useIntakeBacklog(NULL, NULL);
+        backlogSave(&backlog, backlogPath);
+    }
 
-        if (result.success) {
-            printDeliveryInfo(&trucks[result.truckIndex], &result, &baseMap, &shipment.destination);
-        }
-        else {
-            printf("Ships tomorrow\n");
+    if (fromSnapshot) {
+        // Only a finished day empties the trucks for the next start. Stopped by a signal or at the end of
+        // the input, the loads saved after every shipment are left for a restart to carry on with.
+        if (dayEnded) {
+            for (int i = 0; i < NUM_TRUCKS; i++) {
+                trucks[i].numShipments = 0;
+                trucks[i].currentWeight = 0.0;
+                trucks[i].currentVolume = 0.0;
+            }
+            snapshotSaveFleet(&snapshot, trucks, NUM_TRUCKS);
         }
+        useIntakeSnapshot(NULL);
+        useMoveTable(NULL, NULL);
+        snapshotClose(&snapshot);
     }
 
     return 0;
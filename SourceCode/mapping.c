@@ -1,11 +1,11 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include <stdio.h>
 #include "mapping.h"
+#include "pathing.h"
 #include "math.h"
 
-struct Map populateMap()
-{
-	struct Map result = {
+// In read-only data, so it is used where it lies rather than built on every call
+static const struct Map courseMap = {
 		//0	1  2  3  4  5  6  7  8  9  0  1  2  3  4  5  6  7  8  9  0  1  2  3  4
 		//A B  C  D  E  F  G  H  I  J  K  L  M  N  O  P  Q  R  S  T  U  V  W  X  Y
 		{
@@ -36,8 +36,16 @@ struct Map populateMap()
 		{0, 1, 1, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}		//24
 		},
 		MAP_ROWS, MAP_COLS
-	};
-	return result;
+};
+
+struct Map populateMap()
+{
+	return courseMap;
+}
+
+const struct Map* getCourseMap(void)
+{
+	return &courseMap;
 }
 
 int getNumRows(const struct Map* map)
@@ -84,9 +92,7 @@ void printMap(const struct Map* map, const int base1, const int alphaCols)
 	}
 }
 
-struct Route getBlueRoute()
-{
-	struct Route result = {
+static const struct Route blueRoute = {
 		{
 			{0, 0},
 			{1, 0},
@@ -109,13 +115,19 @@ struct Route getBlueRoute()
 				{17, 21},{17, 22},{17, 23},{17, 24},
 		},
 			42, BLUE
-	};
-	return result;
+};
+
+void loadBlueRoute(struct Route* route)
+{
+	*route = blueRoute;
 }
 
-struct Route getGreenRoute()
+struct Route getBlueRoute()
 {
-	struct Route result = {
+	return blueRoute;
+}
+
+static const struct Route greenRoute = {
 		{
 			{0, 0},
 			{1, 0},
@@ -138,13 +150,19 @@ struct Route getGreenRoute()
 			
 		},
 			42, GREEN
-	};
-	return result;
+};
+
+void loadGreenRoute(struct Route* route)
+{
+	*route = greenRoute;
 }
 
-struct Route getYellowRoute()
+struct Route getGreenRoute()
 {
-	struct Route result = {
+	return greenRoute;
+}
+
+static const struct Route yellowRoute = {
 		{
 			{0, 0},
 			{1, 0},
@@ -169,8 +187,16 @@ struct Route getYellowRoute()
 				{19, 13},{19, 14},{19, 15},{19, 16},{19, 17},{19, 18},{19, 19},{19, 20},{19, 21},{19, 22},{19, 23},{19, 24}
 		},
 			48, YELLOW
-	};
-	return result;
+};
+
+void loadYellowRoute(struct Route* route)
+{
+	*route = yellowRoute;
+}
+
+struct Route getYellowRoute()
+{
+	return yellowRoute;
 }
 
 struct Map addRoute(const struct Map* map, const struct Route* route)
@@ -223,46 +249,56 @@ double distance(const struct Point* p1, const struct Point* p2)
 
 struct Route shortestPath(const struct Map* map, const struct Point start, const struct Point dest)
 {
-	struct Route result = { {0,0}, 0, DIVERSION };
-	struct Point last = { -1, -1 };
-	struct Point current = start;
-	struct Route possible = { {0,0},0,0 };
-	int close = 0;
+	return findPath(map, start, dest, getPathEngine());
+}
 
-	while (!eqPt(current, dest) && close >= 0)
+int shortestPathInto(const struct Map* map, const struct Point start, const struct Point dest, struct Route* path)
+{
+	return findPathInto(map, start, dest, getPathEngine(), path);
+}
+
+/*
+* Add a square to a list of moves unless it is the square we came from.
+*/
+static void addMoveIfNot(struct Point moves[MAX_MOVES], int* numMoves, const int row, const int col, const struct Point notThis)
+{
+	if (row != notThis.row || col != notThis.col)
 	{
-		possible = getPossibleMoves(map, current, last);
-		close = getClosestPoint(&possible, dest);
-		if (close >= 0)
-		{
-			last = current;
-			current = possible.points[close];
-			addPtToRoute(&result, current);
-		}
+		moves[*numMoves].row = (char)row;
+		moves[*numMoves].col = (char)col;
+		(*numMoves)++;
 	}
-
-	return result;
 }
 
-struct Route getPossibleMoves(const struct Map* map, const struct Point p1, const struct Point backpath)
+int getPossibleMovesInto(const struct Map* map, const struct Point p1, const struct Point backpath, struct Point moves[MAX_MOVES])
 {
-	struct Route result = { {0,0}, 0, DIVERSION };
+	int n = 0;
+
+	if (getMoveTable(map) != NULL) return listTableMoves(getMoveTable(map), p1, backpath, moves);
 
 	if (p1.row > 0 )
 	{
-		if(map->squares[p1.row - 1][p1.col] != 1) addPointToRouteIfNot(&result, p1.row - 1, p1.col, backpath);	// square above
-		if (p1.col > 0 && map->squares[p1.row - 1][p1.col-1] != 1) addPointToRouteIfNot(&result, p1.row - 1, p1.col-1, backpath);	// top left
-		if (p1.col < (map->numCols-1) && map->squares[p1.row - 1][p1.col + 1] != 1) addPointToRouteIfNot(&result, p1.row - 1, p1.col + 1, backpath);	// top right
+		if(map->squares[p1.row - 1][p1.col] != 1) addMoveIfNot(moves, &n, p1.row - 1, p1.col, backpath);	// square above
+		if (p1.col > 0 && map->squares[p1.row - 1][p1.col-1] != 1) addMoveIfNot(moves, &n, p1.row - 1, p1.col-1, backpath);	// top left
+		if (p1.col < (map->numCols-1) && map->squares[p1.row - 1][p1.col + 1] != 1) addMoveIfNot(moves, &n, p1.row - 1, p1.col + 1, backpath);	// top right
 	}
-	if(p1.col > 0 && map->squares[p1.row][p1.col - 1] != 1)addPointToRouteIfNot(&result, p1.row, p1.col - 1, backpath);	// left
-	if (p1.col < (map->numCols - 1) && map->squares[p1.row][p1.col + 1] != 1)addPointToRouteIfNot(&result, p1.row, p1.col + 1, backpath);	// right
+	if(p1.col > 0 && map->squares[p1.row][p1.col - 1] != 1)addMoveIfNot(moves, &n, p1.row, p1.col - 1, backpath);	// left
+	if (p1.col < (map->numCols - 1) && map->squares[p1.row][p1.col + 1] != 1)addMoveIfNot(moves, &n, p1.row, p1.col + 1, backpath);	// right
 	if (p1.row < (map->numRows - 1))
 	{
-		if (map->squares[p1.row + 1][p1.col] != 1) addPointToRouteIfNot(&result, p1.row + 1, p1.col, backpath);	// square below
-		if (p1.col > 0 && map->squares[p1.row + 1][p1.col - 1] != 1) addPointToRouteIfNot(&result, p1.row + 1, p1.col - 1, backpath);	// bot left
-		if (p1.col < (map->numCols - 1) && map->squares[p1.row + 1][p1.col + 1] != 1) addPointToRouteIfNot(&result, p1.row + 1, p1.col + 1, backpath);	// top right
+		if (map->squares[p1.row + 1][p1.col] != 1) addMoveIfNot(moves, &n, p1.row + 1, p1.col, backpath);	// square below
+		if (p1.col > 0 && map->squares[p1.row + 1][p1.col - 1] != 1) addMoveIfNot(moves, &n, p1.row + 1, p1.col - 1, backpath);	// bot left
+		if (p1.col < (map->numCols - 1) && map->squares[p1.row + 1][p1.col + 1] != 1) addMoveIfNot(moves, &n, p1.row + 1, p1.col + 1, backpath);	// top right
 	}
 
+	return n;
+}
+
+struct Route getPossibleMoves(const struct Map* map, const struct Point p1, const struct Point backpath)
+{
+	struct Route result = { {0,0}, 0, DIVERSION };
+
+	result.numPoints = getPossibleMovesInto(map, p1, backpath, result.points);
 	return result;
 }
 
@@ -272,13 +308,18 @@ int eqPt(const struct Point p1, const struct Point p2)
 }
 
 int getClosestPoint(const struct Route* route, const struct Point pt)
+{
+	return getClosestPointIn(route->points, route->numPoints, pt);
+}
+
+int getClosestPointIn(const struct Point points[], const int numPoints, const struct Point pt)
 {
 	int i, closestIdx = -1;
 	double closestDist = 999999.99, dist;
 
-	for (i = 0; i < route->numPoints; i++)
+	for (i = 0; i < numPoints; i++)
 	{
-		dist = distance(&pt, &route->points[i]);
+		dist = distance(&pt, &points[i]);
 		if (dist < closestDist)
 		{
 			closestDist = dist;
@@ -2,13 +2,22 @@
 #ifndef MAPPING_H
 #define MAPPING_H
 
+// MAP_ROWS, MAP_COLS and MAX_ROUTE can be raised from the compiler command line for large generated
+// maps. A Point stores its row and column in a char so neither dimension can exceed 127.
+#ifndef MAP_ROWS
 #define MAP_ROWS 25
+#endif
+#ifndef MAP_COLS
 #define MAP_COLS 25
+#endif
+#ifndef MAX_ROUTE
 #define MAX_ROUTE 100
+#endif
 #define BLUE 2
 #define GREEN 4
 #define YELLOW 8
 #define DIVERSION 16
+#define MAX_MOVES 8		// squares next to any one square
 
 /**
 * A map is a 2D raster representation of a map with contents of the map encoded as numeric values.
@@ -46,6 +55,12 @@ struct Route
 */
 struct Map populateMap();
 
+/**
+* Get the map populateMap() returns without copying it.
+* @returns - the map with the position of all buildings, which must not be changed.
+*/
+const struct Map* getCourseMap(void);
+
 /**
 * Get the number of rows in a map.
 * @param map - the map to query
@@ -127,6 +142,24 @@ struct Route getGreenRoute();
 */
 struct Route getYellowRoute();
 
+/**
+* Write the route for the blue trucks into caller-provided storage, e.g. straight into a truck.
+* @param route - where to write the route
+*/
+void loadBlueRoute(struct Route* route);
+
+/**
+* Write the route for the green trucks into caller-provided storage.
+* @param route - where to write the route
+*/
+void loadGreenRoute(struct Route* route);
+
+/**
+* Write the route for the yellow trucks into caller-provided storage.
+* @param route - where to write the route
+*/
+void loadYellowRoute(struct Route* route);
+
 /**
 * Calculate the Euclidian distance between two points.
 * @param p1 - the first point
@@ -137,6 +170,7 @@ double distance(const struct Point* p1, const struct Point* p2);
 
 /**
 * Calculate the shortest path between two points so that the path does not pass through buildings.
+* The search algorithm is chosen with setPathEngine() (see pathing.h); the default is the original greedy walk.
 * @param map - the map showing the location of buildings.
 * @param start - the point to start from
 * @param dest - the point to go to
@@ -145,6 +179,17 @@ double distance(const struct Point* p1, const struct Point* p2);
 */
 struct Route shortestPath(const struct Map* map, const struct Point start, const struct Point dest);
 
+/**
+* Calculate the shortest path between two points as shortestPath() does, writing it into caller-provided
+* storage instead of returning a copy.
+* @param map - the map showing the location of buildings.
+* @param start - the point to start from
+* @param dest - the point to go to
+* @param path - where to write the path; it has zero length if there is no path
+* @returns - the number of points in the path.
+*/
+int shortestPathInto(const struct Map* map, const struct Point start, const struct Point dest, struct Route* path);
+
 /**
 * Calculate all adjacent squares to a given point so that the squares do not overpal a building and do not include the backpath.
 * @param map - the map showing the location of buildings.
@@ -154,6 +199,16 @@ struct Route shortestPath(const struct Map* map, const struct Point start, const
 */
 struct Route getPossibleMoves(const struct Map* map, const struct Point p1, const struct Point backpath);
 
+/**
+* Calculate the same squares as getPossibleMoves() into a small array, in the same order.
+* @param map - the map showing the location of buildings.
+* @param p1 - the point to calculate possible moves for
+* @param backpath - the previous point we visited, which is left out
+* @param moves - where to write the squares
+* @returns - the number of squares written.
+*/
+int getPossibleMovesInto(const struct Map* map, const struct Point p1, const struct Point backpath, struct Point moves[MAX_MOVES]);
+
 /**
 * Compare two points for equality.
 * @param p1 - the first point
@@ -171,4 +226,13 @@ int eqPt(const struct Point p1, const struct Point p2);
 */
 int getClosestPoint(const struct Route* route, const struct Point pt);
 
+/**
+* Find the point in an array closest to a single point, as getClosestPoint() does for a route.
+* @param points - the points to search
+* @param numPoints - the number of points in the array
+* @param pt - the point to find the closest member of the array to
+* @returns - the index of the closest point, the first one on a tie, or -1 if the array is empty.
+*/
+int getClosestPointIn(const struct Point points[], const int numPoints, const struct Point pt);
+
 #endif
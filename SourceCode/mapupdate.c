@@ -0,0 +1,593 @@
+#include <stdio.h>
+#include "mapupdate.h"
+#include "pathing.h"
+#include "hpa.h"
+#include "roadgraph.h"
+#include "MS3FunctionSpecs.h"
+
+#define CELL(row, col) ((row) * MAP_COLS + (col))
+#define CELL_ROW(cell) ((cell) / MAP_COLS)
+#define CELL_COL(cell) ((cell) % MAP_COLS)
+
+#define LPA_INFINITY 0xFFFF
+// an inconsistent square is pushed again each time its key changes; once the heap is full the stale
+// entries are dropped, which always leaves at least MAP_CELLS free
+#define LPA_HEAP_MAX (MAP_CELLS * 2)
+
+struct LpaEntry
+{
+	int key1;
+	int key2;
+	int cell;
+};
+
+/*
+* The Lifelong Planning A* state of one diversion. g is the cost of the best path found to each square so
+* far and rhs the cost through its best neighbour; a square whose two values differ is on the heap.
+*/
+struct ActiveDiversion
+{
+	int inUse;
+	int truckNumber;
+	int startCell;
+	int goalCell;
+	unsigned short g[MAP_CELLS];
+	unsigned short rhs[MAP_CELLS];
+	struct LpaEntry heap[LPA_HEAP_MAX];
+	int heapSize;
+	struct Route given;	// the diversion the truck was last told about
+};
+
+static MapObserver observers[MAX_MAP_OBSERVERS];
+static void* observerContexts[MAX_MAP_OBSERVERS];
+static int numObservers;
+
+static struct ActiveDiversion diversions[MAX_ACTIVE_DIVERSIONS];
+static DiversionListener listener;
+static void* listenerContext;
+
+static int floodQueue[MAP_CELLS];
+
+static const int moveRow[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+static const int moveCol[8] = { 0, -1, 1, -1, 1, 0, -1, 1 };
+
+static int absInt(const int value)
+{
+	return value < 0 ? -value : value;
+}
+
+static int minInt(const int a, const int b)
+{
+	return a < b ? a : b;
+}
+
+static int isOpenCell(const struct Map* map, const int cell)
+{
+	return isOpenSquare(map, CELL_ROW(cell), CELL_COL(cell));
+}
+
+/*
+* Give every open square joined to the first one and labelled oldLabel the label newLabel instead.
+*/
+static void floodLabel(struct ReachabilityLabels* labels, const struct Map* map, const int firstCell,
+	const int oldLabel, const int newLabel)
+{
+	int head = 0, tail = 0, cell, next, i;
+
+	labels->label[firstCell] = newLabel;
+	floodQueue[tail++] = firstCell;
+	while (head < tail)
+	{
+		cell = floodQueue[head++];
+		for (i = 0; i < 8; i++)
+		{
+			if (isOpenSquare(map, CELL_ROW(cell) + moveRow[i], CELL_COL(cell) + moveCol[i]))
+			{
+				next = cell + moveRow[i] * MAP_COLS + moveCol[i];
+				if (labels->label[next] == oldLabel)
+				{
+					labels->label[next] = newLabel;
+					floodQueue[tail++] = next;
+				}
+			}
+		}
+	}
+}
+
+void buildReachability(struct ReachabilityLabels* labels, const struct Map* map)
+{
+	int cell;
+
+	labels->nextLabel = 1;
+	for (cell = 0; cell < MAP_CELLS; cell++)
+	{
+		// -1 marks an open square that has not been reached yet
+		labels->label[cell] = isOpenCell(map, cell) ? -1 : 0;
+	}
+	for (cell = 0; cell < MAP_CELLS; cell++)
+	{
+		if (labels->label[cell] == -1)
+		{
+			floodLabel(labels, map, cell, -1, labels->nextLabel++);
+		}
+	}
+}
+
+/*
+* Split the open squares around a square into groups that are joined to each other without passing
+* through it. Returns the number of groups and the first square of each one.
+*/
+static int neighbourGroups(const struct Map* map, const int row, const int col, int firstCells[8])
+{
+	int open[8], group[8], numOpen = 0, numGroups = 0, changed, i, j;
+
+	for (i = 0; i < 8; i++)
+	{
+		if (isOpenSquare(map, row + moveRow[i], col + moveCol[i]))
+		{
+			open[numOpen] = i;
+			group[numOpen++] = -1;
+		}
+	}
+	for (i = 0; i < numOpen; i++)
+	{
+		if (group[i] != -1) continue;
+
+		group[i] = numGroups;
+		firstCells[numGroups++] = CELL(row + moveRow[open[i]], col + moveCol[open[i]]);
+		do
+		{
+			changed = 0;
+			for (j = 0; j < numOpen; j++)
+			{
+				int k;
+
+				for (k = 0; group[j] == -1 && k < numOpen; k++)
+				{
+					if (group[k] == group[i] &&
+						absInt(moveRow[open[j]] - moveRow[open[k]]) <= 1 &&
+						absInt(moveCol[open[j]] - moveCol[open[k]]) <= 1)
+					{
+						group[j] = group[i];
+						changed = 1;
+					}
+				}
+			}
+		} while (changed);
+	}
+	return numGroups;
+}
+
+void updateReachability(struct ReachabilityLabels* labels, const struct Map* map, const int row, const int col)
+{
+	int cell = CELL(row, col), firstCells[8], numGroups, oldLabel, i;
+
+	if (isOpenSquare(map, row, col))
+	{
+		// join every part the square touches into the part of its first open neighbour
+		labels->label[cell] = 0;
+		for (i = 0; i < 8; i++)
+		{
+			if (isOpenSquare(map, row + moveRow[i], col + moveCol[i]))
+			{
+				int next = cell + moveRow[i] * MAP_COLS + moveCol[i];
+
+				if (labels->label[cell] == 0)
+				{
+					labels->label[cell] = labels->label[next];
+				}
+				else if (labels->label[next] != labels->label[cell])
+				{
+					floodLabel(labels, map, next, labels->label[next], labels->label[cell]);
+				}
+			}
+		}
+		if (labels->label[cell] == 0)
+		{
+			labels->label[cell] = labels->nextLabel++;
+		}
+	}
+	else if (labels->label[cell] != 0)
+	{
+		oldLabel = labels->label[cell];
+		labels->label[cell] = 0;
+
+		// the part can only split if the squares around this one are not joined to each other directly
+		numGroups = neighbourGroups(map, row, col, firstCells);
+		for (i = 0; numGroups > 1 && i < numGroups; i++)
+		{
+			if (labels->label[firstCells[i]] == oldLabel)
+			{
+				floodLabel(labels, map, firstCells[i], oldLabel, labels->nextLabel++);
+			}
+		}
+	}
+}
+
+int isReachable(const struct ReachabilityLabels* labels, const struct Point from, const struct Point to)
+{
+	if (from.row < 0 || from.row >= MAP_ROWS || from.col < 0 || from.col >= MAP_COLS ||
+		to.row < 0 || to.row >= MAP_ROWS || to.col < 0 || to.col >= MAP_COLS)
+	{
+		return 0;
+	}
+	return labels->label[CELL(from.row, from.col)] != 0 &&
+		labels->label[CELL(from.row, from.col)] == labels->label[CELL(to.row, to.col)];
+}
+
+void reachabilityMapObserver(const struct Map* map, const int row, const int col, void* context)
+{
+	updateReachability((struct ReachabilityLabels*)context, map, row, col);
+}
+
+void hpaMapObserver(const struct Map* map, const int row, const int col, void* context)
+{
+	hpaUpdateCell((struct HpaIndex*)context, map, row, col);
+}
+
+void moveTableMapObserver(const struct Map* map, const int row, const int col, void* context)
+{
+	updateMoveTable((struct MoveTable*)context, map, row, col);
+}
+
+void roadMapObserver(const struct Map* map, const int row, const int col, void* context)
+{
+	(void)row;
+	(void)col;
+	roadBuild((struct RoadIndex*)context, map);
+}
+
+void destinationMapObserver(const struct Map* map, const int row, const int col, void* context)
+{
+	const struct DestinationWatch* watch = (const struct DestinationWatch*)context;
+
+	(void)row;
+	(void)col;
+	buildDestinationTable(watch->table, map, watch->trucks, watch->numTrucks);
+}
+
+int addMapObserver(MapObserver observer, void* context)
+{
+	if (observer == NULL || numObservers >= MAX_MAP_OBSERVERS) return 0;
+
+	observers[numObservers] = observer;
+	observerContexts[numObservers++] = context;
+	return 1;
+}
+
+void removeMapObserver(MapObserver observer, void* context)
+{
+	int i, j;
+
+	for (i = 0; i < numObservers; i++)
+	{
+		if (observers[i] == observer && observerContexts[i] == context)
+		{
+			for (j = i + 1; j < numObservers; j++)
+			{
+				observers[j - 1] = observers[j];
+				observerContexts[j - 1] = observerContexts[j];
+			}
+			numObservers--;
+			return;
+		}
+	}
+}
+
+/*
+* The number of moves from a square to the destination when nothing is in the way.
+*/
+static int heuristic(const struct ActiveDiversion* d, const int cell)
+{
+	int deltaRow = absInt(CELL_ROW(d->goalCell) - CELL_ROW(cell));
+	int deltaCol = absInt(CELL_COL(d->goalCell) - CELL_COL(cell));
+
+	return deltaRow > deltaCol ? deltaRow : deltaCol;
+}
+
+static struct LpaEntry calculateKey(const struct ActiveDiversion* d, const int cell)
+{
+	struct LpaEntry entry;
+
+	entry.key2 = minInt(d->g[cell], d->rhs[cell]);
+	entry.key1 = entry.key2 + heuristic(d, cell);
+	entry.cell = cell;
+	return entry;
+}
+
+static int keyLess(const struct LpaEntry* a, const struct LpaEntry* b)
+{
+	return a->key1 < b->key1 || (a->key1 == b->key1 && a->key2 < b->key2);
+}
+
+static void heapMoveUp(struct ActiveDiversion* d, int i)
+{
+	struct LpaEntry entry = d->heap[i];
+
+	while (i > 0 && keyLess(&entry, &d->heap[(i - 1) / 2]))
+	{
+		d->heap[i] = d->heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	d->heap[i] = entry;
+}
+
+static void heapMoveDown(struct ActiveDiversion* d, int i)
+{
+	struct LpaEntry entry = d->heap[i];
+	int child;
+
+	while ((child = 2 * i + 1) < d->heapSize)
+	{
+		if (child + 1 < d->heapSize && keyLess(&d->heap[child + 1], &d->heap[child])) child++;
+		if (!keyLess(&d->heap[child], &entry)) break;
+		d->heap[i] = d->heap[child];
+		i = child;
+	}
+	d->heap[i] = entry;
+}
+
+/*
+* Put a square on the heap with its current key. Older entries for the same square are left where they
+* are and skipped when they come off the heap.
+*/
+static void heapPush(struct ActiveDiversion* d, const int cell)
+{
+	int i;
+
+	if (d->heapSize == LPA_HEAP_MAX)
+	{
+		d->heapSize = 0;
+		for (i = 0; i < MAP_CELLS; i++)
+		{
+			if (d->g[i] != d->rhs[i] && i != cell)
+			{
+				d->heap[d->heapSize++] = calculateKey(d, i);
+			}
+		}
+		for (i = d->heapSize / 2 - 1; i >= 0; i--)
+		{
+			heapMoveDown(d, i);
+		}
+	}
+	d->heap[d->heapSize++] = calculateKey(d, cell);
+	heapMoveUp(d, d->heapSize - 1);
+}
+
+static struct LpaEntry heapPop(struct ActiveDiversion* d)
+{
+	struct LpaEntry top = d->heap[0];
+
+	d->heap[0] = d->heap[--d->heapSize];
+	heapMoveDown(d, 0);
+	return top;
+}
+
+/*
+* Recalculate the cost of reaching a square through its best neighbour and queue it if that no longer
+* matches the cost it was reached with.
+*/
+static void updateVertex(struct ActiveDiversion* d, const struct Map* map, const int cell)
+{
+	int best = LPA_INFINITY, row, col, i;
+
+	// the truck is already on the leave point, so like findPath() it may leave from a closed square
+	if (cell == d->startCell)
+	{
+		best = 0;
+	}
+	else if (isOpenCell(map, cell))
+	{
+		for (i = 0; i < 8; i++)
+		{
+			row = CELL_ROW(cell) + moveRow[i];
+			col = CELL_COL(cell) + moveCol[i];
+			if (isOpenSquare(map, row, col) || (row >= 0 && row < MAP_ROWS && col >= 0 && col < MAP_COLS &&
+				CELL(row, col) == d->startCell))
+			{
+				best = minInt(best, d->g[CELL(row, col)] + 1);
+			}
+		}
+	}
+	d->rhs[cell] = (unsigned short)minInt(best, LPA_INFINITY);
+	if (d->g[cell] != d->rhs[cell])
+	{
+		heapPush(d, cell);
+	}
+}
+
+static void updateNeighbours(struct ActiveDiversion* d, const struct Map* map, const int cell)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		if (CELL_ROW(cell) + moveRow[i] >= 0 && CELL_ROW(cell) + moveRow[i] < MAP_ROWS &&
+			CELL_COL(cell) + moveCol[i] >= 0 && CELL_COL(cell) + moveCol[i] < MAP_COLS)
+		{
+			updateVertex(d, map, cell + moveRow[i] * MAP_COLS + moveCol[i]);
+		}
+	}
+}
+
+static void computeShortestPath(struct ActiveDiversion* d, const struct Map* map)
+{
+	struct LpaEntry top, goalKey, current;
+
+	while (d->heapSize > 0)
+	{
+		goalKey = calculateKey(d, d->goalCell);
+		if (!keyLess(&d->heap[0], &goalKey) && d->rhs[d->goalCell] == d->g[d->goalCell]) break;
+
+		top = heapPop(d);
+		current = calculateKey(d, top.cell);
+		if (d->g[top.cell] == d->rhs[top.cell] || current.key1 != top.key1 || current.key2 != top.key2)
+		{
+			continue;	// stale entry
+		}
+
+		if (d->g[top.cell] > d->rhs[top.cell])
+		{
+			d->g[top.cell] = d->rhs[top.cell];
+		}
+		else
+		{
+			d->g[top.cell] = LPA_INFINITY;
+			updateVertex(d, map, top.cell);
+		}
+		updateNeighbours(d, map, top.cell);
+	}
+}
+
+/*
+* Follow the costs back from the destination to the leave point.
+*/
+static struct Route extractPath(const struct ActiveDiversion* d)
+{
+	struct Route route = { { {0,0} }, 0, DIVERSION };
+	int length = d->g[d->goalCell], cell = d->goalCell, next, best, i, n;
+
+	if (length == LPA_INFINITY || length == 0 || length > MAX_ROUTE) return route;
+
+	for (n = length - 1; n >= 0; n--)
+	{
+		route.points[n].row = (char)CELL_ROW(cell);
+		route.points[n].col = (char)CELL_COL(cell);
+		best = -1;
+		for (i = 0; i < 8; i++)
+		{
+			// every square on a shortest path is settled, while a square that has just closed
+			// may still have its old cost until it is taken off the heap
+			if (CELL_ROW(cell) + moveRow[i] >= 0 && CELL_ROW(cell) + moveRow[i] < MAP_ROWS &&
+				CELL_COL(cell) + moveCol[i] >= 0 && CELL_COL(cell) + moveCol[i] < MAP_COLS)
+			{
+				next = cell + moveRow[i] * MAP_COLS + moveCol[i];
+				if (d->g[next] == d->rhs[next] && (best == -1 || d->g[next] < d->g[best])) best = next;
+			}
+		}
+		if (best == -1 || d->g[best] != n)
+		{
+			route.numPoints = 0;
+			return route;
+		}
+		cell = best;
+	}
+	route.numPoints = length;
+	return route;
+}
+
+static int routeUsesCell(const struct Route* route, const int cell)
+{
+	int i;
+
+	for (i = 0; i < route->numPoints; i++)
+	{
+		if (CELL(route->points[i].row, route->points[i].col) == cell) return 1;
+	}
+	return 0;
+}
+
+int startDiversion(const struct Map* map, const int truckNumber, const struct Route* route, const struct Point dest)
+{
+	struct ActiveDiversion* d;
+	int leave, id, i;
+
+	leave = getClosestPoint(route, dest);
+	if (leave < 0 || dest.row < 0 || dest.row >= MAP_ROWS || dest.col < 0 || dest.col >= MAP_COLS) return -1;
+
+	for (id = 0; id < MAX_ACTIVE_DIVERSIONS && diversions[id].inUse; id++)
+	{
+	}
+	if (id == MAX_ACTIVE_DIVERSIONS) return -1;
+
+	d = &diversions[id];
+	d->inUse = 1;
+	d->truckNumber = truckNumber;
+	d->startCell = CELL(route->points[leave].row, route->points[leave].col);
+	d->goalCell = CELL(dest.row, dest.col);
+	d->heapSize = 0;
+	for (i = 0; i < MAP_CELLS; i++)
+	{
+		d->g[i] = LPA_INFINITY;
+		d->rhs[i] = LPA_INFINITY;
+	}
+	updateVertex(d, map, d->startCell);
+	computeShortestPath(d, map);
+	d->given = extractPath(d);
+	return id;
+}
+
+void endDiversion(const int id)
+{
+	if (id >= 0 && id < MAX_ACTIVE_DIVERSIONS)
+	{
+		diversions[id].inUse = 0;
+	}
+}
+
+struct Route getActiveDiversion(const int id)
+{
+	struct Route empty = { { {0,0} }, 0, DIVERSION };
+
+	if (id < 0 || id >= MAX_ACTIVE_DIVERSIONS || !diversions[id].inUse) return empty;
+	return extractPath(&diversions[id]);
+}
+
+void setDiversionListener(DiversionListener newListener, void* context)
+{
+	listener = newListener;
+	listenerContext = context;
+}
+
+/*
+* Repair every active diversion after one square has changed. A diversion is replaced, and the truck told,
+* when the square closes across its path or when a destination that could not be reached becomes reachable.
+*/
+static void repairDiversions(const struct Map* map, const int cell)
+{
+	struct ActiveDiversion* d;
+	int id, stale;
+
+	for (id = 0; id < MAX_ACTIVE_DIVERSIONS; id++)
+	{
+		d = &diversions[id];
+		if (!d->inUse || d->startCell == d->goalCell) continue;
+
+		updateVertex(d, map, cell);
+		updateNeighbours(d, map, cell);
+		computeShortestPath(d, map);
+
+		if (isOpenCell(map, cell))
+		{
+			stale = d->given.numPoints == 0;
+		}
+		else
+		{
+			stale = routeUsesCell(&d->given, cell);
+		}
+		if (stale)
+		{
+			d->given = extractPath(d);
+			if (listener != NULL && (d->given.numPoints > 0 || !isOpenCell(map, cell)))
+			{
+				listener(d->truckNumber, &d->given, listenerContext);
+			}
+		}
+	}
+}
+
+int setSquareBlocked(struct Map* map, const int row, const int col, const int blocked)
+{
+	int i;
+
+	if (row < 0 || row >= map->numRows || col < 0 || col >= map->numCols) return 0;
+	if ((map->squares[row][col] == 1) == (blocked != 0)) return 0;
+
+	map->squares[row][col] = blocked ? 1 : 0;
+	for (i = 0; i < numObservers; i++)
+	{
+		observers[i](map, row, col, observerContexts[i]);
+	}
+	repairDiversions(map, CELL(row, col));
+	return 1;
+}
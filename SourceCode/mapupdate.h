@@ -0,0 +1,167 @@
+#ifndef MAPUPDATE_H
+#define MAPUPDATE_H
+
+#include "delivery.h"
+#include "mapping.h"
+#include "pathing.h"
+
+// the most functions that can be told about map changes at once
+#ifndef MAX_MAP_OBSERVERS
+#define MAX_MAP_OBSERVERS 8
+#endif
+
+// the most diversions that can be kept up to date at once
+#ifndef MAX_ACTIVE_DIVERSIONS
+#define MAX_ACTIVE_DIVERSIONS 8
+#endif
+
+/**
+* A function told about every square that setSquareBlocked() opens or closes. It is called after the
+* square in the map has been changed.
+*/
+typedef void (*MapObserver)(const struct Map* map, const int row, const int col, void* context);
+
+/**
+* A function told when a change to the map makes an active diversion unusable. The diversion passed in is
+* the repaired one, or a Route of zero length if the destination can no longer be reached.
+*/
+typedef void (*DiversionListener)(const int truckNumber, const struct Route* diversion, void* context);
+
+/**
+* Which squares can be reached from which. Two open squares have the same label exactly when there is a
+* path between them; buildings have the label 0. It contains no pointers so it can be copied or saved as it is.
+*/
+struct ReachabilityLabels
+{
+	int nextLabel;
+	int label[MAP_CELLS];
+};
+
+/**
+* The context destinationMapObserver() needs: the table and the trucks it was built from, which must stay
+* where they are while the observer is added.
+*/
+struct DestinationWatch
+{
+	struct DestinationTable* table;
+	const struct Truck* trucks;
+	int numTrucks;
+};
+
+/**
+* Close a square to traffic or open it again, then bring everything registered with addMapObserver() and
+* every active diversion up to date.
+* @param map - the map to change
+* @param row - the row of the square
+* @param col - the column of the square
+* @param blocked - true to close the square, false to open it
+* @returns - true if the square changed, false if it is off the map or was already in that state.
+*/
+int setSquareBlocked(struct Map* map, const int row, const int col, const int blocked);
+
+/**
+* Have a function called whenever setSquareBlocked() changes a square.
+* @param observer - the function to call
+* @param context - passed to the function unchanged
+* @returns - true if it was added, false if MAX_MAP_OBSERVERS are already registered.
+*/
+int addMapObserver(MapObserver observer, void* context);
+
+/**
+* Stop calling a function added with addMapObserver().
+* @param observer - the function that was added
+* @param context - the context it was added with
+*/
+void removeMapObserver(MapObserver observer, void* context);
+
+/**
+* A MapObserver that keeps the struct HpaIndex passed as its context up to date.
+*/
+void hpaMapObserver(const struct Map* map, const int row, const int col, void* context);
+
+/**
+* A MapObserver that keeps the struct ReachabilityLabels passed as its context up to date.
+*/
+void reachabilityMapObserver(const struct Map* map, const int row, const int col, void* context);
+
+/**
+* A MapObserver that keeps the struct MoveTable passed as its context up to date.
+*/
+void moveTableMapObserver(const struct Map* map, const int row, const int col, void* context);
+
+/**
+* A MapObserver that keeps the struct RoadIndex passed as its context up to date. A contraction hierarchy
+* cannot be patched one square at a time, so it is built again from the whole map, which takes far longer
+* than the other observers. If the changed map needs too many arcs the index is left incomplete and
+* calculateRouteDistance() and findPath() go back to the grid.
+*/
+void roadMapObserver(const struct Map* map, const int row, const int col, void* context);
+
+/**
+* A MapObserver that keeps the destination table of the struct DestinationWatch passed as its context up
+* to date, so isValidDestination() accepts a square that was opened and turns down one that was closed or
+* cut off. The table is flooded again from the routes, which only takes one pass over the map.
+*/
+void destinationMapObserver(const struct Map* map, const int row, const int col, void* context);
+
+/**
+* Label every open square of a map with the part of the map it belongs to.
+* @param labels - the labels to fill in
+* @param map - the map showing the location of buildings.
+*/
+void buildReachability(struct ReachabilityLabels* labels, const struct Map* map);
+
+/**
+* Bring the labels up to date after one square of the map has been opened or closed. Opening a square only
+* relabels the parts it joins together. Closing one only searches the map when the squares around it are not
+* still joined to each other.
+* @param labels - the labels built from the map before the change
+* @param map - the map after the change
+* @param row - the row of the square that changed
+* @param col - the column of the square that changed
+*/
+void updateReachability(struct ReachabilityLabels* labels, const struct Map* map, const int row, const int col);
+
+/**
+* Determine if there is any path between two points.
+* @param labels - the labels for the map
+* @param from - the first point
+* @param to - the second point
+* @returns - true if both points are open squares joined by a path.
+*/
+int isReachable(const struct ReachabilityLabels* labels, const struct Point from, const struct Point to);
+
+/**
+* Start keeping a truck's diversion up to date. The diversion leaves from the point on the route closest to
+* the destination, as in findDiversion(), and is repaired with Lifelong Planning A* each time
+* setSquareBlocked() changes the map instead of being searched for again.
+* @param map - the map showing the location of buildings. Later changes must be made to the same map.
+* @param truckNumber - the truck the diversion belongs to, passed to the DiversionListener
+* @param route - the route the truck follows
+* @param dest - the point to deliver to
+* @returns - an id for the diversion or -1 if the route is empty or MAX_ACTIVE_DIVERSIONS are already active.
+*/
+int startDiversion(const struct Map* map, const int truckNumber, const struct Route* route, const struct Point dest);
+
+/**
+* Stop keeping a diversion up to date.
+* @param id - the id returned by startDiversion()
+*/
+void endDiversion(const int id);
+
+/**
+* Get the current shortest path of an active diversion.
+* @param id - the id returned by startDiversion()
+* @returns - the diversion, not including the route point it leaves from, with the DIVERSION symbol, or a
+* Route of zero length if the destination cannot be reached, is on the route, or id is not active.
+*/
+struct Route getActiveDiversion(const int id);
+
+/**
+* Set the function called when a change to the map blocks the path of an active diversion.
+* @param listener - the function to call, or NULL for none
+* @param context - passed to the function unchanged
+*/
+void setDiversionListener(DiversionListener listener, void* context);
+
+#endif
@@ -0,0 +1,218 @@
+/*
+* Purpose: Delivery output formatted on its own thread and written out in large blocks
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <string.h>
+#include "outputsink.h"
+#include "MS3FunctionSpecs.h"
+#include "pathing.h"
+
+// Writes out whatever is waiting in the buffer
+static void flushBuffer(struct OutputSink* sink) {
+    if (sink->used > 0) {
+        fwrite(sink->buffer, 1, sink->used, sink->output);
+        fflush(sink->output);
+        sink->used = 0;
+        sink->writes++;
+    }
+}
+
+// Makes sure the buffer has room for a record of up to size bytes
+static void makeRoom(struct OutputSink* sink, int size) {
+    if (SINK_BUFFER_SIZE - sink->used < size) {
+        flushBuffer(sink);
+    }
+}
+
+static void appendBytes(struct OutputSink* sink, const char* bytes, int size) {
+    if (size > SINK_BUFFER_SIZE) {
+        flushBuffer(sink);
+        fwrite(bytes, 1, size, sink->output);
+        fflush(sink->output);
+        sink->writes++;
+        return;
+    }
+    makeRoom(sink, size);
+    memcpy(sink->buffer + sink->used, bytes, size);
+    sink->used += size;
+}
+
+static void appendDelivery(struct OutputSink* sink, const struct SinkRecord* record) {
+    makeRoom(sink, DELIVERY_INFO_SIZE);
+
+    if (sink->format == SINK_FORMAT_TEXT) {
+        sink->used += formatDeliveryInfo(sink->buffer + sink->used, SINK_BUFFER_SIZE - sink->used,
+            record->truck, &record->result, sink->map, &record->destination);
+    }
+    else {
+        unsigned char* out = (unsigned char*)sink->buffer + sink->used;
+        int n = 0;
+
+        out[0] = 'D';
+        out[1] = (unsigned char)(record->truck->truckNumber & 0xff);
+        out[2] = (unsigned char)((record->truck->truckNumber >> 8) & 0xff);
+        out[3] = (unsigned char)(record->result.needsDiversion != 0);
+        if (record->result.needsDiversion && !isOnRoute(record->truck, record->destination)) {
+            struct Route diversion;
+            int leaveFrom = getClosestRoutePoint(record->truck, record->destination);
+
+            findDiversionInto(sink->map, &record->truck->route, record->destination, &diversion);
+            if (leaveFrom >= 0) {
+                out[6 + 2 * n] = (unsigned char)record->truck->route.points[leaveFrom].row;
+                out[7 + 2 * n] = (unsigned char)record->truck->route.points[leaveFrom].col;
+                n++;
+            }
+            for (int i = 0; i < diversion.numPoints; i++, n++) {
+                out[6 + 2 * n] = (unsigned char)diversion.points[i].row;
+                out[7 + 2 * n] = (unsigned char)diversion.points[i].col;
+            }
+        }
+        out[4] = (unsigned char)(n & 0xff);
+        out[5] = (unsigned char)((n >> 8) & 0xff);
+        sink->used += 6 + 2 * n;
+    }
+}
+
+static void appendText(struct OutputSink* sink, const struct SinkRecord* record) {
+    int length = (int)strlen(record->text);
+
+    if (sink->format == SINK_FORMAT_TEXT) {
+        appendBytes(sink, record->text, length);
+        if (record->kind == SINK_LINE) {
+            appendBytes(sink, "\n", 1);
+        }
+    }
+    else if (record->kind == SINK_LINE) {
+        char header[3];
+
+        if (length > 0xffff) {
+            length = 0xffff;
+        }
+        header[0] = 'L';
+        header[1] = (char)(length & 0xff);
+        header[2] = (char)((length >> 8) & 0xff);
+        appendBytes(sink, header, 3);
+        appendBytes(sink, record->text, length);
+    }
+}
+
+// The sink thread: format while records keep coming, write out whenever the ring runs dry
+static void sinkMain(void* argument) {
+    struct OutputSink* sink = (struct OutputSink*)argument;
+    unsigned long head = sink->head;
+    int stopping = 0;
+    int round = 0;
+
+    while (!stopping) {
+        if (counterLoad(&sink->tail) != head) {
+            const struct SinkRecord* record = &sink->slots[head & (SINK_SLOTS - 1)];
+
+            if (record->kind == SINK_DELIVERY) {
+                appendDelivery(sink, record);
+            }
+            else if (record->kind == SINK_STOP) {
+                stopping = 1;
+            }
+            else {
+                appendText(sink, record);
+            }
+            head++;
+            counterStore(&sink->head, head);    // hands the slot back
+            round = 0;
+        }
+        else {
+            flushBuffer(sink);
+            counterStore(&sink->written, head);
+            backOff(round++);
+        }
+    }
+    flushBuffer(sink);
+    counterStore(&sink->written, head);
+}
+
+/*
+* Name: sinkOpen
+* Description: Starts a sink's thread
+*/
+int sinkOpen(struct OutputSink* sink, FILE* output, enum SinkFormat format, const struct Map* map) {
+    if (sink == NULL || output == NULL || map == NULL) {
+        return 0;
+    }
+    sink->output = output;
+    sink->format = format;
+    sink->map = map;
+    sink->used = 0;
+    sink->writes = 0;
+    counterStore(&sink->head, 0);
+    counterStore(&sink->tail, 0);
+    counterStore(&sink->written, 0);
+    return threadStart(&sink->thread, sinkMain, sink);
+}
+
+/*
+* Name: sinkPost
+* Description: Hands a record to the sink
+*/
+void sinkPost(struct OutputSink* sink, const struct SinkRecord* record) {
+    unsigned long tail = sink->tail;    // only this thread writes it
+
+    for (int round = 0; tail - counterLoad(&sink->head) >= SINK_SLOTS; round++) {
+        backOff(round);
+    }
+    sink->slots[tail & (SINK_SLOTS - 1)] = *record;
+    counterStore(&sink->tail, tail + 1);   // publishes the slot
+}
+
+/*
+* Name: sinkDelivery
+* Description: Posts where a shipment went
+*/
+void sinkDelivery(struct OutputSink* sink, const struct Truck* truck, const struct DeliveryResult* result, const struct Point* destination) {
+    struct SinkRecord record;
+
+    memset(&record, 0, sizeof(record));
+    record.kind = SINK_DELIVERY;
+    record.truck = truck;
+    record.result = *result;
+    record.destination = *destination;
+    sinkPost(sink, &record);
+}
+
+/*
+* Name: sinkText
+* Description: Posts a line of text or a prompt
+*/
+void sinkText(struct OutputSink* sink, enum SinkKind kind, const char* text) {
+    struct SinkRecord record;
+
+    memset(&record, 0, sizeof(record));
+    record.kind = kind;
+    record.text = text;
+    sinkPost(sink, &record);
+}
+
+/*
+* Name: sinkFlush
+* Description: Waits until everything posted has been written out
+*/
+void sinkFlush(struct OutputSink* sink) {
+    unsigned long tail = sink->tail;
+
+    for (int round = 0; counterLoad(&sink->written) != tail; round++) {
+        backOff(round);
+    }
+}
+
+/*
+* Name: sinkClose
+* Description: Writes out everything posted and stops the sink's thread
+*/
+void sinkClose(struct OutputSink* sink) {
+    struct SinkRecord record;
+
+    memset(&record, 0, sizeof(record));
+    record.kind = SINK_STOP;
+    sinkPost(sink, &record);
+    threadJoin(&sink->thread);
+}
@@ -0,0 +1,135 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include <stdio.h>
+#include "delivery.h"
+#include "mapping.h"
+#include "platform.h"
+
+#define SINK_SLOTS 256              // must be a power of two
+#define SINK_BUFFER_SIZE 65536      // bytes gathered before a write
+
+/**
+ * How an output sink writes its records.
+ *
+ * SINK_FORMAT_TEXT writes exactly what printDeliveryInfo() and printf() would have printed.
+ *
+ * SINK_FORMAT_BINARY writes one packed record per delivery or line and drops prompts:
+ *   delivery: 'D', truck number (2 bytes, low first), needsDiversion (1 byte), n (2 bytes, low
+ *             first), then n row/col byte pairs, the route point the truck leaves from first and
+ *             then every square of the diversion; n is 0 when there is no diversion
+ *   line:     'L', length (2 bytes, low first), then the characters without a newline
+ */
+enum SinkFormat {
+    SINK_FORMAT_TEXT,
+    SINK_FORMAT_BINARY
+};
+
+/**
+ * What a sink record asks to be written
+ */
+enum SinkKind {
+    SINK_DELIVERY,      // where a shipment went, as printDeliveryInfo() shows it
+    SINK_LINE,          // text followed by a newline
+    SINK_PROMPT,        // text with no newline, only written in text format
+    SINK_STOP           // everything is written, the sink thread finishes
+};
+
+/**
+ * One thing to write. Only what is needed to describe it is copied in; the diversion is worked
+ * out and the text built on the sink thread.
+ */
+struct SinkRecord {
+    enum SinkKind kind;
+    const struct Truck* truck;      // its route and number must not change while the sink runs
+    struct DeliveryResult result;
+    struct Point destination;
+    const char* text;               // for lines and prompts, must outlive the sink
+};
+
+/**
+ * Formats records on a thread of its own and writes them in large blocks. Records arrive through
+ * a single-producer single-consumer ring like the intake pipeline's. The buffer is written out
+ * when it fills, when the ring runs dry and when the sink stops, so a prompt still shows up as
+ * soon as it is posted but a busy stream goes out in few writes.
+ */
+struct OutputSink {
+    FILE* output;
+    enum SinkFormat format;
+    const struct Map* map;
+    volatile unsigned long head;        // next slot to read, written by the sink thread
+    char headPadding[60];               // keep the counters on separate cache lines
+    volatile unsigned long tail;        // next slot to write, written by the poster
+    char tailPadding[60];
+    volatile unsigned long written;     // records whose bytes have been written out
+    struct SinkRecord slots[SINK_SLOTS];
+    int used;                           // bytes waiting in buffer
+    long writes;                        // number of writes made so far
+    char buffer[SINK_BUFFER_SIZE];
+    struct Thread thread;
+};
+
+/*
+* Name: sinkOpen
+* Description: Starts a sink's thread. A sink is too large for the stack; keep it static or allocated.
+* Parameters:
+*   - sink: the sink
+*   - output: where to write
+*   - format: text or binary
+*   - map: pointer to the map, for working out diversions
+* Returns: 1 if the sink started, 0 otherwise
+*/
+int sinkOpen(struct OutputSink* sink, FILE* output, enum SinkFormat format, const struct Map* map);
+
+/*
+* Name: sinkPost
+* Description: Hands a record to the sink, waiting only if the ring is full. Only one thread may post.
+* Parameters:
+*   - sink: an open sink
+*   - record: the record to copy in
+* Returns: Nothing
+*/
+void sinkPost(struct OutputSink* sink, const struct SinkRecord* record);
+
+/*
+* Name: sinkDelivery
+* Description: Posts where a shipment went, written as printDeliveryInfo() would print it
+* Parameters:
+*   - sink: an open sink
+*   - truck: the truck the shipment went on
+*   - result: what assignShipment() returned for it
+*   - destination: where the shipment is going
+* Returns: Nothing
+*/
+void sinkDelivery(struct OutputSink* sink, const struct Truck* truck, const struct DeliveryResult* result, const struct Point* destination);
+
+/*
+* Name: sinkText
+* Description: Posts a line of text or a prompt
+* Parameters:
+*   - sink: an open sink
+*   - kind: SINK_LINE or SINK_PROMPT
+*   - text: the text, which must outlive the sink
+* Returns: Nothing
+*/
+void sinkText(struct OutputSink* sink, enum SinkKind kind, const char* text);
+
+/*
+* Name: sinkFlush
+* Description: Waits until everything posted so far has been written out
+* Parameters:
+*   - sink: an open sink
+* Returns: Nothing
+*/
+void sinkFlush(struct OutputSink* sink);
+
+/*
+* Name: sinkClose
+* Description: Writes out everything posted and stops the sink's thread
+* Parameters:
+*   - sink: an open sink
+* Returns: Nothing
+*/
+void sinkClose(struct OutputSink* sink);
+
+#endif
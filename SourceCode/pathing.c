@@ -0,0 +1,669 @@
+#include <stdio.h>
+#include "pathing.h"
+#include "hpa.h"
+#include "roadgraph.h"
+
+#define CELL(row, col) ((row) * MAP_COLS + (col))
+#define CELL_ROW(cell) ((cell) / MAP_COLS)
+#define CELL_COL(cell) ((cell) % MAP_COLS)
+
+// every square is pushed at most once per improving neighbour, so 8 entries per square is enough
+#define PATH_HEAP_MAX (MAP_CELLS * 8 + 1)
+
+struct HeapEntry
+{
+	int f;
+	int g;
+	int cell;
+};
+
+static enum PathEngine currentEngine = PATH_GREEDY;
+static const struct MoveTable* activeMoves = NULL;
+static const struct Map* activeMovesMap = NULL;	// the map activeMoves was built from
+static struct PathStats lastStats;
+
+// Search scratch space. A square belongs to the current search only when its stamp equals
+// searchId, which saves clearing every array before each search.
+static unsigned int searchId;
+static unsigned int seen[MAP_CELLS];
+static unsigned int closed[MAP_CELLS];
+static int cost[MAP_CELLS];
+static int parent[MAP_CELLS];
+static struct HeapEntry heap[PATH_HEAP_MAX];
+static int heapSize;
+
+// the breadth first searches use the arrays above for the forward direction and these for the backward one
+static unsigned int seenBack[MAP_CELLS];
+static int costBack[MAP_CELLS];
+static int parentBack[MAP_CELLS];
+static int queue[MAP_CELLS];
+static int queueBack[MAP_CELLS];
+
+static const int moveRow[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+static const int moveCol[8] = { 0, -1, 1, -1, 1, 0, -1, 1 };
+
+// the move from a square to the one at [row + 1][col + 1] relative to it, -1 for the square itself
+static const int moveIndex[3][3] = { { 1, 0, 2 }, { 3, -1, 4 }, { 6, 5, 7 } };
+
+/*
+* Check the eight squares around a square and return a bit for each one that can be moved to.
+*/
+static unsigned int squareMoves(const struct Map* map, const int row, const int col)
+{
+	unsigned int moves = 0;
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		if (isOpenSquare(map, row + moveRow[i], col + moveCol[i])) moves |= 1u << i;
+	}
+	return moves;
+}
+
+/*
+* The open moves out of a square, from the move table when there is one.
+*/
+static unsigned int openMoves(const struct Map* map, const int cell)
+{
+	return (activeMoves != NULL && map == activeMovesMap) ? activeMoves->moves[cell] : squareMoves(map, CELL_ROW(cell), CELL_COL(cell));
+}
+
+static int sign(const int value)
+{
+	return (value > 0) - (value < 0);
+}
+
+static int absInt(const int value)
+{
+	return value < 0 ? -value : value;
+}
+
+/*
+* Number of moves between two squares when nothing is in the way.
+*/
+static int moveDistance(const int fromCell, const int toCell)
+{
+	int deltaRow = absInt(CELL_ROW(toCell) - CELL_ROW(fromCell));
+	int deltaCol = absInt(CELL_COL(toCell) - CELL_COL(fromCell));
+
+	return deltaRow > deltaCol ? deltaRow : deltaCol;
+}
+
+static int heapLess(const struct HeapEntry* a, const struct HeapEntry* b)
+{
+	if (a->f != b->f) return a->f < b->f;
+	if (a->g != b->g) return a->g > b->g;
+	return a->cell < b->cell;
+}
+
+static void heapPush(const int f, const int g, const int cell)
+{
+	int i = heapSize++;
+	struct HeapEntry entry = { f, g, cell };
+
+	while (i > 0 && heapLess(&entry, &heap[(i - 1) / 2]))
+	{
+		heap[i] = heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	heap[i] = entry;
+}
+
+static int heapPop(struct HeapEntry* top)
+{
+	int i = 0, child;
+	struct HeapEntry last;
+
+	if (heapSize == 0) return 0;
+
+	*top = heap[0];
+	last = heap[--heapSize];
+	while ((child = 2 * i + 1) < heapSize)
+	{
+		if (child + 1 < heapSize && heapLess(&heap[child + 1], &heap[child])) child++;
+		if (!heapLess(&heap[child], &last)) break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = last;
+	return 1;
+}
+
+static void beginSearch(void)
+{
+	int i;
+
+	if (++searchId == 0)
+	{
+		for (i = 0; i < MAP_CELLS; i++)
+		{
+			seen[i] = 0;
+			closed[i] = 0;
+			seenBack[i] = 0;
+		}
+		searchId = 1;
+	}
+	heapSize = 0;
+	lastStats.expanded = 0;
+	lastStats.generated = 0;
+}
+
+/*
+* Record a cheaper way of reaching a square and put it on the open list.
+*/
+static void relax(const int cell, const int g, const int from, const int destCell)
+{
+	if (seen[cell] != searchId || g < cost[cell])
+	{
+		seen[cell] = searchId;
+		cost[cell] = g;
+		parent[cell] = from;
+		heapPush(g + moveDistance(cell, destCell), g, cell);
+		lastStats.generated++;
+	}
+}
+
+/*
+* Take the best square off the open list, skipping entries made stale by a cheaper push.
+* Returns -1 when the open list is empty.
+*/
+static int nextToExpand(struct HeapEntry* top)
+{
+	while (heapPop(top))
+	{
+		if (closed[top->cell] != searchId)
+		{
+			closed[top->cell] = searchId;
+			lastStats.expanded++;
+			return top->cell;
+		}
+	}
+	return -1;
+}
+
+static int searchAStar(const struct Map* map, const int startCell, const int destCell)
+{
+	struct HeapEntry top;
+	unsigned int moves;
+	int cell, next, i;
+
+	relax(startCell, 0, startCell, destCell);
+	while ((cell = nextToExpand(&top)) >= 0)
+	{
+		if (cell == destCell) return 1;
+
+		for (i = 0, moves = openMoves(map, cell); moves != 0; i++, moves >>= 1)
+		{
+			if (!(moves & 1)) continue;
+			next = cell + CELL(moveRow[i], moveCol[i]);
+			if (closed[next] != searchId)
+			{
+				relax(next, top.g + 1, cell, destCell);
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+* Walk from a square in one direction until reaching the destination, a square with a forced
+* neighbour (one that can only be reached optimally through this square) or a building.
+* Returns the jump point found or -1 if the walk ran into a building or off the map.
+*/
+static int jump(const struct Map* map, int row, int col, const int dRow, const int dCol, const int destCell)
+{
+	while (1)
+	{
+		row += dRow;
+		col += dCol;
+		if (!isOpenSquare(map, row, col)) return -1;
+		if (CELL(row, col) == destCell) return destCell;
+
+		if (dRow != 0 && dCol != 0)
+		{
+			if ((isOpenSquare(map, row + dRow, col - dCol) && !isOpenSquare(map, row, col - dCol)) ||
+				(isOpenSquare(map, row - dRow, col + dCol) && !isOpenSquare(map, row - dRow, col)))
+			{
+				return CELL(row, col);
+			}
+			if (jump(map, row, col, dRow, 0, destCell) >= 0 || jump(map, row, col, 0, dCol, destCell) >= 0)
+			{
+				return CELL(row, col);
+			}
+		}
+		else if (dRow != 0)
+		{
+			if ((isOpenSquare(map, row + dRow, col + 1) && !isOpenSquare(map, row, col + 1)) ||
+				(isOpenSquare(map, row + dRow, col - 1) && !isOpenSquare(map, row, col - 1)))
+			{
+				return CELL(row, col);
+			}
+		}
+		else
+		{
+			if ((isOpenSquare(map, row + 1, col + dCol) && !isOpenSquare(map, row + 1, col)) ||
+				(isOpenSquare(map, row - 1, col + dCol) && !isOpenSquare(map, row - 1, col)))
+			{
+				return CELL(row, col);
+			}
+		}
+	}
+}
+
+/*
+* Fill dRow/dCol with the directions worth searching from a square given the direction it was
+* entered from. Directions whose squares are reached at least as cheaply by another path are pruned.
+*/
+static int prunedDirections(const struct Map* map, const int cell, int dRow[8], int dCol[8])
+{
+	int row = CELL_ROW(cell), col = CELL_COL(cell);
+	int pRow = sign(row - CELL_ROW(parent[cell]));
+	int pCol = sign(col - CELL_COL(parent[cell]));
+	int n = 0, i;
+
+	if (pRow == 0 && pCol == 0)
+	{
+		for (i = 0; i < 8; i++)
+		{
+			dRow[n] = moveRow[i];
+			dCol[n++] = moveCol[i];
+		}
+	}
+	else if (pRow != 0 && pCol != 0)
+	{
+		dRow[n] = pRow; dCol[n++] = pCol;
+		dRow[n] = pRow; dCol[n++] = 0;
+		dRow[n] = 0; dCol[n++] = pCol;
+		if (!isOpenSquare(map, row, col - pCol)) { dRow[n] = pRow; dCol[n++] = -pCol; }
+		if (!isOpenSquare(map, row - pRow, col)) { dRow[n] = -pRow; dCol[n++] = pCol; }
+	}
+	else if (pRow != 0)
+	{
+		dRow[n] = pRow; dCol[n++] = 0;
+		if (!isOpenSquare(map, row, col + 1)) { dRow[n] = pRow; dCol[n++] = 1; }
+		if (!isOpenSquare(map, row, col - 1)) { dRow[n] = pRow; dCol[n++] = -1; }
+	}
+	else
+	{
+		dRow[n] = 0; dCol[n++] = pCol;
+		if (!isOpenSquare(map, row + 1, col)) { dRow[n] = 1; dCol[n++] = pCol; }
+		if (!isOpenSquare(map, row - 1, col)) { dRow[n] = -1; dCol[n++] = pCol; }
+	}
+	return n;
+}
+
+static int searchJps(const struct Map* map, const int startCell, const int destCell)
+{
+	struct HeapEntry top;
+	int dRow[8], dCol[8];
+	int cell, next, i, n;
+
+	relax(startCell, 0, startCell, destCell);
+	while ((cell = nextToExpand(&top)) >= 0)
+	{
+		if (cell == destCell) return 1;
+
+		n = prunedDirections(map, cell, dRow, dCol);
+		for (i = 0; i < n; i++)
+		{
+			next = jump(map, CELL_ROW(cell), CELL_COL(cell), dRow[i], dCol[i], destCell);
+			if (next >= 0 && closed[next] != searchId)
+			{
+				relax(next, top.g + moveDistance(cell, next), cell, destCell);
+			}
+		}
+	}
+	return 0;
+}
+
+static int searchBfs(const struct Map* map, const int startCell, const int destCell)
+{
+	unsigned int moves;
+	int head = 0, tail = 0, cell, next, i;
+
+	seen[startCell] = searchId;
+	cost[startCell] = 0;
+	parent[startCell] = startCell;
+	queue[tail++] = startCell;
+	while (head < tail)
+	{
+		cell = queue[head++];
+		lastStats.expanded++;
+		for (i = 0, moves = openMoves(map, cell); moves != 0; i++, moves >>= 1)
+		{
+			if (!(moves & 1)) continue;
+			next = cell + CELL(moveRow[i], moveCol[i]);
+			if (seen[next] == searchId) continue;
+
+			seen[next] = searchId;
+			cost[next] = cost[cell] + 1;
+			parent[next] = cell;
+			queue[tail++] = next;
+			lastStats.generated++;
+			if (next == destCell) return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+* Expand one whole level of a breadth first search. Any square reached that the other direction has
+* already seen joins the two searches; the cheapest join found is kept in *best and *meet.
+*/
+static void expandLevel(const struct Map* map, int* queueHead, int* queueTail, int levelQueue[],
+	unsigned int levelSeen[], int levelCost[], int levelParent[],
+	const unsigned int otherSeen[], const int otherCost[], int* best, int* meet)
+{
+	unsigned int moves;
+	int end = *queueTail, cell, next, i;
+
+	while (*queueHead < end)
+	{
+		cell = levelQueue[(*queueHead)++];
+		lastStats.expanded++;
+		for (i = 0, moves = openMoves(map, cell); moves != 0; i++, moves >>= 1)
+		{
+			if (!(moves & 1)) continue;
+			next = cell + CELL(moveRow[i], moveCol[i]);
+			if (levelSeen[next] == searchId) continue;
+
+			levelSeen[next] = searchId;
+			levelCost[next] = levelCost[cell] + 1;
+			levelParent[next] = cell;
+			levelQueue[(*queueTail)++] = next;
+			lastStats.generated++;
+			if (otherSeen[next] == searchId && levelCost[next] + otherCost[next] < *best)
+			{
+				*best = levelCost[next] + otherCost[next];
+				*meet = next;
+			}
+		}
+	}
+}
+
+/*
+* Search from both ends, always growing the side with the smaller frontier, and stop after the level
+* in which the two searches first touch. Returns the square where the shortest path crosses between
+* the two searches or -1 if there is no path.
+*/
+static int searchBidirectional(const struct Map* map, const int startCell, const int destCell)
+{
+	int head = 0, tail = 0, headBack = 0, tailBack = 0;
+	int best = MAP_CELLS + 1, meet = -1;
+
+	seen[startCell] = searchId;
+	cost[startCell] = 0;
+	parent[startCell] = startCell;
+	queue[tail++] = startCell;
+	seenBack[destCell] = searchId;
+	costBack[destCell] = 0;
+	parentBack[destCell] = destCell;
+	queueBack[tailBack++] = destCell;
+
+	while (meet < 0 && head < tail && headBack < tailBack)
+	{
+		if (tail - head <= tailBack - headBack)
+		{
+			expandLevel(map, &head, &tail, queue, seen, cost, parent, seenBack, costBack, &best, &meet);
+		}
+		else
+		{
+			expandLevel(map, &headBack, &tailBack, queueBack, seenBack, costBack, parentBack, seen, cost, &best, &meet);
+		}
+	}
+	return meet;
+}
+
+/*
+* Turn the parent links from destCell back to startCell into a Route. Consecutive squares on the
+* chain are either adjacent (A*) or on one straight or diagonal line (JPS), so the gaps are filled
+* in by stepping along the line. The route is left empty if the path does not fit.
+*/
+static void buildRoute(const int startCell, const int destCell, struct Route* result)
+{
+	static int chain[MAP_CELLS];
+	int n = 0, length = 0, i, cell, row, col, dRow, dCol;
+
+	result->numPoints = 0;
+	for (cell = destCell; cell != startCell; cell = parent[cell])
+	{
+		chain[n++] = cell;
+	}
+	chain[n++] = startCell;
+
+	for (i = n - 1; i > 0; i--)
+	{
+		length += moveDistance(chain[i], chain[i - 1]);
+	}
+	if (length > MAX_ROUTE) return;
+
+	for (i = n - 1; i > 0; i--)
+	{
+		row = CELL_ROW(chain[i]);
+		col = CELL_COL(chain[i]);
+		dRow = sign(CELL_ROW(chain[i - 1]) - row);
+		dCol = sign(CELL_COL(chain[i - 1]) - col);
+		while (CELL(row, col) != chain[i - 1])
+		{
+			row += dRow;
+			col += dCol;
+			addPointToRoute(result, row, col);
+		}
+	}
+}
+
+/*
+* Join the forward search's path to the meeting square with the backward search's path from it.
+*/
+static void spliceRoute(const int startCell, const int meetCell, const int destCell, struct Route* result)
+{
+	int cell;
+
+	result->numPoints = 0;
+	if (cost[meetCell] + costBack[meetCell] > MAX_ROUTE) return;
+
+	buildRoute(startCell, meetCell, result);
+	for (cell = meetCell; cell != destCell; )
+	{
+		cell = parentBack[cell];
+		addPointToRoute(result, CELL_ROW(cell), CELL_COL(cell));
+	}
+}
+
+/*
+* The original shortestPath() walk: repeatedly step to the neighbour closest to the destination.
+* The neighbours go in a small array on the stack and the steps straight into the result.
+*/
+static void greedyPath(const struct Map* map, const struct Point start, const struct Point dest, struct Route* result)
+{
+	struct Point moves[MAX_MOVES];
+	struct Point last = { -1, -1 };
+	struct Point current = start;
+	int close = 0, numMoves;
+
+	result->numPoints = 0;
+	while (!eqPt(current, dest) && close >= 0)
+	{
+		if (result->numPoints == MAX_ROUTE)
+		{
+			// the walk is going in circles, report no path rather than overrun the route
+			result->numPoints = 0;
+			break;
+		}
+		numMoves = getPossibleMovesInto(map, current, last, moves);
+		close = getClosestPointIn(moves, numMoves, dest);
+		lastStats.expanded++;
+		if (close >= 0)
+		{
+			last = current;
+			current = moves[close];
+			addPtToRoute(result, current);
+		}
+		else
+		{
+			// a dead end, report no path rather than a walk that stops short of the destination
+			result->numPoints = 0;
+		}
+	}
+}
+
+void setPathEngine(enum PathEngine engine)
+{
+	currentEngine = engine;
+}
+
+enum PathEngine getPathEngine(void)
+{
+	return currentEngine;
+}
+
+struct PathStats getLastPathStats(void)
+{
+	return lastStats;
+}
+
+void buildMoveTable(struct MoveTable* table, const struct Map* map)
+{
+	int row, col;
+
+	for (row = 0; row < MAP_ROWS; row++)
+	{
+		for (col = 0; col < MAP_COLS; col++)
+		{
+			table->moves[CELL(row, col)] = (unsigned char)squareMoves(map, row, col);
+		}
+	}
+}
+
+void updateMoveTable(struct MoveTable* table, const struct Map* map, const int row, const int col)
+{
+	int i;
+
+	// only the bit of each neighbour that points back at the square can change
+	for (i = 0; i < 8; i++)
+	{
+		if (row + moveRow[i] >= 0 && row + moveRow[i] < MAP_ROWS && col + moveCol[i] >= 0 && col + moveCol[i] < MAP_COLS)
+		{
+			table->moves[CELL(row + moveRow[i], col + moveCol[i])] =
+				(unsigned char)squareMoves(map, row + moveRow[i], col + moveCol[i]);
+		}
+	}
+}
+
+void useMoveTable(const struct MoveTable* table, const struct Map* map)
+{
+	activeMoves = table;
+	activeMovesMap = table != NULL ? map : NULL;
+}
+
+const struct MoveTable* getMoveTable(const struct Map* map)
+{
+	return map == activeMovesMap ? activeMoves : NULL;
+}
+
+int listTableMoves(const struct MoveTable* table, const struct Point p1, const struct Point backpath, struct Point moves[MAX_MOVES])
+{
+	unsigned int open = table->moves[CELL(p1.row, p1.col)];
+	int dRow = backpath.row - p1.row, dCol = backpath.col - p1.col;
+	int n = 0, i;
+
+	if (dRow >= -1 && dRow <= 1 && dCol >= -1 && dCol <= 1 && moveIndex[dRow + 1][dCol + 1] >= 0)
+	{
+		open &= ~(1u << moveIndex[dRow + 1][dCol + 1]);
+	}
+	for (i = 0; open != 0; i++, open >>= 1)
+	{
+		if (!(open & 1)) continue;
+		moves[n].row = (char)(p1.row + moveRow[i]);
+		moves[n].col = (char)(p1.col + moveCol[i]);
+		n++;
+	}
+	return n;
+}
+
+int isOpenSquare(const struct Map* map, const int row, const int col)
+{
+	return row >= 0 && row < map->numRows && col >= 0 && col < map->numCols && map->squares[row][col] != 1;
+}
+
+int findPathInto(const struct Map* map, const struct Point start, const struct Point dest, enum PathEngine engine, struct Route* path)
+{
+	int startCell = CELL(start.row, start.col);
+	int destCell = CELL(dest.row, dest.col);
+	int found = 0, meet;
+
+	path->numPoints = 0;
+	path->routeSymbol = DIVERSION;
+	beginSearch();
+	if (engine == PATH_GREEDY)
+	{
+		greedyPath(map, start, dest, path);
+		return path->numPoints;
+	}
+	if (eqPt(start, dest) || !isOpenSquare(map, dest.row, dest.col)) return 0;
+	if (start.row < 0 || start.row >= map->numRows || start.col < 0 || start.col >= map->numCols) return 0;
+
+	if (engine == PATH_HIERARCHICAL && getHpaIndex() != NULL)
+	{
+		hpaFindPathInto(getHpaIndex(), map, start, dest, path);
+		lastStats = hpaGetLastStats();
+		return path->numPoints;
+	}
+	if (engine == PATH_CONTRACTED && getRoadIndex() != NULL && getRoadIndex()->complete &&
+		isOpenSquare(map, start.row, start.col))
+	{
+		roadFindPathInto(getRoadIndex(), start, dest, path);
+		lastStats = roadGetLastStats();
+		return path->numPoints;
+	}
+	if (engine == PATH_BIDIRECTIONAL)
+	{
+		meet = searchBidirectional(map, startCell, destCell);
+		if (meet >= 0) spliceRoute(startCell, meet, destCell, path);
+		return path->numPoints;
+	}
+	if (engine == PATH_JPS)
+	{
+		found = searchJps(map, startCell, destCell);
+	}
+	else if (engine == PATH_BFS)
+	{
+		found = searchBfs(map, startCell, destCell);
+	}
+	else
+	{
+		found = searchAStar(map, startCell, destCell);
+	}
+
+	if (found) buildRoute(startCell, destCell, path);
+	return path->numPoints;
+}
+
+struct Route findPath(const struct Map* map, const struct Point start, const struct Point dest, enum PathEngine engine)
+{
+	struct Route result;
+
+	findPathInto(map, start, dest, engine, &result);
+	return result;
+}
+
+int findDiversionInto(const struct Map* map, const struct Route* route, const struct Point dest, struct Route* path)
+{
+	int closest = getClosestPoint(route, dest);
+
+	if (closest < 0)
+	{
+		path->numPoints = 0;
+		path->routeSymbol = DIVERSION;
+		return 0;
+	}
+	return findPathInto(map, route->points[closest], dest, getHpaIndex() != NULL ? PATH_HIERARCHICAL : PATH_BIDIRECTIONAL, path);
+}
+
+struct Route findDiversion(const struct Map* map, const struct Route* route, const struct Point dest)
+{
+	struct Route result;
+
+	findDiversionInto(map, route, dest, &result);
+	return result;
+}
@@ -0,0 +1,161 @@
+#ifndef PATHING_H
+#define PATHING_H
+
+#include "mapping.h"
+
+#define MAP_CELLS (MAP_ROWS * MAP_COLS)
+
+/**
+* The search algorithms that can be used to find a path between two points. Every move on the
+* 8-connected grid costs 1, so the length of a path is the number of points in the returned Route.
+*/
+enum PathEngine
+{
+	PATH_GREEDY,	// the original walk that always steps toward the destination, not guaranteed optimal and gives up at a dead end
+	PATH_ASTAR,		// A* search, always returns a shortest path
+	PATH_JPS,		// Jump Point Search, same length as PATH_ASTAR while expanding far fewer squares
+	PATH_BFS,		// breadth first search outward from the start, always returns a shortest path
+	PATH_BIDIRECTIONAL,	// breadth first search from both ends that meets in the middle, always a shortest path
+	PATH_HIERARCHICAL,	// search between cluster entrances of the index set with useHpaIndex() (see hpa.h), nearly
+						// always a shortest path; falls back to PATH_ASTAR when no index is set
+	PATH_CONTRACTED		// search the contracted road graph set with useRoadIndex() (see roadgraph.h), always a
+						// shortest path; falls back to PATH_ASTAR when no index is set
+};
+
+/**
+* For every square, one bit for each of the eight moves out of it that stays on the map and does not enter a
+* building. Bit i is the i-th move in the order getPossibleMoves() lists them: above, top left, top right,
+* left, right, below, bottom left, bottom right. It contains no pointers so it can be copied or saved as it is.
+*/
+struct MoveTable
+{
+	unsigned char moves[MAP_CELLS];
+};
+
+/**
+* Counters describing the work done by the most recent search.
+*/
+struct PathStats
+{
+	int expanded;	// squares taken off the open list and expanded
+	int generated;	// squares put on the open list
+};
+
+/**
+* Select the engine used by shortestPath().
+* @param engine - the engine to use for all following calls to shortestPath()
+*/
+void setPathEngine(enum PathEngine engine);
+
+/**
+* Get the engine currently used by shortestPath().
+* @returns - the engine shortestPath() uses.
+*/
+enum PathEngine getPathEngine(void);
+
+/**
+* Calculate a path between two points that does not pass through buildings using a specific engine.
+* @param map - the map showing the location of buildings.
+* @param start - the point to start from
+* @param dest - the point to go to
+* @param engine - the search algorithm to use
+* @returns - the path from start to dest, not including start. If there is no path, the path does not
+* fit in a Route, or start and dest are the same point, a Route of zero length is returned.
+*/
+struct Route findPath(const struct Map* map, const struct Point start, const struct Point dest, enum PathEngine engine);
+
+/**
+* Calculate a path as findPath() does, writing it into caller-provided storage instead of returning a
+* copy. Nothing is copied on the way: the neighbours of each square are kept in a small array on the
+* stack and each step is written straight into path.
+* @param map - the map showing the location of buildings.
+* @param start - the point to start from
+* @param dest - the point to go to
+* @param engine - the search algorithm to use
+* @param path - where to write the path; it has zero length in the same cases findPath() returns one
+* @returns - the number of points in the path.
+*/
+int findPathInto(const struct Map* map, const struct Point start, const struct Point dest, enum PathEngine engine, struct Route* path);
+
+/**
+* Calculate the diversion a truck has to make to reach a destination: a path from the point on the route
+* closest to the destination. The hierarchical index is used when one has been set with useHpaIndex(),
+* otherwise a shortest path is found by searching from both ends at once.
+* @param map - the map showing the location of buildings.
+* @param route - the route the truck follows
+* @param dest - the point to deliver to
+* @returns - the diversion, not including the route point it leaves from, with the DIVERSION symbol. If the
+* destination is on the route or cannot be reached, a Route of zero length is returned.
+*/
+struct Route findDiversion(const struct Map* map, const struct Route* route, const struct Point dest);
+
+/**
+* Calculate the diversion findDiversion() returns, writing it into caller-provided storage.
+* @param map - the map showing the location of buildings.
+* @param route - the route the truck follows
+* @param dest - the point to deliver to
+* @param path - where to write the diversion
+* @returns - the number of points in the diversion.
+*/
+int findDiversionInto(const struct Map* map, const struct Route* route, const struct Point dest, struct Route* path);
+
+/**
+* Get the counters for the most recent call to findPath() or shortestPath().
+* @returns - the counters of the last search.
+*/
+struct PathStats getLastPathStats(void);
+
+/**
+* Determine if a square can be driven through.
+* @param map - the map showing the location of buildings.
+* @param row - the row of the square
+* @param col - the column of the square
+* @returns - true if the square is on the map and is not a building.
+*/
+int isOpenSquare(const struct Map* map, const int row, const int col);
+
+/**
+* Work out the open moves out of every square of a map.
+* @param table - the table to fill in
+* @param map - the map showing the location of buildings.
+*/
+void buildMoveTable(struct MoveTable* table, const struct Map* map);
+
+/**
+* Bring a move table up to date after one square of the map has been opened or closed. Only the moves of
+* the squares around it change.
+* @param table - the table built from the map before the change
+* @param map - the map after the change
+* @param row - the row of the square that changed
+* @param col - the column of the square that changed
+*/
+void updateMoveTable(struct MoveTable* table, const struct Map* map, const int row, const int col);
+
+/**
+* Make the searches and getPossibleMoves() read the open moves of each square from a table instead of
+* checking the map bounds and buildings around it every time. The table is only read for the map it was
+* built from, which must be the same struct Map in memory; any other map is checked square by square. The
+* table must be kept up to date with that map, e.g. with moveTableMapObserver() (see mapupdate.h).
+* @param table - the table to use, or NULL to go back to checking the map
+* @param map - the map the table was built from
+*/
+void useMoveTable(const struct MoveTable* table, const struct Map* map);
+
+/**
+* Get the table set with useMoveTable() if it was set for a map.
+* @param map - the map about to be searched
+* @returns - the table in use, or NULL if there is none or it was set for another map.
+*/
+const struct MoveTable* getMoveTable(const struct Map* map);
+
+/**
+* List the moves out of a square from a move table, leaving out the square we came from by clearing its bit.
+* @param table - the table for the map
+* @param p1 - the square to list the moves out of
+* @param backpath - the previous point we visited, which is left out
+* @param moves - where to write the squares, in the same order as getPossibleMoves()
+* @returns - the number of squares written.
+*/
+int listTableMoves(const struct MoveTable* table, const struct Point p1, const struct Point backpath, struct Point moves[MAX_MOVES]);
+
+#endif
@@ -0,0 +1,333 @@
+/*
+* Purpose: Shipment intake split into parse, validate, assign and output stages joined by
+*          single-producer single-consumer rings
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdlib.h>
+#include <string.h>
+#include "pipeline.h"
+#include "MS3FunctionSpecs.h"
+#include "outputsink.h"
+#include "platform.h"
+
+
+static const char prompt[] = "Enter shipment weight, box size and destination (0 0 x to stop): ";
+static struct Snapshot* activeSnapshot = NULL;
+static struct Backlog* activeBacklog = NULL;
+static const char* activeBacklogPath = NULL;
+
+/**
+ * The rings between the stages and what the stages share
+ */
+struct Pipeline {
+    FILE* input;
+    struct Truck* trucks;
+    int numTrucks;
+    const struct Map* map;
+    struct Snapshot* snapshot;      // saved to after each placed shipment, or NULL
+    struct Backlog* backlog;        // takes the shipments that ship tomorrow, or NULL
+    const char* backlogPath;        // saved to after each shipment added to the backlog, or NULL
+    struct IntakeRing parsed;       // parse to validate
+    struct IntakeRing validated;    // validate to assign
+    struct IntakeRing assigned;     // assign to output
+    struct OutputSink sink;         // formats and writes the output
+};
+
+/*
+* Name: ringInit
+* Description: Empties a ring
+*/
+void ringInit(struct IntakeRing* ring) {
+    counterStore(&ring->head, 0);
+    counterStore(&ring->tail, 0);
+}
+
+/*
+* Name: ringTryPush
+* Description: Adds a record if there is room
+*/
+int ringTryPush(struct IntakeRing* ring, const struct IntakeRecord* record) {
+    unsigned long tail = ring->tail;    // only this thread writes it
+    if (tail - counterLoad(&ring->head) >= RING_SLOTS) {
+        return 0;
+    }
+    ring->slots[tail & (RING_SLOTS - 1)] = *record;
+    counterStore(&ring->tail, tail + 1);   // publishes the slot
+    return 1;
+}
+
+/*
+* Name: ringTryPop
+* Description: Takes the oldest record if there is one
+*/
+int ringTryPop(struct IntakeRing* ring, struct IntakeRecord* record) {
+    unsigned long head = ring->head;    // only this thread writes it
+    if (counterLoad(&ring->tail) == head) {
+        return 0;
+    }
+    *record = ring->slots[head & (RING_SLOTS - 1)];
+    counterStore(&ring->head, head + 1);   // hands the slot back
+    return 1;
+}
+
+/*
+* Name: ringPush
+* Description: Adds a record, waiting while the ring is full
+*/
+void ringPush(struct IntakeRing* ring, const struct IntakeRecord* record) {
+    for (int round = 0; !ringTryPush(ring, record); round++) {
+        backOff(round);
+    }
+}
+
+/*
+* Name: ringPop
+* Description: Takes the oldest record, waiting while the ring is empty
+*/
+void ringPop(struct IntakeRing* ring, struct IntakeRecord* record) {
+    for (int round = 0; !ringTryPop(ring, record); round++) {
+        backOff(round);
+    }
+}
+
+// Read one line's worth of input the same way the console loop always has
+static void parseStage(void* argument) {
+    struct Pipeline* pipeline = (struct Pipeline*)argument;
+    struct IntakeRecord record;
+
+    do {
+        memset(&record, 0, sizeof(record));
+        int inputs = fscanf(pipeline->input, "%lf %lf %3s", &record.weight, &record.volume, record.destination);
+
+        if (inputs == EOF) {
+            record.kind = INTAKE_STOP;
+        }
+        else if (inputs != 3) {
+            int c;
+            while ((c = fgetc(pipeline->input)) != '\n' && c != EOF);
+            record.kind = INTAKE_REJECTED;
+            record.message = "Invalid input";
+        }
+        else if (record.weight == 0 && record.volume == 0 && (record.destination[0] == 'x' || record.destination[0] == 'X')) {
+            record.kind = INTAKE_STOP;
+            record.message = "Thanks for shipping with Seneca Polytechnic!";
+        }
+        else {
+            record.kind = INTAKE_SHIPMENT;
+        }
+        ringPush(&pipeline->parsed, &record);
+    } while (record.kind != INTAKE_STOP);
+}
+
+// Apply the weight, size and destination rules
+static void validateStage(void* argument) {
+    struct Pipeline* pipeline = (struct Pipeline*)argument;
+    struct IntakeRecord record;
+
+    do {
+        ringPop(&pipeline->parsed, &record);
+        checkIntake(&record, pipeline->map);
+        ringPush(&pipeline->validated, &record);
+    } while (record.kind != INTAKE_STOP);
+}
+
+// The only stage that touches the trucks' cargo, so shipments are placed in the order they came in
+static void assignStage(void* argument) {
+    struct Pipeline* pipeline = (struct Pipeline*)argument;
+    struct IntakeRecord record;
+
+    do {
+        ringPop(&pipeline->validated, &record);
+        if (record.kind == INTAKE_SHIPMENT) {
+            record.result = assignShipment(pipeline->trucks, pipeline->numTrucks, &record.shipment, pipeline->map);
+            if (record.result.success && pipeline->snapshot != NULL) {
+                snapshotSaveFleet(pipeline->snapshot, pipeline->trucks, pipeline->numTrucks);
+            }
+            else if (!record.result.success && pipeline->backlog != NULL) {
+                backlogAdd(pipeline->backlog, &record.shipment);
+                if (pipeline->backlogPath != NULL) {
+                    backlogSave(pipeline->backlog, pipeline->backlogPath);
+                }
+            }
+        }
+        ringPush(&pipeline->assigned, &record);
+    } while (record.kind != INTAKE_STOP);
+}
+
+/*
+* Name: checkIntake
+* Description: Applies the weight, size and destination rules to a parsed shipment
+*/
+int checkIntake(struct IntakeRecord* record, const struct Map* map) {
+    struct Point destination;
+
+    if (record->kind != INTAKE_SHIPMENT) {
+        return 0;
+    }
+    if (record->weight < 1 || record->weight > 5000) {
+        record->kind = INTAKE_REJECTED;
+        record->message = "Invalid weight (must be 1-5000 Kg.)";
+    }
+    else if (record->volume != 0.5 && record->volume != 2.0 && record->volume != 5.0) {
+        record->kind = INTAKE_REJECTED;
+        record->message = "Invalid size";
+    }
+    else if (!parseDestination(record->destination, &destination) || !isValidDestination(&destination, map)) {
+        record->kind = INTAKE_REJECTED;
+        record->message = "Invalid destination";
+    }
+    else {
+        record->shipment.weight = record->weight;
+        record->shipment.volume = record->volume;
+        record->shipment.destination = destination;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+* Name: assignIntakeBatch
+* Description: Places a batch of checked shipments in order, saving the load once for the batch
+*/
+int assignIntakeBatch(struct IntakeRecord records[], int count, struct Truck trucks[], int numTrucks, const struct Map* map) {
+    int placed = 0, carried = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (records[i].kind != INTAKE_SHIPMENT) {
+            continue;
+        }
+        records[i].result = assignShipment(trucks, numTrucks, &records[i].shipment, map);
+        if (records[i].result.success) {
+            placed++;
+        }
+        else if (activeBacklog != NULL) {
+            carried += backlogAdd(activeBacklog, &records[i].shipment);
+        }
+    }
+
+    // One save covers every shipment placed in the batch, and one every shipment carried over
+    if (placed > 0 && activeSnapshot != NULL) {
+        snapshotSaveFleet(activeSnapshot, trucks, numTrucks);
+    }
+    if (carried > 0 && activeBacklogPath != NULL) {
+        backlogSave(activeBacklog, activeBacklogPath);
+    }
+    return placed;
+}
+
+/*
+* Name: runIntakePipeline
+* Description: Runs the intake stages on their own threads and writes the results in order
+*/
+int runIntakePipeline(FILE* input, struct Truck trucks[], int numTrucks, const struct Map* map, int* dayEnded) {
+    struct Pipeline* pipeline;
+    struct IntakeRecord record;
+    struct Thread parser, validator, assigner;
+    int placed = 0;
+
+    if (dayEnded != NULL) {
+        *dayEnded = 0;
+    }
+    if (input == NULL || trucks == NULL || map == NULL) {
+        return 0;
+    }
+
+    // The rings are too large for the stack
+    pipeline = (struct Pipeline*)malloc(sizeof(struct Pipeline));
+    if (pipeline == NULL) {
+        return 0;
+    }
+    pipeline->input = input;
+    pipeline->trucks = trucks;
+    pipeline->numTrucks = numTrucks;
+    pipeline->map = map;
+    pipeline->snapshot = activeSnapshot;
+    pipeline->backlog = activeBacklog;
+    pipeline->backlogPath = activeBacklogPath;
+    ringInit(&pipeline->parsed);
+    ringInit(&pipeline->validated);
+    ringInit(&pipeline->assigned);
+
+    if (!sinkOpen(&pipeline->sink, stdout, SINK_FORMAT_TEXT, map)) {
+        free(pipeline);
+        return 0;
+    }
+    sinkText(&pipeline->sink, SINK_PROMPT, prompt);
+
+    // Start from the end of the pipeline, so if a thread will not start the ones already running
+    // can be sent a stop record and joined
+    memset(&record, 0, sizeof(record));
+    record.kind = INTAKE_STOP;
+    if (!threadStart(&assigner, assignStage, pipeline)) {
+        sinkClose(&pipeline->sink);
+        free(pipeline);
+        return 0;
+    }
+    if (!threadStart(&validator, validateStage, pipeline)) {
+        ringPush(&pipeline->validated, &record);
+        threadJoin(&assigner);
+        sinkClose(&pipeline->sink);
+        free(pipeline);
+        return 0;
+    }
+    if (!threadStart(&parser, parseStage, pipeline)) {
+        ringPush(&pipeline->parsed, &record);
+        threadJoin(&validator);
+        threadJoin(&assigner);
+        sinkClose(&pipeline->sink);
+        free(pipeline);
+        return 0;
+    }
+
+    // Output stage; the truck's route and number never change, so the sink can format a delivery
+    // while later shipments are being assigned
+    do {
+        ringPop(&pipeline->assigned, &record);
+        if (record.kind == INTAKE_SHIPMENT) {
+            if (record.result.success) {
+                sinkDelivery(&pipeline->sink, &trucks[record.result.truckIndex], &record.result, &record.shipment.destination);
+                placed++;
+            }
+            else {
+                sinkText(&pipeline->sink, SINK_LINE, "Ships tomorrow");
+            }
+        }
+        else if (record.message != NULL) {
+            sinkText(&pipeline->sink, SINK_LINE, record.message);
+        }
+
+        if (record.kind != INTAKE_STOP) {
+            sinkText(&pipeline->sink, SINK_PROMPT, prompt);
+        }
+    } while (record.kind != INTAKE_STOP);
+
+    // Only "0 0 x" says goodbye; the end of the input stops without a message
+    if (dayEnded != NULL) {
+        *dayEnded = record.message != NULL;
+    }
+
+    threadJoin(&parser);
+    threadJoin(&validator);
+    threadJoin(&assigner);
+    sinkClose(&pipeline->sink);
+    free(pipeline);
+    return placed;
+}
+
+/*
+* Name: useIntakeSnapshot
+* Description: Sets the snapshot the pipeline saves the fleet's load to
+*/
+void useIntakeSnapshot(struct Snapshot* snapshot) {
+    activeSnapshot = snapshot;
+}
+
+/*
+* Name: useIntakeBacklog
+* Description: Sets the backlog the pipeline carries unplaced shipments over in
+*/
+void useIntakeBacklog(struct Backlog* backlog, const char* path) {
+    activeBacklog = backlog;
+    activeBacklogPath = backlog != NULL ? path : NULL;
+}
@@ -0,0 +1,166 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include "delivery.h"
+#include "mapping.h"
+#include "snapshot.h"
+#include "backlog.h"
+
+#define RING_SLOTS 256      // must be a power of two
+
+/**
+ * What a record carries from one stage of the intake pipeline to the next
+ */
+enum IntakeKind {
+    INTAKE_SHIPMENT,        // a shipment still on its way through
+    INTAKE_REJECTED,        // turned down, message says why
+    INTAKE_STOP             // no more input, message is printed if it is not NULL
+};
+
+/**
+ * One line of input as it moves through the pipeline
+ */
+struct IntakeRecord {
+    enum IntakeKind kind;
+    double weight;                  // as typed
+    double volume;                  // as typed
+    char destination[4];            // as typed, e.g. "12L"
+    const char* message;            // reason for rejecting, or the goodbye on stop
+    struct Shipment shipment;       // filled in once the input is valid
+    struct DeliveryResult result;   // filled in by the assign stage
+};
+
+/**
+ * A bounded queue between exactly one producer thread and one consumer thread. Each side only
+ * writes its own counter, so no locks are needed. The counters run freely and are masked to a slot.
+ */
+struct IntakeRing {
+    volatile unsigned long head;    // next slot to read, written by the consumer
+    char headPadding[60];           // keep the two counters on separate cache lines
+    volatile unsigned long tail;    // next slot to write, written by the producer
+    char tailPadding[60];
+    struct IntakeRecord slots[RING_SLOTS];
+};
+
+/*
+* Name: ringInit
+* Description: Empties a ring before its threads start
+* Parameters:
+*   - ring: the ring
+* Returns: Nothing
+*/
+void ringInit(struct IntakeRing* ring);
+
+/*
+* Name: ringTryPush
+* Description: Adds a record if there is room. Only the producer thread may call this.
+* Parameters:
+*   - ring: the ring
+*   - record: the record to copy in
+* Returns: 1 if the record was added, 0 if the ring is full
+*/
+int ringTryPush(struct IntakeRing* ring, const struct IntakeRecord* record);
+
+/*
+* Name: ringTryPop
+* Description: Takes the oldest record if there is one. Only the consumer thread may call this.
+* Parameters:
+*   - ring: the ring
+*   - record: where to copy the record
+* Returns: 1 if a record was taken, 0 if the ring is empty
+*/
+int ringTryPop(struct IntakeRing* ring, struct IntakeRecord* record);
+
+/*
+* Name: ringPush
+* Description: Adds a record, waiting while the ring is full
+* Parameters:
+*   - ring: the ring
+*   - record: the record to copy in
+* Returns: Nothing
+*/
+void ringPush(struct IntakeRing* ring, const struct IntakeRecord* record);
+
+/*
+* Name: ringPop
+* Description: Takes the oldest record, waiting while the ring is empty
+* Parameters:
+*   - ring: the ring
+*   - record: where to copy the record
+* Returns: Nothing
+*/
+void ringPop(struct IntakeRing* ring, struct IntakeRecord* record);
+
+/*
+* Name: checkIntake
+* Description: Applies the weight, size and destination rules to a shipment that has been parsed.
+*              A shipment that breaks one is turned into a rejection saying why, and a valid one
+*              has its shipment filled in. Records of any other kind are left as they are.
+* Parameters:
+*   - record: a record of kind INTAKE_SHIPMENT with weight, volume and destination as typed
+*   - map: pointer to the map
+* Returns: 1 if the shipment is valid, 0 otherwise
+*/
+int checkIntake(struct IntakeRecord* record, const struct Map* map);
+
+/*
+* Name: assignIntakeBatch
+* Description: Places each valid shipment of a batch with assignShipment() in the order given and
+*              fills in its result. Shipments no truck can take go to the backlog set with
+*              useIntakeBacklog(). If any were placed the load is saved once for the whole batch
+*              to the snapshot set with useIntakeSnapshot(), and then if any went to the backlog
+*              it is saved once too.
+* Parameters:
+*   - records: the batch; only records of kind INTAKE_SHIPMENT are placed
+*   - count: number of records
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks in the array
+*   - map: pointer to the map
+* Returns: The number of shipments placed on a truck
+*/
+int assignIntakeBatch(struct IntakeRecord records[], int count, struct Truck trucks[], int numTrucks, const struct Map* map);
+
+/*
+* Name: runIntakePipeline
+* Description: Reads shipments until "0 0 x" or the end of the input and places each one. Parsing,
+*              validation and assignment run on their own threads joined by rings, and the
+*              calling thread hands the results to an output sink that formats and writes them
+*              on a thread of its own, so reading and printing overlap with assignment.
+*              Shipments are assigned and printed strictly in the order they were read, and the
+*              output is the same as handling one line at a time.
+* Parameters:
+*   - input: where to read shipments from
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks in the array
+*   - map: pointer to the map
+*   - dayEnded: set to 1 if the input ended with "0 0 x" and 0 if it just ran out; may be NULL
+* Returns: The number of shipments placed on a truck
+*/
+int runIntakePipeline(FILE* input, struct Truck trucks[], int numTrucks, const struct Map* map, int* dayEnded);
+
+/*
+* Name: useIntakeSnapshot
+* Description: Makes runIntakePipeline() and assignIntakeBatch() save the fleet's load to a snapshot
+*              after every shipment or batch they place, so a restart after a crash carries on with
+*              the trucks loaded as they were
+* Parameters:
+*   - snapshot: an open snapshot made with the same trucks, or NULL to stop saving
+* Returns: Nothing
+*/
+void useIntakeSnapshot(struct Snapshot* snapshot);
+
+/*
+* Name: useIntakeBacklog
+* Description: Makes runIntakePipeline() and assignIntakeBatch() add each shipment no truck can take
+*              to a backlog, from which a later day's run places it before any new shipments.
+*              With a path the backlog is saved there with backlogSave() as soon as shipments
+*              are added, where the fleet's load is saved, so a crash does not lose them.
+* Parameters:
+*   - backlog: the backlog, or NULL to drop unplaced shipments as before
+*   - path: the backlog file, or NULL to leave saving to the caller
+* Returns: Nothing
+*/
+void useIntakeBacklog(struct Backlog* backlog, const char* path);
+
+#endif
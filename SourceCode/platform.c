@@ -0,0 +1,219 @@
+/*
+* Purpose: The few thread, memory-ordering and file mapping calls the pipelined modules and snapshots
+*          need, for Windows and POSIX
+*/
+
+#include <stdlib.h>
+#include "platform.h"
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+
+static DWORD WINAPI threadMain(LPVOID argument) {
+    struct Thread* thread = (struct Thread*)argument;
+    thread->function(thread->argument);
+    return 0;
+}
+
+int threadStart(struct Thread* thread, ThreadFunction function, void* argument) {
+    thread->function = function;
+    thread->argument = argument;
+    thread->handle = CreateThread(NULL, 0, threadMain, thread, 0, NULL);
+    return thread->handle != NULL;
+}
+
+void threadJoin(struct Thread* thread) {
+    if (thread->handle != NULL) {
+        WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+        CloseHandle((HANDLE)thread->handle);
+        thread->handle = NULL;
+    }
+}
+
+unsigned long counterLoad(volatile unsigned long* counter) {
+    return (unsigned long)InterlockedCompareExchange((volatile LONG*)counter, 0, 0);
+}
+
+void counterStore(volatile unsigned long* counter, unsigned long value) {
+    InterlockedExchange((volatile LONG*)counter, (LONG)value);
+}
+
+void backOff(int round) {
+    if (round < 1000) {
+        SwitchToThread();
+    }
+    else {
+        Sleep(1);
+    }
+}
+
+int mapFile(struct MappedFile* file, const char* path) {
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+
+    file->view = NULL;
+    file->handle = NULL;
+    if (handle == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    if (GetFileSizeEx(handle, &size) && size.QuadPart > 0) {
+        file->size = (unsigned long long)size.QuadPart;
+        file->handle = CreateFileMappingA(handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (file->handle != NULL) {
+            file->view = MapViewOfFile((HANDLE)file->handle, FILE_MAP_COPY, 0, 0, 0);
+        }
+    }
+    CloseHandle(handle);    // the mapping keeps the file open
+    if (file->view == NULL) {
+        unmapFile(file);
+        return 0;
+    }
+    return 1;
+}
+
+void unmapFile(struct MappedFile* file) {
+    if (file->view != NULL) {
+        UnmapViewOfFile(file->view);
+        file->view = NULL;
+    }
+    if (file->handle != NULL) {
+        CloseHandle((HANDLE)file->handle);
+        file->handle = NULL;
+    }
+}
+
+int syncFile(FILE* file) {
+    return fflush(file) == 0 && _commit(_fileno(file)) == 0;
+}
+
+// Write through makes the move wait until the directory change is on the disk
+int replaceFile(const char* from, const char* to) {
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+#else
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static void* threadMain(void* argument) {
+    struct Thread* thread = (struct Thread*)argument;
+    thread->function(thread->argument);
+    return NULL;
+}
+
+int threadStart(struct Thread* thread, ThreadFunction function, void* argument) {
+    pthread_t* handle = (pthread_t*)malloc(sizeof(pthread_t));
+
+    thread->function = function;
+    thread->argument = argument;
+    thread->handle = handle;
+    if (handle == NULL || pthread_create(handle, NULL, threadMain, thread) != 0) {
+        free(handle);
+        thread->handle = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+void threadJoin(struct Thread* thread) {
+    if (thread->handle != NULL) {
+        pthread_join(*(pthread_t*)thread->handle, NULL);
+        free(thread->handle);
+        thread->handle = NULL;
+    }
+}
+
+unsigned long counterLoad(volatile unsigned long* counter) {
+    return __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+}
+
+void counterStore(volatile unsigned long* counter, unsigned long value) {
+    __atomic_store_n(counter, value, __ATOMIC_RELEASE);
+}
+
+void backOff(int round) {
+    if (round < 1000) {
+        sched_yield();
+    }
+    else {
+        struct timespec nap = { 0, 1000000 };
+        nanosleep(&nap, NULL);
+    }
+}
+
+int mapFile(struct MappedFile* file, const char* path) {
+    int descriptor = open(path, O_RDONLY);
+    struct stat status;
+
+    file->view = NULL;
+    file->handle = NULL;
+    if (descriptor < 0) {
+        return 0;
+    }
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        void* view = mmap(NULL, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+        if (view != MAP_FAILED) {
+            file->view = view;
+            file->size = (unsigned long long)status.st_size;
+        }
+    }
+    close(descriptor);      // the mapping keeps the file open
+    return file->view != NULL;
+}
+
+void unmapFile(struct MappedFile* file) {
+    if (file->view != NULL) {
+        munmap(file->view, (size_t)file->size);
+        file->view = NULL;
+    }
+}
+
+int syncFile(FILE* file) {
+    return fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+// A rename lives in the directory, so that is what has to reach the disk for it to last
+static int syncDirectoryOf(const char* path) {
+    const char* slash = strrchr(path, '/');
+    size_t length = (slash == NULL || slash == path) ? 1 : (size_t)(slash - path);
+    char* directory = (char*)malloc(length + 1);
+    int descriptor;
+    int synced;
+
+    if (directory == NULL) {
+        return 0;
+    }
+    if (slash == NULL) {
+        directory[0] = '.';
+    }
+    else {
+        memcpy(directory, path, length);
+    }
+    directory[length] = '\0';
+
+    descriptor = open(directory, O_RDONLY);
+    free(directory);
+    if (descriptor < 0) {
+        return 0;
+    }
+    synced = fsync(descriptor) == 0;
+    close(descriptor);
+    return synced;
+}
+
+int replaceFile(const char* from, const char* to) {
+    return rename(from, to) == 0 && syncDirectoryOf(to);
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdio.h>
+
+typedef void (*ThreadFunction)(void* argument);
+
+/**
+ * A whole file mapped into memory with mapFile(). The view is copy on write: it can be changed in
+ * place, but the changes are private and never reach the file.
+ */
+struct MappedFile {
+    void* view;
+    unsigned long long size;
+    void* handle;
+};
+
+/**
+ * A thread started with threadStart(). The handle is kept behind a pointer so this header does
+ * not need the platform headers.
+ */
+struct Thread {
+    void* handle;
+    ThreadFunction function;
+    void* argument;
+};
+
+/*
+* Name: threadStart
+* Description: Starts a thread running function(argument)
+* Parameters:
+*   - thread: filled in with the new thread, must stay in place until threadJoin()
+*   - function: what the thread runs
+*   - argument: passed to function
+* Returns: 1 if the thread started, 0 otherwise
+*/
+int threadStart(struct Thread* thread, ThreadFunction function, void* argument);
+
+/*
+* Name: threadJoin
+* Description: Waits for a thread to finish and releases it
+* Parameters:
+*   - thread: a thread started with threadStart()
+* Returns: Nothing
+*/
+void threadJoin(struct Thread* thread);
+
+/*
+* Name: counterLoad
+* Description: Reads a counter another thread writes, seeing everything written before it was stored
+* Parameters:
+*   - counter: the counter
+* Returns: Its value
+*/
+unsigned long counterLoad(volatile unsigned long* counter);
+
+/*
+* Name: counterStore
+* Description: Writes a counter so that everything written before it is seen by counterLoad()
+* Parameters:
+*   - counter: the counter
+*   - value: the new value
+* Returns: Nothing
+*/
+void counterStore(volatile unsigned long* counter, unsigned long value);
+
+/*
+* Name: backOff
+* Description: Gives up the processor while waiting on another thread, yielding at first and then
+*              sleeping for a millisecond so a long wait does not keep a core busy
+* Parameters:
+*   - round: how many times the caller has waited so far
+* Returns: Nothing
+*/
+void backOff(int round);
+
+/*
+* Name: mapFile
+* Description: Maps a whole file into memory, so its pages are read in from the page cache as they
+*              are first touched instead of being copied up front
+* Parameters:
+*   - file: filled in with the view and its size
+*   - path: the file to map
+* Returns: 1 if the file was mapped, 0 if it could not be opened or is empty
+*/
+int mapFile(struct MappedFile* file, const char* path);
+
+/*
+* Name: unmapFile
+* Description: Releases a view made with mapFile()
+* Parameters:
+*   - file: the mapped file
+* Returns: Nothing
+*/
+void unmapFile(struct MappedFile* file);
+
+/*
+* Name: syncFile
+* Description: Flushes a file and waits until the system has written it to the disk, so what was
+*              written survives the machine going down and not just the program stopping
+* Parameters:
+*   - file: an open file
+* Returns: 1 if the file is on the disk, 0 otherwise
+*/
+int syncFile(FILE* file);
+
+/*
+* Name: replaceFile
+* Description: Renames a file over another in one step, so a reader sees either the old file or the
+*              new one and never a partly written one, and waits until the rename is on the disk.
+*              The new file should have been written out with syncFile() first.
+* Parameters:
+*   - from: the new file
+*   - to: the file to replace, which need not exist
+* Returns: 1 if the file was replaced and the rename is on the disk, 0 otherwise
+*/
+int replaceFile(const char* from, const char* to);
+
+#endif
@@ -0,0 +1,789 @@
+#include <stdio.h>
+#include "roadgraph.h"
+#include "pathing.h"
+
+#define CELL(row, col) ((row) * MAP_COLS + (col))
+#define CELL_ROW(cell) ((cell) / MAP_COLS)
+#define CELL_COL(cell) ((cell) % MAP_COLS)
+
+#define ROAD_INFINITY 0x3FFFFFFF
+// a witness search gives up after settling this many nodes; a missed witness only costs an extra shortcut
+#define ROAD_WITNESS_LIMIT 64
+// every successful relaxation pushes one entry, so the arcs plus the starting nodes is enough
+#define ROAD_HEAP_MAX (ROAD_MAX_ARCS + MAP_CELLS)
+
+struct RoadHeapEntry
+{
+	int key;
+	int node;
+};
+
+struct RoadHeap
+{
+	int size;
+	struct RoadHeapEntry* entries;
+};
+
+// Queries keep their scratch space per thread so several threads can measure routes at once
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+static const struct RoadIndex* activeIndex;
+static THREAD_LOCAL struct PathStats lastStats;
+
+static const int moveRow[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+static const int moveCol[8] = { 0, -1, 1, -1, 1, 0, -1, 1 };
+
+// Search scratch space, stamped with searchId in the same way as the grid searches.
+static THREAD_LOCAL unsigned int searchId;
+static THREAD_LOCAL struct RoadHeapEntry forwardEntries[ROAD_HEAP_MAX];
+static THREAD_LOCAL struct RoadHeapEntry backwardEntries[ROAD_HEAP_MAX];
+static struct RoadHeapEntry witnessEntries[ROAD_HEAP_MAX];
+static struct RoadHeapEntry orderEntries[MAP_CELLS];
+static THREAD_LOCAL struct RoadHeap forwardHeap;	// entries are set by beginSearch(), a thread's own arrays have no fixed address
+static THREAD_LOCAL struct RoadHeap backwardHeap;
+static struct RoadHeap witnessHeap = { 0, witnessEntries };
+static struct RoadHeap orderHeap = { 0, orderEntries };
+static THREAD_LOCAL unsigned int forwardSeen[MAP_CELLS];
+static THREAD_LOCAL unsigned int backwardSeen[MAP_CELLS];
+static unsigned int witnessSeen[MAP_CELLS];
+static THREAD_LOCAL int forwardDist[MAP_CELLS];
+static THREAD_LOCAL int backwardDist[MAP_CELLS];
+static int witnessDist[MAP_CELLS];
+static THREAD_LOCAL int forwardArc[MAP_CELLS];	// arc a node was reached by, -1 for the nodes a search starts from
+static THREAD_LOCAL int backwardArc[MAP_CELLS];
+
+// contraction scratch space
+static int contracted[MAP_CELLS];
+static int deletedNeighbours[MAP_CELLS];
+static int numNeighbours;
+static int neighbourNode[MAP_CELLS];
+static int neighbourArc[MAP_CELLS];	// cheapest arc from the node being contracted to each neighbour
+static unsigned int neighbourSeen[MAP_CELLS];
+static int neighbourSlot[MAP_CELLS];
+
+static int heapLess(const struct RoadHeapEntry* a, const struct RoadHeapEntry* b)
+{
+	return a->key < b->key || (a->key == b->key && a->node < b->node);
+}
+
+static void heapPush(struct RoadHeap* heap, const int key, const int node)
+{
+	struct RoadHeapEntry entry = { key, node };
+	int i = heap->size++;
+
+	while (i > 0 && heapLess(&entry, &heap->entries[(i - 1) / 2]))
+	{
+		heap->entries[i] = heap->entries[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	heap->entries[i] = entry;
+}
+
+static struct RoadHeapEntry heapPop(struct RoadHeap* heap)
+{
+	struct RoadHeapEntry top = heap->entries[0], last = heap->entries[--heap->size];
+	int i = 0, child;
+
+	while ((child = 2 * i + 1) < heap->size)
+	{
+		if (child + 1 < heap->size && heapLess(&heap->entries[child + 1], &heap->entries[child])) child++;
+		if (!heapLess(&heap->entries[child], &last)) break;
+		heap->entries[i] = heap->entries[child];
+		i = child;
+	}
+	if (heap->size > 0) heap->entries[i] = last;
+	return top;
+}
+
+static int heapTop(const struct RoadHeap* heap)
+{
+	return heap->size > 0 ? heap->entries[0].key : ROAD_INFINITY;
+}
+
+static void beginSearch(void)
+{
+	searchId++;
+	if (searchId == 0)
+	{
+		int i;
+
+		for (i = 0; i < MAP_CELLS; i++)
+		{
+			forwardSeen[i] = backwardSeen[i] = witnessSeen[i] = neighbourSeen[i] = 0;
+		}
+		searchId = 1;
+	}
+	forwardHeap.entries = forwardEntries;
+	backwardHeap.entries = backwardEntries;
+	forwardHeap.size = 0;
+	backwardHeap.size = 0;
+}
+
+/*
+* A corridor square joins exactly two open squares that do not touch each other, so a shortest path
+* can only pass straight through it.
+*/
+static int isCorridor(const struct Map* map, const int row, const int col)
+{
+	int count = 0, first = 0, second = 0, i;
+
+	if (!isOpenSquare(map, row, col)) return 0;
+	for (i = 0; i < 8; i++)
+	{
+		if (isOpenSquare(map, row + moveRow[i], col + moveCol[i]))
+		{
+			if (count == 0) first = i;
+			else second = i;
+			count++;
+		}
+	}
+	if (count != 2) return 0;
+	return moveRow[first] - moveRow[second] < -1 || moveRow[first] - moveRow[second] > 1 ||
+		moveCol[first] - moveCol[second] < -1 || moveCol[first] - moveCol[second] > 1;
+}
+
+/*
+* Add both directions of an edge. The arc from u to w gets the even number.
+*/
+static int addEdge(struct RoadIndex* index, const int u, const int w, const int weight, const int first, const int second)
+{
+	struct RoadArc* arc;
+
+	if (index->numArcs + 2 > ROAD_MAX_ARCS) return 0;
+
+	arc = &index->arcs[index->numArcs];
+	arc->to = w;
+	arc->weight = weight;
+	arc->next = index->firstArc[u];
+	arc->first = first;
+	arc->second = second;
+	index->firstArc[u] = index->numArcs++;
+
+	arc = &index->arcs[index->numArcs];
+	arc->to = u;
+	arc->weight = weight;
+	arc->next = index->firstArc[w];
+	arc->first = first >= 0 ? second ^ 1 : -1;
+	arc->second = first >= 0 ? first ^ 1 : second;
+	index->firstArc[w] = index->numArcs++;
+	return 1;
+}
+
+/*
+* Follow a corridor from the square next to a node until it reaches another node, and join the two
+* nodes with one edge.
+*/
+static int walkChain(struct RoadIndex* index, const struct Map* map, int previous, int cell)
+{
+	int chain = index->numChains++, start = index->chainFirst[chain], next = -1, i;
+
+	index->chainEndA[chain] = index->cellNode[previous];
+	index->chainLength[chain] = 0;
+	while (index->cellNode[cell] == -1)
+	{
+		index->cellChain[cell] = chain;
+		index->chainPos[cell] = index->chainLength[chain];
+		index->chainCells[start + index->chainLength[chain]++] = cell;
+		for (i = 0; i < 8; i++)
+		{
+			if (isOpenSquare(map, CELL_ROW(cell) + moveRow[i], CELL_COL(cell) + moveCol[i]) &&
+				cell + moveRow[i] * MAP_COLS + moveCol[i] != previous)
+			{
+				next = cell + moveRow[i] * MAP_COLS + moveCol[i];
+			}
+		}
+		previous = cell;
+		cell = next;
+	}
+	index->chainEndB[chain] = index->cellNode[cell];
+	if (chain + 1 < MAP_CELLS)
+	{
+		index->chainFirst[chain + 1] = start + index->chainLength[chain];
+	}
+
+	// a corridor that leaves and returns to the same node is never part of a shortest path
+	if (index->chainEndA[chain] == index->chainEndB[chain]) return 1;
+	return addEdge(index, index->chainEndA[chain], index->chainEndB[chain], index->chainLength[chain] + 1, -1, chain);
+}
+
+static int addRoads(struct RoadIndex* index, const struct Map* map, const int cell)
+{
+	int row = CELL_ROW(cell), col = CELL_COL(cell), next, i;
+
+	for (i = 0; i < 8; i++)
+	{
+		if (!isOpenSquare(map, row + moveRow[i], col + moveCol[i])) continue;
+
+		next = cell + moveRow[i] * MAP_COLS + moveCol[i];
+		if (index->cellNode[next] == -1 && index->cellChain[next] == -1)
+		{
+			if (!walkChain(index, map, cell, next)) return 0;
+		}
+		else if (index->cellNode[next] > index->cellNode[cell])
+		{
+			if (!addEdge(index, index->cellNode[cell], index->cellNode[next], 1, -1, -1)) return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+* Find the not yet contracted nodes next to v and the cheapest arc to each one.
+*/
+static void collectNeighbours(const struct RoadIndex* index, const int v)
+{
+	int arc, to;
+
+	numNeighbours = 0;
+	beginSearch();
+	for (arc = index->firstArc[v]; arc != -1; arc = index->arcs[arc].next)
+	{
+		to = index->arcs[arc].to;
+		if (contracted[to] || to == v) continue;
+
+		if (neighbourSeen[to] != searchId)
+		{
+			neighbourSeen[to] = searchId;
+			neighbourSlot[to] = numNeighbours;
+			neighbourNode[numNeighbours] = to;
+			neighbourArc[numNeighbours++] = arc;
+		}
+		else if (index->arcs[arc].weight < index->arcs[neighbourArc[neighbourSlot[to]]].weight)
+		{
+			neighbourArc[neighbourSlot[to]] = arc;
+		}
+	}
+}
+
+/*
+* Dijkstra's search from source over the nodes still in the graph, without passing through skip.
+*/
+static void witnessSearch(const struct RoadIndex* index, const int source, const int skip, const int limit)
+{
+	struct RoadHeapEntry top;
+	int settled = 0, arc, to, cost;
+
+	beginSearch();
+	witnessHeap.size = 0;
+	witnessSeen[source] = searchId;
+	witnessDist[source] = 0;
+	heapPush(&witnessHeap, 0, source);
+	while (witnessHeap.size > 0 && settled < ROAD_WITNESS_LIMIT)
+	{
+		top = heapPop(&witnessHeap);
+		if (top.key > witnessDist[top.node]) continue;
+		if (top.key > limit) break;
+
+		settled++;
+		for (arc = index->firstArc[top.node]; arc != -1; arc = index->arcs[arc].next)
+		{
+			to = index->arcs[arc].to;
+			if (contracted[to] || to == skip) continue;
+
+			cost = top.key + index->arcs[arc].weight;
+			if (witnessSeen[to] != searchId || cost < witnessDist[to])
+			{
+				witnessSeen[to] = searchId;
+				witnessDist[to] = cost;
+				heapPush(&witnessHeap, cost, to);
+			}
+		}
+	}
+}
+
+/*
+* Count the shortcuts needed to remove v from the graph, adding them when apply is true. Returns -1 if
+* there is no room for them.
+*/
+static int contractNode(struct RoadIndex* index, const int v, const int apply)
+{
+	const int* arcs = neighbourArc;
+	int count = 0, maxWeight = 0, i, j, candidate, dist, node;
+
+	collectNeighbours(index, v);
+	for (i = 0; i < numNeighbours; i++)
+	{
+		if (index->arcs[arcs[i]].weight > maxWeight) maxWeight = index->arcs[arcs[i]].weight;
+	}
+	for (i = 0; i < numNeighbours; i++)
+	{
+		node = index->arcs[arcs[i]].to;
+		witnessSearch(index, node, v, index->arcs[arcs[i]].weight + maxWeight);
+		for (j = i + 1; j < numNeighbours; j++)
+		{
+			candidate = index->arcs[arcs[i]].weight + index->arcs[arcs[j]].weight;
+			dist = witnessSeen[index->arcs[arcs[j]].to] == searchId ? witnessDist[index->arcs[arcs[j]].to] : ROAD_INFINITY;
+			if (dist > candidate)
+			{
+				count++;
+				if (apply && !addEdge(index, node, index->arcs[arcs[j]].to, candidate, arcs[i] ^ 1, arcs[j])) return -1;
+			}
+		}
+	}
+	if (apply)
+	{
+		for (i = 0; i < numNeighbours; i++)
+		{
+			deletedNeighbours[index->arcs[arcs[i]].to]++;
+		}
+	}
+	return count;
+}
+
+/*
+* Nodes that add few shortcuts and whose neighbours have not been contracted yet go first.
+*/
+static int contractionPriority(struct RoadIndex* index, const int v)
+{
+	int shortcuts = contractNode(index, v, 0);
+
+	return shortcuts - numNeighbours + deletedNeighbours[v];
+}
+
+static int contractAll(struct RoadIndex* index)
+{
+	struct RoadHeapEntry top;
+	int nextRank = 0, priority, node, arc, i;
+
+	orderHeap.size = 0;
+	for (node = 0; node < index->numNodes; node++)
+	{
+		contracted[node] = 0;
+		deletedNeighbours[node] = 0;
+	}
+	for (node = 0; node < index->numNodes; node++)
+	{
+		heapPush(&orderHeap, contractionPriority(index, node), node);
+	}
+	while (orderHeap.size > 0)
+	{
+		top = heapPop(&orderHeap);
+		priority = contractionPriority(index, top.node);
+		if (priority > heapTop(&orderHeap))
+		{
+			heapPush(&orderHeap, priority, top.node);
+			continue;
+		}
+		if (contractNode(index, top.node, 1) < 0) return 0;
+		contracted[top.node] = 1;
+		index->rank[top.node] = nextRank++;
+	}
+
+	// keep only the arcs that lead up the hierarchy for searching
+	index->firstUp[0] = 0;
+	for (node = 0, i = 0; node < index->numNodes; node++)
+	{
+		for (arc = index->firstArc[node]; arc != -1; arc = index->arcs[arc].next)
+		{
+			if (index->rank[index->arcs[arc].to] > index->rank[node])
+			{
+				index->upArcs[i++] = arc;
+			}
+		}
+		index->firstUp[node + 1] = i;
+	}
+	return 1;
+}
+
+int roadBuild(struct RoadIndex* index, const struct Map* map)
+{
+	int cell;
+
+	index->complete = 0;
+	index->numNodes = 0;
+	index->numChains = 0;
+	index->numArcs = 0;
+	index->chainFirst[0] = 0;
+	for (cell = 0; cell < MAP_CELLS; cell++)
+	{
+		index->cellNode[cell] = -1;
+		index->cellChain[cell] = -1;
+		index->firstArc[cell] = -1;
+		if (isOpenSquare(map, CELL_ROW(cell), CELL_COL(cell)) && !isCorridor(map, CELL_ROW(cell), CELL_COL(cell)))
+		{
+			index->nodeCell[index->numNodes] = cell;
+			index->cellNode[cell] = index->numNodes++;
+		}
+	}
+	for (cell = 0; cell < MAP_CELLS; cell++)
+	{
+		if (index->cellNode[cell] != -1 && !addRoads(index, map, cell)) return 0;
+	}
+	for (cell = 0; cell < MAP_CELLS; cell++)
+	{
+		// a closed loop of corridor never reaches a node, so one of its squares is made into one
+		if (isCorridor(map, CELL_ROW(cell), CELL_COL(cell)) && index->cellChain[cell] == -1)
+		{
+			index->nodeCell[index->numNodes] = cell;
+			index->cellNode[cell] = index->numNodes++;
+			if (!addRoads(index, map, cell)) return 0;
+		}
+	}
+
+	index->complete = contractAll(index);
+	return index->complete;
+}
+
+/*
+* The nodes a square is attached to and the number of moves to each one: the square itself for a node,
+* or the nodes at both ends of its corridor.
+*/
+static int attachedNodes(const struct RoadIndex* index, const struct Point pt, int nodes[2], int dists[2])
+{
+	int cell, chain;
+
+	if (pt.row < 0 || pt.row >= MAP_ROWS || pt.col < 0 || pt.col >= MAP_COLS) return 0;
+
+	cell = CELL(pt.row, pt.col);
+	if (index->cellNode[cell] != -1)
+	{
+		nodes[0] = index->cellNode[cell];
+		dists[0] = 0;
+		return 1;
+	}
+	chain = index->cellChain[cell];
+	if (chain == -1) return 0;
+
+	nodes[0] = index->chainEndA[chain];
+	dists[0] = index->chainPos[cell] + 1;
+	nodes[1] = index->chainEndB[chain];
+	dists[1] = index->chainLength[chain] - index->chainPos[cell];
+	return 2;
+}
+
+static void seedForward(const int node, const int dist)
+{
+	if (forwardSeen[node] != searchId || dist < forwardDist[node])
+	{
+		forwardSeen[node] = searchId;
+		forwardDist[node] = dist;
+		forwardArc[node] = -1;
+		heapPush(&forwardHeap, dist, node);
+	}
+}
+
+static void seedBackward(const int node, const int dist)
+{
+	if (backwardSeen[node] != searchId || dist < backwardDist[node])
+	{
+		backwardSeen[node] = searchId;
+		backwardDist[node] = dist;
+		backwardArc[node] = -1;
+		heapPush(&backwardHeap, dist, node);
+	}
+}
+
+/*
+* A node is stalled when a higher node already reached by the same search leads back down to it more
+* cheaply, so no shortest path goes up through it and its arcs need not be followed.
+*/
+static int isStalled(const struct RoadIndex* index, const int node, const int key, const unsigned int* seen, const int* dist)
+{
+	int to, i;
+
+	for (i = index->firstUp[node]; i < index->firstUp[node + 1]; i++)
+	{
+		to = index->arcs[index->upArcs[i]].to;
+		if (seen[to] == searchId && dist[to] + index->arcs[index->upArcs[i]].weight < key) return 1;
+	}
+	return 0;
+}
+
+/*
+* Search up the hierarchy from both sets of seeded nodes until no shorter meeting point can be found.
+* Returns the length of the shortest path and the node where the two searches met.
+*/
+static int searchUp(const struct RoadIndex* index, int* meet)
+{
+	struct RoadHeapEntry top;
+	struct RoadHeap* heap;
+	unsigned int* seen;
+	unsigned int* otherSeen;
+	int* dist;
+	int* otherDist;
+	int* via;
+	int best = ROAD_INFINITY, forward, cost, to, i;
+
+	lastStats.expanded = 0;
+	lastStats.generated = forwardHeap.size + backwardHeap.size;
+	*meet = -1;
+	while (heapTop(&forwardHeap) < best || heapTop(&backwardHeap) < best)
+	{
+		forward = heapTop(&forwardHeap) <= heapTop(&backwardHeap);
+		heap = forward ? &forwardHeap : &backwardHeap;
+		seen = forward ? forwardSeen : backwardSeen;
+		otherSeen = forward ? backwardSeen : forwardSeen;
+		dist = forward ? forwardDist : backwardDist;
+		otherDist = forward ? backwardDist : forwardDist;
+		via = forward ? forwardArc : backwardArc;
+
+		top = heapPop(heap);
+		if (top.key > dist[top.node]) continue;
+
+		lastStats.expanded++;
+		if (otherSeen[top.node] == searchId && top.key + otherDist[top.node] < best)
+		{
+			best = top.key + otherDist[top.node];
+			*meet = top.node;
+		}
+		if (isStalled(index, top.node, top.key, seen, dist)) continue;
+
+		for (i = index->firstUp[top.node]; i < index->firstUp[top.node + 1]; i++)
+		{
+			to = index->arcs[index->upArcs[i]].to;
+			cost = top.key + index->arcs[index->upArcs[i]].weight;
+			if (seen[to] != searchId || cost < dist[to])
+			{
+				seen[to] = searchId;
+				dist[to] = cost;
+				via[to] = index->upArcs[i];
+				heapPush(heap, cost, to);
+				lastStats.generated++;
+			}
+		}
+	}
+	return best;
+}
+
+/*
+* The number of moves between two squares of the same corridor without leaving it, or ROAD_INFINITY.
+*/
+static int alongChain(const struct RoadIndex* index, const struct Point start, const struct Point dest)
+{
+	int startCell = CELL(start.row, start.col), destCell = CELL(dest.row, dest.col);
+
+	if (index->cellChain[startCell] == -1 || index->cellChain[startCell] != index->cellChain[destCell])
+	{
+		return ROAD_INFINITY;
+	}
+	return index->chainPos[startCell] > index->chainPos[destCell] ?
+		index->chainPos[startCell] - index->chainPos[destCell] : index->chainPos[destCell] - index->chainPos[startCell];
+}
+
+/*
+* Seed both searches and run them, returning the shortest length through the hierarchy.
+*/
+static int searchPoints(const struct RoadIndex* index, const struct Point start, const struct Point dest, int* meet)
+{
+	int nodes[2], dists[2], count, i;
+
+	beginSearch();
+	count = attachedNodes(index, start, nodes, dists);
+	for (i = 0; i < count; i++)
+	{
+		seedForward(nodes[i], dists[i]);
+	}
+	count = attachedNodes(index, dest, nodes, dists);
+	for (i = 0; i < count; i++)
+	{
+		seedBackward(nodes[i], dists[i]);
+	}
+	return searchUp(index, meet);
+}
+
+static int validPoints(const struct RoadIndex* index, const struct Point start, const struct Point dest)
+{
+	int nodes[2], dists[2];
+
+	return index != NULL && index->complete &&
+		attachedNodes(index, start, nodes, dists) > 0 && attachedNodes(index, dest, nodes, dists) > 0;
+}
+
+int roadDistance(const struct RoadIndex* index, const struct Point start, const struct Point dest)
+{
+	int best, direct, meet;
+
+	lastStats.expanded = 0;
+	lastStats.generated = 0;
+	if (!validPoints(index, start, dest)) return -1;
+	if (eqPt(start, dest)) return 0;
+
+	best = searchPoints(index, start, dest, &meet);
+	direct = alongChain(index, start, dest);
+	if (direct < best) best = direct;
+	return best < ROAD_INFINITY ? best : -1;
+}
+
+int roadDistanceFromRoute(const struct RoadIndex* index, const struct Route* route, const struct Point dest)
+{
+	int nodes[2], dists[2], count, best, direct, meet, i, j;
+
+	lastStats.expanded = 0;
+	lastStats.generated = 0;
+	if (index == NULL || !index->complete || route == NULL || attachedNodes(index, dest, nodes, dists) == 0) return -1;
+
+	beginSearch();
+	for (i = 0; i < route->numPoints; i++)
+	{
+		if (eqPt(route->points[i], dest)) return 0;
+
+		count = attachedNodes(index, route->points[i], nodes, dists);
+		for (j = 0; j < count; j++)
+		{
+			seedForward(nodes[j], dists[j]);
+		}
+	}
+	count = attachedNodes(index, dest, nodes, dists);
+	for (j = 0; j < count; j++)
+	{
+		seedBackward(nodes[j], dists[j]);
+	}
+	best = searchUp(index, &meet);
+
+	for (i = 0; i < route->numPoints; i++)
+	{
+		if (attachedNodes(index, route->points[i], nodes, dists) > 0)
+		{
+			direct = alongChain(index, route->points[i], dest);
+			if (direct < best) best = direct;
+		}
+	}
+	return best < ROAD_INFINITY ? best : -1;
+}
+
+static void appendCell(struct Route* route, const int cell)
+{
+	if (route->numPoints < MAX_ROUTE)
+	{
+		route->points[route->numPoints].row = (char)CELL_ROW(cell);
+		route->points[route->numPoints].col = (char)CELL_COL(cell);
+	}
+	route->numPoints++;
+}
+
+/*
+* Add the squares of corridor chain from position from to position to, inclusive, in that order.
+*/
+static void appendChain(const struct RoadIndex* index, struct Route* route, const int chain, const int from, const int to)
+{
+	int step = from <= to ? 1 : -1, i;
+
+	for (i = from; i != to + step; i += step)
+	{
+		appendCell(route, index->chainCells[index->chainFirst[chain] + i]);
+	}
+}
+
+/*
+* Add the squares an arc passes through, expanding shortcuts into the arcs they were made from.
+*/
+static void appendArc(const struct RoadIndex* index, struct Route* route, const int arc)
+{
+	const struct RoadArc* a = &index->arcs[arc];
+
+	if (a->first >= 0)
+	{
+		appendArc(index, route, a->first);
+		appendArc(index, route, a->second);
+		return;
+	}
+	if (a->second >= 0)
+	{
+		if (arc % 2 == 0) appendChain(index, route, a->second, 0, index->chainLength[a->second] - 1);
+		else appendChain(index, route, a->second, index->chainLength[a->second] - 1, 0);
+	}
+	appendCell(route, index->nodeCell[a->to]);
+}
+
+int roadFindPathInto(const struct RoadIndex* index, const struct Point start, const struct Point dest, struct Route* route)
+{
+	int arcs[MAP_CELLS], numArcs = 0, startCell, destCell, best, direct, meet, node, chain, i;
+
+	route->numPoints = 0;
+	route->routeSymbol = DIVERSION;
+	lastStats.expanded = 0;
+	lastStats.generated = 0;
+	if (!validPoints(index, start, dest) || eqPt(start, dest)) return 0;
+
+	startCell = CELL(start.row, start.col);
+	destCell = CELL(dest.row, dest.col);
+	best = searchPoints(index, start, dest, &meet);
+	direct = alongChain(index, start, dest);
+	if (direct < ROAD_INFINITY && direct <= best)
+	{
+		chain = index->cellChain[startCell];
+		if (index->chainPos[startCell] < index->chainPos[destCell])
+		{
+			appendChain(index, route, chain, index->chainPos[startCell] + 1, index->chainPos[destCell]);
+		}
+		else
+		{
+			appendChain(index, route, chain, index->chainPos[startCell] - 1, index->chainPos[destCell]);
+		}
+		return route->numPoints;
+	}
+	if (best == ROAD_INFINITY) return 0;
+
+	// from the start along its corridor to the node the forward search began at
+	for (node = meet; forwardArc[node] != -1; node = index->arcs[forwardArc[node] ^ 1].to)
+	{
+		arcs[numArcs++] = forwardArc[node];
+	}
+	chain = index->cellChain[startCell];
+	if (chain != -1)
+	{
+		if (node == index->chainEndA[chain] && forwardDist[node] == index->chainPos[startCell] + 1)
+		{
+			if (index->chainPos[startCell] > 0) appendChain(index, route, chain, index->chainPos[startCell] - 1, 0);
+		}
+		else if (index->chainPos[startCell] < index->chainLength[chain] - 1)
+		{
+			appendChain(index, route, chain, index->chainPos[startCell] + 1, index->chainLength[chain] - 1);
+		}
+		appendCell(route, index->nodeCell[node]);
+	}
+
+	// down the hierarchy to the meeting node and back down the other side
+	for (i = numArcs - 1; i >= 0; i--)
+	{
+		appendArc(index, route, arcs[i]);
+	}
+	for (node = meet; backwardArc[node] != -1; node = index->arcs[backwardArc[node] ^ 1].to)
+	{
+		appendArc(index, route, backwardArc[node] ^ 1);
+	}
+
+	// along the destination's corridor from the node the backward search began at
+	chain = index->cellChain[destCell];
+	if (chain != -1)
+	{
+		if (node == index->chainEndA[chain] && backwardDist[node] == index->chainPos[destCell] + 1)
+		{
+			appendChain(index, route, chain, 0, index->chainPos[destCell]);
+		}
+		else
+		{
+			appendChain(index, route, chain, index->chainLength[chain] - 1, index->chainPos[destCell]);
+		}
+	}
+
+	if (route->numPoints > MAX_ROUTE) route->numPoints = 0;
+	return route->numPoints;
+}
+
+struct Route roadFindPath(const struct RoadIndex* index, const struct Point start, const struct Point dest)
+{
+	struct Route route;
+
+	roadFindPathInto(index, start, dest, &route);
+	return route;
+}
+
+void useRoadIndex(const struct RoadIndex* index)
+{
+	activeIndex = index;
+}
+
+const struct RoadIndex* getRoadIndex(void)
+{
+	return activeIndex;
+}
+
+struct PathStats roadGetLastStats(void)
+{
+	return lastStats;
+}
@@ -0,0 +1,127 @@
+#ifndef ROADGRAPH_H
+#define ROADGRAPH_H
+
+#include "mapping.h"
+#include "pathing.h"
+
+// room for the road graph edges plus the shortcuts added while it is contracted, two arcs per edge
+#ifndef ROAD_MAX_ARCS
+#define ROAD_MAX_ARCS (MAP_CELLS * 16)
+#endif
+
+/**
+* One direction of an edge of the road graph. An arc made by contraction skips over a node and is the
+* join of the arcs first and second; an arc of the road itself has first set to -1 and follows the
+* corridor numbered second, or steps straight to a neighbouring node when second is -1. The two directions
+* of an edge are stored next to each other, so arc ^ 1 is always the reverse of arc.
+*/
+struct RoadArc
+{
+	int to;
+	int weight;
+	int next;	// the next arc leaving the same node
+	int first;
+	int second;
+};
+
+/**
+* A sparse road graph of a map with a contraction hierarchy built on top of it. Open squares that only
+* join two squares that do not touch each other form corridors, which become single weighted edges
+* between the squares at their ends; every other open square is a node. It contains no pointers so it
+* can be copied or saved as it is.
+*/
+struct RoadIndex
+{
+	int complete;	// false if the map needed more than ROAD_MAX_ARCS arcs and the index cannot be used
+	int numNodes;
+	int numChains;
+	int numArcs;
+	int nodeCell[MAP_CELLS];
+	int cellNode[MAP_CELLS];	// node of a square, -1 for corridors and buildings
+	int rank[MAP_CELLS];		// order in which the nodes were contracted
+	int cellChain[MAP_CELLS];	// corridor of a square, -1 for nodes and buildings
+	int chainPos[MAP_CELLS];	// position of a square along its corridor
+	int chainFirst[MAP_CELLS];	// start of each corridor in chainCells
+	int chainLength[MAP_CELLS];
+	int chainEndA[MAP_CELLS];	// node next to the first square of each corridor
+	int chainEndB[MAP_CELLS];	// node next to the last square
+	int chainCells[MAP_CELLS];
+	int firstArc[MAP_CELLS];	// list of arcs leaving each node
+	int firstUp[MAP_CELLS + 1];	// upArcs[firstUp[n]] to upArcs[firstUp[n + 1] - 1] lead to higher ranked nodes
+	int upArcs[ROAD_MAX_ARCS];
+	struct RoadArc arcs[ROAD_MAX_ARCS];
+};
+
+/**
+* Convert a map into a road graph and contract it. The index is large, so it should be static or
+* allocated rather than a local variable. It has to be built again after the map changes, which
+* roadMapObserver() (see mapupdate.h) does for changes made with setSquareBlocked().
+* @param index - the index to fill in
+* @param map - the map showing the location of buildings.
+* @returns - true if the index was built, false if the map needs more than ROAD_MAX_ARCS arcs.
+*/
+int roadBuild(struct RoadIndex* index, const struct Map* map);
+
+/**
+* Find the number of moves on the shortest path between two points by searching up the hierarchy from
+* the nodes each point is attached to.
+* @param index - the index built for the map
+* @param start - the point to start from
+* @param dest - the point to go to
+* @returns - the number of moves, the same as a PATH_ASTAR path, or -1 if either point is a building or
+* there is no path.
+*/
+int roadDistance(const struct RoadIndex* index, const struct Point start, const struct Point dest);
+
+/**
+* Find the number of moves from the closest point of a route to a destination with a single search that
+* starts from every point of the route at once.
+* @param index - the index built for the map
+* @param route - the route to start from
+* @param dest - the point to go to
+* @returns - the fewest moves from any point on the route to dest, or -1 if dest cannot be reached.
+*/
+int roadDistanceFromRoute(const struct RoadIndex* index, const struct Route* route, const struct Point dest);
+
+/**
+* Find a shortest path by searching the hierarchy and then expanding its shortcuts and corridors back
+* into squares.
+* @param index - the index built for the map
+* @param start - the point to start from
+* @param dest - the point to go to
+* @returns - the path from start to dest, not including start, or a Route of zero length if there is no
+* path, it does not fit in a Route, or start and dest are the same point.
+*/
+struct Route roadFindPath(const struct RoadIndex* index, const struct Point start, const struct Point dest);
+
+/**
+* Find a shortest path as roadFindPath() does, writing it into caller-provided storage instead of
+* returning a copy.
+* @param index - the index built for the map
+* @param start - the point to start from
+* @param dest - the point to go to
+* @param route - where to write the path; it has zero length if there is none
+* @returns - the number of points in the path.
+*/
+int roadFindPathInto(const struct RoadIndex* index, const struct Point start, const struct Point dest, struct Route* route);
+
+/**
+* Get the counters for the most recent query of the road index made on this thread. Queries may run
+* on several threads at once; building an index may not.
+* @returns - the nodes settled by the last query.
+*/
+struct PathStats roadGetLastStats(void);
+
+/**
+* Make findPath() with PATH_CONTRACTED and calculateRouteDistance() use an index.
+* @param index - the index to use, or NULL to stop using one
+*/
+void useRoadIndex(const struct RoadIndex* index);
+
+/**
+* Get the index installed with useRoadIndex().
+* @returns - the index in use or NULL if there is none.
+*/
+const struct RoadIndex* getRoadIndex(void);
+
+#endif
@@ -0,0 +1,163 @@
+#include "segments.h"
+
+/*
+* Round a quotient down, for a divisor greater than 0.
+*/
+static int floorDivide(const int value, const int divisor)
+{
+	return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+/*
+* The square of the straight line distance from the k-th point of a run to a point.
+*/
+static int squaredDistanceAt(const struct RouteSegment* segment, const int k, const struct Point pt)
+{
+	int deltaRow = segment->start.row + k * segment->rowStep - pt.row;
+	int deltaCol = segment->start.col + k * segment->colStep - pt.col;
+
+	return deltaRow * deltaRow + deltaCol * deltaCol;
+}
+
+int compressRoute(const struct Route* route, struct RouteSegment segments[], const int maxSegments)
+{
+	int numSegments = 0, i = 0, rowStep, colStep;
+
+	while (i < route->numPoints)
+	{
+		if (numSegments == maxSegments) return -1;
+
+		segments[numSegments].start = route->points[i];
+		segments[numSegments].rowStep = 0;
+		segments[numSegments].colStep = 0;
+		segments[numSegments].length = 1;
+		if (i + 1 < route->numPoints)
+		{
+			rowStep = route->points[i + 1].row - route->points[i].row;
+			colStep = route->points[i + 1].col - route->points[i].col;
+			segments[numSegments].rowStep = (signed char)rowStep;
+			segments[numSegments].colStep = (signed char)colStep;
+			while (i + 1 < route->numPoints
+				&& route->points[i + 1].row - route->points[i].row == rowStep
+				&& route->points[i + 1].col - route->points[i].col == colStep)
+			{
+				segments[numSegments].length++;
+				i++;
+			}
+		}
+		i++;
+		numSegments++;
+	}
+	return numSegments;
+}
+
+int expandSegments(const struct RouteSegment segments[], const int numSegments, struct Route* route)
+{
+	struct SegmentCursor cursor;
+	struct Point point;
+
+	route->numPoints = 0;
+	startSegmentCursor(&cursor, segments, numSegments);
+	while (route->numPoints < MAX_ROUTE && nextSegmentPoint(&cursor, &point))
+	{
+		route->points[route->numPoints++] = point;
+	}
+	return route->numPoints;
+}
+
+void startSegmentCursor(struct SegmentCursor* cursor, const struct RouteSegment segments[], const int numSegments)
+{
+	cursor->segments = segments;
+	cursor->numSegments = numSegments;
+	cursor->segment = 0;
+	cursor->step = 0;
+}
+
+int nextSegmentPoint(struct SegmentCursor* cursor, struct Point* point)
+{
+	const struct RouteSegment* segment;
+
+	if (cursor->segment >= cursor->numSegments) return 0;
+
+	segment = &cursor->segments[cursor->segment];
+	point->row = (char)(segment->start.row + cursor->step * segment->rowStep);
+	point->col = (char)(segment->start.col + cursor->step * segment->colStep);
+	if (++cursor->step == segment->length)
+	{
+		cursor->segment++;
+		cursor->step = 0;
+	}
+	return 1;
+}
+
+int isOnSegments(const struct RouteSegment segments[], const int numSegments, const struct Point point)
+{
+	const struct RouteSegment* segment;
+	int i, deltaRow, deltaCol, k;
+
+	for (i = 0; i < numSegments; i++)
+	{
+		segment = &segments[i];
+		deltaRow = point.row - segment->start.row;
+		deltaCol = point.col - segment->start.col;
+
+		// the number of steps along the run that would reach the point, if any does
+		if (segment->rowStep != 0)
+		{
+			if (deltaRow % segment->rowStep != 0) continue;
+			k = deltaRow / segment->rowStep;
+		}
+		else if (segment->colStep != 0)
+		{
+			if (deltaCol % segment->colStep != 0) continue;
+			k = deltaCol / segment->colStep;
+		}
+		else
+		{
+			k = 0;
+		}
+		if (k >= 0 && k < segment->length && deltaRow == k * segment->rowStep && deltaCol == k * segment->colStep) return 1;
+	}
+	return 0;
+}
+
+int getClosestPointOnSegments(const struct RouteSegment segments[], const int numSegments, const struct Point pt)
+{
+	const struct RouteSegment* segment;
+	int i, first = 0, closestIdx = -1, closestDist = 0, stepLength, k, dist, nextDist;
+
+	for (i = 0; i < numSegments; i++)
+	{
+		segment = &segments[i];
+
+		// the distance along the run is a parabola in k, so the closest point is one of the two whole steps
+		// either side of where the point projects onto the run's line, kept within the run
+		stepLength = segment->rowStep * segment->rowStep + segment->colStep * segment->colStep;
+		k = 0;
+		if (stepLength > 0)
+		{
+			k = floorDivide((pt.row - segment->start.row) * segment->rowStep + (pt.col - segment->start.col) * segment->colStep, stepLength);
+			if (k < 0) k = 0;
+			if (k > segment->length - 1) k = segment->length - 1;
+		}
+		dist = squaredDistanceAt(segment, k, pt);
+		if (k + 1 < segment->length)
+		{
+			nextDist = squaredDistanceAt(segment, k + 1, pt);
+			if (nextDist < dist)
+			{
+				dist = nextDist;
+				k++;
+			}
+		}
+
+		// only a strictly closer run wins, so the first of several equally close points is kept
+		if (closestIdx < 0 || dist < closestDist)
+		{
+			closestDist = dist;
+			closestIdx = first + k;
+		}
+		first += segment->length;
+	}
+	return closestIdx;
+}
@@ -0,0 +1,85 @@
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include "mapping.h"
+
+/**
+* A straight run of route points: the start, then the start moved by the step once, twice and so on. Most
+* routes are a few long runs along rows, columns and diagonals, so a route kept as runs takes room for each
+* turn rather than for each square. A point that is not part of a longer run is a run of one with no step.
+*/
+struct RouteSegment
+{
+	struct Point start;
+	signed char rowStep;
+	signed char colStep;
+	int length;		// points in the run, at least 1
+};
+
+/**
+* A place in a list of runs, for visiting their points in route order without expanding them.
+*/
+struct SegmentCursor
+{
+	const struct RouteSegment* segments;
+	int numSegments;
+	int segment;	// the run the next point is in
+	int step;		// how far along that run the next point is
+};
+
+/**
+* Split a route into the fewest runs, taking each run as far as the step between points stays the same.
+* @param route - the route to split
+* @param segments - where to write the runs
+* @param maxSegments - room in segments; a route never needs more runs than it has points
+* @returns - the number of runs, or -1 if more than maxSegments are needed.
+*/
+int compressRoute(const struct Route* route, struct RouteSegment segments[], const int maxSegments);
+
+/**
+* Write out every point of a list of runs.
+* @param segments - the runs
+* @param numSegments - the number of runs
+* @param route - where to write the points; the route symbol is left as it is
+* @returns - the number of points written, at most MAX_ROUTE.
+*/
+int expandSegments(const struct RouteSegment segments[], const int numSegments, struct Route* route);
+
+/**
+* Start visiting the points of a list of runs.
+* @param cursor - the cursor to set to the first point
+* @param segments - the runs, which must stay in place while the cursor is used
+* @param numSegments - the number of runs
+*/
+void startSegmentCursor(struct SegmentCursor* cursor, const struct RouteSegment segments[], const int numSegments);
+
+/**
+* Take the next point of a list of runs.
+* @param cursor - a cursor set up with startSegmentCursor()
+* @param point - where to write the point
+* @returns - true if there was a point, false once every point has been visited.
+*/
+int nextSegmentPoint(struct SegmentCursor* cursor, struct Point* point);
+
+/**
+* Determine if a point is on a route kept as runs, working out from each run whether the point lies on it
+* rather than checking the run's points one at a time.
+* @param segments - the runs
+* @param numSegments - the number of runs
+* @param point - the point to look for
+* @returns - true if the point is one of the route's points.
+*/
+int isOnSegments(const struct RouteSegment segments[], const int numSegments, const struct Point point);
+
+/**
+* Find the route point closest to a point by projecting the point onto each run, so each run costs the same
+* however long it is.
+* @param segments - the runs
+* @param numSegments - the number of runs
+* @param pt - the point to measure from
+* @returns - the position of the closest point in the expanded route, the same one getClosestPoint() returns
+* for it, or -1 if there are no points.
+*/
+int getClosestPointOnSegments(const struct RouteSegment segments[], const int numSegments, const struct Point pt);
+
+#endif
@@ -0,0 +1,127 @@
+/*
+* Purpose: Shipment assignment with the fleet scored in parallel, one shard per task
+*/
+
+#include <stddef.h>
+#include "shardassign.h"
+#include "assignpolicy.h"
+
+/**
+ * Everything a shard task needs, and where it leaves its best truck
+ */
+struct ShardJob {
+    const struct FleetShards* shards;
+    const struct Truck* trucks;
+    const struct Shipment* s;
+    const struct Map* map;
+    struct ReachMasks masks;
+    struct AssignCandidate best[MAX_SHARDS];
+};
+
+// The MS4 order with the truck index as the last tie-break, so no two trucks ever compare equal
+#define BETTER_OR_EARLIER(c, b) \
+    (BETTER_MIN_DIVERSION(c, b) || (!BETTER_MIN_DIVERSION(b, c) && (c).index < (b).index))
+
+/*
+* Name: buildFleetShards
+* Description: Splits the fleet into shards by the middle point of each route
+*/
+void buildFleetShards(struct FleetShards* shards, const struct Truck trucks[], int numTrucks, int numShards) {
+    int sector[SHARD_MAX_TRUCKS];
+
+    if (shards == NULL) {
+        return;
+    }
+
+    shards->numTrucks = (trucks == NULL || numTrucks <= 0) ? 0 : (numTrucks < SHARD_MAX_TRUCKS ? numTrucks : SHARD_MAX_TRUCKS);
+    shards->numShards = numShards < 1 ? 1 : (numShards > MAX_SHARDS ? MAX_SHARDS : numShards);
+
+    for (int k = 0; k <= shards->numShards; k++) {
+        shards->first[k] = 0;
+    }
+
+    // Count the trucks in each band of columns
+    for (int i = 0; i < shards->numTrucks; i++) {
+        const struct Route* route = &trucks[i].route;
+        int col = route->numPoints > 0 ? route->points[route->numPoints / 2].col : 0;
+        sector[i] = (col < 0 ? 0 : col) * shards->numShards / MAP_COLS;
+        if (sector[i] >= shards->numShards) {
+            sector[i] = shards->numShards - 1;
+        }
+        shards->first[sector[i] + 1]++;
+    }
+    for (int k = 0; k < shards->numShards; k++) {
+        shards->first[k + 1] += shards->first[k];
+    }
+
+    // Counting sort keeps each shard in truck order
+    int next[MAX_SHARDS];
+    for (int k = 0; k < shards->numShards; k++) {
+        next[k] = shards->first[k];
+    }
+    for (int i = 0; i < shards->numTrucks; i++) {
+        shards->order[next[sector[i]]++] = i;
+    }
+}
+
+// Score one shard, lowest index first so the first of several equal trucks is kept
+static void scoreShard(void* context, int shard) {
+    struct ShardJob* job = (struct ShardJob*)context;
+    struct AssignCandidate* best = &job->best[shard];
+    struct AssignCandidate candidate;
+
+    best->index = -1;
+    for (int j = job->shards->first[shard]; j < job->shards->first[shard + 1]; j++) {
+        int i = job->shards->order[j];
+        if (!canFitShipment(&job->trucks[i], job->s)) {
+            continue;
+        }
+        candidate.diversion = reachDistance(&job->masks, job->trucks, i, job->s->destination, job->map);
+        if (candidate.diversion < 0) {
+            continue;
+        }
+        fillCandidate(&candidate, &job->trucks[i], i, job->s);
+        if (best->index < 0 || BETTER_MIN_DIVERSION(candidate, *best)) {
+            *best = candidate;
+        }
+    }
+}
+
+/*
+* Name: assignShipmentSharded
+* Description: Places the shipment by scoring the shards in parallel
+*/
+struct DeliveryResult assignShipmentSharded(struct WorkPool* pool, const struct FleetShards* shards,
+    struct Truck trucks[], int numTrucks, const struct Shipment* s, const struct Map* map) {
+    struct AssignCandidate best = { -1, 0, 0.0, 0, 0, 0, 0 };
+    struct ShardJob job;
+
+    if (trucks == NULL || numTrucks <= 0 || s == NULL || map == NULL) {
+        return commitAssignment(trucks, &best, s);
+    }
+    if (shards == NULL || shards->numTrucks != numTrucks) {
+        return assignShipment(trucks, numTrucks, s, map);
+    }
+
+    job.shards = shards;
+    job.trucks = trucks;
+    job.s = s;
+    job.map = map;
+    findReachMasks(&job.masks, trucks, numTrucks, s->destination, map);
+    if (pool != NULL) {
+        poolRun(pool, scoreShard, &job, shards->numShards);
+    }
+    else {
+        for (int k = 0; k < shards->numShards; k++) {
+            scoreShard(&job, k);
+        }
+    }
+
+    // Shards are reduced in a fixed order, so the winner is the same whichever thread ran them
+    for (int k = 0; k < shards->numShards; k++) {
+        if (job.best[k].index >= 0 && (best.index < 0 || BETTER_OR_EARLIER(job.best[k], best))) {
+            best = job.best[k];
+        }
+    }
+    return commitAssignment(trucks, &best, s);
+}
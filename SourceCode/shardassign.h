@@ -0,0 +1,55 @@
+#ifndef SHARDASSIGN_H
+#define SHARDASSIGN_H
+
+#include "delivery.h"
+#include "mapping.h"
+#include "workpool.h"
+
+#ifndef SHARD_MAX_TRUCKS
+#define SHARD_MAX_TRUCKS 1024
+#endif
+#define MAX_SHARDS 64
+
+/**
+ * The fleet split into shards by the sector of the map each truck's route is centred in.
+ * Shard k holds trucks order[first[k]] to order[first[k + 1] - 1], lowest index first.
+ */
+struct FleetShards {
+    int numShards;
+    int numTrucks;
+    int first[MAX_SHARDS + 1];
+    int order[SHARD_MAX_TRUCKS];
+};
+
+/*
+* Name: buildFleetShards
+* Description: Splits the fleet into shards, one for each band of columns of the map, by the
+*              middle point of each truck's route
+* Parameters:
+*   - shards: the shards to fill in
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks, at most SHARD_MAX_TRUCKS
+*   - numShards: number of shards, from 1 to MAX_SHARDS
+* Returns: Nothing
+*/
+void buildFleetShards(struct FleetShards* shards, const struct Truck trucks[], int numTrucks, int numShards);
+
+/*
+* Name: assignShipmentSharded
+* Description: Places the shipment the same way assignShipment() does, but scores each shard on
+*              the pool's threads and then picks from the shards' best trucks in a fixed order,
+*              so the result does not depend on the number of threads or which finished first
+* Parameters:
+*   - pool: a started pool, or NULL to score the shards on the calling thread
+*   - shards: shards built for this fleet
+*   - trucks: array of truck structures
+*   - numTrucks: number of trucks in the array
+*   - s: pointer to the shipment to assign
+*   - map: pointer to the map
+* Returns: The same delivery result as assignShipment(). If the shards were built for a different
+*          number of trucks assignShipment() is used instead.
+*/
+struct DeliveryResult assignShipmentSharded(struct WorkPool* pool, const struct FleetShards* shards,
+    struct Truck trucks[], int numTrucks, const struct Shipment* s, const struct Map* map);
+
+#endif
@@ -0,0 +1,437 @@
+/*
+* Purpose: Trucks driving their routes over a day, with shipments assigned as they come in
+*/
+
+#include <limits.h>
+#include <stddef.h>
+#include "simulation.h"
+#include "assignpolicy.h"
+
+#define MAX_DIVERSION 10.0      // as far off its route as a truck may be sent, the same as calculateRouteDistance()
+
+// Earlier time first, then the order the events were scheduled in
+#define EVENT_BEFORE(a, b) ((a).time < (b).time || ((a).time == (b).time && (a).sequence < (b).sequence))
+
+static int pushEvent(struct Simulation* sim, int time, int type, int index) {
+    struct SimEvent event;
+    int i;
+
+    if (sim->numEvents == SIM_MAX_EVENTS) {
+        return 0;
+    }
+    event.time = time;
+    event.sequence = sim->sequence++;
+    event.type = type;
+    event.index = index;
+
+    // Up from the new leaf until the parent is earlier
+    i = sim->numEvents++;
+    while (i > 0 && EVENT_BEFORE(event, sim->events[(i - 1) / 2])) {
+        sim->events[i] = sim->events[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    sim->events[i] = event;
+    return 1;
+}
+
+static struct SimEvent popEvent(struct Simulation* sim) {
+    struct SimEvent first = sim->events[0];
+    struct SimEvent last = sim->events[--sim->numEvents];
+    int i = 0, child;
+
+    // The last leaf goes down from the root until both children are later
+    while ((child = 2 * i + 1) < sim->numEvents) {
+        if (child + 1 < sim->numEvents && EVENT_BEFORE(sim->events[child + 1], sim->events[child])) {
+            child++;
+        }
+        if (!EVENT_BEFORE(sim->events[child], last)) {
+            break;
+        }
+        sim->events[i] = sim->events[child];
+        i = child;
+    }
+    sim->events[i] = last;
+    return first;
+}
+
+// Time to drive between two route points, diagonally as far as possible and then straight
+static int moveSeconds(const struct SimulationConfig* config, struct Point from, struct Point to) {
+    int rows = from.row > to.row ? from.row - to.row : to.row - from.row;
+    int cols = from.col > to.col ? from.col - to.col : to.col - from.col;
+    int diagonal = rows < cols ? rows : cols;
+
+    return diagonal * config->diagonalSeconds + (rows + cols - 2 * diagonal) * config->straightSeconds;
+}
+
+// True if indexRoute() split the truck's route into runs its cursor can follow
+static int hasRuns(const struct Truck* truck) {
+    return truck->routeIndexed && truck->numSegments > 0;
+}
+
+static int squaredDistance(struct Point a, struct Point b) {
+    return (a.row - b.row) * (a.row - b.row) + (a.col - b.col) * (a.col - b.col);
+}
+
+// The smallest box around a run
+static struct SimBox runBox(const struct RouteSegment* run) {
+    struct SimBox box;
+    int endRow = run->start.row + (run->length - 1) * run->rowStep;
+    int endCol = run->start.col + (run->length - 1) * run->colStep;
+
+    box.top = (signed char)(run->start.row < endRow ? run->start.row : endRow);
+    box.left = (signed char)(run->start.col < endCol ? run->start.col : endCol);
+    box.bottom = (signed char)(run->start.row + endRow - box.top);
+    box.right = (signed char)(run->start.col + endCol - box.left);
+    return box;
+}
+
+// The square of the distance from a point to a box, no more than to any point of the run inside it
+static int boxDistance(const struct SimBox* box, struct Point point) {
+    int rows = point.row < box->top ? box->top - point.row : (point.row > box->bottom ? point.row - box->bottom : 0);
+    int cols = point.col < box->left ? box->left - point.col : (point.col > box->right ? point.col - box->right : 0);
+
+    return rows * rows + cols * cols;
+}
+
+static void markTiles(struct Simulation* sim, int t, int top, int left, int bottom, int right) {
+    int reach = (int)MAX_DIVERSION;
+
+    top = top - reach < 0 ? 0 : (top - reach) / SIM_TILE;
+    left = left - reach < 0 ? 0 : (left - reach) / SIM_TILE;
+    bottom = (bottom + reach) / SIM_TILE < SIM_TILE_ROWS ? (bottom + reach) / SIM_TILE : SIM_TILE_ROWS - 1;
+    right = (right + reach) / SIM_TILE < SIM_TILE_COLS ? (right + reach) / SIM_TILE : SIM_TILE_COLS - 1;
+    for (int row = top; row <= bottom; row++) {
+        for (int col = left; col <= right; col++) {
+            sim->nearTile[row][col][t / 32] |= 1u << (t % 32);
+        }
+    }
+}
+
+// Mark the tiles within a diversion of the part of the truck's route still ahead
+static void markNearTiles(struct Simulation* sim, int t) {
+    const struct Truck* truck = &sim->trucks[t];
+
+    for (int row = 0; row < SIM_TILE_ROWS; row++) {
+        for (int col = 0; col < SIM_TILE_COLS; col++) {
+            sim->nearTile[row][col][t / 32] &= ~(1u << (t % 32));
+        }
+    }
+
+    for (int i = sim->next[t]; i < truck->route.numPoints; i++) {
+        struct Point p = truck->route.points[i];
+        markTiles(sim, t, p.row, p.col, p.row, p.col);
+    }
+}
+
+static void findNextDrop(struct Simulation* sim, int t) {
+    sim->nextDrop[t] = -1;
+    for (int slot = 0; slot < sim->trucks[t].numShipments; slot++) {
+        if (sim->dropAt[t][slot] >= 0 && (sim->nextDrop[t] < 0 || sim->dropAt[t][slot] < sim->nextDrop[t])) {
+            sim->nextDrop[t] = sim->dropAt[t][slot];
+        }
+    }
+}
+
+// Hand over everything the truck delivers from the point it has just reached, one diversion after another
+static void deliverAt(struct Simulation* sim, int t, int point) {
+    const struct Truck* truck = &sim->trucks[t];
+    struct Point here = truck->route.points[point];
+    int driven = 0;
+
+    for (int slot = 0; slot < truck->numShipments; slot++) {
+        if (sim->dropAt[t][slot] != point) {
+            continue;
+        }
+        int oneWay = (int)(distance(&here, &truck->cargo[slot].destination) * sim->config.straightSeconds + 0.5);
+        driven += oneWay;
+        sim->dropAt[t][slot] = -1;
+        sim->stats.delivered++;
+        if (sim->orderOf[t][slot] >= 0) {
+            struct SimOrder* order = &sim->orders[sim->orderOf[t][slot]];
+            order->deliveredTime = sim->now + driven;
+            sim->stats.waitSeconds += order->deliveredTime - order->orderTime;
+        }
+        driven += oneWay;
+    }
+    sim->detour[t] += driven;
+    findNextDrop(sim, t);
+}
+
+static void arrive(struct Simulation* sim, int t) {
+    const struct Truck* truck = &sim->trucks[t];
+    int point = sim->next[t];
+    struct Point reached;
+
+    if (sim->nextDrop[t] == point) {
+        deliverAt(sim, t, point);
+    }
+    sim->next[t]++;
+    if (hasRuns(truck)) {
+        nextSegmentPoint(&sim->cursors[t], &reached);
+    }
+
+    // The runs behind the truck no longer count, and a truck at the end of its route is off the map
+    if (sim->next[t] == truck->route.numPoints || (hasRuns(truck) && sim->cursors[t].step == 0)) {
+        markNearTiles(sim, t);
+    }
+    sim->stats.lastArrival = sim->now;
+
+    if (sim->next[t] < truck->route.numPoints) {
+        int time = sim->now + sim->detour[t] + moveSeconds(&sim->config, truck->route.points[point], truck->route.points[point + 1]);
+        sim->detour[t] = 0;
+        pushEvent(sim, time, SIM_EVENT_ARRIVE, t);
+    }
+}
+
+static void takeOrder(struct Simulation* sim, int o) {
+    struct SimOrder* order = &sim->orders[o];
+    struct DeliveryResult result = assignShipmentAhead(sim, &order->shipment, &order->leaveFrom);
+
+    if (!result.success) {
+        sim->stats.refused++;
+        return;
+    }
+
+    int t = result.truckIndex;
+    int slot = sim->trucks[t].numShipments - 1;
+    order->truck = t;
+    sim->dropAt[t][slot] = order->leaveFrom;
+    sim->orderOf[t][slot] = o;
+    if (sim->nextDrop[t] < 0 || order->leaveFrom < sim->nextDrop[t]) {
+        sim->nextDrop[t] = order->leaveFrom;
+    }
+    sim->stats.assigned++;
+}
+
+/*
+* Name: startSimulation
+* Description: Sets the fleet up at the start of its routes
+*/
+int startSimulation(struct Simulation* sim, struct Truck trucks[], int numTrucks, const struct SimulationConfig* config) {
+    if (sim == NULL || trucks == NULL || config == NULL || numTrucks < 0 || numTrucks > SIM_MAX_TRUCKS) {
+        return 0;
+    }
+
+    sim->config = *config;
+    sim->trucks = trucks;
+    sim->numTrucks = numTrucks;
+    sim->now = config->departTime;
+    sim->sequence = 0;
+    sim->numEvents = 0;
+    sim->numOrders = 0;
+    sim->stats.events = 0;
+    sim->stats.assigned = 0;
+    sim->stats.refused = 0;
+    sim->stats.delivered = 0;
+    sim->stats.waitSeconds = 0;
+    sim->stats.lastArrival = config->departTime;
+
+    for (int row = 0; row < SIM_TILE_ROWS; row++) {
+        for (int col = 0; col < SIM_TILE_COLS; col++) {
+            for (int w = 0; w < SIM_TRUCK_WORDS; w++) {
+                sim->nearTile[row][col][w] = 0;
+            }
+        }
+    }
+
+    for (int t = 0; t < numTrucks; t++) {
+        sim->next[t] = 0;
+        sim->detour[t] = 0;
+        startSegmentCursor(&sim->cursors[t], trucks[t].segments, trucks[t].numSegments);
+        for (int i = 0; i < trucks[t].numSegments; i++) {
+            sim->boxes[t][i] = runBox(&trucks[t].segments[i]);
+        }
+
+        // Cargo loaded before the day starts comes off where the route passes closest
+        for (int slot = 0; slot < trucks[t].numShipments; slot++) {
+            sim->dropAt[t][slot] = getClosestRoutePoint(&trucks[t], trucks[t].cargo[slot].destination);
+            sim->orderOf[t][slot] = -1;
+        }
+        findNextDrop(sim, t);
+        markNearTiles(sim, t);
+
+        if (trucks[t].route.numPoints > 0) {
+            pushEvent(sim, config->departTime + t * config->departInterval, SIM_EVENT_ARRIVE, t);
+        }
+    }
+    return 1;
+}
+
+/*
+* Name: scheduleOrder
+* Description: Schedules a shipment to come in at a time
+*/
+int scheduleOrder(struct Simulation* sim, int time, const struct Shipment* s) {
+    struct SimOrder* order;
+
+    if (sim == NULL || s == NULL || sim->numOrders == SIM_MAX_ORDERS) {
+        return -1;
+    }
+
+    order = &sim->orders[sim->numOrders];
+    order->shipment = *s;
+    order->orderTime = time < sim->now ? sim->now : time;
+    order->truck = -1;
+    order->leaveFrom = -1;
+    order->deliveredTime = -1;
+    if (!pushEvent(sim, order->orderTime, SIM_EVENT_ORDER, sim->numOrders)) {
+        return -1;
+    }
+    return sim->numOrders++;
+}
+
+/*
+* Name: runSimulation
+* Description: Handles events in time order up to a time
+*/
+long runSimulation(struct Simulation* sim, int until) {
+    long handled = 0;
+
+    if (sim == NULL) {
+        return 0;
+    }
+
+    while (sim->numEvents > 0 && sim->events[0].time <= until) {
+        struct SimEvent event = popEvent(sim);
+
+        sim->now = event.time;
+        if (event.type == SIM_EVENT_ARRIVE) {
+            arrive(sim, event.index);
+        }
+        else {
+            takeOrder(sim, event.index);
+        }
+        handled++;
+    }
+    if (sim->now < until && sim->numEvents > 0) {
+        sim->now = until;
+    }
+    sim->stats.events += handled;
+    return handled;
+}
+
+// The closest route point still ahead whose squared distance is at most limit, or -1 if there is none
+static int closestAheadWithin(const struct Simulation* sim, int t, struct Point point, int limit) {
+    const struct Truck* truck = &sim->trucks[t];
+    int next = sim->next[t];
+    int closest = -1, closestDist = limit;
+
+    if (next >= truck->route.numPoints) {
+        return -1;
+    }
+
+    // Without runs, scan the points that are left
+    if (!hasRuns(truck)) {
+        closest = next + getClosestPointIn(&truck->route.points[next], truck->route.numPoints - next, point);
+        return squaredDistance(truck->route.points[closest], point) <= limit ? closest : -1;
+    }
+
+    // The run the truck is on, cut down to the part still ahead, then the later runs. A later run
+    // only wins with a point strictly closer, so a run whose box is no closer is skipped.
+    const struct SegmentCursor* cursor = &sim->cursors[t];
+    struct RouteSegment current = truck->segments[cursor->segment];
+    current.start.row = (char)(current.start.row + cursor->step * current.rowStep);
+    current.start.col = (char)(current.start.col + cursor->step * current.colStep);
+    current.length -= cursor->step;
+
+    struct SimBox currentBox = runBox(&current);
+    int first = next;
+    for (int i = cursor->segment; i < truck->numSegments; i++) {
+        const struct RouteSegment* run = (i == cursor->segment) ? &current : &truck->segments[i];
+        const struct SimBox* box = (i == cursor->segment) ? &currentBox : &sim->boxes[t][i];
+        if (boxDistance(box, point) <= closestDist) {
+            int k = first + getClosestPointOnSegments(run, 1, point);
+            int dist = squaredDistance(truck->route.points[k], point);
+            if (dist < closestDist || (closest < 0 && dist == closestDist)) {
+                closestDist = dist;
+                closest = k;
+            }
+        }
+        first += run->length;
+    }
+    return closest;
+}
+
+/*
+* Name: closestPointAhead
+* Description: Finds the closest route point the truck has still to reach
+*/
+int closestPointAhead(const struct Simulation* sim, int truckIndex, const struct Point point) {
+    if (sim == NULL || truckIndex < 0 || truckIndex >= sim->numTrucks) {
+        return -1;
+    }
+    return closestAheadWithin(sim, truckIndex, point, INT_MAX);
+}
+
+/*
+* Name: assignShipmentAhead
+* Description: Places a shipment measuring diversions from the route points still ahead
+*/
+struct DeliveryResult assignShipmentAhead(struct Simulation* sim, const struct Shipment* s, int* leaveFrom) {
+    struct DeliveryResult result = { 0, -1, 0, 0.0 };
+    struct AssignCandidate best = { -1, 0, 0.0, 0, 0, 0, 0 };
+    int bestLeave = -1;
+
+    if (leaveFrom != NULL) {
+        *leaveFrom = -1;
+    }
+    if (sim == NULL || s == NULL) {
+        return result;
+    }
+
+    // Only the trucks that pass near the destination's tile, lowest index first
+    if (s->destination.row < 0 || s->destination.row >= MAP_ROWS || s->destination.col < 0 || s->destination.col >= MAP_COLS) {
+        return result;
+    }
+    const unsigned int* near = sim->nearTile[s->destination.row / SIM_TILE][s->destination.col / SIM_TILE];
+
+    // Trucks still to drive through the destination first, found with the route bitmap. Only if none
+    // of them can take it are the others measured, and once a truck is found, one further off cannot
+    // beat it, so later trucks only look that far.
+    for (int pass = 0; pass < 2 && best.index < 0; pass++) {
+        int limit = pass == 0 ? 0 : (int)(MAX_DIVERSION * MAX_DIVERSION);
+
+        for (int w = 0; w < SIM_TRUCK_WORDS && w * 32 < sim->numTrucks; w++) {
+            for (int bit = 0; bit < 32 && (near[w] >> bit) != 0; bit++) {
+                int t = w * 32 + bit;
+                const struct Truck* truck = &sim->trucks[t];
+                struct AssignCandidate candidate;
+                int leave;
+
+                // Capacity before the distance, it is much cheaper
+                if (!((near[w] >> bit) & 1u) || (pass == 0 && !isOnRoute(truck, s->destination)) || !canFitShipment(truck, s)) {
+                    continue;
+                }
+                leave = closestAheadWithin(sim, t, s->destination, limit);
+                if (leave < 0) {
+                    continue;
+                }
+
+                candidate.index = t;
+                candidate.truckNumber = truck->truckNumber;
+                candidate.diversion = distance(&truck->route.points[leave], &s->destination);
+                candidate.capacityLeft = capacityLeftShare(truck);
+                if (best.index < 0 || BETTER_MIN_DIVERSION(candidate, best)) {
+                    best = candidate;
+                    bestLeave = leave;
+                    limit = squaredDistance(truck->route.points[leave], s->destination);
+                }
+            }
+        }
+    }
+
+    if (best.index < 0) {
+        return result;
+    }
+
+    result.truckIndex = best.index;
+    result.distanceToGo = best.diversion;
+    result.needsDiversion = (best.diversion > 0.01) ? 1 : 0;  // small epsilon for floating point
+    if (addShipmentToTruck(&sim->trucks[best.index], s)) {
+        result.success = 1;
+        if (leaveFrom != NULL) {
+            *leaveFrom = bestLeave;
+        }
+    }
+    return result;
+}
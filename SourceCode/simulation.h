@@ -0,0 +1,167 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "delivery.h"
+#include "mapping.h"
+#include "segments.h"
+
+#ifndef SIM_MAX_TRUCKS
+#define SIM_MAX_TRUCKS 1024
+#endif
+#ifndef SIM_MAX_ORDERS
+#define SIM_MAX_ORDERS 32768
+#endif
+#define SIM_MAX_EVENTS (SIM_MAX_ORDERS + SIM_MAX_TRUCKS)   // one pending arrival per truck and one per order
+#define SIM_TRUCK_WORDS ((SIM_MAX_TRUCKS + 31) / 32)
+
+// The map is split into square tiles of SIM_TILE squares a side to look up which trucks pass near a square
+#define SIM_TILE 8
+#define SIM_TILE_ROWS ((MAP_ROWS + SIM_TILE - 1) / SIM_TILE)
+#define SIM_TILE_COLS ((MAP_COLS + SIM_TILE - 1) / SIM_TILE)
+
+#define SIM_EVENT_ARRIVE 0      // a truck reaches its next route point
+#define SIM_EVENT_ORDER 1       // a shipment comes in and is assigned
+
+/**
+ * How long the trucks take and when they set off. Times are in seconds from midnight.
+ */
+struct SimulationConfig {
+    int departTime;         // when the first truck reaches the first point of its route
+    int departInterval;     // each truck after the first sets off this much later than the one before
+    int straightSeconds;    // one move along a row or column
+    int diagonalSeconds;    // one diagonal move
+};
+
+/**
+ * Something that happens at a time. Events at the same time happen in the order they were scheduled.
+ */
+struct SimEvent {
+    int time;
+    unsigned int sequence;  // order the event was scheduled in
+    int type;               // SIM_EVENT_ARRIVE or SIM_EVENT_ORDER
+    int index;              // the truck for an arrival, the order for an order
+};
+
+/**
+ * A shipment given to the simulation and what became of it
+ */
+struct SimOrder {
+    struct Shipment shipment;
+    int orderTime;          // when it came in
+    int truck;              // the truck it was loaded on, -1 if none could take it or not yet assigned
+    int leaveFrom;          // the route point the truck delivers it from
+    int deliveredTime;      // when it was delivered, -1 until then
+};
+
+/**
+ * Totals kept while the simulation runs
+ */
+struct SimulationStats {
+    long events;            // events handled
+    int assigned;           // orders loaded on a truck
+    int refused;            // orders no truck still on the road could take
+    int delivered;          // orders delivered, including any already on the trucks at the start
+    long long waitSeconds;  // sum of the time from order to delivery of the delivered orders
+    int lastArrival;        // time of the last route point reached
+};
+
+/**
+ * The rows and columns one run of a route spans
+ */
+struct SimBox {
+    signed char top;
+    signed char left;
+    signed char bottom;
+    signed char right;
+};
+
+/**
+ * A fleet driving its routes. Truck t has reached every route point before next[t], and
+ * cursors[t] points at route point next[t] when the truck's route has been split into runs.
+ */
+struct Simulation {
+    struct SimulationConfig config;
+    struct Truck* trucks;
+    int numTrucks;
+    int now;
+    unsigned int sequence;
+    int numEvents;
+    struct SimEvent events[SIM_MAX_EVENTS];     // binary heap, earliest first
+    int numOrders;
+    struct SimOrder orders[SIM_MAX_ORDERS];
+    int next[SIM_MAX_TRUCKS];
+    struct SegmentCursor cursors[SIM_MAX_TRUCKS];
+    struct SimBox boxes[SIM_MAX_TRUCKS][MAX_ROUTE_SEGMENTS];   // around each run of each truck's route
+    int detour[SIM_MAX_TRUCKS];                 // seconds of diversions to drive before the next point
+    int nextDrop[SIM_MAX_TRUCKS];               // lowest leaveFrom of the truck's undelivered cargo, -1 if none
+    int dropAt[SIM_MAX_TRUCKS][MAX_SHIPMENTS];  // leaveFrom of each cargo slot, -1 once delivered
+    int orderOf[SIM_MAX_TRUCKS][MAX_SHIPMENTS]; // the order in each cargo slot, -1 if loaded before the start
+    unsigned int nearTile[SIM_TILE_ROWS][SIM_TILE_COLS][SIM_TRUCK_WORDS];   // bit t is set if truck t's route passes
+                                                                            // close enough to take a shipment in the tile
+    struct SimulationStats stats;
+};
+
+/*
+* Name: startSimulation
+* Description: Sets a fleet up at the start of its routes and schedules each truck's first arrival.
+*              Cargo already on the trucks is delivered from the closest point of the route.
+* Parameters:
+*   - sim: the simulation to set up
+*   - trucks: array of truck structures, routes indexed; the simulation loads them as it runs
+*   - numTrucks: number of trucks, at most SIM_MAX_TRUCKS
+*   - config: how long moves take and when the trucks set off
+* Returns: 1 if the simulation was set up, 0 if an argument was out of range
+*/
+int startSimulation(struct Simulation* sim, struct Truck trucks[], int numTrucks, const struct SimulationConfig* config);
+
+/*
+* Name: scheduleOrder
+* Description: Schedules a shipment to come in at a time. It is assigned when the simulation
+*              reaches that time, to a truck still to pass close enough to its destination.
+* Parameters:
+*   - sim: a started simulation
+*   - time: when the order comes in, no earlier than the simulation's current time
+*   - s: pointer to the shipment
+* Returns: The order's number, or -1 if the simulation has no room for another order
+*/
+int scheduleOrder(struct Simulation* sim, int time, const struct Shipment* s);
+
+/*
+* Name: runSimulation
+* Description: Handles events in time order until the next one is after a time or none are left
+* Parameters:
+*   - sim: a started simulation
+*   - until: the last time to handle events at
+* Returns: The number of events handled
+*/
+long runSimulation(struct Simulation* sim, int until);
+
+/*
+* Name: closestPointAhead
+* Description: Finds the route point closest to a point among those the truck has still to reach,
+*              a run at a time when the truck's route was split into runs
+* Parameters:
+*   - sim: a started simulation
+*   - truckIndex: position of the truck in the simulation's array
+*   - point: the point to measure from
+* Returns: The index of the closest point still ahead, the first of equally close ones, or -1 if
+*          the truck has reached the end of its route
+*/
+int closestPointAhead(const struct Simulation* sim, int truckIndex, const struct Point point);
+
+/*
+* Name: assignShipmentAhead
+* Description: Places a shipment by the assignShipment() rules, shortest diversion, then most
+*              capacity left, then lowest truck number, measuring the diversion from the route
+*              points each truck has still to reach. A truck that has passed the destination or
+*              finished its route does not count as being on it. The diversion is the straight
+*              line distance and must be at most 10.
+* Parameters:
+*   - sim: a started simulation
+*   - s: pointer to the shipment
+*   - leaveFrom: set to the route point the chosen truck leaves from, may be NULL
+* Returns: The delivery result, as assignShipment() gives it
+*/
+struct DeliveryResult assignShipmentAhead(struct Simulation* sim, const struct Shipment* s, int* leaveFrom);
+
+#endif
@@ -0,0 +1,257 @@
+/*
+* Purpose: The map, indexes and fleet load saved to one file that a restart maps instead of rebuilding
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "MS3FunctionSpecs.h"
+
+#define SNAPSHOT_PATH_SIZE 1024
+
+// The part of the image the header's checksum covers: the map and everything built from it
+#define STATIC_FIRST offsetof(struct SnapshotImage, map)
+#define STATIC_SIZE (offsetof(struct SnapshotImage, loads) - offsetof(struct SnapshotImage, map))
+
+#define CHECKSUM_START 0xcbf29ce484222325ULL
+
+// 64 bit FNV-1a a word at a time, folding the high bits down after each word, then any bytes left over
+static unsigned long long checksumMore(unsigned long long hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    unsigned long long word;
+    size_t i = 0;
+
+    for (; i + sizeof(word) <= size; i += sizeof(word)) {
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static unsigned long long checksum(const void* data, size_t size) {
+    return checksumMore(CHECKSUM_START, data, size);
+}
+
+// The map and each route field by field, so padding and points past the end of a route do not count
+static unsigned long long sourceChecksum(const struct Map* map, const struct Truck trucks[], int numTrucks) {
+    unsigned long long hash = checksum(map, sizeof(*map));
+
+    hash = checksumMore(hash, &numTrucks, sizeof(numTrucks));
+    for (int i = 0; i < numTrucks; i++) {
+        const struct Route* route = &trucks[i].route;
+        int numPoints = route->numPoints < 0 ? 0 : (route->numPoints < MAX_ROUTE ? route->numPoints : MAX_ROUTE);
+
+        hash = checksumMore(hash, &route->numPoints, sizeof(route->numPoints));
+        hash = checksumMore(hash, &route->routeSymbol, sizeof(route->routeSymbol));
+        hash = checksumMore(hash, route->points, (size_t)numPoints * sizeof(struct Point));
+    }
+    return hash;
+}
+
+// The bytes of a load that are written and checked: everything up to the last truck in use
+static size_t loadSize(int numTrucks) {
+    return offsetof(struct SnapshotLoad, trucks) + (size_t)numTrucks * sizeof(struct Truck);
+}
+
+static unsigned long long loadChecksum(const struct SnapshotLoad* load) {
+    return checksum(&load->numTrucks, loadSize(load->numTrucks) - offsetof(struct SnapshotLoad, numTrucks));
+}
+
+static void fillLoad(struct SnapshotLoad* load, const struct Truck trucks[], int numTrucks, unsigned long long sequence) {
+    load->sequence = sequence;
+    load->numTrucks = numTrucks;
+    load->padding = 0;
+    for (int i = 0; i < numTrucks; i++) {
+        load->trucks[i] = trucks[i];
+    }
+    load->checksum = loadChecksum(load);
+}
+
+static int loadIsWhole(const struct SnapshotLoad* load) {
+    return load->sequence != 0 && load->numTrucks >= 0 && load->numTrucks <= MAX_FLEET && load->checksum == loadChecksum(load);
+}
+
+/*
+* Name: snapshotCreate
+* Description: Builds the indexes startup uses for a map and fleet and writes a new snapshot file
+*/
+int snapshotCreate(const char* path, const struct Map* map, const struct Truck trucks[], int numTrucks) {
+    struct SnapshotImage* image;
+    char temporary[SNAPSHOT_PATH_SIZE];
+    FILE* output;
+    int written;
+
+    if (path == NULL || map == NULL || trucks == NULL || numTrucks < 0 || numTrucks > MAX_FLEET) {
+        return 0;
+    }
+
+    // A file that is there but cannot be written, such as a read-only one, is not replaced
+    output = fopen(path, "rb");
+    if (output != NULL) {
+        fclose(output);
+        output = fopen(path, "r+b");
+        if (output == NULL) {
+            return 0;
+        }
+        fclose(output);
+    }
+    if (snprintf(temporary, sizeof(temporary), "%s.tmp", path) >= (int)sizeof(temporary)) {
+        return 0;
+    }
+
+    // Zeroed, so the padding inside the structures is the same in every file
+    image = (struct SnapshotImage*)calloc(1, sizeof(struct SnapshotImage));
+    if (image == NULL) {
+        return 0;
+    }
+    image->header.magic = SNAPSHOT_MAGIC;
+    image->header.version = SNAPSHOT_VERSION;
+    image->header.mapRows = MAP_ROWS;
+    image->header.mapCols = MAP_COLS;
+    image->header.maxRoute = MAX_ROUTE;
+    image->header.maxFleet = MAX_FLEET;
+    image->header.imageSize = sizeof(struct SnapshotImage);
+    image->map = *map;
+    buildMoveTable(&image->moves, map);
+    buildFleetIndex(&image->fleet, trucks, numTrucks);
+    image->header.checksum = checksum((const char*)image + STATIC_FIRST, STATIC_SIZE);
+    image->header.sourceChecksum = sourceChecksum(map, trucks, numTrucks);
+    fillLoad(&image->loads[0], trucks, numTrucks, 1);
+
+    output = fopen(temporary, "wb");
+    written = output != NULL && fwrite(image, sizeof(struct SnapshotImage), 1, output) == 1 && syncFile(output);
+    if (output != NULL && fclose(output) != 0) {
+        written = 0;
+    }
+    free(image);
+
+    if (!written || !replaceFile(temporary, path)) {
+        remove(temporary);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+* Name: snapshotOpen
+* Description: Maps a snapshot file and checks its header, checksums and loads
+*/
+int snapshotOpen(struct Snapshot* snapshot, const char* path, const struct Map* map, const struct Truck trucks[], int numTrucks) {
+    const struct SnapshotHeader* header;
+
+    if (snapshot == NULL || path == NULL || map == NULL || trucks == NULL || numTrucks < 0 || numTrucks > MAX_FLEET) {
+        return 0;
+    }
+    snapshot->image = NULL;
+    snapshot->load = NULL;
+    snapshot->output = NULL;
+    if (!mapFile(&snapshot->file, path)) {
+        return 0;
+    }
+
+    // Written by this build from this map and these routes, complete, and the map and indexes undamaged
+    header = (const struct SnapshotHeader*)snapshot->file.view;
+    if (snapshot->file.size != sizeof(struct SnapshotImage)
+        || header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION
+        || header->mapRows != MAP_ROWS || header->mapCols != MAP_COLS
+        || header->maxRoute != MAX_ROUTE || header->maxFleet != MAX_FLEET
+        || header->imageSize != sizeof(struct SnapshotImage)
+        || header->sourceChecksum != sourceChecksum(map, trucks, numTrucks)
+        || header->checksum != checksum((const char*)snapshot->file.view + STATIC_FIRST, STATIC_SIZE)) {
+        unmapFile(&snapshot->file);
+        return 0;
+    }
+    snapshot->image = (struct SnapshotImage*)snapshot->file.view;
+
+    // The newest load that was written out in full
+    for (int slot = 0; slot < 2; slot++) {
+        const struct SnapshotLoad* load = &snapshot->image->loads[slot];
+        if (loadIsWhole(load) && (snapshot->load == NULL || load->sequence > snapshot->load->sequence)) {
+            snapshot->load = load;
+        }
+    }
+    if (snapshot->load == NULL) {
+        unmapFile(&snapshot->file);
+        snapshot->image = NULL;
+        return 0;
+    }
+
+    // Loads are saved through a separate handle; the mapped view is never written back. A file that
+    // cannot be written would lose every load saved from here on, so it is not used at all.
+    snapshot->output = fopen(path, "r+b");
+    if (snapshot->output == NULL) {
+        unmapFile(&snapshot->file);
+        snapshot->image = NULL;
+        snapshot->load = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+/*
+* Name: snapshotLoadFleet
+* Description: Copies the newest saved load out of a snapshot
+*/
+int snapshotLoadFleet(const struct Snapshot* snapshot, struct Truck trucks[], int maxTrucks) {
+    int n;
+
+    if (snapshot == NULL || snapshot->load == NULL || trucks == NULL) {
+        return 0;
+    }
+    n = snapshot->load->numTrucks < maxTrucks ? snapshot->load->numTrucks : maxTrucks;
+    for (int i = 0; i < n; i++) {
+        trucks[i] = snapshot->load->trucks[i];
+    }
+    return n;
+}
+
+/*
+* Name: snapshotSaveFleet
+* Description: Writes the fleet's load over the older saved load
+*/
+int snapshotSaveFleet(struct Snapshot* snapshot, const struct Truck trucks[], int numTrucks) {
+    struct SnapshotLoad* load;
+    int slot;
+
+    if (snapshot == NULL || snapshot->load == NULL || snapshot->output == NULL || trucks == NULL
+        || numTrucks < 0 || numTrucks > MAX_FLEET) {
+        return 0;
+    }
+
+    // Built in the private view, so the image keeps matching what was last saved
+    slot = (snapshot->load == &snapshot->image->loads[0]) ? 1 : 0;
+    load = &snapshot->image->loads[slot];
+    fillLoad(load, trucks, numTrucks, snapshot->load->sequence + 1);
+
+    if (fseek(snapshot->output, (long)offsetof(struct SnapshotImage, loads) + slot * (long)sizeof(struct SnapshotLoad), SEEK_SET) != 0
+        || fwrite(load, loadSize(numTrucks), 1, snapshot->output) != 1
+        || !syncFile(snapshot->output)) {
+        return 0;
+    }
+    snapshot->load = load;
+    return 1;
+}
+
+/*
+* Name: snapshotClose
+* Description: Closes the save handle and unmaps the file
+*/
+void snapshotClose(struct Snapshot* snapshot) {
+    if (snapshot == NULL) {
+        return;
+    }
+    if (snapshot->output != NULL) {
+        fclose(snapshot->output);
+        snapshot->output = NULL;
+    }
+    unmapFile(&snapshot->file);
+    snapshot->image = NULL;
+    snapshot->load = NULL;
+}
@@ -0,0 +1,126 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "delivery.h"
+#include "mapping.h"
+#include "pathing.h"
+#include "platform.h"
+
+#define SNAPSHOT_MAGIC 0x50414e53u     // "SNAP" when read from the start of the file
+#define SNAPSHOT_VERSION 4
+
+/**
+ * The start of a snapshot file: what wrote it, what it was made from and a checksum of the map and
+ * indexes behind it. A file written by a build with different map sizes or limits, or made from a
+ * different map or routes, is refused rather than misread.
+ */
+struct SnapshotHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int mapRows;               // MAP_ROWS of the build that wrote it
+    unsigned int mapCols;               // MAP_COLS
+    unsigned int maxRoute;              // MAX_ROUTE
+    unsigned int maxFleet;              // MAX_FLEET
+    unsigned long long imageSize;       // sizeof(struct SnapshotImage)
+    unsigned long long checksum;        // of everything from the map to the fleet index
+    unsigned long long sourceChecksum;  // of the map and routes the snapshot was made from
+};
+
+/**
+ * One saved load of the fleet. There are two, written in turn, so a crash while one is being written
+ * leaves the other one whole.
+ */
+struct SnapshotLoad {
+    unsigned long long sequence;        // higher is newer, 0 if never written
+    unsigned long long checksum;        // of numTrucks and the first numTrucks trucks
+    int numTrucks;
+    int padding;
+    struct Truck trucks[MAX_FLEET];
+};
+
+/**
+ * Everything startup works out, laid out exactly as it is in the file. None of it holds pointers,
+ * so the file can be mapped and used where it lies.
+ */
+struct SnapshotImage {
+    struct SnapshotHeader header;
+    struct Map map;
+    struct MoveTable moves;
+    struct FleetIndex fleet;            // built from the routes, which do not change during a day
+    struct SnapshotLoad loads[2];
+};
+
+/**
+ * A snapshot file opened with snapshotOpen()
+ */
+struct Snapshot {
+    struct MappedFile file;
+    struct SnapshotImage* image;        // the mapped file, copy on write
+    const struct SnapshotLoad* load;    // the newest whole load
+    FILE* output;                       // open for saving loads
+};
+
+/*
+* Name: snapshotCreate
+* Description: Works out the move table and fleet index for a map and fleet and writes them with
+*              the map and the fleet's load to a new snapshot file. The file is written beside
+*              path, synced to the disk and renamed over it, so an older snapshot stays whole until
+*              the new one is complete. A file already at path that cannot be written is left as it is.
+* Parameters:
+*   - path: the snapshot file
+*   - map: pointer to the map
+*   - trucks: array of truck structures, routes indexed
+*   - numTrucks: number of trucks, at most MAX_FLEET
+* Returns: 1 if the snapshot was written, 0 otherwise
+*/
+int snapshotCreate(const char* path, const struct Map* map, const struct Truck trucks[], int numTrucks);
+
+/*
+* Name: snapshotOpen
+* Description: Maps a snapshot file and checks it was written by this build from the map and routes
+*              given, and is undamaged. Nothing is rebuilt: the map and indexes are used from the
+*              mapped file.
+* Parameters:
+*   - snapshot: filled in with the open snapshot
+*   - path: the snapshot file
+*   - map: pointer to the map the snapshot must have been made from
+*   - trucks: array of truck structures whose routes the snapshot must have been made from
+*   - numTrucks: number of trucks
+* Returns: 1 if the snapshot can be used, 0 if it is missing, from another build, made from another
+*          map or routes, damaged, or cannot be written to save loads
+*/
+int snapshotOpen(struct Snapshot* snapshot, const char* path, const struct Map* map, const struct Truck trucks[], int numTrucks);
+
+/*
+* Name: snapshotLoadFleet
+* Description: Copies the newest saved load of the fleet out of a snapshot
+* Parameters:
+*   - snapshot: an open snapshot
+*   - trucks: where to copy the trucks
+*   - maxTrucks: room in trucks
+* Returns: The number of trucks copied
+*/
+int snapshotLoadFleet(const struct Snapshot* snapshot, struct Truck trucks[], int maxTrucks);
+
+/*
+* Name: snapshotSaveFleet
+* Description: Writes the fleet's current load over the older of the two saved loads and waits until
+*              it is on the disk, so the next start can carry on from here after a crash
+* Parameters:
+*   - snapshot: an open snapshot
+*   - trucks: array of truck structures, the same routes the snapshot was made with
+*   - numTrucks: number of trucks, at most MAX_FLEET
+* Returns: 1 if the load was written, 0 otherwise
+*/
+int snapshotSaveFleet(struct Snapshot* snapshot, const struct Truck trucks[], int numTrucks);
+
+/*
+* Name: snapshotClose
+* Description: Unmaps a snapshot. Nothing from its image may be used afterwards.
+* Parameters:
+*   - snapshot: an open snapshot
+* Returns: Nothing
+*/
+void snapshotClose(struct Snapshot* snapshot);
+
+#endif
@@ -0,0 +1,282 @@
+/*
+* Purpose: A small work-stealing thread pool for running numbered tasks in parallel
+*/
+
+#include <stdlib.h>
+#include "workpool.h"
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef HANDLE Thread;
+typedef CRITICAL_SECTION Lock;
+typedef CONDITION_VARIABLE Signal;
+
+static long long atomicLoad64(volatile long long* p) { return InterlockedCompareExchange64(p, 0, 0); }
+static int atomicSwap64(volatile long long* p, long long expected, long long value) { return InterlockedCompareExchange64(p, value, expected) == expected; }
+static void atomicStore64(volatile long long* p, long long value) { InterlockedExchange64(p, value); }
+static long atomicDecrement(volatile long* p) { return InterlockedDecrement(p); }
+static long atomicLoad(volatile long* p) { return InterlockedCompareExchange(p, 0, 0); }
+static void atomicStore(volatile long* p, long value) { InterlockedExchange(p, value); }
+
+static void lockInit(Lock* lock) { InitializeCriticalSection(lock); }
+static void lockFree(Lock* lock) { DeleteCriticalSection(lock); }
+static void lockTake(Lock* lock) { EnterCriticalSection(lock); }
+static void lockGive(Lock* lock) { LeaveCriticalSection(lock); }
+static void signalInit(Signal* signal) { InitializeConditionVariable(signal); }
+static void signalFree(Signal* signal) { (void)signal; }
+static void signalWait(Signal* signal, Lock* lock) { SleepConditionVariableCS(signal, lock, INFINITE); }
+static void signalAll(Signal* signal) { WakeAllConditionVariable(signal); }
+
+#else
+
+#include <pthread.h>
+
+typedef pthread_t Thread;
+typedef pthread_mutex_t Lock;
+typedef pthread_cond_t Signal;
+
+static long long atomicLoad64(volatile long long* p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+static int atomicSwap64(volatile long long* p, long long expected, long long value) {
+    return __atomic_compare_exchange_n(p, &expected, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+static void atomicStore64(volatile long long* p, long long value) { __atomic_store_n(p, value, __ATOMIC_SEQ_CST); }
+static long atomicDecrement(volatile long* p) { return __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST); }
+static long atomicLoad(volatile long* p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+static void atomicStore(volatile long* p, long value) { __atomic_store_n(p, value, __ATOMIC_SEQ_CST); }
+
+static void lockInit(Lock* lock) { pthread_mutex_init(lock, NULL); }
+static void lockFree(Lock* lock) { pthread_mutex_destroy(lock); }
+static void lockTake(Lock* lock) { pthread_mutex_lock(lock); }
+static void lockGive(Lock* lock) { pthread_mutex_unlock(lock); }
+static void signalInit(Signal* signal) { pthread_cond_init(signal, NULL); }
+static void signalFree(Signal* signal) { pthread_cond_destroy(signal); }
+static void signalWait(Signal* signal, Lock* lock) { pthread_cond_wait(signal, lock); }
+static void signalAll(Signal* signal) { pthread_cond_broadcast(signal); }
+
+#endif
+
+struct Worker {
+    struct WorkPool* pool;
+    int id;
+};
+
+struct Platform {
+    Thread threads[MAX_POOL_THREADS];
+    struct Worker workers[MAX_POOL_THREADS];
+    Lock lock;
+    Signal wake;    // a new job or stopping
+    Signal done;    // the last task of a job finished
+};
+
+static long long packRange(int top, int bottom) {
+    return ((long long)top << 32) | (unsigned int)bottom;
+}
+
+// The owner works back from the bottom of its own queue
+static int takeOwn(struct WorkQueue* queue) {
+    for (;;) {
+        long long range = atomicLoad64(&queue->range);
+        int top = (int)(range >> 32), bottom = (int)(range & 0xFFFFFFFF);
+        if (top >= bottom) {
+            return -1;
+        }
+        if (atomicSwap64(&queue->range, range, packRange(top, bottom - 1))) {
+            return bottom - 1;
+        }
+    }
+}
+
+// Other threads take from the top, away from the owner
+static int steal(struct WorkQueue* queue) {
+    for (;;) {
+        long long range = atomicLoad64(&queue->range);
+        int top = (int)(range >> 32), bottom = (int)(range & 0xFFFFFFFF);
+        if (top >= bottom) {
+            return -1;
+        }
+        if (atomicSwap64(&queue->range, range, packRange(top + 1, bottom))) {
+            return top;
+        }
+    }
+}
+
+// Run tasks until every queue is empty, starting with this thread's own
+static void work(struct WorkPool* pool, int self) {
+    struct Platform* platform = (struct Platform*)pool->platform;
+    int numQueues = pool->numThreads + 1;
+
+    for (;;) {
+        int task = takeOwn(&pool->queues[self]);
+        for (int k = 1; task < 0 && k < numQueues; k++) {
+            task = steal(&pool->queues[(self + k) % numQueues]);
+        }
+        if (task < 0) {
+            return;
+        }
+
+        pool->function(pool->context, task);
+        if (atomicDecrement(&pool->remaining) == 0) {
+            lockTake(&platform->lock);
+            signalAll(&platform->done);
+            lockGive(&platform->lock);
+        }
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI workerMain(LPVOID argument)
+#else
+static void* workerMain(void* argument)
+#endif
+{
+    struct Worker* worker = (struct Worker*)argument;
+    struct WorkPool* pool = worker->pool;
+    struct Platform* platform = (struct Platform*)pool->platform;
+
+    lockTake(&platform->lock);
+    long seen = atomicLoad(&pool->generation);
+    for (;;) {
+        while (!atomicLoad(&pool->stopping) && atomicLoad(&pool->generation) == seen) {
+            signalWait(&platform->wake, &platform->lock);
+        }
+        if (atomicLoad(&pool->stopping)) {
+            break;
+        }
+        seen = atomicLoad(&pool->generation);
+        lockGive(&platform->lock);
+        work(pool, worker->id);
+        lockTake(&platform->lock);
+    }
+    lockGive(&platform->lock);
+    return 0;
+}
+
+/*
+* Name: poolStart
+* Description: Starts the worker threads
+*/
+int poolStart(struct WorkPool* pool, int numThreads) {
+    if (pool == NULL) {
+        return 0;
+    }
+
+    pool->numThreads = 0;
+    pool->function = NULL;
+    pool->context = NULL;
+    pool->remaining = 0;
+    pool->generation = 0;
+    pool->stopping = 0;
+    for (int q = 0; q <= MAX_POOL_THREADS; q++) {
+        pool->queues[q].range = 0;
+    }
+
+    struct Platform* platform = (struct Platform*)malloc(sizeof(struct Platform));
+    pool->platform = platform;
+    if (platform == NULL) {
+        return 0;
+    }
+    lockInit(&platform->lock);
+    signalInit(&platform->wake);
+    signalInit(&platform->done);
+
+    if (numThreads > MAX_POOL_THREADS) {
+        numThreads = MAX_POOL_THREADS;
+    }
+    for (int i = 0; i < numThreads; i++) {
+        platform->workers[i].pool = pool;
+        platform->workers[i].id = i;
+#if defined(_WIN32)
+        platform->threads[i] = CreateThread(NULL, 0, workerMain, &platform->workers[i], 0, NULL);
+        if (platform->threads[i] == NULL) {
+            break;
+        }
+#else
+        if (pthread_create(&platform->threads[i], NULL, workerMain, &platform->workers[i]) != 0) {
+            break;
+        }
+#endif
+        pool->numThreads++;
+    }
+
+    if (pool->numThreads < numThreads) {
+        poolStop(pool);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+* Name: poolRun
+* Description: Runs every task and waits for them to finish
+*/
+void poolRun(struct WorkPool* pool, WorkFunction function, void* context, int numTasks) {
+    if (pool == NULL || function == NULL || numTasks <= 0) {
+        return;
+    }
+
+    struct Platform* platform = (struct Platform*)pool->platform;
+    if (platform == NULL || pool->numThreads == 0) {
+        for (int task = 0; task < numTasks; task++) {
+            function(context, task);
+        }
+        return;
+    }
+
+    // One block of tasks per thread; the caller takes the last block
+    int numQueues = pool->numThreads + 1;
+    pool->function = function;
+    pool->context = context;
+    atomicStore(&pool->remaining, numTasks);
+    for (int q = 0; q < numQueues; q++) {
+        atomicStore64(&pool->queues[q].range, packRange(
+            (int)((long long)numTasks * q / numQueues), (int)((long long)numTasks * (q + 1) / numQueues)));
+    }
+
+    lockTake(&platform->lock);
+    atomicStore(&pool->generation, pool->generation + 1);
+    signalAll(&platform->wake);
+    lockGive(&platform->lock);
+
+    work(pool, pool->numThreads);
+
+    lockTake(&platform->lock);
+    while (atomicLoad(&pool->remaining) > 0) {
+        signalWait(&platform->done, &platform->lock);
+    }
+    lockGive(&platform->lock);
+}
+
+/*
+* Name: poolStop
+* Description: Stops and joins the worker threads
+*/
+void poolStop(struct WorkPool* pool) {
+    if (pool == NULL || pool->platform == NULL) {
+        return;
+    }
+
+    struct Platform* platform = (struct Platform*)pool->platform;
+    lockTake(&platform->lock);
+    atomicStore(&pool->stopping, 1);
+    signalAll(&platform->wake);
+    lockGive(&platform->lock);
+
+    for (int i = 0; i < pool->numThreads; i++) {
+#if defined(_WIN32)
+        WaitForSingleObject(platform->threads[i], INFINITE);
+        CloseHandle(platform->threads[i]);
+#else
+        pthread_join(platform->threads[i], NULL);
+#endif
+    }
+
+    signalFree(&platform->done);
+    signalFree(&platform->wake);
+    lockFree(&platform->lock);
+    free(platform);
+    pool->platform = NULL;
+    pool->numThreads = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#define MAX_POOL_THREADS 64
+
+/**
+ * The part of a job one thread owns. Tasks top to bottom - 1 are still to do; the owner takes
+ * from the bottom and other threads steal from the top, both with one compare-and-swap on the
+ * packed pair so a task is never run twice.
+ */
+struct WorkQueue {
+    volatile long long range;   // top in the high 32 bits, bottom in the low 32 bits
+    char padding[56];           // keep each queue on its own cache line
+};
+
+typedef void (*WorkFunction)(void* context, int task);
+
+/**
+ * A fixed set of worker threads that run numbered tasks. The thread handles and locks are kept
+ * behind opaque storage so this header does not need the platform headers.
+ */
+struct WorkPool {
+    int numThreads;                             // workers started, the caller also works
+    struct WorkQueue queues[MAX_POOL_THREADS + 1];  // the caller's queue is the last one in use
+    WorkFunction function;                      // job being run
+    void* context;
+    volatile long remaining;                    // tasks not finished yet
+    volatile long generation;                   // bumped for each job so sleeping workers notice
+    volatile long stopping;
+    void* platform;                             // threads, lock and condition variables
+};
+
+/*
+* Name: poolStart
+* Description: Starts the worker threads. With 0 threads every job runs on the caller.
+* Parameters:
+*   - pool: the pool to start
+*   - numThreads: workers to start, at most MAX_POOL_THREADS
+* Returns: 1 if the pool is ready, 0 if the threads could not be started
+*/
+int poolStart(struct WorkPool* pool, int numThreads);
+
+/*
+* Name: poolRun
+* Description: Runs function(context, task) for every task from 0 to numTasks - 1 and waits for
+*              them all. The tasks are split into one block per thread and idle threads steal
+*              from the others, so the order they run in is not fixed.
+* Parameters:
+*   - pool: a started pool
+*   - function: the work for one task
+*   - context: passed to every call
+*   - numTasks: number of tasks
+* Returns: Nothing
+*/
+void poolRun(struct WorkPool* pool, WorkFunction function, void* context, int numTasks);
+
+/*
+* Name: poolStop
+* Description: Stops and joins the worker threads
+* Parameters:
+*   - pool: the pool to stop
+* Returns: Nothing
+*/
+void poolStop(struct WorkPool* pool);
+
+#endif
@@ -2,9 +2,24 @@
 #include "CppUnitTest.h"
 
 extern "C" {
-#include "../FunctionSpecs/MS3FunctionSpecs.h"
+#include "../SourceCode/MS3FunctionSpecs.h"
 #include "../SourceCode/delivery.h"
 #include "../SourceCode/mapping.h"
+#include "../SourceCode/pathing.h"
+#include "../SourceCode/hpa.h"
+#include "../SourceCode/mapupdate.h"
+#include "../SourceCode/roadgraph.h"
+#include "../SourceCode/assignpolicy.h"
+#include "../SourceCode/fleetscore.h"
+#include "../SourceCode/shardassign.h"
+#include "../SourceCode/pipeline.h"
+#include "../SourceCode/outputsink.h"
+#include "../SourceCode/citygen.h"
+#include "../SourceCode/snapshot.h"
+#include "../SourceCode/segments.h"
+#include "../SourceCode/simulation.h"
+#include "../SourceCode/backlog.h"
+#include "../SourceCode/coursetables.h"
 }
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -108,6 +123,7 @@ TEST_CLASS(BB_AssignShipment)
 public:
     TEST_METHOD(BB_013_PicksFirstTruck)
     {
+        struct Map map = populateMap();
         struct Truck trucks[2] = { 0 };
         struct Shipment s = { 10, 1, {5,5} };
 
@@ -117,12 +133,13 @@ public:
             trucks[i].route.points[0] = s.destination;
         }
 
-        int idx = assignShipment(trucks, 2, &s);
+        int idx = assignShipment(trucks, 2, &s, &map).truckIndex;
         Assert::AreEqual(0, idx);
     }
 
     TEST_METHOD(BB_014_PicksSecondTruck)
     {
+        struct Map map = populateMap();
         struct Truck trucks[2] = { 0 };
         struct Shipment s = { 10, 1, {5,5} };
 
@@ -135,21 +152,23 @@ public:
         // fill truck 0 so it’s skipped
         trucks[0].currentWeight = MAX_WEIGHT;
 
-        int idx = assignShipment(trucks, 2, &s);
+        int idx = assignShipment(trucks, 2, &s, &map).truckIndex;
         Assert::AreEqual(1, idx);
     }
 
     TEST_METHOD(BB_015_NoTruckFits)
     {
+        struct Map map = populateMap();
         struct Truck trucks[1] = { 0 };
         trucks[0].currentWeight = MAX_WEIGHT;
         struct Shipment s = { 10, 1, {5,5} };
-        Assert::AreEqual(-1, assignShipment(trucks, 1, &s));
+        Assert::AreEqual(-1, assignShipment(trucks, 1, &s, &map).truckIndex);
     }
     TEST_METHOD(BB_016_NullArray)
     {
+        struct Map map = populateMap();
         struct Shipment s = { 1, 1, {0,0} };
-        Assert::AreEqual(-1, assignShipment(nullptr, 0, &s));
+        Assert::AreEqual(-1, assignShipment(nullptr, 0, &s, &map).truckIndex);
     }
 };
 TEST_CLASS(WB_RemainingCapacityKg)
@@ -296,7 +315,7 @@ public:
         // Fill truck 0 so it's at capacity and skipped
         trucks[0].currentWeight = MAX_WEIGHT;
 
-        int idx = assignShipment(trucks, 2, &s);
+        int idx = assignShipment(trucks, 2, &s, &map).truckIndex;
         Assert::AreEqual(1, idx);
     }
 
@@ -313,13 +332,14 @@ public:
         }
 
         struct Shipment s = { 1, 1.0, {0,0} };
-        Assert::AreEqual(-1, assignShipment(trucks, 2, &s));
+        Assert::AreEqual(-1, assignShipment(trucks, 2, &s, &map).truckIndex);
     }
 
     TEST_METHOD(WBT_019_Assign_NullArray)
     {
+        struct Map map = populateMap();
         struct Shipment s = { 500, 5.0, {0,0} };
-        Assert::AreEqual(-1, assignShipment(nullptr, 0, &s));
+        Assert::AreEqual(-1, assignShipment(nullptr, 0, &s, &map).truckIndex);
     }
 
     TEST_METHOD(WBT_020_Assign_NullShipment)
@@ -328,7 +348,7 @@ public:
         struct Truck trucks[1] = { 0 };
         trucks[0].route.numPoints = 1;
         trucks[0].route.points[0] = { 0,0 };
-        Assert::AreEqual(-1, assignShipment(trucks, 1, nullptr));
+        Assert::AreEqual(-1, assignShipment(trucks, 1, nullptr, &map).truckIndex);
     }
 };
 
@@ -429,4 +449,1562 @@ public:
         struct Point dest = { 1,1 };
         Assert::AreEqual(-1.0, calculateRouteDistance(&t, dest, nullptr), 0.0001);
     }
-};
\ No newline at end of file
+};
+
+// Points spread over the course map, corners included, that the path tests check between
+static const struct Point pathPoints[] = { {0,0}, {24,24}, {9,3}, {16,20}, {3,12}, {24,0}, {10,17} };
+
+// Calls check(from, to) for every ordered pair of pathPoints, each point with itself as well
+template <typename Check>
+static void forEachPathPair(Check check)
+{
+    for (const struct Point& from : pathPoints) {
+        for (const struct Point& to : pathPoints) {
+            check(from, to);
+        }
+    }
+}
+
+TEST_CLASS(WB_PathEngines)
+{
+public:
+    TEST_METHOD(WBT_028_AStar_ShortestLength)
+    {
+        struct Map map = populateMap();
+        struct Point start = { 0,0 };
+        struct Point dest = { 24,24 };
+        struct Route path = findPath(&map, start, dest, PATH_ASTAR);
+        Assert::AreEqual(33, path.numPoints);
+        Assert::IsTrue(eqPt(dest, path.points[path.numPoints - 1]));
+    }
+
+    TEST_METHOD(WBT_029_Jps_MatchesAStar)
+    {
+        struct Map map = populateMap();
+
+        forEachPathPair([&](struct Point from, struct Point to) {
+            struct Route astar = findPath(&map, from, to, PATH_ASTAR);
+            struct Route jps = findPath(&map, from, to, PATH_JPS);
+            Assert::AreEqual(astar.numPoints, jps.numPoints);
+            for (int k = 0; k < jps.numPoints; k++) {
+                Assert::IsTrue(isOpenSquare(&map, jps.points[k].row, jps.points[k].col));
+            }
+        });
+    }
+
+    TEST_METHOD(WBT_030_Jps_FewerExpansions)
+    {
+        struct Map map = populateMap();
+        struct Point start = { 0,0 };
+        struct Point dest = { 24,24 };
+
+        findPath(&map, start, dest, PATH_ASTAR);
+        int astarExpanded = getLastPathStats().expanded;
+        findPath(&map, start, dest, PATH_JPS);
+        Assert::IsTrue(getLastPathStats().expanded < astarExpanded);
+    }
+
+    TEST_METHOD(WBT_031_DestOnBuilding)
+    {
+        struct Map map = populateMap();
+        struct Point start = { 0,0 };
+        struct Point dest = { 7,23 };
+        Assert::AreEqual(0, findPath(&map, start, dest, PATH_JPS).numPoints);
+    }
+
+    TEST_METHOD(WBT_032_ShortestPath_UsesEngine)
+    {
+        struct Map map = populateMap();
+        struct Point start = { 0,0 };
+        struct Point dest = { 24,24 };
+
+        setPathEngine(PATH_JPS);
+        struct Route path = shortestPath(&map, start, dest);
+        setPathEngine(PATH_GREEDY);
+        Assert::AreEqual(33, path.numPoints);
+    }
+};
+
+TEST_CLASS(WB_BidirectionalSearch)
+{
+public:
+    TEST_METHOD(WBT_033_Bidirectional_MatchesAStar)
+    {
+        struct Map map = populateMap();
+
+        forEachPathPair([&](struct Point from, struct Point to) {
+            struct Route astar = findPath(&map, from, to, PATH_ASTAR);
+            struct Route both = findPath(&map, from, to, PATH_BIDIRECTIONAL);
+            Assert::AreEqual(astar.numPoints, both.numPoints);
+            if (both.numPoints > 0) {
+                Assert::IsTrue(eqPt(to, both.points[both.numPoints - 1]));
+            }
+        });
+    }
+
+    TEST_METHOD(WBT_034_Diversion_FromClosestRoutePoint)
+    {
+        struct Map map = populateMap();
+        struct Route blue = getBlueRoute();
+        struct Point dest = { 20,20 };
+        struct Point leave = blue.points[getClosestPoint(&blue, dest)];
+
+        struct Route diversion = findDiversion(&map, &blue, dest);
+        Assert::AreEqual((int)DIVERSION, (int)diversion.routeSymbol);
+        Assert::AreEqual(findPath(&map, leave, dest, PATH_BFS).numPoints, diversion.numPoints);
+        Assert::IsTrue(eqPt(dest, diversion.points[diversion.numPoints - 1]));
+    }
+
+    TEST_METHOD(WBT_035_Diversion_OnRoute)
+    {
+        struct Map map = populateMap();
+        struct Route blue = getBlueRoute();
+        Assert::AreEqual(0, findDiversion(&map, &blue, blue.points[10]).numPoints);
+    }
+};
+
+TEST_CLASS(WB_HierarchicalPaths)
+{
+public:
+    TEST_METHOD(WBT_036_Hpa_ValidNearShortest)
+    {
+        static struct HpaIndex index;
+        struct Map map = populateMap();
+
+        hpaBuild(&index, &map);
+        forEachPathPair([&](struct Point from, struct Point to) {
+            struct Route astar = findPath(&map, from, to, PATH_ASTAR);
+            struct Route hpa = hpaFindPath(&index, &map, from, to);
+            Assert::AreEqual(astar.numPoints > 0, hpa.numPoints > 0);
+            Assert::IsTrue(hpa.numPoints >= astar.numPoints);
+            for (int k = 0; k < hpa.numPoints; k++) {
+                Assert::IsTrue(isOpenSquare(&map, hpa.points[k].row, hpa.points[k].col));
+            }
+            if (hpa.numPoints > 0) {
+                Assert::IsTrue(eqPt(to, hpa.points[hpa.numPoints - 1]));
+                Assert::AreEqual(hpa.numPoints, hpaPathLength(&index, &map, from, to));
+            }
+        });
+    }
+
+    TEST_METHOD(WBT_037_Hpa_UpdateMatchesRebuild)
+    {
+        static struct HpaIndex updated, rebuilt;
+        struct Map map = populateMap();
+
+        hpaBuild(&updated, &map);
+        map.squares[10][10] = 1;
+        hpaUpdateCell(&updated, &map, 10, 10);
+        map.squares[0][9] = 1;
+        hpaUpdateCell(&updated, &map, 0, 9);
+        hpaBuild(&rebuilt, &map);
+        forEachPathPair([&](struct Point from, struct Point to) {
+            Assert::AreEqual(hpaPathLength(&rebuilt, &map, from, to), hpaPathLength(&updated, &map, from, to));
+        });
+    }
+
+    TEST_METHOD(WBT_038_Diversion_UsesIndex)
+    {
+        static struct HpaIndex index;
+        struct Map map = populateMap();
+        struct Route blue = getBlueRoute();
+        struct Point dest = { 20,20 };
+
+        hpaBuild(&index, &map);
+        useHpaIndex(&index);
+        struct Route diversion = findDiversion(&map, &blue, dest);
+        useHpaIndex(NULL);
+        Assert::AreEqual((int)DIVERSION, (int)diversion.routeSymbol);
+        Assert::IsTrue(eqPt(dest, diversion.points[diversion.numPoints - 1]));
+    }
+};
+
+static int divertedTruck = -1;
+static int divertedLength = -1;
+
+static void recordDiversion(const int truckNumber, const struct Route* diversion, void* context)
+{
+    divertedTruck = truckNumber;
+    divertedLength = diversion->numPoints;
+}
+
+TEST_CLASS(WB_MapUpdates)
+{
+public:
+    TEST_METHOD(WBT_039_Reachability_WallClosed)
+    {
+        static struct ReachabilityLabels labels;
+        struct Map map = { {0}, MAP_ROWS, MAP_COLS };
+        struct Point left = { 0,0 };
+        struct Point right = { 0,24 };
+
+        for (int row = 0; row < MAP_ROWS; row++) {
+            map.squares[row][12] = row != 5;
+        }
+        buildReachability(&labels, &map);
+        addMapObserver(reachabilityMapObserver, &labels);
+        Assert::IsTrue(isReachable(&labels, left, right));
+        setSquareBlocked(&map, 5, 12, 1);
+        Assert::IsFalse(isReachable(&labels, left, right));
+        setSquareBlocked(&map, 5, 12, 0);
+        removeMapObserver(reachabilityMapObserver, &labels);
+        Assert::IsTrue(isReachable(&labels, left, right));
+    }
+
+    TEST_METHOD(WBT_040_ActiveDiversion_Repaired)
+    {
+        struct Map map = populateMap();
+        struct Route blue = getBlueRoute();
+        struct Point dest = { 20,20 };
+
+        int id = startDiversion(&map, 0, &blue, dest);
+        struct Route before = getActiveDiversion(id);
+        setDiversionListener(recordDiversion, NULL);
+        divertedTruck = -1;
+        setSquareBlocked(&map, before.points[1].row, before.points[1].col, 1);
+        setDiversionListener(NULL, NULL);
+
+        struct Route after = getActiveDiversion(id);
+        endDiversion(id);
+        Assert::AreEqual(0, divertedTruck);
+        Assert::AreEqual(after.numPoints, divertedLength);
+        Assert::AreEqual(findDiversion(&map, &blue, dest).numPoints, after.numPoints);
+        for (int i = 0; i < after.numPoints; i++) {
+            Assert::IsTrue(isOpenSquare(&map, after.points[i].row, after.points[i].col));
+        }
+    }
+
+    TEST_METHOD(WBT_041_SetSquareBlocked_NoChange)
+    {
+        struct Map map = populateMap();
+        Assert::AreEqual(0, setSquareBlocked(&map, 0, 0, 0));
+        Assert::AreEqual(0, setSquareBlocked(&map, 25, 0, 1));
+        Assert::AreEqual(1, setSquareBlocked(&map, 0, 0, 1));
+        Assert::AreEqual(0, setSquareBlocked(&map, 0, 0, 1));
+    }
+};
+
+TEST_CLASS(WB_RoadGraph)
+{
+public:
+    TEST_METHOD(WBT_042_RoadDistance_MatchesAStar)
+    {
+        static struct RoadIndex index;
+        struct Map map = populateMap();
+
+        Assert::IsTrue(roadBuild(&index, &map) != 0);
+        forEachPathPair([&](struct Point from, struct Point to) {
+            struct Route astar = findPath(&map, from, to, PATH_ASTAR);
+            int expected = eqPt(from, to) ? 0 : (astar.numPoints > 0 ? astar.numPoints : -1);
+            Assert::AreEqual(expected, roadDistance(&index, from, to));
+        });
+    }
+
+    TEST_METHOD(WBT_043_Contracted_PathMatchesAStar)
+    {
+        static struct RoadIndex index;
+        struct Map map = populateMap();
+        struct Point start = { 0,0 };
+        struct Point dest = { 24,24 };
+
+        roadBuild(&index, &map);
+        useRoadIndex(&index);
+        struct Route path = findPath(&map, start, dest, PATH_CONTRACTED);
+        useRoadIndex(NULL);
+        Assert::AreEqual(33, path.numPoints);
+        Assert::IsTrue(eqPt(dest, path.points[path.numPoints - 1]));
+        for (int k = 0; k < path.numPoints; k++) {
+            Assert::IsTrue(isOpenSquare(&map, path.points[k].row, path.points[k].col));
+        }
+    }
+
+    TEST_METHOD(WBT_044_CalcDist_UsesRoadIndex)
+    {
+        static struct RoadIndex index;
+        struct Map map = populateMap();
+        struct Truck t = { 0 };
+        struct Point dest = { 0,13 };
+        int expected = -1;
+
+        t.route = getBlueRoute();
+        for (int i = 0; i < t.route.numPoints; i++) {
+            int moves = findPath(&map, t.route.points[i], dest, PATH_BFS).numPoints;
+            if (moves > 0 && (expected < 0 || moves < expected)) expected = moves;
+        }
+        roadBuild(&index, &map);
+        useRoadIndex(&index);
+        double dist = calculateRouteDistance(&t, dest, &map);
+        useRoadIndex(NULL);
+        Assert::AreEqual((double)expected, dist, 0.0001);
+    }
+
+    TEST_METHOD(WBT_087_RoadIndex_FollowsClosures)
+    {
+        static struct RoadIndex index;
+        static struct Map map;
+        struct Point left = { 0,0 };
+        struct Point right = { 0,24 };
+
+        map.numRows = MAP_ROWS;
+        map.numCols = MAP_COLS;
+        for (int row = 0; row < MAP_ROWS; row++) {
+            map.squares[row][12] = row != 5;
+        }
+        roadBuild(&index, &map);
+        addMapObserver(roadMapObserver, &index);
+        Assert::AreEqual(findPath(&map, left, right, PATH_ASTAR).numPoints, roadDistance(&index, left, right));
+        setSquareBlocked(&map, 5, 12, 1);
+        Assert::AreEqual(-1, roadDistance(&index, left, right));
+        setSquareBlocked(&map, 5, 12, 0);
+        removeMapObserver(roadMapObserver, &index);
+        Assert::AreEqual(findPath(&map, left, right, PATH_ASTAR).numPoints, roadDistance(&index, left, right));
+    }
+};
+
+TEST_CLASS(WB_RouteBitmap)
+{
+public:
+    TEST_METHOD(WBT_045_IsOnRoute_MatchesScan)
+    {
+        struct Truck indexed = { 0 };
+        struct Truck scanned = { 0 };
+        indexed.route = getBlueRoute();
+        scanned.route = getBlueRoute();
+        indexRoute(&indexed);
+
+        for (int row = 0; row < MAP_ROWS; row++) {
+            for (int col = 0; col < MAP_COLS; col++) {
+                struct Point p = { (char)row, (char)col };
+                Assert::AreEqual(isOnRoute(&scanned, p), isOnRoute(&indexed, p));
+            }
+        }
+        Assert::AreEqual(1, isOnRoute(&indexed, indexed.route.points[5]));
+    }
+
+    TEST_METHOD(WBT_046_FleetIndex_TruckBits)
+    {
+        static struct FleetIndex fleet;
+        struct Truck trucks[3] = { 0 };
+        trucks[0].route = getBlueRoute();
+        trucks[1].route = getGreenRoute();
+        trucks[2].route = getYellowRoute();
+        buildFleetIndex(&fleet, trucks, 3);
+
+        for (int row = 0; row < MAP_ROWS; row++) {
+            for (int col = 0; col < MAP_COLS; col++) {
+                struct Point p = { (char)row, (char)col };
+                unsigned int expected = 0;
+                for (int i = 0; i < 3; i++) {
+                    if (isOnRoute(&trucks[i], p)) expected |= 1u << i;
+                }
+                Assert::AreEqual(expected, trucksAtPoint(&fleet, p));
+            }
+        }
+    }
+
+    TEST_METHOD(WBT_047_CalcDist_IndexedOnRoute)
+    {
+        struct Map map = populateMap();
+        struct Truck t = { 0 };
+        t.route = getGreenRoute();
+        indexRoute(&t);
+        Assert::AreEqual(0.0, calculateRouteDistance(&t, t.route.points[7], &map), 0.0001);
+    }
+
+    TEST_METHOD(WBT_083_FleetIndex_OtherArrayScanned)
+    {
+        static struct FleetIndex fleet;
+        struct Map map = populateMap();
+        struct Truck indexed[3] = { 0 };
+        struct Truck other[3] = { 0 };
+        struct Shipment s = { 10, 0.5, { 0, 0 } };
+        indexed[0].route = getBlueRoute();
+        indexed[1].route = getGreenRoute();
+        indexed[2].route = getYellowRoute();
+        buildFleetIndex(&fleet, indexed, 3);
+
+        // The same routes in the other order, so the index's bits name the wrong trucks
+        for (int i = 0; i < 3; i++) {
+            other[i] = indexed[2 - i];
+            other[i].truckNumber = i;
+        }
+        for (int i = 0; i < indexed[0].route.numPoints; i++) {
+            if (trucksAtPoint(&fleet, indexed[0].route.points[i]) == 1u) {
+                s.destination = indexed[0].route.points[i];
+                break;
+            }
+        }
+
+        useCapacityIndex(NULL);
+        useFleetIndex(&fleet, indexed);
+        struct DeliveryResult result = assignShipment(other, 3, &s, &map);
+        useFleetIndex(NULL, NULL);
+
+        Assert::AreEqual(2, result.truckIndex);
+        Assert::AreEqual(0, result.needsDiversion);
+    }
+
+    TEST_METHOD(WBT_086_Assign_FleetLargerThanMaxFleet)
+    {
+        static struct Truck trucks[MAX_FLEET + 8];
+        struct Map map = populateMap();
+        struct Shipment s = { 10, 0.5, { 0, 0 } };
+        int last = MAX_FLEET + 7;
+
+        // Only the last truck, past the bits a mask has, passes the destination
+        for (int i = 0; i <= last; i++) {
+            trucks[i].route = getBlueRoute();
+            trucks[i].truckNumber = i;
+        }
+        trucks[last].route = getYellowRoute();
+        s.destination = trucks[last].route.points[trucks[last].route.numPoints - 1];
+
+        useCapacityIndex(NULL);
+        struct DeliveryResult result = assignShipment(trucks, last + 1, &s, &map);
+
+        Assert::AreEqual(last, result.truckIndex);
+        Assert::AreEqual(0, result.needsDiversion);
+    }
+};
+
+TEST_CLASS(WB_CapacityIndex)
+{
+public:
+    TEST_METHOD(WBT_048_NextFitting_SkipsFullTrucks)
+    {
+        static struct CapacityIndex index;
+        struct Truck trucks[5] = { 0 };
+        struct Shipment s = { 500, 2, {0,0} };
+        trucks[0].currentWeight = 4800;
+        trucks[1].currentVolume = 199;
+        trucks[3].currentWeight = 4900;
+        buildCapacityIndex(&index, trucks, 5);
+
+        Assert::AreEqual(2, nextFittingTruck(&index, &s, 0));
+        Assert::AreEqual(4, nextFittingTruck(&index, &s, 3));
+        Assert::AreEqual(-1, nextFittingTruck(&index, &s, 5));
+    }
+
+    TEST_METHOD(WBT_049_AddShipment_UpdatesIndex)
+    {
+        static struct CapacityIndex index;
+        struct Truck trucks[2] = { 0 };
+        struct Shipment big = { 4000, 5, {0,0} };
+        struct Shipment next = { 2000, 5, {0,0} };
+        buildCapacityIndex(&index, trucks, 2);
+        useCapacityIndex(&index);
+
+        addShipmentToTruck(&trucks[0], &big);
+        Assert::AreEqual(1, nextFittingTruck(&index, &next, 0));
+        addShipmentToTruck(&trucks[1], &big);
+        useCapacityIndex(NULL);
+        Assert::AreEqual(-1, nextFittingTruck(&index, &next, 0));
+        Assert::AreEqual(1000, index.weightLeft[1]);
+    }
+
+    TEST_METHOD(WBT_050_BestFitting_MostCapacityThenNumber)
+    {
+        static struct CapacityIndex index;
+        struct Truck trucks[4] = { 0 };
+        struct Shipment s = { 100, 2, {0,0} };
+        for (int i = 0; i < 4; i++) trucks[i].truckNumber = 3 - i;
+        trucks[0].currentWeight = 1000;
+        buildCapacityIndex(&index, trucks, 4);
+
+        Assert::AreEqual(3, bestFittingTruck(&index, &s, 0xF));
+        Assert::AreEqual(1, bestFittingTruck(&index, &s, 0x3));
+        Assert::AreEqual(0, bestFittingTruck(&index, &s, 0x1));
+    }
+};
+
+TEST_CLASS(WB_AssignPolicy)
+{
+public:
+    TEST_METHOD(WBT_051_MinDiversion_MatchesAssignShipment)
+    {
+        struct Map map = populateMap();
+        struct Truck a[3] = { 0 }, b[3] = { 0 };
+        struct Shipment s = { 300, 2, {12,12} };
+        a[0].route = getBlueRoute(); a[1].route = getGreenRoute(); a[2].route = getYellowRoute();
+        for (int i = 0; i < 3; i++) { a[i].truckNumber = i; b[i] = a[i]; }
+
+        struct DeliveryResult expected = assignShipment(a, 3, &s, &map);
+        struct DeliveryResult result = assignMinDiversion(b, 3, &s, &map);
+        Assert::AreEqual(expected.success, result.success);
+        Assert::AreEqual(expected.truckIndex, result.truckIndex);
+        Assert::AreEqual(expected.distanceToGo, result.distanceToGo, 0.0001);
+        Assert::AreEqual(a[result.truckIndex].currentWeight, b[result.truckIndex].currentWeight, 0.0001);
+    }
+
+    TEST_METHOD(WBT_052_WeightFirst_TightestFit)
+    {
+        struct Map map = populateMap();
+        struct Truck trucks[3] = { 0 };
+        struct Shipment s = { 1000, 2, {4,2} };
+        for (int i = 0; i < 3; i++) { trucks[i].route = getBlueRoute(); trucks[i].truckNumber = i; }
+        trucks[0].currentWeight = 1000;
+        trucks[1].currentWeight = 3500;
+        trucks[2].currentWeight = 4500;
+
+        struct DeliveryResult result = assignWeightFirst(trucks, 3, &s, &map);
+        Assert::AreEqual(1, result.success);
+        Assert::AreEqual(1, result.truckIndex);
+        Assert::AreEqual(4500.0, trucks[1].currentWeight, 0.0001);
+    }
+
+    TEST_METHOD(WBT_053_Balanced_SpreadsLoad)
+    {
+        struct Map map = populateMap();
+        struct Truck trucks[2] = { 0 };
+        struct Shipment s = { 500, 2, {4,2} };
+        for (int i = 0; i < 2; i++) { trucks[i].route = getBlueRoute(); trucks[i].truckNumber = i; }
+
+        Assert::AreEqual(0, assignPolicies[3].assign(trucks, 2, &s, &map).truckIndex);
+        Assert::AreEqual(1, assignPolicies[3].assign(trucks, 2, &s, &map).truckIndex);
+        Assert::AreEqual(0, assignPolicies[3].assign(trucks, 2, &s, &map).truckIndex);
+    }
+};
+
+TEST_CLASS(WB_FleetScore)
+{
+public:
+    TEST_METHOD(WBT_054_FittingTrucks_MatchesCanFit)
+    {
+        static struct CapacityIndex index;
+        struct Truck trucks[6] = { 0 };
+        struct Shipment s = { 1000, 5, {0,0} };
+        trucks[1].currentWeight = 4000.5;
+        trucks[2].currentWeight = 4000;
+        trucks[3].currentVolume = 196;
+        trucks[5].currentVolume = 195;
+        buildCapacityIndex(&index, trucks, 6);
+
+        unsigned int fits = fittingTrucks(&index, &s);
+        for (int i = 0; i < 6; i++) {
+            Assert::AreEqual(canFitShipment(&trucks[i], &s), (int)((fits >> i) & 1u));
+        }
+        Assert::AreEqual(0x35u, fits);
+    }
+
+    TEST_METHOD(WBT_055_BestScored_TieBreakOrder)
+    {
+        static struct CapacityIndex index;
+        struct Truck trucks[5] = { 0 };
+        double diversion[MAX_FLEET] = { 0 };
+        trucks[0].truckNumber = 2; trucks[1].truckNumber = 1; trucks[2].truckNumber = 1;
+        trucks[3].truckNumber = 0; trucks[4].truckNumber = 0;
+        trucks[3].currentWeight = 100;
+        diversion[0] = 2; diversion[1] = 1; diversion[2] = 1; diversion[3] = 1; diversion[4] = 3;
+        buildCapacityIndex(&index, trucks, 5);
+
+        Assert::AreEqual(1, bestScoredTruck(&index, diversion, 0x1F));
+        Assert::AreEqual(2, bestScoredTruck(&index, diversion, 0x1D));
+        Assert::AreEqual(3, bestScoredTruck(&index, diversion, 0x19));
+        Assert::AreEqual(-1, bestScoredTruck(&index, diversion, 0));
+    }
+};
+
+TEST_CLASS(WB_FixedPointCapacity)
+{
+public:
+    TEST_METHOD(WBT_056_Units_RoundAndCeil)
+    {
+        Assert::AreEqual(1500, weightToGrams(1.5));
+        Assert::AreEqual(100, weightToGrams(0.1));
+        Assert::AreEqual(2, kilogramsNeeded(1.001));
+        Assert::AreEqual(1, kilogramsNeeded(1.0));
+        Assert::AreEqual(1, volumeToUnits(0.5));
+        Assert::AreEqual(10, volumeToUnits(5));
+    }
+
+    TEST_METHOD(WBT_057_AddShipment_NoDrift)
+    {
+        struct Truck t = { 0 };
+        struct Shipment s = { 0.1, 0.5, {0,0} };
+        for (int i = 0; i < 3; i++) {
+            addShipmentToTruck(&t, &s);
+        }
+        Assert::IsTrue(t.currentWeight == 0.3);
+        Assert::IsTrue(t.currentVolume == 1.5);
+    }
+
+    TEST_METHOD(WBT_058_CapacityShare_ExactTies)
+    {
+        struct Truck byWeight = { 0 }, byVolume = { 0 };
+        byWeight.currentWeight = 2500;
+        byVolume.currentVolume = 100;
+        Assert::AreEqual(CAPACITY_SCALE / 2, capacityLeftShare(&byWeight));
+        Assert::AreEqual(capacityLeftShare(&byWeight), capacityLeftShare(&byVolume));
+        byVolume.currentWeight = 2500.001;
+        Assert::IsTrue(capacityLeftShare(&byVolume) < capacityLeftShare(&byWeight));
+    }
+};
+
+TEST_CLASS(WB_ShardedAssign)
+{
+public:
+    TEST_METHOD(WBT_059_Shards_CoverFleetInOrder)
+    {
+        static struct FleetShards shards;
+        struct Truck trucks[6] = { 0 };
+        struct Route routes[3] = { getBlueRoute(), getGreenRoute(), getYellowRoute() };
+        for (int i = 0; i < 6; i++) trucks[i].route = routes[i % 3];
+        buildFleetShards(&shards, trucks, 6, 4);
+
+        int seen = 0;
+        Assert::AreEqual(6, shards.first[4]);
+        for (int k = 0; k < 4; k++) {
+            for (int j = shards.first[k]; j < shards.first[k + 1]; j++) {
+                seen |= 1 << shards.order[j];
+                if (j > shards.first[k]) Assert::IsTrue(shards.order[j - 1] < shards.order[j]);
+            }
+        }
+        Assert::AreEqual(0x3F, seen);
+    }
+
+    TEST_METHOD(WBT_060_Sharded_MatchesSerialAnyThreads)
+    {
+        static struct FleetShards shards;
+        static struct Truck serial[12], sharded[12];
+        struct Map map = populateMap();
+        struct Route routes[3] = { getBlueRoute(), getGreenRoute(), getYellowRoute() };
+        struct Point dests[4] = { {12,12}, {4,2}, {20,20}, {8,24} };
+
+        for (int threads = 0; threads <= 3; threads++) {
+            struct WorkPool pool;
+            Assert::AreEqual(1, poolStart(&pool, threads));
+            for (int i = 0; i < 12; i++) {
+                serial[i] = {};
+                serial[i].route = routes[i % 3];
+                serial[i].truckNumber = i % 4;
+                sharded[i] = serial[i];
+            }
+            buildFleetShards(&shards, sharded, 12, 5);
+
+            for (int k = 0; k < 40; k++) {
+                struct Shipment s = { 100.0 + 37 * k, (k % 3 == 0) ? 5.0 : 2.0, dests[k % 4] };
+                struct DeliveryResult expected = assignShipment(serial, 12, &s, &map);
+                struct DeliveryResult result = assignShipmentSharded(&pool, &shards, sharded, 12, &s, &map);
+                Assert::AreEqual(expected.success, result.success);
+                Assert::AreEqual(expected.truckIndex, result.truckIndex);
+                Assert::AreEqual(expected.distanceToGo, result.distanceToGo, 0.0);
+            }
+            poolStop(&pool);
+        }
+    }
+};
+
+TEST_CLASS(WB_IntakePipeline)
+{
+public:
+    TEST_METHOD(WBT_061_Ring_FifoAndBounded)
+    {
+        static struct IntakeRing ring;
+        struct IntakeRecord record = {};
+        ringInit(&ring);
+
+        Assert::AreEqual(0, ringTryPop(&ring, &record));
+        for (int i = 0; i < RING_SLOTS; i++) {
+            record.weight = i;
+            Assert::AreEqual(1, ringTryPush(&ring, &record));
+        }
+        Assert::AreEqual(0, ringTryPush(&ring, &record));
+        for (int i = 0; i < RING_SLOTS; i++) {
+            Assert::AreEqual(1, ringTryPop(&ring, &record));
+            Assert::AreEqual((double)i, record.weight);
+        }
+        Assert::AreEqual(0, ringTryPop(&ring, &record));
+    }
+
+    TEST_METHOD(WBT_062_Pipeline_PlacesInOrder)
+    {
+        struct Map map = populateMap();
+        struct Truck trucks[3] = { 0 };
+        trucks[0].route = getBlueRoute(); trucks[1].route = getGreenRoute(); trucks[2].route = getYellowRoute();
+        for (int i = 0; i < 3; i++) trucks[i].truckNumber = i;
+
+        FILE* input = tmpfile();
+        Assert::IsTrue(input != NULL);
+        fputs("4000 2 16L\nbad line\n2000 2 16L\n900 5 16L\n0 0 x\n", input);
+        rewind(input);
+        int dayEnded = 0;
+        int placed = runIntakePipeline(input, trucks, 3, &map, &dayEnded);
+        fclose(input);
+
+        Assert::AreEqual(3, placed);
+        Assert::AreEqual(1, dayEnded);
+        Assert::AreEqual(4900.0, trucks[0].currentWeight, 0.0001);
+        Assert::AreEqual(2000.0, trucks[2].currentWeight, 0.0001);
+    }
+};
+
+TEST_CLASS(WB_OutputSink)
+{
+public:
+    TEST_METHOD(WBT_063_Sink_TextMatchesPrinted)
+    {
+        static struct OutputSink sink;
+        static char expected[DELIVERY_INFO_SIZE + 128], written[DELIVERY_INFO_SIZE + 128];
+        struct Map map = populateMap();
+        struct Truck truck = { 0 };
+        struct DeliveryResult result = { 1, 0, 1, 0.0 };
+        struct Point dest = { 12, 11 };
+        truck.route = getBlueRoute();
+
+        int length = formatDeliveryInfo(expected, DELIVERY_INFO_SIZE, &truck, &result, &map, &dest);
+        const char* tail = "Ships tomorrow\nNext: ";
+        for (int i = 0; tail[i] != '\0'; i++) expected[length++] = tail[i];
+
+        FILE* output = tmpfile();
+        Assert::IsTrue(output != NULL);
+        Assert::AreEqual(1, sinkOpen(&sink, output, SINK_FORMAT_TEXT, &map));
+        sinkDelivery(&sink, &truck, &result, &dest);
+        sinkText(&sink, SINK_LINE, "Ships tomorrow");
+        sinkText(&sink, SINK_PROMPT, "Next: ");
+        sinkClose(&sink);
+
+        rewind(output);
+        int count = (int)fread(written, 1, sizeof(written), output);
+        fclose(output);
+        Assert::AreEqual(length, count);
+        for (int i = 0; i < length; i++) Assert::AreEqual(expected[i], written[i]);
+    }
+
+    TEST_METHOD(WBT_090_DeliveryInfo_CutShortInSmallBuffer)
+    {
+        static char full[DELIVERY_INFO_SIZE];
+        char small[48];
+        struct Map map = populateMap();
+        struct Truck truck = { 0 };
+        struct DeliveryResult result = { 1, 0, 1, 0.0 };
+        struct Point dest = { 12, 11 };
+        truck.route = getBlueRoute();
+
+        int fullLength = formatDeliveryInfo(full, DELIVERY_INFO_SIZE, &truck, &result, &map, &dest);
+        Assert::IsTrue(fullLength > (int)sizeof(small));
+        for (int size = 1; size <= (int)sizeof(small); size++) {
+            int length = formatDeliveryInfo(small, size, &truck, &result, &map, &dest);
+            Assert::AreEqual(size - 1, length);
+            Assert::AreEqual('\0', small[length]);
+            for (int i = 0; i < length; i++) Assert::AreEqual(full[i], small[i]);
+        }
+    }
+
+    TEST_METHOD(WBT_064_Sink_BinaryRecords)
+    {
+        static struct OutputSink sink;
+        unsigned char written[512];
+        struct Map map = populateMap();
+        struct Truck truck = { 0 };
+        struct DeliveryResult onRoute = { 1, 0, 0, 0.0 };
+        struct DeliveryResult diverted = { 1, 0, 1, 0.0 };
+        truck.route = getBlueRoute();
+        truck.truckNumber = 2;
+        struct Point stop = truck.route.points[5];
+        struct Point dest = { 20, 20 };
+
+        FILE* output = tmpfile();
+        Assert::IsTrue(output != NULL);
+        Assert::AreEqual(1, sinkOpen(&sink, output, SINK_FORMAT_BINARY, &map));
+        sinkDelivery(&sink, &truck, &onRoute, &stop);
+        sinkText(&sink, SINK_PROMPT, "dropped");
+        sinkText(&sink, SINK_LINE, "ok");
+        sinkDelivery(&sink, &truck, &diverted, &dest);
+        sinkFlush(&sink);
+        sinkClose(&sink);
+
+        rewind(output);
+        int count = (int)fread(written, 1, sizeof(written), output);
+        fclose(output);
+
+        const unsigned char head[] = { 'D', 2, 0, 0, 0, 0, 'L', 2, 0, 'o', 'k', 'D', 2, 0, 1 };
+        Assert::IsTrue(count > (int)sizeof(head));
+        for (int i = 0; i < (int)sizeof(head); i++) Assert::AreEqual((int)head[i], (int)written[i]);
+
+        struct Route diversion = findDiversion(&map, &truck.route, dest);
+        int leaveFrom = getClosestPoint(&truck.route, dest);
+        int n = written[15] | written[16] << 8;
+        Assert::AreEqual(diversion.numPoints + 1, n);
+        Assert::AreEqual(17 + 2 * n, count);
+        Assert::AreEqual((int)truck.route.points[leaveFrom].row, (int)written[17]);
+        Assert::AreEqual((int)truck.route.points[leaveFrom].col, (int)written[18]);
+        Assert::AreEqual((int)dest.row, (int)written[17 + 2 * (n - 1)]);
+        Assert::AreEqual((int)dest.col, (int)written[18 + 2 * (n - 1)]);
+    }
+};
+
+TEST_CLASS(WB_RouteInto)
+{
+public:
+    TEST_METHOD(WBT_065_PossibleMovesInto_MatchesRoute)
+    {
+        struct Map map = populateMap();
+        struct Point moves[MAX_MOVES];
+        struct Point back = { 4, 4 };
+
+        for (int row = 0; row < MAP_ROWS; row += 3) {
+            for (int col = 0; col < MAP_COLS; col += 2) {
+                struct Point p = { (char)row, (char)col };
+                struct Route expected = getPossibleMoves(&map, p, back);
+                int n = getPossibleMovesInto(&map, p, back, moves);
+                Assert::AreEqual(expected.numPoints, n);
+                for (int i = 0; i < n; i++) Assert::IsTrue(eqPt(expected.points[i], moves[i]) != 0);
+            }
+        }
+    }
+
+    TEST_METHOD(WBT_066_FindPathInto_MatchesFindPath)
+    {
+        static struct Route path;
+        struct Map map = populateMap();
+        struct Point starts[3] = { {0,0}, {17,24}, {9,3} };
+        struct Point dests[3] = { {12,12}, {4,2}, {20,20} };
+        enum PathEngine engines[4] = { PATH_GREEDY, PATH_ASTAR, PATH_BFS, PATH_BIDIRECTIONAL };
+
+        for (int e = 0; e < 4; e++) {
+            for (int k = 0; k < 3; k++) {
+                struct Route expected = findPath(&map, starts[k], dests[k], engines[e]);
+                path.numPoints = 99;
+                Assert::AreEqual(expected.numPoints, findPathInto(&map, starts[k], dests[k], engines[e], &path));
+                Assert::AreEqual(expected.numPoints, path.numPoints);
+                for (int i = 0; i < path.numPoints; i++) Assert::IsTrue(eqPt(expected.points[i], path.points[i]) != 0);
+            }
+        }
+
+        loadBlueRoute(&path);
+        Assert::AreEqual(getBlueRoute().numPoints, path.numPoints);
+        Assert::AreEqual((int)BLUE, (int)path.routeSymbol);
+    }
+};
+
+TEST_CLASS(WB_MoveTable)
+{
+public:
+    TEST_METHOD(WBT_067_MoveTable_IncrementalMatchesRebuild)
+    {
+        static struct MoveTable live, fresh;
+        struct Map map = populateMap();
+        struct Point cells[4] = { {12,12}, {0,0}, {24,24}, {5,9} };
+
+        buildMoveTable(&live, &map);
+        Assert::AreEqual(1, addMapObserver(moveTableMapObserver, &live));
+        for (int k = 0; k < 8; k++) {
+            setSquareBlocked(&map, cells[k % 4].row, cells[k % 4].col, k < 4);
+            buildMoveTable(&fresh, &map);
+            for (int i = 0; i < MAP_CELLS; i++) Assert::AreEqual((int)fresh.moves[i], (int)live.moves[i]);
+        }
+        removeMapObserver(moveTableMapObserver, &live);
+
+        // a corner has only three moves, and the one back to where we came from is left out
+        struct Point moves[MAX_MOVES];
+        struct Point corner = { 0, 0 };
+        struct Point back = { 1, 1 };
+        map.squares[0][1] = 0; map.squares[1][0] = 0; map.squares[1][1] = 0;
+        buildMoveTable(&fresh, &map);
+        Assert::AreEqual(2, listTableMoves(&fresh, corner, back, moves));
+    }
+
+    TEST_METHOD(WBT_068_MoveTable_SearchesUnchanged)
+    {
+        static struct MoveTable table;
+        static struct Route plain, tabled;
+        struct Map map = populateMap();
+        struct Point starts[3] = { {0,0}, {17,24}, {9,3} };
+        struct Point dests[3] = { {12,12}, {4,2}, {20,20} };
+        enum PathEngine engines[4] = { PATH_GREEDY, PATH_ASTAR, PATH_BFS, PATH_BIDIRECTIONAL };
+
+        buildMoveTable(&table, &map);
+        for (int e = 0; e < 4; e++) {
+            for (int k = 0; k < 3; k++) {
+                findPathInto(&map, starts[k], dests[k], engines[e], &plain);
+                useMoveTable(&table, &map);
+                findPathInto(&map, starts[k], dests[k], engines[e], &tabled);
+                useMoveTable(NULL, NULL);
+                Assert::AreEqual(plain.numPoints, tabled.numPoints);
+                for (int i = 0; i < plain.numPoints; i++) Assert::IsTrue(eqPt(plain.points[i], tabled.points[i]) != 0);
+            }
+        }
+    }
+
+    TEST_METHOD(WBT_089_Tables_OnlyUsedForTheirMap)
+    {
+        static struct MoveTable table;
+        static struct DestinationTable destinations;
+        static struct Truck trucks[1];
+        struct Map map = populateMap();
+        struct Point start = { 0,0 };
+        struct Point dest = { 0,24 };
+        struct Point closed = { 0,12 };
+
+        buildMoveTable(&table, &map);
+        loadBlueRoute(&trucks[0].route);
+        buildDestinationTable(&destinations, &map, trucks, 1);
+
+        // A copy with a wall across it, changed without telling either table
+        struct Map walled = map;
+        for (int row = 0; row < MAP_ROWS; row++) {
+            walled.squares[row][12] = 1;
+        }
+        struct Route plain = findPath(&walled, start, dest, PATH_ASTAR);
+
+        useMoveTable(&table, &map);
+        useDestinationTable(&destinations, trucks, &map);
+        struct Route tabled = findPath(&walled, start, dest, PATH_ASTAR);
+        int copyAccepts = isValidDestination(&closed, &walled);
+        int mapAccepts = isValidDestination(&closed, &map);
+        useMoveTable(NULL, NULL);
+        useDestinationTable(NULL, NULL, NULL);
+
+        Assert::AreEqual(plain.numPoints, tabled.numPoints);
+        Assert::AreEqual(0, copyAccepts);
+        Assert::AreEqual(isDeliverable(&destinations, closed), mapAccepts);
+    }
+};
+
+TEST_CLASS(WB_CityGenerator)
+{
+public:
+    TEST_METHOD(WBT_069_Generator_SameSeedSameCity)
+    {
+        static struct City a, b;
+        static struct Truck fleetA[4], fleetB[4];
+        static struct Workload streamA, streamB;
+        struct CityConfig config = { 25, 25, 4, 1, 2, 50, 99 };
+        struct WorkloadConfig zipf = { DESTINATIONS_ZIPF, 0, 0, 0, 1.0, 1000, 5 };
+
+        generateCity(&a, &config);
+        generateCity(&b, &config);
+        for (int r = 0; r < MAP_ROWS; r++)
+            for (int c = 0; c < MAP_COLS; c++) Assert::AreEqual(a.map.squares[r][c], b.map.squares[r][c]);
+
+        generateFleet(fleetA, 4, &a, 60, 3);
+        generateFleet(fleetB, 4, &b, 60, 3);
+        for (int t = 0; t < 4; t++) {
+            Assert::AreEqual(fleetA[t].route.numPoints, fleetB[t].route.numPoints);
+            for (int i = 0; i < fleetA[t].route.numPoints; i++) Assert::IsTrue(eqPt(fleetA[t].route.points[i], fleetB[t].route.points[i]) != 0);
+        }
+
+        Assert::IsTrue(startWorkload(&streamA, &zipf, &a.map) > 0);
+        startWorkload(&streamB, &zipf, &b.map);
+        for (int i = 0; i < 200; i++) {
+            struct Shipment x, y;
+            nextShipment(&streamA, &a.map, &x);
+            nextShipment(&streamB, &b.map, &y);
+            Assert::AreEqual(x.weight, y.weight);
+            Assert::AreEqual(x.volume, y.volume);
+            Assert::IsTrue(eqPt(x.destination, y.destination) != 0);
+        }
+    }
+
+    TEST_METHOD(WBT_070_Generator_RoutesOnStreetsShipmentsOnOpenSquares)
+    {
+        static struct City city;
+        static struct Truck fleet[6];
+        static struct Workload stream;
+        struct CityConfig config = { 25, 25, 3, 1, 1, 80, 7 };
+        struct WorkloadConfig hotspots = { DESTINATIONS_HOTSPOTS, 3, 2, 90, 0.0, 2000, 11 };
+
+        generateCity(&city, &config);
+        generateFleet(fleet, 6, &city, MAX_ROUTE, 13);
+        for (int t = 0; t < 6; t++) {
+            const struct Route* route = &fleet[t].route;
+            Assert::IsTrue(route->numPoints > 1);
+            Assert::AreEqual(t, fleet[t].truckNumber);
+            for (int i = 0; i < route->numPoints; i++) {
+                struct Point p = route->points[i];
+                Assert::IsTrue(city.streetRow[(int)p.row] || city.streetCol[(int)p.col]);
+                if (i > 0) {
+                    int moved = abs(p.row - route->points[i - 1].row) + abs(p.col - route->points[i - 1].col);
+                    Assert::AreEqual(1, moved);
+                }
+            }
+        }
+
+        startWorkload(&stream, &hotspots, &city.map);
+        for (int i = 0; i < 500; i++) {
+            struct Shipment s;
+            nextShipment(&stream, &city.map, &s);
+            Assert::IsTrue(isOpenSquare(&city.map, s.destination.row, s.destination.col) != 0);
+            Assert::IsTrue(s.weight >= 1 && s.weight <= 2000);
+        }
+    }
+};
+
+TEST_CLASS(WB_Snapshot)
+{
+public:
+    TEST_METHOD(WBT_071_Snapshot_RestoresMapIndexesAndNewestLoad)
+    {
+        static struct Snapshot snapshot;
+        static struct Truck trucks[3], restored[3];
+        struct Map map = populateMap();
+        struct Shipment s = { 800, 2, { 12, 11 } };
+        const char* path = "wbt071.snap";
+
+        loadBlueRoute(&trucks[0].route); loadGreenRoute(&trucks[1].route); loadYellowRoute(&trucks[2].route);
+        for (int i = 0; i < 3; i++) { trucks[i].truckNumber = i; indexRoute(&trucks[i]); }
+
+        Assert::AreEqual(1, snapshotCreate(path, &map, trucks, 3));
+        Assert::AreEqual(1, snapshotOpen(&snapshot, path, &map, trucks, 3));
+        for (int r = 0; r < MAP_ROWS; r++)
+            for (int c = 0; c < MAP_COLS; c++) Assert::AreEqual(map.squares[r][c], snapshot.image->map.squares[r][c]);
+        struct Point on = { 17, 11 };
+        Assert::IsTrue(trucksAtPoint(&snapshot.image->fleet, on) != 0);
+        static struct MoveTable moves;
+        buildMoveTable(&moves, &map);
+        for (int i = 0; i < MAP_ROWS * MAP_COLS; i++) Assert::IsTrue(moves.moves[i] == snapshot.image->moves.moves[i]);
+
+        // two more loads, so both slots have been written and the newest is read back
+        Assert::AreEqual(1, addShipmentToTruck(&trucks[1], &s));
+        Assert::AreEqual(1, snapshotSaveFleet(&snapshot, trucks, 3));
+        Assert::AreEqual(1, addShipmentToTruck(&trucks[1], &s));
+        Assert::AreEqual(1, snapshotSaveFleet(&snapshot, trucks, 3));
+        snapshotClose(&snapshot);
+
+        Assert::AreEqual(1, snapshotOpen(&snapshot, path, &map, trucks, 3));
+        Assert::AreEqual(3, snapshotLoadFleet(&snapshot, restored, 3));
+        snapshotClose(&snapshot);
+        remove(path);
+        Assert::AreEqual(2, restored[1].numShipments);
+        Assert::AreEqual(1600.0, restored[1].currentWeight, 0.0001);
+        Assert::AreEqual(1, isOnRoute(&restored[2], trucks[2].route.points[5]));
+    }
+
+    TEST_METHOD(WBT_072_Snapshot_DamageDetected)
+    {
+        static struct Snapshot snapshot;
+        static struct Truck trucks[1], restored[1];
+        struct Map map = populateMap();
+        struct Shipment s = { 100, 1, { 0, 0 } };
+        const char* path = "wbt072.snap";
+
+        loadBlueRoute(&trucks[0].route);
+        indexRoute(&trucks[0]);
+        Assert::AreEqual(1, snapshotCreate(path, &map, trucks, 1));
+        Assert::AreEqual(1, snapshotOpen(&snapshot, path, &map, trucks, 1));
+        Assert::AreEqual(1, addShipmentToTruck(&trucks[0], &s));
+        Assert::AreEqual(1, snapshotSaveFleet(&snapshot, trucks, 1));
+        long newestLoad = (long)((const char*)snapshot.load - (const char*)snapshot.image);
+        long moveTable = (long)((const char*)&snapshot.image->moves - (const char*)snapshot.image);
+        snapshotClose(&snapshot);
+
+        // a load torn part way through is passed over for the older whole one
+        FILE* file = fopen(path, "r+b");
+        Assert::IsTrue(file != NULL);
+        fseek(file, newestLoad + 40, SEEK_SET);
+        fputc(0x5a, file);
+        fclose(file);
+        Assert::AreEqual(1, snapshotOpen(&snapshot, path, &map, trucks, 1));
+        Assert::AreEqual(1, snapshotLoadFleet(&snapshot, restored, 1));
+        snapshotClose(&snapshot);
+        Assert::AreEqual(0, restored[0].numShipments);
+
+        // a change to the map or indexes makes the whole file unusable
+        file = fopen(path, "r+b");
+        Assert::IsTrue(file != NULL);
+        fseek(file, moveTable + 3, SEEK_SET);
+        fputc(0x5a, file);
+        fclose(file);
+        Assert::AreEqual(0, snapshotOpen(&snapshot, path, &map, trucks, 1));
+        remove(path);
+        Assert::AreEqual(0, snapshotOpen(&snapshot, path, &map, trucks, 1));
+    }
+
+    TEST_METHOD(WBT_084_Snapshot_OtherMapOrRoutesRefused)
+    {
+        static struct Snapshot snapshot;
+        static struct Truck trucks[2], moved[2];
+        struct Map map = populateMap();
+        struct Map built = populateMap();
+        const char* path = "wbt084.snap";
+
+        loadBlueRoute(&trucks[0].route); loadGreenRoute(&trucks[1].route);
+        for (int i = 0; i < 2; i++) { trucks[i].truckNumber = i; indexRoute(&trucks[i]); moved[i] = trucks[i]; }
+        Assert::AreEqual(1, snapshotCreate(path, &map, trucks, 2));
+
+        // a building put up since the snapshot was made
+        built.squares[0][0] = 1 - built.squares[0][0];
+        Assert::AreEqual(0, snapshotOpen(&snapshot, path, &built, trucks, 2));
+
+        // a route that changed, or one truck fewer
+        moved[1].route.numPoints--;
+        Assert::AreEqual(0, snapshotOpen(&snapshot, path, &map, moved, 2));
+        Assert::AreEqual(0, snapshotOpen(&snapshot, path, &map, trucks, 1));
+
+        Assert::AreEqual(1, snapshotOpen(&snapshot, path, &map, trucks, 2));
+        snapshotClose(&snapshot);
+        remove(path);
+    }
+};
+
+TEST_CLASS(WB_RouteSegments)
+{
+public:
+    TEST_METHOD(WBT_073_Segments_RoundTripInFewRuns)
+    {
+        static struct Route routes[3], expanded;
+        struct RouteSegment segments[MAX_ROUTE];
+        struct SegmentCursor cursor;
+        struct Point p;
+
+        loadBlueRoute(&routes[0]); loadGreenRoute(&routes[1]); loadYellowRoute(&routes[2]);
+        for (int r = 0; r < 3; r++) {
+            int n = compressRoute(&routes[r], segments, MAX_ROUTE);
+            Assert::IsTrue(n > 0 && n <= 8);
+            Assert::AreEqual(routes[r].numPoints, expandSegments(segments, n, &expanded));
+
+            int i = 0;
+            startSegmentCursor(&cursor, segments, n);
+            while (nextSegmentPoint(&cursor, &p)) {
+                Assert::IsTrue(eqPt(routes[r].points[i], p) != 0);
+                Assert::IsTrue(eqPt(expanded.points[i], p) != 0);
+                i++;
+            }
+            Assert::AreEqual(routes[r].numPoints, i);
+        }
+
+        // too little room, and a route of single points that jump about
+        Assert::AreEqual(-1, compressRoute(&routes[0], segments, 2));
+        struct Route jumpy = { { {3,3}, {3,3}, {10,1}, {8,5}, {6,9} }, 5, BLUE };
+        Assert::AreEqual(2, compressRoute(&jumpy, segments, MAX_ROUTE));
+        Assert::AreEqual(2, segments[0].length);
+        Assert::AreEqual(3, segments[1].length);
+    }
+
+    TEST_METHOD(WBT_074_Segments_QueriesMatchPointScan)
+    {
+        static struct Truck truck;
+        struct RouteSegment segments[MAX_ROUTE];
+        struct Route routes[3] = { getBlueRoute(), getGreenRoute(), getYellowRoute() };
+
+        for (int r = 0; r < 3; r++) {
+            int n = compressRoute(&routes[r], segments, MAX_ROUTE);
+            truck.route = routes[r];
+            indexRoute(&truck);
+            for (int row = 0; row < MAP_ROWS; row++) {
+                for (int col = 0; col < MAP_COLS; col++) {
+                    struct Point p = { (char)row, (char)col };
+                    Assert::AreEqual(getClosestPoint(&routes[r], p), getClosestPointOnSegments(segments, n, p));
+                    Assert::AreEqual(isOnRoute(&truck, p), isOnSegments(segments, n, p));
+                }
+            }
+        }
+        Assert::AreEqual(-1, getClosestPointOnSegments(segments, 0, routes[0].points[0]));
+    }
+
+    TEST_METHOD(WBT_075_Segments_TruckKeepsRunsForClosestPoint)
+    {
+        static struct Truck indexed, plain;
+        struct Point dest = { 17, 22 };
+
+        indexed.route = getGreenRoute();
+        plain.route = indexed.route;
+        indexRoute(&indexed);
+        Assert::AreEqual(6, indexed.numSegments);
+
+        for (int row = 0; row < MAP_ROWS; row++) {
+            for (int col = 0; col < MAP_COLS; col++) {
+                struct Point p = { (char)row, (char)col };
+                Assert::AreEqual(getClosestPoint(&indexed.route, p), getClosestRoutePoint(&indexed, p));
+                Assert::AreEqual(getClosestPoint(&indexed.route, p), getClosestRoutePoint(&plain, p));
+            }
+        }
+
+        // The same straight-line diversion with and without the runs
+        struct Map map = populateMap();
+        Assert::AreEqual(calculateRouteDistance(&plain, dest, &map), calculateRouteDistance(&indexed, dest, &map));
+        Assert::AreEqual(-1, getClosestRoutePoint(NULL, dest));
+    }
+};
+
+TEST_CLASS(WB_Simulation)
+{
+public:
+    TEST_METHOD(WBT_076_Simulation_TruckDrivesItsRouteInTime)
+    {
+        static struct Simulation sim;
+        static struct Truck trucks[1];
+        struct SimulationConfig config = { 8 * 3600, 0, 60, 85 };
+        struct Shipment preloaded = { 100, 2, { 0, 0 } };
+        int expected = config.departTime;
+
+        trucks[0].route = getBlueRoute();
+        indexRoute(&trucks[0]);
+        preloaded.destination = trucks[0].route.points[10];
+        addShipmentToTruck(&trucks[0], &preloaded);
+        for (int i = 1; i < trucks[0].route.numPoints; i++) {
+            int diagonal = trucks[0].route.points[i].row != trucks[0].route.points[i - 1].row
+                && trucks[0].route.points[i].col != trucks[0].route.points[i - 1].col;
+            expected += diagonal ? config.diagonalSeconds : config.straightSeconds;
+        }
+
+        Assert::AreEqual(1, startSimulation(&sim, trucks, 1, &config));
+        Assert::AreEqual((long)trucks[0].route.numPoints, runSimulation(&sim, 24 * 3600));
+        Assert::AreEqual(expected, sim.stats.lastArrival);
+        Assert::AreEqual(1, sim.stats.delivered);
+        Assert::AreEqual(-1, closestPointAhead(&sim, 0, trucks[0].route.points[0]));
+    }
+
+    TEST_METHOD(WBT_077_Simulation_OnlyRoutePointsAheadCount)
+    {
+        static struct Simulation sim;
+        static struct Truck trucks[2];
+        struct SimulationConfig config = { 8 * 3600, 3600, 60, 60 };
+        struct Shipment s = { 10, 0.5, { 0, 0 } };
+        int leave;
+
+        for (int t = 0; t < 2; t++) {
+            trucks[t].route = getBlueRoute();
+            trucks[t].truckNumber = t;
+            indexRoute(&trucks[t]);
+        }
+        Assert::AreEqual(1, startSimulation(&sim, trucks, 2, &config));
+
+        // Twenty minutes in the first truck has reached twenty-one points and the second has not set off
+        runSimulation(&sim, config.departTime + 20 * 60);
+        Assert::AreEqual(21, sim.next[0]);
+        Assert::AreEqual(0, sim.next[1]);
+        for (int row = 0; row < MAP_ROWS; row++) {
+            for (int col = 0; col < MAP_COLS; col++) {
+                struct Point p = { (char)row, (char)col };
+                Assert::AreEqual(21 + getClosestPointIn(&trucks[0].route.points[21], trucks[0].route.numPoints - 21, p), closestPointAhead(&sim, 0, p));
+            }
+        }
+
+        // The first truck is emptier, but it has already passed the destination
+        s.destination = trucks[0].route.points[5];
+        addShipmentToTruck(&trucks[1], &s);
+        struct DeliveryResult result = assignShipmentAhead(&sim, &s, &leave);
+        Assert::AreEqual(1, result.success);
+        Assert::AreEqual(1, result.truckIndex);
+        Assert::AreEqual(0, result.needsDiversion);
+        Assert::AreEqual(5, leave);
+
+        // Still ahead of it, so the emptier first truck takes it
+        s.destination = trucks[0].route.points[30];
+        result = assignShipmentAhead(&sim, &s, &leave);
+        Assert::AreEqual(0, result.truckIndex);
+        Assert::AreEqual(30, leave);
+    }
+};
+
+TEST_CLASS(WB_Backlog)
+{
+public:
+    TEST_METHOD(WBT_078_Backlog_SavesAndLoadsInAgeOrder)
+    {
+        static struct Backlog backlog;
+        struct Shipment s[3] = { { 12.5, 0.5, { 3, 7 } }, { 4999, 5, { 24, 24 } }, { 1, 2, { 0, 0 } } };
+        const char* path = "wbt078.backlog";
+
+        backlogInit(&backlog, 1);
+        Assert::AreEqual(1, backlogAdd(&backlog, &s[0]));
+        Assert::AreEqual(1, backlogAdd(&backlog, &s[1]));
+        Assert::AreEqual(1, backlogSave(&backlog, path));
+
+        // The next day adds one of its own behind the two carried over
+        Assert::AreEqual(1, backlogLoad(&backlog, path));
+        Assert::AreEqual(2, backlog.today);
+        Assert::AreEqual(1, backlogAdd(&backlog, &s[2]));
+        Assert::AreEqual(1, backlogSave(&backlog, path));
+
+        Assert::AreEqual(1, backlogLoad(&backlog, path));
+        Assert::AreEqual(3, backlog.today);
+        Assert::AreEqual(3, backlog.count);
+        for (int i = 0; i < 3; i++) {
+            Assert::AreEqual(s[i].weight, backlog.entries[i].shipment.weight);
+            Assert::AreEqual(s[i].volume, backlog.entries[i].shipment.volume);
+            Assert::IsTrue(eqPt(s[i].destination, backlog.entries[i].shipment.destination) != 0);
+        }
+        Assert::AreEqual(1, backlog.entries[0].day);
+        Assert::AreEqual(1, backlog.entries[1].day);
+        Assert::AreEqual(2, backlog.entries[2].day);
+
+        // Eight bytes a shipment behind the header
+        FILE* file = fopen(path, "r+b");
+        Assert::IsTrue(file != NULL);
+        fseek(file, 0, SEEK_END);
+        Assert::AreEqual((long)(BACKLOG_HEADER_SIZE + 3 * BACKLOG_RECORD_SIZE), ftell(file));
+
+        // A changed record fails the checksum, and the backlog starts empty
+        fseek(file, BACKLOG_HEADER_SIZE + BACKLOG_RECORD_SIZE + 5, SEEK_SET);
+        fputc(9, file);
+        fclose(file);
+        Assert::AreEqual(0, backlogLoad(&backlog, path));
+        Assert::AreEqual(0, backlog.count);
+        Assert::AreEqual(1, backlog.today);
+        remove(path);
+        Assert::AreEqual(0, backlogLoad(&backlog, path));
+    }
+
+    TEST_METHOD(WBT_079_Backlog_PlacesOldestFirstInBatches)
+    {
+        static struct Backlog backlog;
+        static struct Truck trucks[1];
+        struct Map map = populateMap();
+        struct Shipment s = { 3000, 0.5, { 0, 0 } };
+
+        useFleetIndex(NULL, NULL);
+        useCapacityIndex(NULL);
+        loadBlueRoute(&trucks[0].route);
+        indexRoute(&trucks[0]);
+        s.destination = trucks[0].route.points[4];
+
+        // Only the first of two 3000 kg shipments fits, then a 1500 kg one fits behind it
+        backlogInit(&backlog, 1);
+        backlogAdd(&backlog, &s);
+        s.weight = 2999;
+        backlogAdd(&backlog, &s);
+        s.weight = 1500;
+        backlogAdd(&backlog, &s);
+
+        Assert::AreEqual(2, assignBacklog(&backlog, trucks, 1, &map, 2));
+        Assert::AreEqual(1, assignBacklog(&backlog, trucks, 1, &map, 2));
+        Assert::AreEqual(0, assignBacklog(&backlog, trucks, 1, &map, 2));
+        Assert::AreEqual(2, backlog.placed);
+        Assert::AreEqual(1, backlog.count);
+        Assert::AreEqual(2999.0, backlog.entries[0].shipment.weight);
+        Assert::AreEqual(4500.0, trucks[0].currentWeight);
+
+        // With no room for the smallest box the rest is carried over untried, in the same order
+        s.weight = 500;
+        Assert::AreEqual(1, addShipmentToTruck(&trucks[0], &s));
+        backlogInit(&backlog, 2);
+        for (int i = 0; i < 5; i++) {
+            s.weight = 10 + i;
+            backlogAdd(&backlog, &s);
+        }
+        Assert::AreEqual(0, assignBacklog(&backlog, trucks, 1, &map, BACKLOG_BATCH));
+        Assert::AreEqual(5, backlog.count);
+        Assert::AreEqual(0, backlog.placed);
+        Assert::AreEqual(12.0, backlog.entries[2].shipment.weight);
+    }
+};
+
+TEST_CLASS(WB_IntakeBatch)
+{
+public:
+    TEST_METHOD(WBT_080_IntakeBatch_ChecksAndPlacesInOrder)
+    {
+        static struct Backlog backlog, saved;
+        static struct Truck trucks[1];
+        struct IntakeRecord records[4] = {};
+        struct Map map = populateMap();
+        const double weights[4] = { 3000, 0, 2999, 1500 };
+
+        useFleetIndex(NULL, NULL);
+        useCapacityIndex(NULL);
+        useIntakeSnapshot(NULL);
+        loadBlueRoute(&trucks[0].route);
+        indexRoute(&trucks[0]);
+        for (int i = 0; i < 4; i++) {
+            records[i].kind = INTAKE_SHIPMENT;
+            records[i].weight = weights[i];
+            records[i].volume = 0.5;
+            records[i].destination[0] = '1';
+            records[i].destination[1] = '6';
+            records[i].destination[2] = 'L';
+        }
+
+        Assert::AreEqual(1, checkIntake(&records[0], &map));
+        Assert::AreEqual(0, checkIntake(&records[1], &map));
+        Assert::AreEqual((int)INTAKE_REJECTED, (int)records[1].kind);
+        Assert::IsTrue(records[1].message != NULL);
+        Assert::AreEqual(1, checkIntake(&records[2], &map));
+        Assert::AreEqual(1, checkIntake(&records[3], &map));
+
+        // The second valid shipment no longer fits once the first is placed, and is carried over
+        // and saved straight away
+        backlogInit(&backlog, 1);
+        useIntakeBacklog(&backlog, "wbt080.backlog");
+        Assert::AreEqual(2, assignIntakeBatch(records, 4, trucks, 1, &map));
+        useIntakeBacklog(NULL, NULL);
+        Assert::AreEqual(1, backlogLoad(&saved, "wbt080.backlog"));
+        remove("wbt080.backlog");
+        Assert::AreEqual(1, saved.count);
+        Assert::AreEqual(2999.0, saved.entries[0].shipment.weight);
+        Assert::AreEqual(1, records[0].result.success);
+        Assert::AreEqual(0, records[2].result.success);
+        Assert::AreEqual(1, records[3].result.success);
+        Assert::AreEqual(1, backlog.count);
+        Assert::AreEqual(2999.0, backlog.entries[0].shipment.weight);
+        Assert::AreEqual(4500.0, trucks[0].currentWeight);
+    }
+};
+
+TEST_CLASS(WB_DestinationTable)
+{
+public:
+    TEST_METHOD(WBT_081_Destinations_OpenAndReachedFromARoute)
+    {
+        static struct DestinationTable table;
+        static struct Truck trucks[1];
+        struct Map map = populateMap();
+        struct Point building = { 12, 11 }, open = { 16, 11 }, walledIn = { 23, 8 }, offMap = { -1, 3 };
+
+        // Without a table a building is turned down, where it used to get through
+        useDestinationTable(NULL, NULL, NULL);
+        Assert::AreEqual(0, isValidDestination(&building, &map));
+        Assert::AreEqual(1, isValidDestination(&open, &map));
+        Assert::AreEqual(0, isValidDestination(&offMap, &map));
+
+        // Wall one open square in so no route can reach it
+        for (int dr = -1; dr <= 1; dr++) {
+            for (int dc = -1; dc <= 1; dc++) {
+                if (dr != 0 || dc != 0) map.squares[walledIn.row + dr][walledIn.col + dc] = 1;
+            }
+        }
+        loadBlueRoute(&trucks[0].route);
+        Assert::AreEqual(0, buildDestinationTable(&table, &map, trucks, 0));
+        Assert::IsTrue(buildDestinationTable(&table, &map, trucks, 1) > trucks[0].route.numPoints);
+        Assert::AreEqual(1, isDeliverable(&table, open));
+        Assert::AreEqual(0, isDeliverable(&table, building));
+        Assert::AreEqual(0, isDeliverable(&table, walledIn));
+        Assert::AreEqual(0, isDeliverable(&table, offMap));
+
+        useDestinationTable(&table, trucks, &map);
+        Assert::AreEqual(0, isValidDestination(&walledIn, &map));
+        Assert::AreEqual(1, isValidDestination(&open, &map));
+        useDestinationTable(NULL, NULL, NULL);
+        Assert::AreEqual(1, isValidDestination(&walledIn, &map));
+    }
+
+    TEST_METHOD(WBT_088_Destinations_FollowClosures)
+    {
+        static struct DestinationTable table;
+        static struct Map map;
+        struct Truck trucks[1] = { 0 };
+        struct DestinationWatch watch = { &table, trucks, 1 };
+        struct Point across = { 3, 20 };
+
+        // A wall down column 12 with one gap, and a route on the left of it
+        map.numRows = MAP_ROWS;
+        map.numCols = MAP_COLS;
+        for (int row = 0; row < MAP_ROWS; row++) {
+            map.squares[row][12] = row != 5;
+        }
+        for (int row = 0; row < 6; row++) {
+            struct Point p = { (char)row, 10 };
+            trucks[0].route.points[trucks[0].route.numPoints++] = p;
+        }
+        buildDestinationTable(&table, &map, trucks, 1);
+        addMapObserver(destinationMapObserver, &watch);
+        useDestinationTable(&table, trucks, &map);
+
+        Assert::AreEqual(1, isValidDestination(&across, &map));
+        setSquareBlocked(&map, 5, 12, 1);
+        Assert::AreEqual(0, isValidDestination(&across, &map));
+        setSquareBlocked(&map, 3, 10, 1);
+        Assert::AreEqual(0, isValidDestination(&trucks[0].route.points[3], &map));
+        setSquareBlocked(&map, 3, 10, 0);
+        setSquareBlocked(&map, 5, 12, 0);
+        Assert::AreEqual(1, isValidDestination(&across, &map));
+        Assert::AreEqual(1, isValidDestination(&trucks[0].route.points[3], &map));
+
+        useDestinationTable(NULL, NULL, NULL);
+        removeMapObserver(destinationMapObserver, &watch);
+    }
+
+    TEST_METHOD(WBT_085_Destinations_OnlyTrucksThatReachAreChosen)
+    {
+        static struct DestinationTable table;
+        static struct Map map;
+        struct Truck trucks[2] = { 0 };
+        struct Shipment s = { 10, 0.5, { 3, 13 } };
+
+        // A wall down column 12 with truck 0 just left of it and truck 1 further off to the right
+        map.numRows = MAP_ROWS;
+        map.numCols = MAP_COLS;
+        for (int row = 0; row < MAP_ROWS; row++) {
+            map.squares[row][12] = 1;
+        }
+        for (int t = 0; t < 2; t++) {
+            trucks[t].truckNumber = t;
+            for (int row = 0; row < 6; row++) {
+                struct Point p = { (char)row, (char)(t == 0 ? 11 : 20) };
+                trucks[t].route.points[trucks[t].route.numPoints++] = p;
+            }
+        }
+        buildDestinationTable(&table, &map, trucks, 2);
+        Assert::AreEqual(2u, trucksReaching(&table, s.destination));
+        Assert::AreEqual(1u, trucksReaching(&table, trucks[0].route.points[2]));
+
+        // Truck 0 is closer in a straight line but cannot get round the wall, whichever way the shipment is placed
+        static struct FleetShards shards;
+        buildFleetShards(&shards, trucks, 2, 2);
+        useFleetIndex(NULL, NULL);
+        useCapacityIndex(NULL);
+        useDestinationTable(&table, trucks, &map);
+        struct DeliveryResult results[3];
+        results[0] = assignShipment(trucks, 2, &s, &map);
+        results[1] = assignMinDiversion(trucks, 2, &s, &map);
+        results[2] = assignShipmentSharded(NULL, &shards, trucks, 2, &s, &map);
+        useDestinationTable(NULL, NULL, NULL);
+        for (int k = 0; k < 3; k++) {
+            Assert::AreEqual(1, results[k].truckIndex);
+            Assert::AreEqual(1, results[k].success);
+        }
+        Assert::AreEqual(3, trucks[1].numShipments);
+    }
+};
+
+TEST_CLASS(WB_CourseTables)
+{
+public:
+    TEST_METHOD(WBT_082_CourseTables_MatchTablesBuiltAtRunTime)
+    {
+        static struct Truck trucks[3];
+        static struct MoveTable moves;
+        static struct FleetIndex fleet;
+        static struct DestinationTable destinations;
+        const struct Map* map = getCourseMap();
+        struct Map copy = populateMap();
+
+        // What the generator was run on must not have changed since
+        loadBlueRoute(&trucks[0].route);
+        loadGreenRoute(&trucks[1].route);
+        loadYellowRoute(&trucks[2].route);
+        for (int t = 0; t < 3; t++) {
+            trucks[t].truckNumber = t;
+            indexRoute(&trucks[t]);
+        }
+        buildMoveTable(&moves, map);
+        buildFleetIndex(&fleet, trucks, 3);
+        buildDestinationTable(&destinations, map, trucks, 3);
+
+        Assert::AreEqual(3, courseFleet.numTrucks);
+        Assert::AreEqual(3, courseDestinations.numTrucks);
+        for (int row = 0; row < MAP_ROWS; row++) {
+            for (int col = 0; col < MAP_COLS; col++) {
+                int cell = row * MAP_COLS + col;
+                Assert::AreEqual(map->squares[row][col], copy.squares[row][col]);
+                Assert::AreEqual((int)moves.moves[cell], (int)courseMoves.moves[cell]);
+                Assert::AreEqual(fleet.trucksAt[row][col], courseFleet.trucksAt[row][col]);
+                Assert::AreEqual(destinations.reachedBy[cell], courseDestinations.reachedBy[cell]);
+            }
+        }
+
+        for (int t = 0; t < 3; t++) {
+            const struct Truck* built = &courseTrucks[t];
+            Assert::AreEqual(t, built->truckNumber);
+            Assert::AreEqual(0, built->numShipments);
+            Assert::AreEqual(0.0, built->currentWeight);
+            Assert::AreEqual((int)trucks[t].route.routeSymbol, (int)built->route.routeSymbol);
+            Assert::AreEqual(trucks[t].route.numPoints, built->route.numPoints);
+            for (int i = 0; i < built->route.numPoints; i++) {
+                Assert::IsTrue(eqPt(trucks[t].route.points[i], built->route.points[i]) != 0);
+            }
+            Assert::AreEqual(1, built->routeIndexed);
+            for (int i = 0; i < ROUTE_MAP_WORDS; i++) {
+                Assert::AreEqual(trucks[t].routeCells[i], built->routeCells[i]);
+            }
+            Assert::AreEqual(trucks[t].numSegments, built->numSegments);
+            for (int i = 0; i < built->numSegments; i++) {
+                Assert::IsTrue(eqPt(trucks[t].segments[i].start, built->segments[i].start) != 0);
+                Assert::AreEqual((int)trucks[t].segments[i].rowStep, (int)built->segments[i].rowStep);
+                Assert::AreEqual((int)trucks[t].segments[i].colStep, (int)built->segments[i].colStep);
+                Assert::AreEqual(trucks[t].segments[i].length, built->segments[i].length);
+            }
+        }
+    }
+};
@@ -0,0 +1,887 @@
+/*
+* Purpose: Differential test of the fast routing and assignment code against slow reference versions
+*          that are easy to check by eye: a plain breadth first search for path lengths and a brute
+*          force pass over the fleet for the assignShipment() rules. Each case is a random map, fleet
+*          and list of shipments made from its own seed. A case that disagrees with the reference is
+*          shrunk, one small change at a time, for as long as the same check keeps failing, and the
+*          smallest failing case is printed.
+*
+* Build and run from this folder with
+*   gcc -O2 -I../SourceCode difftest.c ../SourceCode/mapping.c ../SourceCode/MS3Functions.c
+*       ../SourceCode/pathing.c ../SourceCode/hpa.c ../SourceCode/roadgraph.c ../SourceCode/mapupdate.c
+*       ../SourceCode/assignpolicy.c ../SourceCode/fleetscore.c ../SourceCode/workpool.c
+*       ../SourceCode/shardassign.c ../SourceCode/citygen.c ../SourceCode/segments.c
+*       -lm -pthread -o difftest
+*   ./difftest [cases] [first seed] [-planted]
+* It is not part of the Tests project. Case k uses seed first seed + k, so "./difftest 1 <seed>" runs a
+* failing case again on its own. -planted also checks assignWeightFirst(), which follows different rules
+* on purpose, to see a failure found and shrunk. The exit status is 1 if any case fails.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "MS3FunctionSpecs.h"
+#include "assignpolicy.h"
+#include "citygen.h"
+#include "hpa.h"
+#include "roadgraph.h"
+#include "segments.h"
+#include "shardassign.h"
+
+#define MAX_CASE_SHIPMENTS 24
+#define NUM_SHARDS 4
+#define POOL_THREADS 2
+
+/**
+ * One random case: a map, two points to find paths between, a fleet and the shipments given to it
+ */
+struct DiffCase {
+    unsigned int seed;
+    struct Map map;
+    struct Point start;
+    struct Point dest;
+    int numTrucks;
+    struct Truck trucks[MAX_FLEET];
+    int numShipments;
+    struct Shipment shipments[MAX_CASE_SHIPMENTS];
+};
+
+/**
+ * The first check a case failed and what was different
+ */
+struct Failure {
+    char check[64];
+    char detail[256];
+};
+
+enum AssignEngine {
+    ASSIGN_PLAIN,
+    ASSIGN_INDEXED,
+    ASSIGN_POLICY,
+    ASSIGN_SHARDED,
+    ASSIGN_SHARDED_POOL,
+    ASSIGN_PLANTED,
+    NUM_ASSIGN_ENGINES
+};
+
+static const char* assignNames[NUM_ASSIGN_ENGINES] = {
+    "assignShipment",
+    "assignShipment with fleet and capacity indexes",
+    "assignMinDiversion",
+    "assignShipmentSharded",
+    "assignShipmentSharded on a pool",
+    "assignWeightFirst (planted)"
+};
+
+// Engines that always return a shortest path, checked against the reference length
+static const enum PathEngine exactEngines[] = { PATH_ASTAR, PATH_JPS, PATH_BFS, PATH_BIDIRECTIONAL, PATH_CONTRACTED };
+static const char* exactNames[] = { "astar", "jps", "bfs", "bidirectional", "contracted" };
+#define NUM_EXACT_ENGINES ((int)(sizeof(exactEngines) / sizeof(exactEngines[0])))
+
+static struct DiffCase current;
+static struct DiffCase trial;
+static struct Truck oracleFleet[MAX_FLEET];
+static struct Truck engineFleet[MAX_FLEET];
+static struct DeliveryResult expected[MAX_CASE_SHIPMENTS];
+static struct MoveTable moveTable;
+static struct HpaIndex hpa;
+static struct RoadIndex roads;
+static struct FleetIndex fleetIndex;
+static struct CapacityIndex capacity;
+static struct FleetShards shards;
+static struct WorkPool pool;
+static int poolStarted = 0;
+static int planted = 0;
+static long numComparisons = 0;
+
+static int fail(struct Failure* failure, const char* check, const char* format, ...) {
+    va_list args;
+
+    snprintf(failure->check, sizeof(failure->check), "%s", check);
+    va_start(args, format);
+    vsnprintf(failure->detail, sizeof(failure->detail), format, args);
+    va_end(args);
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------------------------- */
+/* The reference versions                                                                          */
+/* ---------------------------------------------------------------------------------------------- */
+
+static int openSquare(const struct Map* map, int row, int col) {
+    return row >= 0 && row < map->numRows && col >= 0 && col < map->numCols && map->squares[row][col] != 1;
+}
+
+static int samePoint(struct Point a, struct Point b) {
+    return a.row == b.row && a.col == b.col;
+}
+
+/*
+* Plain breadth first search over the 8-connected grid, every move costing 1. Returns the fewest moves
+* from any of the open sources to dest, or -1 if dest cannot be reached.
+*/
+static int oracleDistance(const struct Map* map, const struct Point sources[], int numSources, struct Point dest) {
+    static int dist[MAP_ROWS][MAP_COLS];
+    static struct Point queue[MAP_ROWS * MAP_COLS];
+    int head = 0, tail = 0;
+
+    for (int r = 0; r < MAP_ROWS; r++) {
+        for (int c = 0; c < MAP_COLS; c++) {
+            dist[r][c] = -1;
+        }
+    }
+    for (int i = 0; i < numSources; i++) {
+        if (openSquare(map, sources[i].row, sources[i].col) && dist[(int)sources[i].row][(int)sources[i].col] < 0) {
+            dist[(int)sources[i].row][(int)sources[i].col] = 0;
+            queue[tail++] = sources[i];
+        }
+    }
+    while (head < tail) {
+        struct Point p = queue[head++];
+
+        if (samePoint(p, dest)) {
+            return dist[(int)p.row][(int)p.col];
+        }
+        for (int dr = -1; dr <= 1; dr++) {
+            for (int dc = -1; dc <= 1; dc++) {
+                int row = p.row + dr, col = p.col + dc;
+
+                if ((dr != 0 || dc != 0) && openSquare(map, row, col) && dist[row][col] < 0) {
+                    dist[row][col] = dist[(int)p.row][(int)p.col] + 1;
+                    queue[tail].row = (char)row;
+                    queue[tail].col = (char)col;
+                    tail++;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+// The number of points findPath() returns for a shortest path of this many moves
+static int routeLength(int moves) {
+    return (moves > 0 && moves <= MAX_ROUTE) ? moves : 0;
+}
+
+// The first route point closest to dest in a straight line, as the diversion leaves from
+static int oracleClosest(const struct Route* route, struct Point dest) {
+    int best = -1, bestSquared = 0;
+
+    for (int i = 0; i < route->numPoints; i++) {
+        int dr = route->points[i].row - dest.row, dc = route->points[i].col - dest.col;
+
+        if (best < 0 || dr * dr + dc * dc < bestSquared) {
+            best = i;
+            bestSquared = dr * dr + dc * dc;
+        }
+    }
+    return best;
+}
+
+/*
+* The diversion rule of calculateRouteDistance(): 0 on the route, otherwise the moves from the route
+* when the road index is in use or the straight line distance from the closest point when it is not,
+* and -1 if that is more than 10.
+*/
+static double oracleDiversion(const struct Truck* truck, struct Point dest, const struct Map* map, int byRoad) {
+    double best = -1.0;
+
+    for (int i = 0; i < truck->route.numPoints; i++) {
+        if (samePoint(truck->route.points[i], dest)) {
+            return 0.0;
+        }
+    }
+    if (byRoad) {
+        int moves = oracleDistance(map, truck->route.points, truck->route.numPoints, dest);
+        return (moves < 0 || moves > 10) ? -1.0 : (double)moves;
+    }
+    for (int i = 0; i < truck->route.numPoints; i++) {
+        int dr = dest.row - truck->route.points[i].row, dc = dest.col - truck->route.points[i].col;
+        double straight = sqrt((double)(dr * dr + dc * dc));
+
+        if (best < 0 || straight < best) {
+            best = straight;
+        }
+    }
+    return (best < 0 || best > 10.0) ? -1.0 : best;
+}
+
+/*
+* The assignShipment() rules by brute force: score every truck that fits and can reach the destination,
+* then take the one with the smallest (diversion, -capacity left, truck number, position). With a
+* destination table in use a truck whose route has no open path to the destination cannot take it
+* however close it is. The capacity arithmetic is the spec's own canFitShipment(), capacityLeftShare()
+* and addShipmentToTruck(); what is checked is which truck the fast versions pick.
+*/
+static struct DeliveryResult oracleAssign(struct Truck trucks[], int numTrucks, const struct Shipment* s,
+    const struct Map* map, int byRoad, int byTable) {
+    struct DeliveryResult result = { 0, -1, 0, 0.0 };
+    double diversion[MAX_FLEET];
+    int share[MAX_FLEET];
+    int best = -1;
+
+    for (int i = 0; i < numTrucks; i++) {
+        diversion[i] = oracleDiversion(&trucks[i], s->destination, map, byRoad);
+        if (byTable && oracleDistance(map, trucks[i].route.points, trucks[i].route.numPoints, s->destination) < 0) {
+            diversion[i] = -1.0;
+        }
+        share[i] = capacityLeftShare(&trucks[i]);
+    }
+    for (int i = 0; i < numTrucks; i++) {
+        if (diversion[i] < 0 || !canFitShipment(&trucks[i], s)) {
+            continue;
+        }
+        if (best < 0
+            || diversion[i] < diversion[best]
+            || (diversion[i] == diversion[best] && share[i] > share[best])
+            || (diversion[i] == diversion[best] && share[i] == share[best] && trucks[i].truckNumber < trucks[best].truckNumber)) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        result.truckIndex = best;
+        result.distanceToGo = diversion[best];
+        result.needsDiversion = diversion[best] > 0.01;
+        result.success = addShipmentToTruck(&trucks[best], s);
+    }
+    return result;
+}
+
+/* ---------------------------------------------------------------------------------------------- */
+/* The checks                                                                                      */
+/* ---------------------------------------------------------------------------------------------- */
+
+// True if path is a walk of single moves over open squares from just after start to dest
+static int isWalk(const struct Map* map, struct Point start, struct Point dest, const struct Route* path) {
+    struct Point at = start;
+
+    for (int i = 0; i < path->numPoints; i++) {
+        struct Point next = path->points[i];
+
+        if (abs(next.row - at.row) > 1 || abs(next.col - at.col) > 1 || samePoint(next, at)
+            || !openSquare(map, next.row, next.col)) {
+            return 0;
+        }
+        at = next;
+    }
+    return path->numPoints == 0 || samePoint(at, dest);
+}
+
+static int checkPaths(const struct DiffCase* c, struct Failure* failure) {
+    struct Route path;
+    int moves = oracleDistance(&c->map, &c->start, 1, c->dest);
+    int length, n;
+
+    for (int table = 0; table < 2; table++) {
+        const char* suffix = table ? " with move table" : "";
+        char check[64];
+
+        useMoveTable(table ? &moveTable : NULL, &c->map);
+        for (int e = 0; e < NUM_EXACT_ENGINES; e++) {
+            if (exactEngines[e] == PATH_CONTRACTED && !roads.complete) {
+                continue;
+            }
+            snprintf(check, sizeof(check), "%s%s", exactNames[e], suffix);
+            n = findPathInto(&c->map, c->start, c->dest, exactEngines[e], &path);
+            numComparisons++;
+            if (n != routeLength(moves) || path.numPoints != n) {
+                return fail(failure, check, "%d points, the shortest path has %d moves", n, moves);
+            }
+            if (!isWalk(&c->map, c->start, c->dest, &path)) {
+                return fail(failure, check, "the path is not a walk of single moves over open squares to the destination");
+            }
+        }
+
+        snprintf(check, sizeof(check), "greedy%s", suffix);
+        findPathInto(&c->map, c->start, c->dest, PATH_GREEDY, &path);
+        numComparisons++;
+        if (!isWalk(&c->map, c->start, c->dest, &path)) {
+            return fail(failure, check, "the path is not a walk of single moves over open squares to the destination");
+        }
+
+        // Not always shortest, but never shorter, never missing a path that exists, and as long as its length says
+        snprintf(check, sizeof(check), "hierarchical%s", suffix);
+        length = hpaPathLength(&hpa, &c->map, c->start, c->dest);
+        n = findPathInto(&c->map, c->start, c->dest, PATH_HIERARCHICAL, &path);
+        numComparisons++;
+        if ((length < 0) != (moves < 0) || length < moves) {
+            return fail(failure, check, "hpaPathLength() is %d, the shortest path has %d moves", length, moves);
+        }
+        if (n != routeLength(length) || !isWalk(&c->map, c->start, c->dest, &path)) {
+            return fail(failure, check, "%d points, hpaPathLength() is %d", n, length);
+        }
+    }
+    useMoveTable(NULL, NULL);
+
+    if (roads.complete) {
+        numComparisons++;
+        length = roadDistance(&roads, c->start, c->dest);
+        if (length != moves) {
+            return fail(failure, "roadDistance", "%d moves, the shortest path has %d", length, moves);
+        }
+    }
+    return 1;
+}
+
+// The run form of a route gives back its points and answers the same as a scan of them
+static int checkSegments(int t, const struct Route* route, struct Point dest, int closest, struct Failure* failure) {
+    struct RouteSegment segments[MAX_ROUTE];
+    struct Route expanded;
+    int n, onRoute = 0;
+
+    n = compressRoute(route, segments, MAX_ROUTE);
+    if (n < 0 || expandSegments(segments, n, &expanded) != route->numPoints) {
+        return fail(failure, "route segments", "truck %d: %d runs do not give back %d points", t, n, route->numPoints);
+    }
+    for (int i = 0; i < route->numPoints; i++) {
+        onRoute = onRoute || samePoint(route->points[i], dest);
+        if (!samePoint(route->points[i], expanded.points[i])) {
+            return fail(failure, "route segments", "truck %d: point %d differs once expanded", t, i);
+        }
+    }
+    if (getClosestPointOnSegments(segments, n, dest) != closest || isOnSegments(segments, n, dest) != onRoute) {
+        return fail(failure, "route segments", "truck %d: closest point %d and on route %d, a scan gives %d and %d", t,
+            getClosestPointOnSegments(segments, n, dest), isOnSegments(segments, n, dest), closest, onRoute);
+    }
+    return 1;
+}
+
+static int checkDiversions(const struct DiffCase* c, struct Failure* failure) {
+    struct Route path;
+    int n, moves, length, leave;
+
+    for (int t = 0; t < c->numTrucks; t++) {
+        const struct Route* route = &c->trucks[t].route;
+
+        leave = oracleClosest(route, c->dest);
+        numComparisons++;
+        if (!checkSegments(t, route, c->dest, leave, failure)) {
+            return 0;
+        }
+        moves = leave < 0 ? -1 : oracleDistance(&c->map, &route->points[leave], 1, c->dest);
+
+        useHpaIndex(NULL);
+        n = findDiversionInto(&c->map, route, c->dest, &path);
+        numComparisons++;
+        if (n != routeLength(moves) || (n > 0 && !isWalk(&c->map, route->points[leave], c->dest, &path))) {
+            return fail(failure, "findDiversion", "truck %d: %d points, the shortest diversion has %d moves", t, n, moves);
+        }
+
+        useHpaIndex(&hpa);
+        n = findDiversionInto(&c->map, route, c->dest, &path);
+        useHpaIndex(NULL);
+        numComparisons++;
+        if ((n > 0 && (n < moves || !isWalk(&c->map, route->points[leave], c->dest, &path))) || (n == 0 && moves > 0 && moves <= MAX_ROUTE && hpaPathLength(&hpa, &c->map, route->points[leave], c->dest) <= MAX_ROUTE)) {
+            return fail(failure, "findDiversion with HPA index", "truck %d: %d points, the shortest diversion has %d moves", t, n, moves);
+        }
+
+        if (roads.complete) {
+            numComparisons++;
+            length = roadDistanceFromRoute(&roads, route, c->dest);
+            moves = oracleDistance(&c->map, route->points, route->numPoints, c->dest);
+            if (length != moves) {
+                return fail(failure, "roadDistanceFromRoute", "truck %d: %d moves, the closest route point is %d moves away", t, length, moves);
+            }
+        }
+    }
+    return 1;
+}
+
+// A truck can deliver to a square when its route reaches it over open squares
+static int checkDestinations(const struct DiffCase* c, struct Failure* failure) {
+    static struct DestinationTable table;
+    struct Point p;
+    unsigned int reachedBy;
+    int reached;
+
+    buildDestinationTable(&table, &c->map, c->trucks, c->numTrucks);
+    for (int i = -2; i < c->numShipments; i++) {
+        p = i == -2 ? c->start : (i == -1 ? c->dest : c->shipments[i].destination);
+        reachedBy = 0;
+        for (int t = 0; t < c->numTrucks; t++) {
+            if (oracleDistance(&c->map, c->trucks[t].route.points, c->trucks[t].route.numPoints, p) >= 0) {
+                reachedBy |= 1u << t;
+            }
+        }
+        reached = reachedBy != 0;
+        numComparisons += 2;
+        if (trucksReaching(&table, p) != reachedBy) {
+            return fail(failure, "trucksReaching", "square %d%c: %#x, reachable from routes %#x", p.row, 'A' + p.col, trucksReaching(&table, p), reachedBy);
+        }
+        if (isDeliverable(&table, p) != reached) {
+            return fail(failure, "isDeliverable", "square %d%c: %d, reachable from a route %d", p.row, 'A' + p.col, isDeliverable(&table, p), reached);
+        }
+    }
+    return 1;
+}
+
+static struct DeliveryResult runEngine(enum AssignEngine engine, struct Truck trucks[], int numTrucks,
+    const struct Shipment* s, const struct Map* map) {
+    switch (engine) {
+    case ASSIGN_POLICY:
+        return assignMinDiversion(trucks, numTrucks, s, map);
+    case ASSIGN_SHARDED:
+        return assignShipmentSharded(NULL, &shards, trucks, numTrucks, s, map);
+    case ASSIGN_SHARDED_POOL:
+        return assignShipmentSharded(poolStarted ? &pool : NULL, &shards, trucks, numTrucks, s, map);
+    case ASSIGN_PLANTED:
+        return assignWeightFirst(trucks, numTrucks, s, map);
+    default:
+        return assignShipment(trucks, numTrucks, s, map);
+    }
+}
+
+static int checkAssignments(const struct DiffCase* c, struct Failure* failure) {
+    static struct DestinationTable destinations;
+
+    for (int run = 0; run < 2 * (roads.complete + 1); run++) {
+        int byRoad = run / 2, byTable = run % 2;
+
+        useRoadIndex(byRoad ? &roads : NULL);
+
+        for (int t = 0; t < c->numTrucks; t++) {
+            oracleFleet[t] = c->trucks[t];
+            indexRoute(&oracleFleet[t]);
+        }
+        for (int k = 0; k < c->numShipments; k++) {
+            expected[k] = oracleAssign(oracleFleet, c->numTrucks, &c->shipments[k], &c->map, byRoad, byTable);
+        }
+
+        for (int e = 0; e < NUM_ASSIGN_ENGINES; e++) {
+            char check[96];
+
+            if (e == ASSIGN_PLANTED && !planted) {
+                continue;
+            }
+            snprintf(check, sizeof(check), "%s%s%s", assignNames[e], byRoad ? " with road index" : "",
+                byTable ? " with destination table" : "");
+            for (int t = 0; t < c->numTrucks; t++) {
+                engineFleet[t] = c->trucks[t];
+                indexRoute(&engineFleet[t]);
+            }
+            if (e == ASSIGN_INDEXED) {
+                buildFleetIndex(&fleetIndex, engineFleet, c->numTrucks);
+                useFleetIndex(&fleetIndex, engineFleet);
+                buildCapacityIndex(&capacity, engineFleet, c->numTrucks);
+                useCapacityIndex(&capacity);
+            }
+            if (byTable) {
+                buildDestinationTable(&destinations, &c->map, engineFleet, c->numTrucks);
+                useDestinationTable(&destinations, engineFleet, &c->map);
+            }
+            buildFleetShards(&shards, engineFleet, c->numTrucks, NUM_SHARDS);
+
+            for (int k = 0; k < c->numShipments; k++) {
+                struct DeliveryResult got = runEngine((enum AssignEngine)e, engineFleet, c->numTrucks, &c->shipments[k], &c->map);
+
+                numComparisons++;
+                if (got.success != expected[k].success || got.truckIndex != expected[k].truckIndex
+                    || got.needsDiversion != expected[k].needsDiversion || got.distanceToGo != expected[k].distanceToGo) {
+                    useFleetIndex(NULL, NULL);
+                    useCapacityIndex(NULL);
+                    useDestinationTable(NULL, NULL, NULL);
+                    useRoadIndex(NULL);
+                    return fail(failure, check, "shipment %d: got {%d, %d, %d, %g}, expected {%d, %d, %d, %g}", k,
+                        got.success, got.truckIndex, got.needsDiversion, got.distanceToGo,
+                        expected[k].success, expected[k].truckIndex, expected[k].needsDiversion, expected[k].distanceToGo);
+                }
+            }
+            useFleetIndex(NULL, NULL);
+            useCapacityIndex(NULL);
+            useDestinationTable(NULL, NULL, NULL);
+
+            for (int t = 0; t < c->numTrucks; t++) {
+                if (engineFleet[t].numShipments != oracleFleet[t].numShipments
+                    || engineFleet[t].currentWeight != oracleFleet[t].currentWeight
+                    || engineFleet[t].currentVolume != oracleFleet[t].currentVolume) {
+                    useRoadIndex(NULL);
+                    return fail(failure, check, "truck %d ends with %d shipments, %g kg, %g m3; expected %d, %g kg, %g m3", t,
+                        engineFleet[t].numShipments, engineFleet[t].currentWeight, engineFleet[t].currentVolume,
+                        oracleFleet[t].numShipments, oracleFleet[t].currentWeight, oracleFleet[t].currentVolume);
+                }
+            }
+        }
+    }
+    useRoadIndex(NULL);
+    return 1;
+}
+
+/*
+* Run every check on a case, building the indexes for its map first. Returns 1 if everything agrees
+* with the reference, otherwise 0 with the first disagreement in failure.
+*/
+static int checkCase(const struct DiffCase* c, struct Failure* failure) {
+    buildMoveTable(&moveTable, &c->map);
+    hpaBuild(&hpa, &c->map);
+    roadBuild(&roads, &c->map);
+    useHpaIndex(&hpa);
+    useRoadIndex(roads.complete ? &roads : NULL);
+
+    int ok = checkPaths(c, failure);
+
+    useHpaIndex(NULL);
+    useRoadIndex(NULL);
+    ok = ok && checkDiversions(c, failure) && checkDestinations(c, failure) && checkAssignments(c, failure);
+    return ok;
+}
+
+/* ---------------------------------------------------------------------------------------------- */
+/* Making and shrinking cases                                                                      */
+/* ---------------------------------------------------------------------------------------------- */
+
+static struct Point randomOpenSquare(const struct Map* map, struct CityRandom* random) {
+    struct Point p = { 0, 0 };
+
+    for (int tries = 0; tries < 1000; tries++) {
+        p.row = (char)cityRandomBelow(random, map->numRows);
+        p.col = (char)cityRandomBelow(random, map->numCols);
+        if (openSquare(map, p.row, p.col)) {
+            break;
+        }
+    }
+    return p;
+}
+
+// A route that wanders over open squares one move at a time, sometimes crossing itself
+static void randomWalk(struct Route* route, const struct Map* map, int length, struct CityRandom* random) {
+    struct Point at = randomOpenSquare(map, random);
+
+    route->numPoints = 0;
+    addPtToRoute(route, at);
+    while (route->numPoints < length) {
+        struct Point next = at;
+        int tries;
+
+        for (tries = 0; tries < 16; tries++) {
+            next.row = (char)(at.row + cityRandomBelow(random, 3) - 1);
+            next.col = (char)(at.col + cityRandomBelow(random, 3) - 1);
+            if (!samePoint(next, at) && openSquare(map, next.row, next.col)) {
+                break;
+            }
+        }
+        if (tries == 16) {
+            break;
+        }
+        addPtToRoute(route, next);
+        at = next;
+    }
+}
+
+/*
+* A load chosen to land on the edges of the capacity rules: empty, partly full, within a few grams or
+* half cubic metres of full, or one shipment short of MAX_SHIPMENTS.
+*/
+static void randomLoad(struct Truck* truck, struct CityRandom* random) {
+    int grams = 0, units = 0;
+
+    switch (cityRandomBelow(random, 4)) {
+    case 1:
+        grams = cityRandomBelow(random, MAX_WEIGHT_G + 1);
+        units = cityRandomBelow(random, MAX_VOLUME_UNITS + 1);
+        break;
+    case 2:
+        grams = MAX_WEIGHT_G - cityRandomBelow(random, 3 * GRAMS_PER_KG);
+        units = MAX_VOLUME_UNITS - cityRandomBelow(random, 12);
+        break;
+    case 3:
+        truck->numShipments = MAX_SHIPMENTS - 1 - cityRandomBelow(random, 2);
+        break;
+    }
+    truck->currentWeight = (double)grams / GRAMS_PER_KG;
+    truck->currentVolume = (double)units / VOLUME_UNITS_PER_M3;
+}
+
+static void randomCase(struct DiffCase* c, unsigned int seed) {
+    static struct City city;
+    static const double volumes[3] = { 0.5, 2.0, 5.0 };
+    struct CityRandom random;
+    struct Truck empty = { 0 };
+    int rows, cols, street;
+
+    seedCityRandom(&random, seed);
+    c->seed = seed;
+    rows = 1 + cityRandomBelow(&random, MAP_ROWS);
+    cols = 1 + cityRandomBelow(&random, MAP_COLS);
+    street = cityRandomBelow(&random, 2);
+
+    if (street) {
+        struct CityConfig config = { rows, cols, 2 + cityRandomBelow(&random, 5), cityRandomBelow(&random, 3),
+            1 + cityRandomBelow(&random, 2), cityRandomBelow(&random, 100), seed };
+
+        generateCity(&city, &config);
+        c->map = city.map;
+    }
+    else {
+        int percent = cityRandomBelow(&random, 50);
+
+        c->map.numRows = rows;
+        c->map.numCols = cols;
+        for (int r = 0; r < MAP_ROWS; r++) {
+            for (int col = 0; col < MAP_COLS; col++) {
+                c->map.squares[r][col] = r < rows && col < cols && cityRandomBelow(&random, 100) < percent;
+            }
+        }
+        c->map.squares[0][0] = 0;   // at least one open square
+    }
+    c->start = randomOpenSquare(&c->map, &random);
+    c->dest = cityRandomBelow(&random, 8) == 0 ? c->start : randomOpenSquare(&c->map, &random);
+
+    // Small fleets with repeated truck numbers make ties likely
+    c->numTrucks = cityRandomBelow(&random, 2) ? 1 + cityRandomBelow(&random, 4) : 1 + cityRandomBelow(&random, MAX_FLEET);
+    for (int t = 0; t < c->numTrucks; t++) {
+        int length = 1 + cityRandomBelow(&random, MAX_ROUTE);
+
+        c->trucks[t] = empty;
+        if (street) {
+            generateRoute(&c->trucks[t].route, &city, length, BLUE, &random);
+        }
+        else {
+            randomWalk(&c->trucks[t].route, &c->map, length, &random);
+        }
+        c->trucks[t].route.routeSymbol = BLUE;
+        c->trucks[t].truckNumber = cityRandomBelow(&random, 4);
+        randomLoad(&c->trucks[t], &random);
+    }
+
+    c->numShipments = 1 + cityRandomBelow(&random, MAX_CASE_SHIPMENTS);
+    for (int k = 0; k < c->numShipments; k++) {
+        struct Shipment* s = &c->shipments[k];
+
+        // Whole kilograms, odd grams, or enough to fill a truck to within a gram
+        switch (cityRandomBelow(&random, 3)) {
+        case 0:
+            s->weight = 1 + cityRandomBelow(&random, 50);
+            break;
+        case 1:
+            s->weight = (1 + cityRandomBelow(&random, 2000000)) / 1000.0;
+            break;
+        default:
+            s->weight = MAX_WEIGHT - cityRandomBelow(&random, 3) + (cityRandomBelow(&random, 3) - 1) / 1000.0;
+            break;
+        }
+        s->volume = volumes[cityRandomBelow(&random, 3)];
+        if (cityRandomBelow(&random, 10) == 0) {
+            s->destination.row = (char)cityRandomBelow(&random, c->map.numRows);
+            s->destination.col = (char)cityRandomBelow(&random, c->map.numCols);
+        }
+        else if (c->numTrucks > 0 && c->trucks[0].route.numPoints > 0 && cityRandomBelow(&random, 4) == 0) {
+            const struct Route* route = &c->trucks[cityRandomBelow(&random, c->numTrucks)].route;
+            s->destination = route->numPoints > 0 ? route->points[cityRandomBelow(&random, route->numPoints)] : c->start;
+        }
+        else {
+            s->destination = randomOpenSquare(&c->map, &random);
+        }
+    }
+}
+
+// True if every point of the case is inside a map of this size
+static int fitsSize(const struct DiffCase* c, int rows, int cols) {
+    if (rows < 1 || cols < 1 || c->start.row >= rows || c->start.col >= cols || c->dest.row >= rows || c->dest.col >= cols) {
+        return 0;
+    }
+    for (int t = 0; t < c->numTrucks; t++) {
+        for (int i = 0; i < c->trucks[t].route.numPoints; i++) {
+            if (c->trucks[t].route.points[i].row >= rows || c->trucks[t].route.points[i].col >= cols) {
+                return 0;
+            }
+        }
+    }
+    for (int k = 0; k < c->numShipments; k++) {
+        if (c->shipments[k].destination.row >= rows || c->shipments[k].destination.col >= cols) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Keep the trial case in place of the current one if the same check still fails
+static int keepIfFails(struct DiffCase* c, struct Failure* failure) {
+    struct Failure again;
+
+    if (checkCase(&trial, &again) || strcmp(again.check, failure->check) != 0) {
+        return 0;
+    }
+    *c = trial;
+    *failure = again;
+    return 1;
+}
+
+/*
+* Make a failing case smaller for as long as the same check keeps failing: drop shipments and trucks,
+* shorten routes, empty trucks, simplify shipments, shrink the map and knock down buildings. Each pass
+* tries every change once and the passes repeat until none of them is kept.
+*/
+static void shrinkCase(struct DiffCase* c, struct Failure* failure) {
+    int progress = 1;
+
+    while (progress) {
+        progress = 0;
+
+        for (int k = c->numShipments - 1; k >= 0; k--) {
+            trial = *c;
+            for (int j = k; j + 1 < trial.numShipments; j++) {
+                trial.shipments[j] = trial.shipments[j + 1];
+            }
+            trial.numShipments--;
+            progress |= keepIfFails(c, failure);
+        }
+        for (int t = c->numTrucks - 1; t >= 0; t--) {
+            trial = *c;
+            for (int j = t; j + 1 < trial.numTrucks; j++) {
+                trial.trucks[j] = trial.trucks[j + 1];
+            }
+            trial.numTrucks--;
+            progress |= keepIfFails(c, failure);
+        }
+        for (int t = 0; t < c->numTrucks; t++) {
+            int length = c->trucks[t].route.numPoints;
+
+            if (length > 1) {
+                trial = *c;
+                trial.trucks[t].route.numPoints = length / 2;
+                if (keepIfFails(c, failure)) {
+                    progress = 1;
+                    continue;
+                }
+            }
+            if (length > 0) {
+                trial = *c;
+                trial.trucks[t].route.numPoints--;
+                if (keepIfFails(c, failure)) {
+                    progress = 1;
+                    continue;
+                }
+                trial = *c;
+                for (int i = 0; i + 1 < length; i++) {
+                    trial.trucks[t].route.points[i] = trial.trucks[t].route.points[i + 1];
+                }
+                trial.trucks[t].route.numPoints--;
+                progress |= keepIfFails(c, failure);
+            }
+        }
+        for (int t = 0; t < c->numTrucks; t++) {
+            if (c->trucks[t].numShipments != 0 || c->trucks[t].currentWeight != 0 || c->trucks[t].currentVolume != 0) {
+                trial = *c;
+                trial.trucks[t].numShipments = 0;
+                trial.trucks[t].currentWeight = 0;
+                trial.trucks[t].currentVolume = 0;
+                progress |= keepIfFails(c, failure);
+            }
+            if (c->trucks[t].truckNumber != 0) {
+                trial = *c;
+                trial.trucks[t].truckNumber = 0;
+                progress |= keepIfFails(c, failure);
+            }
+        }
+        for (int k = 0; k < c->numShipments; k++) {
+            if (c->shipments[k].weight != 1 || c->shipments[k].volume != 0.5) {
+                trial = *c;
+                trial.shipments[k].weight = 1;
+                trial.shipments[k].volume = 0.5;
+                progress |= keepIfFails(c, failure);
+            }
+        }
+        while (fitsSize(c, c->map.numRows - 1, c->map.numCols)) {
+            trial = *c;
+            trial.map.numRows--;
+            for (int col = 0; col < MAP_COLS; col++) {
+                trial.map.squares[trial.map.numRows][col] = 0;
+            }
+            if (!keepIfFails(c, failure)) {
+                break;
+            }
+            progress = 1;
+        }
+        while (fitsSize(c, c->map.numRows, c->map.numCols - 1)) {
+            trial = *c;
+            trial.map.numCols--;
+            for (int r = 0; r < MAP_ROWS; r++) {
+                trial.map.squares[r][trial.map.numCols] = 0;
+            }
+            if (!keepIfFails(c, failure)) {
+                break;
+            }
+            progress = 1;
+        }
+        for (int r = 0; r < c->map.numRows; r++) {
+            for (int col = 0; col < c->map.numCols; col++) {
+                if (c->map.squares[r][col] == 1) {
+                    trial = *c;
+                    trial.map.squares[r][col] = 0;
+                    progress |= keepIfFails(c, failure);
+                }
+            }
+        }
+    }
+}
+
+static void printPoint(struct Point p) {
+    printf("%d%c", p.row + 1, 'A' + p.col);
+}
+
+static void printCase(const struct DiffCase* c) {
+    printf("Map %d x %d:\n", c->map.numRows, c->map.numCols);
+    printMap(&c->map, 1, 1);
+    printf("start ");
+    printPoint(c->start);
+    printf(", destination ");
+    printPoint(c->dest);
+    printf("\n");
+    for (int t = 0; t < c->numTrucks; t++) {
+        printf("truck %d: number %d, %d shipments, %.3f kg, %.1f m3, route", t, c->trucks[t].truckNumber,
+            c->trucks[t].numShipments, c->trucks[t].currentWeight, c->trucks[t].currentVolume);
+        for (int i = 0; i < c->trucks[t].route.numPoints; i++) {
+            printf(" ");
+            printPoint(c->trucks[t].route.points[i]);
+        }
+        printf("\n");
+    }
+    for (int k = 0; k < c->numShipments; k++) {
+        printf("shipment %d: %.3f kg, %.1f m3 to ", k, c->shipments[k].weight, c->shipments[k].volume);
+        printPoint(c->shipments[k].destination);
+        printf("\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    struct Failure failure;
+    int numCases = 1000;
+    unsigned int firstSeed = 1;
+    int numArgs = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-planted") == 0) {
+            planted = 1;
+        }
+        else if (numArgs++ == 0) {
+            numCases = atoi(argv[i]);
+        }
+        else {
+            firstSeed = (unsigned int)strtoul(argv[i], NULL, 10);
+        }
+    }
+    poolStarted = poolStart(&pool, POOL_THREADS);
+
+    for (int k = 0; k < numCases; k++) {
+        randomCase(&current, firstSeed + k);
+        if (!checkCase(&current, &failure)) {
+            printf("Case %u failed %s: %s\n", current.seed, failure.check, failure.detail);
+            shrinkCase(&current, &failure);
+            printf("Shrunk to a case that fails %s: %s\n", failure.check, failure.detail);
+            printCase(&current);
+            if (poolStarted) {
+                poolStop(&pool);
+            }
+            return 1;
+        }
+    }
+    printf("%d cases from seed %u, %ld results all agree with the reference\n", numCases, firstSeed, numComparisons);
+    if (poolStarted) {
+        poolStop(&pool);
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+* Purpose: Work out the tables a fresh start needs from the course map and the three trucks' routes,
+*          and write them out as C source so they are compiled into read-only data instead of being
+*          set up on every start.
+*
+* Build and run from this folder after changing the map, a route or one of the structures, e.g.
+*   gcc -O2 -I../SourceCode gentables.c ../SourceCode/mapping.c ../SourceCode/MS3Functions.c
+*       ../SourceCode/pathing.c ../SourceCode/hpa.c ../SourceCode/roadgraph.c ../SourceCode/fleetscore.c
+*       ../SourceCode/segments.c -lm -o gentables
+*   ./gentables ../SourceCode/coursetables.c
+* Build it with the default MAP_ROWS, MAP_COLS and MAX_ROUTE, the ones the app is built with.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include "MS3FunctionSpecs.h"
+#include "pathing.h"
+
+static struct Truck trucks[NUM_TRUCKS];
+static struct MoveTable moves;
+static struct FleetIndex fleet;
+static struct DestinationTable destinations;
+
+// One line of values per map row, each in braces of its own for a two dimensional array
+static void writeCells(FILE* out, const char* format, const unsigned int values[MAP_ROWS * MAP_COLS], int rowBraces) {
+    for (int row = 0; row < MAP_ROWS; row++) {
+        fprintf(out, rowBraces ? "        { " : "        ");
+        for (int col = 0; col < MAP_COLS; col++) {
+            fprintf(out, format, values[row * MAP_COLS + col]);
+            fprintf(out, col + 1 < MAP_COLS || (row + 1 < MAP_ROWS && !rowBraces) ? "," : "");
+        }
+        fprintf(out, "%s   // %d\n", rowBraces ? (row + 1 < MAP_ROWS ? " }," : " }") : "", row);
+    }
+}
+
+static void writeTruck(FILE* out, const struct Truck* truck) {
+    fprintf(out, "    {\n        .route = {\n            {");
+    for (int i = 0; i < truck->route.numPoints; i++) {
+        fprintf(out, "%s{ %d, %d }", i % 10 == 0 ? "\n                " : " ", truck->route.points[i].row, truck->route.points[i].col);
+        fprintf(out, i + 1 < truck->route.numPoints ? "," : "");
+    }
+    fprintf(out, "\n            },\n            %d, %d\n        },\n", truck->route.numPoints, truck->route.routeSymbol);
+    fprintf(out, "        .truckNumber = %d,\n        .routeCells = {", truck->truckNumber);
+    for (int i = 0; i < ROUTE_MAP_WORDS; i++) {
+        fprintf(out, "%s0x%08xu%s", i % 6 == 0 ? "\n            " : " ", truck->routeCells[i], i + 1 < ROUTE_MAP_WORDS ? "," : "");
+    }
+    fprintf(out, "\n        },\n        .routeIndexed = %d,\n        .segments = {\n", truck->routeIndexed);
+    for (int i = 0; i < truck->numSegments; i++) {
+        const struct RouteSegment* s = &truck->segments[i];
+        fprintf(out, "            { { %d, %d }, %d, %d, %d }%s\n", s->start.row, s->start.col, s->rowStep, s->colStep,
+            s->length, i + 1 < truck->numSegments ? "," : "");
+    }
+    fprintf(out, "        },\n        .numSegments = %d\n    }", truck->numSegments);
+}
+
+int main(int argc, char* argv[]) {
+    static unsigned int values[MAP_ROWS * MAP_COLS];
+    const struct Map* map = getCourseMap();
+    FILE* out;
+
+    if (argc != 2) {
+        printf("usage: gentables <output file>\n");
+        return 1;
+    }
+
+    // The same set up main() used to do on every start
+    loadBlueRoute(&trucks[0].route);
+    loadGreenRoute(&trucks[1].route);
+    loadYellowRoute(&trucks[2].route);
+    for (int i = 0; i < NUM_TRUCKS; i++) {
+        trucks[i].truckNumber = i;
+        indexRoute(&trucks[i]);
+    }
+    buildMoveTable(&moves, map);
+    buildFleetIndex(&fleet, trucks, NUM_TRUCKS);
+    buildDestinationTable(&destinations, map, trucks, NUM_TRUCKS);
+
+    out = fopen(argv[1], "w");
+    if (out == NULL) {
+        printf("could not write %s\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(out, "/*\n* Generated by Tools/gentables.c from the course map and routes in mapping.c. Do not edit;\n");
+    fprintf(out, "* run the generator again instead.\n*/\n\n#include \"coursetables.h\"\n\n");
+    fprintf(out, "#if MAP_ROWS != %d || MAP_COLS != %d || MAX_ROUTE != %d\n", MAP_ROWS, MAP_COLS, MAX_ROUTE);
+    fprintf(out, "#error \"coursetables.c was generated for a %dx%d map with routes of up to %d points\"\n#endif\n\n",
+        MAP_ROWS, MAP_COLS, MAX_ROUTE);
+
+    fprintf(out, "const struct Truck courseTrucks[NUM_TRUCKS] = {\n");
+    for (int i = 0; i < NUM_TRUCKS; i++) {
+        writeTruck(out, &trucks[i]);
+        fprintf(out, i + 1 < NUM_TRUCKS ? ",\n" : "\n");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "const struct MoveTable courseMoves = {\n    {\n");
+    for (int cell = 0; cell < MAP_ROWS * MAP_COLS; cell++) {
+        values[cell] = moves.moves[cell];
+    }
+    writeCells(out, "%3u", values, 0);
+    fprintf(out, "    }\n};\n\n");
+
+    fprintf(out, "const struct FleetIndex courseFleet = {\n    %d,\n    {\n", fleet.numTrucks);
+    for (int cell = 0; cell < MAP_ROWS * MAP_COLS; cell++) {
+        values[cell] = fleet.trucksAt[cell / MAP_COLS][cell % MAP_COLS];
+    }
+    writeCells(out, "%u", values, 1);
+    fprintf(out, "    }\n};\n\n");
+
+    fprintf(out, "const struct DestinationTable courseDestinations = {\n    %d,\n    {\n", destinations.numTrucks);
+    for (int cell = 0; cell < MAP_ROWS * MAP_COLS; cell++) {
+        values[cell] = destinations.reachedBy[cell];
+    }
+    writeCells(out, "%u", values, 0);
+    fprintf(out, "    }\n};\n");
+
+    if (fclose(out) != 0) {
+        printf("could not write %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}